@@ -47,7 +47,8 @@ int main()
 	// The calibration object is now connected and ready to work. Lets get data:
 	
 	//Assignment object holds all information about data obtained
-	auto_ptr<Assignment> a(calib->GetAssignment("/test/test_vars/test_table"));
+	//It is owned by the calibration (or its provider if the cache is off), so it is not deleted here
+	Assignment* a = calib->GetAssignment("/test/test_vars/test_table");
 	
 	//type table class holds information about table
 	cout<<"A full path requested: "<< a->GetTypeTable()->GetFullPath() <<endl;
@@ -24,9 +24,9 @@ extern std::string gConnectionString;
 #define BENCHMARK_INIT() StopWatch stopwatch; 
 
 //must be called once per function that performs tests
-#define BENCHMARK_START(title) gConsole.WriteLine(Console::cBrightBlue,"\n[ %s ]", (title)); stopwatch.Start();
+#define BENCHMARK_START(title) gConsole.WriteLine(Console::cBrightBlue,"\n[ %s ]", (title)); stopwatch.Restart();
 
 //must be called once per function that performs tests
-#define BENCHMARK_FINISH(title) stopwatch.Stop(); gConsole.WriteLine(Console::cGreen, " %s %f", (title), stopwatch.GetDuration());
+#define BENCHMARK_FINISH(title) gConsole.WriteLine(Console::cGreen, " %s %f", (title), stopwatch.ElapsedUs() / 1e6);
 
 #endif // bencjmarks_h__
\ No newline at end of file
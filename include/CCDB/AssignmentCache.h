@@ -0,0 +1,228 @@
+#ifndef DAssignmentCache_h
+#define DAssignmentCache_h
+
+#include <string>
+#include <map>
+#include <vector>
+#include <unordered_map>
+#include <memory>
+#include <atomic>
+
+#ifdef _MSC_VER
+    #include "winpthreads.h"
+#else   // GCC?
+    #include <pthread.h>
+#endif
+
+#include "CCDB/Globals.h"
+#include "CCDB/Model/Assignment.h"
+
+namespace ccdb
+{
+
+/** @brief Accounting information of AssignmentCache */
+struct AssignmentCacheStats
+{
+    size_t Entries;             ///< Number of assignments that are held by the cache now
+    size_t Bytes;               ///< Estimated memory that is held by the cached assignments
+    size_t MemoryLimit;         ///< Memory budget of the cache in bytes. 0 - unlimited
+    unsigned long Hits;         ///< Number of requests that were served from the cache
+    unsigned long Misses;       ///< Number of requests that were not found in the cache
+    unsigned long Evictions;    ///< Number of assignments and missing intervals of requests removed to fit the memory budget
+    unsigned long Insertions;   ///< Number of assignments put to the cache
+    size_t MissingIntervals;    ///< Number of run intervals known to have no assignment
+    unsigned long MissingHits;  ///< Number of requests answered "not found" by the missing intervals
+};
+
+
+/** @brief Bounded LRU cache of assignments
+ *
+ * The cache holds assignments by shared pointers and accounts memory
+ * that they use (@see Assignment::GetMemoryUsage). Once the total size exceeds
+ * the memory budget the least recently used assignments are evicted.
+ *
+ * Besides plain keys, assignments may be found by run number. A request (table, variation, time)
+ * resolves to the same assignment for all runs of some interval. Once the interval is known
+ * (@see DataProvider::GetAssignmentRunInterval) any run inside it is served from the cache.
+ *
+ * Lookups take a shared (reader) lock only, so cache hits from many threads run in parallel.
+ * Instead of reordering a LRU list on every hit, each entry remembers the tick of its last use
+ * and the eviction picks the entries with the oldest ticks.
+ *
+ * Requests that have no assignment are remembered the same way: as run intervals of the request
+ * key for which nothing is found (@see PutMissing, DataProvider::GetMissingRunInterval).
+ * Missing intervals of a request count in the memory budget and are evicted by the last use
+ * together with assignments.
+ *
+ * Evicted assignments are not deleted while someone still holds a shared pointer to them.
+ * The most recently added or requested assignment is never evicted, so a single
+ * assignment that is bigger than the budget is still cached until the next one comes.
+ *
+ * @remark the class is thread safe
+ */
+class AssignmentCache
+{
+public:
+
+    /** @brief Constructor
+     *
+     * @parameter [in] memoryLimit - memory budget in bytes. 0 means the cache is unlimited
+     */
+    explicit AssignmentCache(size_t memoryLimit = CCDB_DEFAULT_CACHE_MEMORY_LIMIT);
+
+    ~AssignmentCache();
+
+    /** @brief Gets assignment by key and marks it as most recently used
+     *
+     * @parameter [in] key - cache key
+     * @return   shared pointer to assignment or empty pointer if key is not in the cache
+     */
+    std::shared_ptr<Assignment> Get(const std::string& key);
+
+    /** @brief Adds assignment to the cache. Replaces the assignment if key exists
+     *
+     * Adding may evict the least recently used assignments to fit the memory budget
+     *
+     * @parameter [in] key - cache key
+     * @parameter [in] assignment - assignment to cache. Empty pointers are ignored
+     */
+    void Put(const std::string& key, const std::shared_ptr<Assignment>& assignment);
+
+    /** @brief Gets assignment cached for a run interval that contains the run
+     *
+     * @parameter [in] requestKey - request key without run number, i.e. path:variation:time
+     * @parameter [in] run - run number
+     * @parameter [out] runMin - if not NULL, receives the first run of the interval
+     * @parameter [out] runMax - if not NULL, receives the last run of the interval
+     * @return   shared pointer to assignment or empty pointer if no known interval contains the run
+     */
+    std::shared_ptr<Assignment> Get(const std::string& requestKey, int run, int* runMin = NULL, int* runMax = NULL);
+
+    /** @brief The same as Get(requestKey, run) but hits and misses are not counted
+     *
+     * Is used to check again a request that already missed, i.e. after waiting for another thread loading it
+     */
+    std::shared_ptr<Assignment> Peek(const std::string& requestKey, int run, int* runMin = NULL, int* runMax = NULL);
+
+    /** @brief Adds assignment and the run interval for which the request resolves to it
+     *
+     * @parameter [in] requestKey - request key without run number, i.e. path:variation:time
+     * @parameter [in] runMin - first run of the interval
+     * @parameter [in] runMax - last run of the interval
+     * @parameter [in] key - key of the assignment itself, i.e. path:assignment_id
+     * @parameter [in] assignment - assignment to cache. Empty pointers are ignored
+     */
+    void Put(const std::string& requestKey, int runMin, int runMax, const std::string& key, const std::shared_ptr<Assignment>& assignment);
+
+    /** @brief Remembers that the request has no assignment for runs of the interval
+     *
+     * @parameter [in] requestKey - request key without run number, i.e. path:variation:time
+     * @parameter [in] runMin - first run of the interval
+     * @parameter [in] runMax - last run of the interval
+     */
+    void PutMissing(const std::string& requestKey, int runMin, int runMax);
+
+    /** @brief Checks if the request is known to have no assignment for the run
+     *
+     * The check takes the shared lock and doesn't allocate memory
+     *
+     * @parameter [in] requestKey - request key without run number, i.e. path:variation:time
+     * @parameter [in] run - run number
+     * @parameter [out] runMin - if not NULL, receives the first run of the missing interval
+     * @parameter [out] runMax - if not NULL, receives the last run of the missing interval
+     * @return   true if a missing interval contains the run
+     */
+    bool IsMissing(const std::string& requestKey, int run, int* runMin = NULL, int* runMax = NULL);
+
+    /** @brief Removes assignment with the key from the cache
+     *
+     * @parameter [in] key - cache key
+     * @return   true if key was in the cache
+     */
+    bool Remove(const std::string& key);
+
+    /** @brief Removes assignments and missing intervals of one table
+     *
+     * Removes entries of all keys that start with "path:" (@see Calibration::MakeRequestKey),
+     * i.e. of all variations, times and runs of the table
+     *
+     * @parameter [in] path - full path of the table
+     * @return   number of removed assignments and missing intervals
+     */
+    size_t RemoveTable(const std::string& path);
+
+    /** @brief Removes all assignments and missing intervals from the cache. Statistics counters are kept */
+    void Clear();
+
+    /** @brief Sets memory budget in bytes. 0 - unlimited
+     *
+     * If the cache is already bigger than the new budget, assignments are evicted immediately
+     */
+    void SetMemoryLimit(size_t bytes);
+
+    /** @brief Memory budget in bytes. 0 - unlimited */
+    size_t GetMemoryLimit() const;
+
+    /** @brief Gets entries, bytes, hits, misses, evictions and insertions accounting */
+    AssignmentCacheStats GetStats() const;
+
+    /** @brief Resets hits, misses, evictions and insertions counters */
+    void ResetStats();
+
+private:
+    struct Entry
+    {
+        Entry(): Bytes(0), DataBytes(0), LastUse(0) {}
+        std::shared_ptr<Assignment> Data;      // cached assignment
+        size_t Bytes;                          // accounted size of assignment and its intervals
+        size_t DataBytes;                      // accounted size of assignment only
+        std::atomic<unsigned long> LastUse;    // tick of the last use, updated under the shared lock
+        std::vector<std::pair<std::string, int> > Intervals; // (requestKey, runMin) of intervals referring the entry
+    };
+
+    struct MissingEntry
+    {
+        MissingEntry(): Bytes(0), LastUse(0) {}
+        std::map<int, int> Intervals;          // runMin => runMax of runs without assignment
+        size_t Bytes;                          // accounted size of the intervals
+        std::atomic<unsigned long> LastUse;    // tick of the last use, updated under the shared lock
+    };
+
+    struct RunInterval
+    {
+        int RunMax;                            // last run of the interval
+        std::string Key;                       // key of the assignment entry
+    };
+    typedef std::map<int, RunInterval> RunIntervals;   // runMin => interval
+
+    typedef std::unordered_map<std::string, Entry> Entries;
+    typedef std::unordered_map<std::string, MissingEntry> MissingEntries;
+
+    Entries::iterator PutEntry(const std::string& key, const std::shared_ptr<Assignment>& assignment); // exclusive lock must be held
+    void EraseEntry(Entries::iterator iter);   // exclusive lock must be held
+    void EraseMissing(MissingEntries::iterator iter); // exclusive lock must be held
+    void EvictToFit();                         // exclusive lock must be held
+    void Touch(std::atomic<unsigned long>& lastUse); // marks entry as most recently used
+    Entry* Find(const std::string& requestKey, int run, int* runMin, int* runMax); // shared lock must be held
+
+    Entries mEntries;
+    std::unordered_map<std::string, RunIntervals> mRunIntervals;  // requestKey => known run intervals
+    MissingEntries mMissingIntervals;          // requestKey => runs without assignment
+    size_t mBytes;
+    size_t mMemoryLimit;
+    std::atomic<unsigned long> mTick;          // use counter that orders entries by recency
+    std::atomic<unsigned long> mHits;
+    std::atomic<unsigned long> mMisses;
+    size_t mMissingCount;                      // number of missing intervals
+    std::atomic<unsigned long> mEvictions;
+    std::atomic<unsigned long> mInsertions;
+    std::atomic<unsigned long> mMissingHits;
+    mutable pthread_rwlock_t mLock;            // shared for lookups, exclusive for modifications
+
+    AssignmentCache(const AssignmentCache& rhs);
+    AssignmentCache& operator=(const AssignmentCache& rhs);
+};
+
+}
+
+#endif // DAssignmentCache_h
@@ -0,0 +1,80 @@
+#ifndef DCalibHandle_h
+#define DCalibHandle_h
+
+#include <time.h>
+#include <memory>
+
+#include "CCDB/Model/Assignment.h"
+
+namespace ccdb
+{
+
+class Calibration;
+
+/** @brief Precompiled request /path/to/data:run:variation:time
+ *
+ * The handle is created once by @see Calibration::GetHandle. The path and the variation
+ * are interned to integer ids, so fetching constants through the handle does no parsing,
+ * no string work and no allocations inside the library while the requested run stays
+ * inside the run interval of the last fetched assignment.
+ *
+ * The typical usage is to keep a handle as a member of a JANA factory, call SetRun
+ * when the run changes and GetCalib(values, handle) for each event.
+ *
+ * @remark a handle remembers the last fetched assignment, so it should not be used by
+ *         several threads at the same time. Create a handle per thread (factory) instead.
+ */
+class CalibHandle
+{
+public:
+    CalibHandle():
+        mOwner(NULL),
+        mPathId(-1),
+        mVariationId(-1),
+        mRun(0),
+        mTime(0),
+        mHasColumns(false),
+        mRunMin(0),
+        mRunMax(-1),
+        mGeneration(0)
+    {
+    }
+
+    /** @brief true if the handle was created by Calibration::GetHandle */
+    bool IsValid() const { return mOwner != NULL; }
+
+    /** @brief Interned id of the table path */
+    int GetPathId() const { return mPathId; }
+
+    /** @brief Interned id of the variation name */
+    int GetVariationId() const { return mVariationId; }
+
+    /** @brief Run number the constants are fetched for */
+    int GetRun() const { return mRun; }
+
+    /** @brief Changes the run number. The next fetch resolves the assignment only if the run is outside of the known interval */
+    void SetRun(int run) { mRun = run; }
+
+    /** @brief Time of the request. 0 - the latest constants */
+    time_t GetTime() const { return mTime; }
+
+private:
+    friend class Calibration;
+
+    const Calibration* mOwner;              ///< Calibration which created the handle
+    int mPathId;                            ///< Interned path id
+    int mVariationId;                       ///< Interned variation id
+    int mRun;                               ///< Run number
+    time_t mTime;                           ///< Request time
+
+    // The last fetched assignment and the run interval it is valid for
+    std::shared_ptr<Assignment> mAssignment;
+    bool mHasColumns;                       ///< The assignment was loaded with columns
+    int mRunMin;                            ///< First run of the interval
+    int mRunMax;                            ///< Last run of the interval
+    unsigned long mGeneration;              ///< Cache generation the assignment was fetched in
+};
+
+}
+
+#endif // DCalibHandle_h
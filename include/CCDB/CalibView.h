@@ -0,0 +1,88 @@
+#ifndef DCalibView_h
+#define DCalibView_h
+
+#include <stddef.h>
+#include <memory>
+
+#include "CCDB/Model/Assignment.h"
+
+namespace ccdb
+{
+
+class Calibration;
+
+/** @brief Read-only view of a constants table as one contiguous row-major array
+ *
+ * The view is filled by Calibration::GetCalib(view, namepath). It points right to the
+ * row by row copy of the typed columns kept with the assignment (@see Assignment::GetDoubleValues),
+ * so the values are the same as other GetCalib versions give. The copy is made once on the first
+ * request of the type, the next views are filled without copying. The view holds the assignment,
+ * the pointer stays valid while the view exists, even if the cache is cleared or the assignment is replaced.
+ *
+ * Cell [row][column] is at GetData()[row*GetColumnsCount() + column]
+ *
+ * @remark T is double or int
+ */
+template<typename T>
+class CalibView
+{
+public:
+    CalibView():
+        mData(NULL),
+        mRows(0),
+        mColumns(0)
+    {
+    }
+
+    /** @brief Pointer to the first value. NULL if the view is empty */
+    const T* GetData() const { return mData; }
+
+    /** @brief Number of rows */
+    size_t GetRowsCount() const { return mRows; }
+
+    /** @brief Number of columns */
+    size_t GetColumnsCount() const { return mColumns; }
+
+    /** @brief Number of values, rows*columns */
+    size_t GetSize() const { return mRows * mColumns; }
+
+    /** @brief true if the view points to no values */
+    bool IsEmpty() const { return mRows * mColumns == 0; }
+
+    /** @brief Value of the cell [row][column]. Indexes are not checked */
+    const T& operator()(size_t row, size_t column) const { return mData[row * mColumns + column]; }
+
+    /** @brief Value by index in the row-major array. The index is not checked */
+    const T& operator[](size_t index) const { return mData[index]; }
+
+    const T* begin() const { return mData; }
+    const T* end() const { return mData + mRows * mColumns; }
+
+    /** @brief Releases the assignment and empties the view */
+    void Reset()
+    {
+        mAssignment.reset();
+        mData = NULL;
+        mRows = mColumns = 0;
+    }
+
+private:
+    friend class Calibration;
+
+    void Set(const std::shared_ptr<Assignment>& assignment, const T* data, size_t rows, size_t columns)
+    {
+        mAssignment = assignment;
+        mData = data;
+        mRows = rows;
+        mColumns = columns;
+    }
+
+    std::shared_ptr<Assignment> mAssignment;    ///< Keeps the values alive
+    const T* mData;                             ///< First value
+    size_t mRows;                               ///< Number of rows
+    size_t mColumns;                            ///< Number of columns
+};
+
+}
+
+#endif // DCalibView_h
@@ -7,9 +7,19 @@
 #include <time.h>
 #include <memory>
 #include <mutex>
+#include <atomic>
+#include <future>
+#include <unordered_map>
+#include <deque>
 
 #include "CCDB/Globals.h"
 #include "CCDB/Providers/DataProvider.h"
+#include "CCDB/Providers/DataProviderPool.h"
+#include "CCDB/AssignmentCache.h"
+#include "CCDB/CalibHandle.h"
+#include "CCDB/CalibView.h"
+#include "CCDB/IOExecutor.h"
+#include "CCDB/Helpers/PathUtils.h"
 #include "CCDB/PthreadMutex.h"
 #include "CCDB/PthreadSyncObject.h"
 
@@ -23,6 +33,27 @@ using namespace std;
 namespace ccdb
 {
 
+/** @brief Report of Calibration::Prefetch */
+struct PrefetchStats
+{
+    size_t Requested;       ///< Number of requested namepaths
+    size_t AlreadyCached;   ///< Number of requests that were already in the cache
+    size_t Loaded;          ///< Number of assignments loaded from the database
+    size_t NotFound;        ///< Number of requests that have no data
+    double Seconds;         ///< Time spent
+};
+
+
+/** @brief Report of Calibration::CheckForChanges */
+struct ChangeCheckStats
+{
+    unsigned long Checks;               ///< Number of times the database was checked
+    unsigned long Changes;              ///< Number of checks that found the database changed
+    unsigned long InvalidatedTables;    ///< Number of tables dropped from the cache
+    unsigned long FullClears;           ///< Number of changes that cleared the whole cache
+};
+
+
 class Calibration {
 
 public:
@@ -182,6 +213,156 @@ public:
     virtual bool GetCalib(double &value, const string & namepath);
     virtual bool GetCalib(int &value, const string & namepath);
 
+    /** @brief Get constants by namepath
+     *
+     * this version of function fills values as one contiguous row-major array
+     * (cell [row][column] is at row*columns + column)
+     *
+     * @parameter [out] values  - all cells of the table, row by row
+     * @parameter [out] rows    - number of rows
+     * @parameter [out] columns - number of columns
+     * @parameter [in]  namepath - data path
+     * @return true if constants were found and filled. false if namepath was not found. raises std::exception if any other error acured.
+     */
+    virtual bool GetCalib(vector<double> &values, size_t &rows, size_t &columns, const string & namepath);
+    virtual bool GetCalib(vector<int> &values, size_t &rows, size_t &columns, const string & namepath);
+
+    /** @brief Get constants by namepath
+     *
+     * this version of function copies the table row by row to the buffer of the caller,
+     * so the same buffer may be reused without allocations
+     *
+     * @parameter [out] buffer     - buffer for rows*columns values
+     * @parameter [in]  bufferSize - number of values the buffer can hold
+     * @parameter [out] rows       - number of rows
+     * @parameter [out] columns    - number of columns
+     * @parameter [in]  namepath   - data path
+     * @return true if constants were found and filled. false if namepath was not found.
+     *         raises std::logic_error if the buffer is too small (rows and columns are set),
+     *         std::exception if any other error acured.
+     */
+    virtual bool GetCalib(double *buffer, size_t bufferSize, size_t &rows, size_t &columns, const string & namepath);
+    virtual bool GetCalib(int *buffer, size_t bufferSize, size_t &rows, size_t &columns, const string & namepath);
+
+    /** @brief Get constants by namepath
+     *
+     * this version of function does not copy values on each call. The view points to the row by row
+     * copy of the typed columns kept with the assignment and keeps the assignment alive. @see CalibView
+     *
+     * @parameter [out] view     - read-only row-major view of the table
+     * @parameter [in]  namepath - data path
+     * @return true if constants were found and filled. false if namepath was not found. raises std::exception if any other error acured.
+     */
+    virtual bool GetCalib(CalibView<double> &view, const string & namepath);
+    virtual bool GetCalib(CalibView<int> &view, const string & namepath);
+
+    /** @brief Creates precompiled handle for the request
+     *
+     * The namepath is parsed once, not given run, variation and time are taken from defaults.
+     * The path and the variation are interned to ids. @see CalibHandle
+     *
+     * @parameter [in]  namepath - data path. Short /path/to/data .Full format is /path/to/data:run:variation:time
+     * @return handle to use with GetCalib(values, handle)
+     */
+    CalibHandle GetHandle(const string & namepath);
+
+    /** @brief Get constants by precompiled handle
+     *
+     * The same as GetCalib(values, namepath) versions but the request is taken from the handle.
+     * If the handle run is inside the run interval of the assignment fetched last time,
+     * the data is taken from the handle without parsing, locks and allocations inside the library
+     *
+     * @parameter [out] values - the same as for namepath versions
+     * @parameter [in]  handle - handle created by @see GetHandle of this Calibration
+     * @return true if constants were found and filled. false if there is no such data. raises std::exception if any other error acured.
+     */
+    virtual bool GetCalib(vector< map<string, string> > &values, CalibHandle & handle);
+    virtual bool GetCalib(vector< map<string, double> > &values, CalibHandle & handle);
+    virtual bool GetCalib(vector< map<string, int> > &values, CalibHandle & handle);
+    virtual bool GetCalib(vector< vector<string> > &values, CalibHandle & handle);
+    virtual bool GetCalib(vector< vector<double> > &values, CalibHandle & handle);
+    virtual bool GetCalib(vector< vector<int> >   &values, CalibHandle & handle);
+    virtual bool GetCalib(map<string, string> &values, CalibHandle & handle);
+    virtual bool GetCalib(map<string, double> &values, CalibHandle & handle);
+    virtual bool GetCalib(map<string, int> &values, CalibHandle & handle);
+    virtual bool GetCalib(vector<string> &values, CalibHandle & handle);
+    virtual bool GetCalib(vector<double> &values, CalibHandle & handle);
+    virtual bool GetCalib(vector<int> &values, CalibHandle & handle);
+    virtual bool GetCalib(string &value, CalibHandle & handle);
+    virtual bool GetCalib(double &value, CalibHandle & handle);
+    virtual bool GetCalib(int &value, CalibHandle & handle);
+    virtual bool GetCalib(vector<double> &values, size_t &rows, size_t &columns, CalibHandle & handle);
+    virtual bool GetCalib(vector<int> &values, size_t &rows, size_t &columns, CalibHandle & handle);
+    virtual bool GetCalib(double *buffer, size_t bufferSize, size_t &rows, size_t &columns, CalibHandle & handle);
+    virtual bool GetCalib(int *buffer, size_t bufferSize, size_t &rows, size_t &columns, CalibHandle & handle);
+    virtual bool GetCalib(CalibView<double> &view, CalibHandle & handle);
+    virtual bool GetCalib(CalibView<int> &view, CalibHandle & handle);
+
+    /** @brief Gets the assignment by precompiled handle as a shared pointer. @see GetSharedAssignment */
+    std::shared_ptr<Assignment> GetSharedAssignment(CalibHandle & handle, bool loadColumns = true);
+
+    /** @brief Get constants by namepath in background
+     *
+     * The request is run by the I/O threads of the calibration (@see SetIOThreads),
+     * so the calling thread may do other work while the data is read from the database.
+     * Any GetCalib(values, namepath) version may be used
+     *
+     * @warning values must stay alive and must not be touched until the future is ready
+     *
+     * @parameter [out] values - the same as for GetCalib
+     * @parameter [in]  namepath - data path. Short /path/to/data .Full format is /path/to/data:run:variation:time
+     * @return future of GetCalib result. future::get rethrows exceptions of GetCalib
+     */
+    template<typename T>
+    std::future<bool> GetCalibAsync(T &values, const string & namepath)
+    {
+        T* target = &values;
+        return GetIOExecutor().Submit([this, target, namepath]() { return GetCalib(*target, namepath); });
+    }
+
+    /** @brief Get constants of many namepaths in background
+     *
+     * The requests are loaded in one go (@see Prefetch) and then filled one by one
+     * as GetCalib(values[i], namepaths[i]) does. A JANA factory may issue all its requests
+     * at run change and wait for them after other setup work
+     *
+     * @warning values must stay alive and must not be touched until the future is ready
+     *
+     * @parameter [out] values - resized to the number of namepaths, values[i] is filled for namepaths[i]
+     * @parameter [in]  namepaths - requests in GetCalib format
+     * @return future of GetCalib results by namepath. future::get rethrows the first exception of GetCalib
+     */
+    template<typename T>
+    std::future<vector<bool> > GetCalibManyAsync(vector<T> &values, const vector<string> & namepaths)
+    {
+        vector<T>* target = &values;
+        return GetIOExecutor().Submit([this, target, namepaths]() {
+            Prefetch(namepaths);
+            target->clear();
+            target->resize(namepaths.size());
+            vector<bool> results(namepaths.size());
+            for(size_t i = 0; i < namepaths.size(); i++) results[i] = GetCalib((*target)[i], namepaths[i]);
+            return results;
+        });
+    }
+
+    /** @brief Gets the assignment in background. @see GetSharedAssignment, GetCalibAsync
+     * @return future of the assignment, empty if no assignment was found
+     */
+    std::future<std::shared_ptr<Assignment> > GetSharedAssignmentAsync(const string & namepath, bool loadColumns = true);
+
+    /** @brief Sets maximum number of threads that run asynchronous requests
+     *
+     * Threads are started when requests come. Without the connection pool (@see SetPoolSize)
+     * they read the database one at a time, so more threads than pooled connections don't help
+     *
+     * @param threads maximum number of threads, at least 1. The default is CCDB_DEFAULT_IO_THREADS
+     */
+    void SetIOThreads(size_t threads);
+
+    /** @brief Maximum number of threads that run asynchronous requests. @see SetIOThreads */
+    size_t GetIOThreads();
+
     /** @brief gets connection string which is used for current provider
     *@return mConnectionString
     */
@@ -254,11 +435,31 @@ public:
 	*
 	* @remark the function is thread safe
 	*
+	* @warning The caller must not delete the assignment. If cache is enabled, it is held by
+	*          the calibration (the same assignment for all requests that resolve to it) and is valid
+	*          until ClearCache() is called or the calibration is destroyed, even if the cache evicts it.
+	*          Without cache it is owned by the provider as it always was.
+	*          Use @see GetSharedAssignment to control the lifetime of the assignment.
+	*
 	* @parameter [in] namepath -  full namepath is /path/to/data:run:variation:time but usually it is only /path/to/data
 	* @return   DAssignment *
 	*/
 	virtual Assignment* GetAssignment(const string& namepath, bool loadColumns = true);
 
+	/** @brief Gets the assignment from provider using namepath as a shared pointer
+	* namepath is the common ccdb request; @see GetCalib
+	*
+	* The assignment stays valid as long as the pointer is held, even if the cache evicts it
+	*
+	* @remark the function is thread safe. Cache hits don't wait for other threads reading the database.
+	*         If several threads miss the same request at once, only one of them reads the database
+	*         and the others take its result from the cache
+	*
+	* @parameter [in] namepath -  full namepath is /path/to/data:run:variation:time but usually it is only /path/to/data
+	* @return   shared pointer to assignment, empty if no assignment was found
+	*/
+	virtual std::shared_ptr<Assignment> GetSharedAssignment(const string& namepath, bool loadColumns = true);
+
     /** @brief if true the data will be cached
      *
      * @param value true - enable cache, false - disable
@@ -271,6 +472,128 @@ public:
     /** @brief if true the caching is using */
     bool IsCacheEnabled();
 
+    /** @brief Sets memory budget of the cache in bytes. 0 - unlimited
+     *
+     * When the cached assignments exceed the budget, the least recently used are evicted.
+     * The default is CCDB_DEFAULT_CACHE_MEMORY_LIMIT
+     *
+     * @param bytes memory budget in bytes
+     */
+    void SetCacheMemoryLimit(size_t bytes) { mCache.SetMemoryLimit(bytes); }
+
+    /** @brief Memory budget of the cache in bytes. 0 - unlimited */
+    size_t GetCacheMemoryLimit() const { return mCache.GetMemoryLimit(); }
+
+    /** @brief Gets cache accounting: entries, bytes, hits, misses, evictions and known missing run intervals */
+    AssignmentCacheStats GetCacheStats() const { return mCache.GetStats(); }
+
+    /** @brief Loads a list of tables to the cache in one go
+     *
+     * Instead of loading tables one by one at the first event of a run, the requests
+     * are grouped by run, variation and time and each group is loaded from the database
+     * at once (@see DataProvider::GetAssignmentsShort). Tables are loaded with columns, so
+     * they serve all GetCalib versions. Requests which are already cached are not loaded again.
+     *
+     * @remark nothing is loaded if the cache is disabled
+     *
+     * @parameter [in] namepaths - requests in GetCalib format /path/to/data:run:variation:time
+     * @return counts of loaded, cached and not found tables and the time spent
+     */
+    PrefetchStats Prefetch(const vector<string>& namepaths);
+
+    /** @brief Loads all tables of the database for default run, variation and time to the cache. @see Prefetch */
+    PrefetchStats PrefetchAll();
+
+    /** @brief Removes all assignments from the cache. Handles fetch their assignments again
+     *
+     * @warning assignments given by GetAssignment are deleted
+     */
+    void ClearCache();
+
+    /** @brief Checks the database for changes every 'seconds' seconds. 0 - never (default)
+     *
+     * Cached data never gets old by itself. Long running processes that should see
+     * new constants keep the cache on and let it check the database from time to time.
+     * The check is done by the request that comes when the interval is over and is cheap:
+     * SQLite tells if the file was changed by PRAGMA data_version, MySQL gives the biggest id and
+     * the latest modification time of assignments. Only then the tables with new or modified
+     * assignments are dropped from the cache (@see DataProvider::GetChangedTables).
+     * Other changes (i.e. removed assignments) clear the whole cache
+     *
+     * @remark a frozen snapshot (@see Freeze) is not changed, Freeze again to publish new data
+     *
+     * @param seconds interval between checks in seconds. 0 - don't check
+     */
+    void SetChangeCheckInterval(time_t seconds);
+
+    /** @brief Interval between checks of the database for changes in seconds. 0 - not checked */
+    time_t GetChangeCheckInterval() const { return mChangeCheckInterval.load(); }
+
+    /** @brief Checks the database for changes now and drops changed tables from the cache
+     *
+     * The first call only takes the state of the database. @see SetChangeCheckInterval
+     *
+     * @return true if the database was changed since the last check
+     */
+    bool CheckForChanges();
+
+    /** @brief Gets counts of checks, changes and dropped tables */
+    ChangeCheckStats GetChangeCheckStats();
+
+    /** @brief Publishes immutable snapshot of the loaded tables
+     *
+     * After warm-up (i.e. the first event of a run) all needed tables are loaded. Freeze() collects
+     * tables that were requested as plain /path/to/data (with default run, variation and time)
+     * into a snapshot that is never modified. Then GetCalib for these paths doesn't take locks,
+     * doesn't check the connection and doesn't allocate memory inside the library.
+     *
+     * Requests that are not in the snapshot (explicit run, variation or time, tables that were
+     * not loaded before Freeze) go the usual way and are counted by @see GetFrozenMisses.
+     * Calling Freeze() again publishes a new snapshot with tables loaded since the previous one.
+     *
+     * @remark A replaced snapshot is deleted by the next Freeze or Unfreeze that finds no lookups
+     *         in progress, so repeated Freeze/Unfreeze don't accumulate snapshots.
+     *         Assignments taken from a snapshot stay valid while they are held.
+     */
+    void Freeze();
+
+    /** @brief Stops serving requests from the frozen snapshot. @see Freeze */
+    void Unfreeze();
+
+    /** @brief true if requests are served from the frozen snapshot. @see Freeze */
+    bool IsFrozen() const { return mFrozen.load() != NULL; }
+
+    /** @brief Number of requests that were not found in the frozen snapshot and went the slow way */
+    unsigned long GetFrozenMisses() const { return mFrozenMisses.load(); }
+
+    /** @brief Reads the database through a pool of connections
+     *
+     * By default all database reads of the Calibration go one by one through one provider.
+     * With a pool, cache misses and Prefetch of different threads take their own
+     * connections (@see DataProviderPool), so independent tables are loaded in parallel.
+     * Connections are opened when needed, up to poolSize, and follow the connection of the main provider.
+     *
+     * @remark The pool is created or removed (poolSize 0) before the Calibration is used by several threads.
+     *         Resizing an existing pool is safe at any time
+     * @exception logic_error if the calibration can't create providers for the pool (@see CreateProvider)
+     *
+     * @param poolSize maximum number of pooled connections. 0 - don't use the pool (default)
+     */
+    void SetPoolSize(size_t poolSize);
+
+    /** @brief Maximum number of pooled connections. 0 if the pool is not used. @see SetPoolSize */
+    size_t GetPoolSize() const { return mPool ? mPool->GetMaxSize() : 0; }
+
+    /** @brief The pool of connections or NULL if the pool is not used. @see SetPoolSize */
+    DataProviderPool* GetProviderPool() const { return mPool.get(); }
+
+    /** @brief Closes pooled connections that were idle longer than maxIdleTime seconds
+     *
+     * Is called by @see CalibrationGenerator::UpdateInactivity
+     * @return number of closed connections
+     */
+    size_t ReapIdleConnections(time_t maxIdleTime) { return mPool ? mPool->ReapIdle(maxIdleTime) : 0; }
+
 protected:
 
 
@@ -298,20 +621,123 @@ protected:
      */
     void UpdateActivityTime();
 
+    /** @brief Parses namepath and fills not given run, variation and time with default values
+     *
+     * @parameter [in] namepath - full namepath is /path/to/data:run:variation:time
+     * @return   parse result with absolute path
+     */
+    RequestParseResult ParseRequest(const string& namepath) const;
+
+    /** @brief Creates not connected provider of the calibration type for the connection pool
+     * @return new provider or NULL if the calibration doesn't support the pool
+     */
+    virtual DataProvider* CreateProvider() { return NULL; }
+
     DataProvider *mProvider;         /// Underlaid DataProvider object
     bool mProviderIsLocked;          /// If provider
     int mDefaultRun;                 /// Default run number
     string mDefaultVariation;        /// Default variation
     time_t mDefaultTime;             /// Set default time
-    time_t mLastActivityTime;        /// Time of the last request
+    std::atomic<time_t> mLastActivityTime; /// Time of the last request
     bool mIsAutoReconnect;           /// Try to auto-reconnect if possible
     bool mIsCacheEnabled;            /// If true the data is cached
 
-    std::mutex mReadMutex;
+    std::mutex mReadMutex;           /// Serializes provider access
+    std::unique_ptr<DataProviderPool> mPool; /// Pooled connections for parallel reads or NULL. @see SetPoolSize
+    AssignmentCache mCache;          /// Cached assignments
+
+    std::mutex mLoadsMutex;          /// Guards mLoads
+    std::map<string, std::shared_future<void> > mLoads; /// Cache misses being loaded now by request key
+
+    /** Immutable set of assignments published by Freeze() */
+    struct FrozenSnapshot
+    {
+        typedef std::unordered_map<string, std::shared_ptr<Assignment> > Assignments;
+        Assignments ByPath[2];       /// [with columns] namepath => assignment
+    };
+    std::atomic<FrozenSnapshot*> mFrozen;                      /// Current snapshot or NULL if not frozen
+    std::atomic<unsigned long> mFrozenReaders;                  /// Lookups in the snapshot being done now
+    std::vector<std::unique_ptr<FrozenSnapshot> > mSnapshots;   /// Current and replaced snapshots that are not deleted yet. Guarded by mWarmPathsMutex
+    std::mutex mWarmPathsMutex;                                 /// Guards mWarmPaths and mSnapshots
+    std::map<string, bool> mWarmPaths;                          /// Paths loaded with defaults => with columns
+    std::atomic<unsigned long> mFrozenMisses;                   /// Requests not found in the snapshot
+
+    std::mutex mInternMutex;                    /// Guards interned paths and variations
+    std::deque<string> mInternedPaths;          /// Path id => path
+    std::deque<string> mInternedVariations;     /// Variation id => variation name
+    std::unordered_map<string, int> mPathIds;       /// Path => id
+    std::unordered_map<string, int> mVariationIds;  /// Variation name => id
+    std::atomic<unsigned long> mCacheGeneration;    /// Is changed when handles should fetch assignments again
+
+    std::mutex mIOExecutorMutex;                /// Guards creation of mIOExecutor
+    std::unique_ptr<IOExecutor> mIOExecutor;    /// Threads of asynchronous requests. Is created on the first request
+    size_t mIOThreads;                          /// Maximum number of threads of mIOExecutor
+
+    std::mutex mChangeCheckMutex;               /// One check for changes at a time. Guards mChangeMark and mChangeStats
+    ChangeMark mChangeMark;                     /// State of the database at the last check
+    bool mHasChangeMark;                        /// mChangeMark is taken
+    ChangeCheckStats mChangeStats;
+    std::atomic<time_t> mChangeCheckInterval;   /// Seconds between checks, 0 - not checked
+    std::atomic<time_t> mNextChangeCheck;       /// Monotonic time of the next check
+    std::mutex mInvalidationMutex;              /// Loaded data is put to the cache and changed tables are dropped one at a time
+
+    std::mutex mHeldAssignmentsMutex;           /// Guards mHeldAssignments
+    std::unordered_map<string, std::shared_ptr<Assignment> > mHeldAssignments; /// Assignments given by GetAssignment by assignment key
 private:
     Calibration(const Calibration& rhs);
     Calibration& operator=(const Calibration& rhs);
     void CheckConnection(); /// Check if is connected and reconnect if needed (and allowed)
+
+    /** Provider for one database read: a pooled connection of the calling thread if the pool is used
+     *  and connects, otherwise the main provider locked by mReadMutex */
+    class ProviderLease
+    {
+    public:
+        explicit ProviderLease(Calibration& owner);
+        ~ProviderLease();
+        DataProvider* Get() const { return mProvider; }
+        DataProvider* operator->() const { return mProvider; }
+    private:
+        ProviderLease(const ProviderLease& rhs);
+        ProviderLease& operator=(const ProviderLease& rhs);
+        Calibration& mOwner;
+        DataProvider* mProvider;
+        bool mIsPooled;
+    };
+
+    /** Finds assignment in the frozen snapshot or loads it. Returns reference to 'loaded' that holds the result */
+    const std::shared_ptr<Assignment>& FindOrLoadAssignment(const string& namepath, bool loadColumns, std::shared_ptr<Assignment>& loaded);
+
+    /** Deletes replaced snapshots if no lookup is in progress. mWarmPathsMutex must be locked */
+    void DeleteReplacedSnapshots();
+
+    /** Gets assignment through the cache or from provider if the cache is disabled */
+    std::shared_ptr<Assignment> LoadSharedAssignment(const string& namepath, bool loadColumns);
+
+    /** The same for parsed request. runMin and runMax (if not NULL) receive the run interval of the result */
+    std::shared_ptr<Assignment> LoadSharedAssignment(const RequestParseResult& request, bool loadColumns, int* runMin, int* runMax);
+
+    /** Returns the assignment remembered by the handle or fetches it and remembers */
+    const std::shared_ptr<Assignment>& FindOrLoadAssignment(CalibHandle& handle, bool loadColumns);
+
+    /** Cache keys of the request. The request without run and the assignment itself */
+    static string MakeRequestKey(const RequestParseResult& request, bool loadColumns);
+    static string MakeAssignmentKey(const RequestParseResult& request, Assignment* assignment, bool loadColumns);
+
+    /** Remembers tables requested for the defaults for Freeze() */
+    void RememberWarmPath(const RequestParseResult& request, bool loadColumns);
+
+    /** Gets id of the interned string. Adds the string if it is not interned yet. mInternMutex must be locked */
+    static int Intern(const string& value, std::deque<string>& strings, std::unordered_map<string, int>& ids);
+
+    /** Checks the database for changes if the check interval is over. @see SetChangeCheckInterval */
+    void CheckForChangesIfDue();
+
+    /** Gets the executor of asynchronous requests. Creates it on the first call */
+    IOExecutor& GetIOExecutor();
+
+    /** Loads assignment from the provider. If detach is true the provider doesn't own the result. The provider must be leased */
+    Assignment* LoadAssignment(DataProvider* provider, const RequestParseResult& request, bool loadColumns, bool detach);
 };
 
 }
@@ -2,9 +2,14 @@
 #define __CCDB_CONSTANTS_TABLE_H__
 
 #include <algorithm>
+#include <map>
+#include <memory>
 #include <string>
 #include <sstream>
 #include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
 
 #include "CCDB/MySQLCalibration.h"
 
@@ -20,12 +25,38 @@ using std::vector;
  *  is called. Columns can be accessed (and converted to specific
  *  types) by the col(colname) method. Individual numbers can be
  *  obtained via the elem<typename>(colname, row_index) method.
+ *
+ *  The cells are converted to the column types once, when the
+ *  constants are loaded. Numeric columns are kept as arrays of
+ *  numbers, so elem(), col() and row() read memory instead of
+ *  parsing strings. Column names are found through a hash index.
+ *
+ *  NOTE: row() builds its index on the first call for a column,
+ *  so a table should not be shared between threads without a lock.
  **/
 class ConstantsTable
 {
   private:
-    /// the table as filled by MySQLCalibration::GetCalib()
-    vector<vector<string> > values;
+    /// one column of the table as it is kept after loading
+    struct column_data
+    {
+        /// how the values of the column are kept
+        enum kinds { real_kind, integer_kind, text_kind };
+
+        column_data(): kind(text_kind), is_unsigned(false) {}
+
+        kinds kind;                 ///< double, integer or string (also numeric columns with bad cells)
+        bool is_unsigned;           ///< ulong column, integers are kept bit by bit
+        vector<double> reals;       ///< values of double columns
+        vector<long> integers;      ///< values of int, uint, long, ulong and bool columns
+        vector<string> texts;       ///< the cells as they are in the database
+    };
+
+    /// the table by columns
+    vector<column_data> data;
+
+    /// number of rows
+    unsigned int rows_count;
 
     /// the names of the columns
     vector<string> columns;
@@ -33,16 +64,33 @@ class ConstantsTable
     /// the types of the columns in string form
     vector<string> column_types;
 
+    /// column name -> column index
+    std::unordered_map<string, unsigned int> column_index;
+
+    /// integer value -> first row with it, per column. Built by row() on the first call
+    vector<std::unordered_map<long, unsigned int> > integer_rows;
+
+    /// cell text -> first row with it, per column. Built by row() on the first call
+    vector<std::unordered_map<string, unsigned int> > text_rows;
+
+    /// key columns set by index_by() and the sorted index of their values
+    vector<unsigned int> key_columns;
+    std::map<vector<long>, unsigned int> key_rows;
+
     /** \brief find the index of the column associated with the name
      *  colname.
      *
-     * \return column index of the column identified by colname
+     * \return column index of the column identified by colname.
+     *  throws std::out_of_range if there is no such column
      **/
     unsigned int find_column(const string& colname)
     {
-        return distance(
-            columns.begin(),
-            find(columns.begin(), columns.end(), colname) );
+        std::unordered_map<string, unsigned int>::const_iterator it = column_index.find(colname);
+        if (it == column_index.end())
+        {
+            throw std::out_of_range("No such column: " + colname);
+        }
+        return it->second;
     }
 
     /** \brief generic function to convert a string to any type (T)
@@ -61,9 +109,116 @@ class ConstantsTable
         return ret;
     }
 
+    /** \brief the cell converted to T. Numbers are taken from the typed
+     *  arrays, only string columns are converted on each call
+     **/
+    template <typename T>
+    T cell(const column_data& column, unsigned int row, std::true_type /*is_arithmetic*/)
+    {
+        switch (column.kind)
+        {
+        case column_data::real_kind:
+            return static_cast<T>(column.reals.at(row));
+        case column_data::integer_kind:
+            if (column.is_unsigned)
+            {
+                return static_cast<T>(static_cast<unsigned long>(column.integers.at(row)));
+            }
+            return static_cast<T>(column.integers.at(row));
+        default:
+            return lexical_cast<T>(column.texts.at(row));
+        }
+    }
+
+    template <typename T>
+    T cell(const column_data& column, unsigned int row, std::false_type /*is_arithmetic*/)
+    {
+        return lexical_cast<T>(column.texts.at(row));
+    }
+
+    template <typename T>
+    T cell(unsigned int col_index, unsigned int row)
+    {
+        return cell<T>(data.at(col_index), row, std::is_arithmetic<T>());
+    }
+
+    /** \brief finds the first row of the column with the value
+     *
+     * Whole numbers in integer columns are looked up in a hash index,
+     * other columns are scanned.
+     **/
+    template <typename T>
+    bool find_row(unsigned int col_index, const T& val, unsigned int& row, std::true_type /*is_arithmetic*/)
+    {
+        const column_data& column = data.at(col_index);
+        if (column.kind == column_data::integer_kind && !column.is_unsigned)
+        {
+            /// the value may be equal to a cell only if it is a whole number
+            long key = static_cast<long>(val);
+            if (static_cast<T>(key) != val) return false;
+
+            std::unordered_map<long, unsigned int>& index = integer_rows[col_index];
+            if (index.empty())
+            {
+                for (unsigned int i=0; i<rows_count; i++)
+                {
+                    index.insert(std::make_pair(column.integers[i], i));
+                }
+            }
+
+            std::unordered_map<long, unsigned int>::const_iterator it = index.find(key);
+            if (it == index.end()) return false;
+            row = it->second;
+            return true;
+        }
+
+        for (unsigned int i=0; i<rows_count; i++)
+        {
+            if (cell<T>(column, i, std::true_type()) == val)
+            {
+                row = i;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    template <typename T>
+    bool find_row(unsigned int col_index, const T& val, unsigned int& row, std::false_type /*is_arithmetic*/)
+    {
+        const column_data& column = data.at(col_index);
+        for (unsigned int i=0; i<rows_count; i++)
+        {
+            if (lexical_cast<T>(column.texts[i]) == val)
+            {
+                row = i;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool find_row(unsigned int col_index, const string& val, unsigned int& row, std::false_type /*is_arithmetic*/)
+    {
+        const column_data& column = data.at(col_index);
+        std::unordered_map<string, unsigned int>& index = text_rows[col_index];
+        if (index.empty())
+        {
+            for (unsigned int i=0; i<rows_count; i++)
+            {
+                index.insert(std::make_pair(column.texts[i], i));
+            }
+        }
+
+        std::unordered_map<string, unsigned int>::const_iterator it = index.find(val);
+        if (it == index.end()) return false;
+        row = it->second;
+        return true;
+    }
+
   public:
 
-    ConstantsTable() {}
+    ConstantsTable(): rows_count(0) {}
 
     /** \brief combines the user, host and such into the MySQL connection
      * string used by MySQLCalibration::Connect().
@@ -92,9 +247,15 @@ class ConstantsTable
      **/
     void clear()
     {
-        values.clear();
+        data.clear();
+        rows_count = 0;
         columns.clear();
         column_types.clear();
+        column_index.clear();
+        integer_rows.clear();
+        text_rows.clear();
+        key_columns.clear();
+        key_rows.clear();
     }
 
     /** \brief connects to the MySQL (CCDB) database and obtains the
@@ -104,8 +265,6 @@ class ConstantsTable
         const string& constsetid_str,
         const string& conn_str = "" )
     {
-        this->clear();
-
         string conn;
         if (conn_str == "")
         {
@@ -121,9 +280,82 @@ class ConstantsTable
         MySQLCalibration calib(100);
         calib.Connect(conn);
 
-        calib.GetCalib(values, constsetid_str);
-        columns = calib.GetAssignment(constsetid_str)->GetTypeTable()->GetColumnNames();
-        column_types = calib.GetAssignment(constsetid_str)->GetTypeTable()->GetColumnTypeStrings();
+        load_constants(constsetid_str, calib);
+    }
+
+    /** \brief obtains the data, the column names, and their types
+     * through already connected calibration (MySQL or SQLite).
+     *
+     * throws std::logic_error if there are no such constants
+     **/
+    void load_constants(const string& constsetid_str, Calibration& calib)
+    {
+        std::shared_ptr<Assignment> assignment = calib.GetSharedAssignment(constsetid_str);
+        if (!assignment)
+        {
+            throw std::logic_error("No constants: " + constsetid_str);
+        }
+        load(*assignment);
+    }
+
+    /** \brief fills the table from the loaded assignment. The cells
+     * are converted to the column types here, once.
+     *
+     * A numeric column with a cell which is not a number is kept as
+     * strings and converted on access (as the cell can't be read anyway).
+     **/
+    void load(const Assignment& assignment)
+    {
+        this->clear();
+
+        ConstantsTypeTable* table = assignment.GetTypeTable();
+        columns = table->GetColumnNames();
+        column_types = table->GetColumnTypeStrings();
+
+        vector<vector<string> > values;
+        assignment.GetData(values);
+        rows_count = values.size();
+
+        unsigned int cols_count = columns.size();
+        const vector<TypedColumn>& typed = assignment.GetTypedColumns();
+        bool has_types = typed.size() == cols_count;
+
+        data.resize(cols_count);
+        integer_rows.resize(cols_count);
+        text_rows.resize(cols_count);
+        for (unsigned int col_index=0; col_index<cols_count; col_index++)
+        {
+            column_index[columns[col_index]] = col_index;
+
+            column_data& column = data[col_index];
+            column.texts.resize(rows_count);
+            for (unsigned int row_index=0; row_index<rows_count; row_index++)
+            {
+                column.texts[row_index] = values[row_index][col_index];
+            }
+
+            if (!has_types || typed[col_index].ParseErrors > 0) continue;
+
+            const TypedColumn& source = typed[col_index];
+            switch (source.Type)
+            {
+            case ConstantsTypeColumn::cDoubleColumn:
+                column.kind = column_data::real_kind;
+                column.reals = source.Doubles;
+                break;
+            case ConstantsTypeColumn::cBoolColumn:
+                column.kind = column_data::integer_kind;
+                column.integers.assign(source.Bools.begin(), source.Bools.end());
+                break;
+            case ConstantsTypeColumn::cStringColumn:
+                break;
+            default:
+                column.kind = column_data::integer_kind;
+                column.is_unsigned = source.Type == ConstantsTypeColumn::cULongColumn;
+                column.integers = source.Integers;
+                break;
+            }
+        }
     }
 
     /** \return number of rows in this data set.
@@ -131,7 +363,7 @@ class ConstantsTable
      **/
     unsigned int nrows()
     {
-        return values.size();
+        return rows_count;
     }
 
     /** \return number of columns in this data set.
@@ -141,7 +373,7 @@ class ConstantsTable
     {
         if (this->nrows() > 0)
         {
-            return values.at(0).size();
+            return data.size();
         }
         else
         {
@@ -157,6 +389,15 @@ class ConstantsTable
         return columns.at(i);
     }
 
+    /** \return the index of the column identified by colname.
+     *
+     * Can be taken once and used with elem(col_index, row) in loops
+     **/
+    unsigned int colindex(const string& colname)
+    {
+        return find_column(colname);
+    }
+
     /** \return the column type of the ith column
      *
      **/
@@ -188,13 +429,13 @@ class ConstantsTable
     template <typename T=double>
     vector<T> col(const string& colname)
     {
-        vector<T> ret;
-
         unsigned int col_index = find_column(colname);
 
-        for (int row_index=0; row_index<nrows(); row_index++)
+        vector<T> ret;
+        ret.reserve(rows_count);
+        for (unsigned int row_index=0; row_index<rows_count; row_index++)
         {
-            ret.push_back(lexical_cast<T>(values.at(row_index).at(col_index)));
+            ret.push_back(cell<T>(col_index, row_index));
         }
 
         return ret;
@@ -223,8 +464,18 @@ class ConstantsTable
     template <typename T=double>
     T elem(const string& colname, const unsigned int& row=0)
     {
-        return lexical_cast<T>(
-            values.at(row).at(find_column(colname)) );
+        return cell<T>(find_column(colname), row);
+    }
+
+    /** \brief the same as elem(colname, row) with the column index
+     * taken from colindex(). No lookup by name at all.
+     *
+     *  \return element of the table cast to type T (default: double)
+     **/
+    template <typename T=double>
+    T elem(const unsigned int& col_index, const unsigned int& row)
+    {
+        return cell<T>(col_index, row);
     }
 
     /** \brief find the first row of a specified column that has a
@@ -233,6 +484,8 @@ class ConstantsTable
      * NOTE: getting the row index works for integers but
      * not for floats!!! Use only integers or strings. The
      * "string for floats" usage is OK, but not recommended.
+     * Integer and string values are found by a hash index
+     * which is built on the first call for the column.
      *
      * example:
      *   table.row("dist2tgt", "348.09")
@@ -242,12 +495,10 @@ class ConstantsTable
     template <typename T>
     unsigned int row(const string& colname, const T& val)
     {
-        for (unsigned int i=0; i<nrows(); i++)
+        unsigned int row_index;
+        if (find_row(find_column(colname), val, row_index, std::is_arithmetic<T>()))
         {
-            if (elem<T>(colname,i) == val)
-            {
-                return i;
-            }
+            return row_index;
         }
         stringstream ss;
         ss << "No such value: " << val << " in column " << colname;
@@ -262,8 +513,74 @@ class ConstantsTable
         return row<string>(colname, string(val));
     }
 
+    /** \brief builds a sorted index on the key columns, for
+     * example sector, layer and component. The columns have to be
+     * integer columns. If several rows have the same key, the first
+     * one is indexed.
+     *
+     * example:
+     *   table.index_by({"sector", "layer", "component"});
+     *   table.elem("pedestal", table.row({2, 1, 15}));
+     **/
+    void index_by(const vector<string>& colnames)
+    {
+        key_columns.clear();
+        key_rows.clear();
+        for (size_t i=0; i<colnames.size(); i++)
+        {
+            unsigned int col_index = find_column(colnames[i]);
+            if (data[col_index].kind != column_data::integer_kind)
+            {
+                throw std::logic_error("Key column is not an integer column: " + colnames[i]);
+            }
+            key_columns.push_back(col_index);
+        }
+
+        vector<long> key(key_columns.size());
+        for (unsigned int row_index=0; row_index<rows_count; row_index++)
+        {
+            for (size_t i=0; i<key_columns.size(); i++)
+            {
+                key[i] = data[key_columns[i]].integers[row_index];
+            }
+            key_rows.insert(std::make_pair(key, row_index));
+        }
+    }
+
+    /** \brief finds the row by the values of the key columns set
+     * by index_by(), in the same order.
+     *
+     * \return row index associated with the key
+     **/
+    unsigned int row(const vector<long>& key)
+    {
+        if (key.size() != key_columns.size())
+        {
+            throw std::logic_error("The key doesn't match the key columns set by index_by()");
+        }
+
+        std::map<vector<long>, unsigned int>::const_iterator it = key_rows.find(key);
+        if (it == key_rows.end())
+        {
+            stringstream ss;
+            ss << "No such key:";
+            for (size_t i=0; i<key.size(); i++) ss << " " << key[i];
+            throw std::logic_error(ss.str());
+        }
+        return it->second;
+    }
+
 };
 
+/** \brief strings are returned as they are in the database
+ *
+ **/
+template <>
+inline string ConstantsTable::cell<string>(unsigned int col_index, unsigned int row)
+{
+    return data.at(col_index).texts.at(row);
+}
+
 } /* namespace ccdb */
 
 #endif /* __CCDB_CONSTANTS_TABLE_H__ */
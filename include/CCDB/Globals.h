@@ -13,12 +13,35 @@ typedef int dbkey_t;
 //This constant represent the delimeter that is used to separate stringified data inside database blob
 #define CCDB_DATA_BLOB_DELIMETER "|"
 
+//Binary typed data blob starts with this prefix. The format is (@see Assignment::VectorToBlob)
+//#ccdb-bin:<version>:<rows>:<column type codes>:<base64 of little-endian typed arrays, column by column>
+#define CCDB_BINARY_BLOB_PREFIX "#ccdb-bin:"
+#define CCDB_BINARY_BLOB_VERSION 1
+
+//Compressed data blob starts with this prefix. The format is (@see Assignment::CompressBlob)
+//#ccdb-z:<version>:<size of the blob>:<base64 of zlib stream of the text or binary blob>
+#define CCDB_COMPRESSED_BLOB_PREFIX "#ccdb-z:"
+#define CCDB_COMPRESSED_BLOB_VERSION 1
+
+//Blobs shorter than this are not compressed, the gain is not worth the decompression
+#define CCDB_COMPRESSED_BLOB_MIN_SIZE 1024
+
 //name of @default variation
 #define CCDB_DEFAULT_VARIATION_NAME "default"
 
 //name of run range that holds all pssible ranges [0,INFINITE_RUN]
 #define CCDB_ALL_RUNRANGE_NAME "all"
 
+//default memory budget (in bytes) of the assignments cache of one Calibration object
+#define CCDB_DEFAULT_CACHE_MEMORY_LIMIT (256UL*1024UL*1024UL)
+
+//default maximum number of threads that serve asynchronous requests of one Calibration object
+#define CCDB_DEFAULT_IO_THREADS 2
+
+//number of variations of a chain (variation, parent, grandparent...) resolved by one assignment query.
+//Longer chains take one more query for each next part of the chain
+#define CCDB_VARIATION_CHAIN_QUERY_DEPTH 8
+
 /*----------------------------------------------------------------------------------------------------
  *  E R R O R   C O D E S 
  * -------------------------------------------------------------------------------------------------*/
@@ -140,6 +163,9 @@ typedef int dbkey_t;
 //ASSIGMEN is NULL or has improper ID so update operations cant be done
 #define CCDB_ERROR_DATA_INCONSISTANT 1280
 
+//Compressed data blob read from the database can't be decompressed
+#define CCDB_ERROR_VAULT_DECOMPRESS 1290
+
 /*----------------------------------------------------------------------------------------------------
  *  SYSTEM DEFINE
  * -------------------------------------------------------------------------------------------------*/
@@ -267,6 +267,54 @@ public:
     static double           ParseDouble(const string& source, bool *result=NULL );      ///Reads double from the last query row
     static string           ParseString(const string& source, bool *result=NULL );      ///Reads string from the last query row
     static time_t           ParseUnixTime(const string& source, bool *result=NULL );    ///Reads string from the last query row
+
+    /** @brief Parses number from chars [begin, end) without making a string
+     *
+     * Leading and trailing blanks are skipped. Doubles are correctly rounded:
+     * short decimals are converted exactly in a fast path, the rest goes to strtod.
+     * Integers that don't fit the type get the nearest limit.
+     *
+     * @param [in]  begin - first char
+     * @param [in]  end   - char after the last one
+     * @param [out] value - parsed value. If the range is not a number, the number from
+     *                      the beginning of the range (or 0) as atof and atoi give
+     * @return true if the whole range is a number of the type
+     */
+    static bool ParseInt(const char* begin, const char* end, int& value);
+    static bool ParseUInt(const char* begin, const char* end, unsigned int& value);
+    static bool ParseLong(const char* begin, const char* end, long& value);
+    static bool ParseULong(const char* begin, const char* end, unsigned long& value);
+    static bool ParseBool(const char* begin, const char* end, bool& value);
+    static bool ParseDouble(const char* begin, const char* end, double& value);
+
+    /** @brief Parses all cells of a blob in one pass
+     *
+     * Cells are separated by the delimiter, empty cells are skipped as Split does
+     *
+     * @param [in]  begin     - first char of the blob
+     * @param [in]  end       - char after the last one
+     * @param [in]  delimiter - cells delimiter, like '|'
+     * @param [out] values    - parsed cells are appended here
+     * @return number of cells that are not numbers (@see ParseDouble(const char*, const char*, double&))
+     */
+    static size_t ParseDoubles(const char* begin, const char* end, char delimiter, vector<double>& values);
+
+    /** @brief Encodes bytes to base64 text (standard alphabet with '=' padding)
+     *
+     * @param [in]  data - bytes to encode
+     * @param [in]  size - number of bytes
+     * @return base64 text
+     */
+    static string Base64Encode(const char* data, size_t size);
+
+    /** @brief Decodes base64 text made by Base64Encode
+     *
+     * @param [in]  begin  - first char of the text
+     * @param [in]  end    - char after the last one
+     * @param [out] result - decoded bytes
+     * @return false if the text is not a valid base64
+     */
+    static bool Base64Decode(const char* begin, const char* end, string& result);
 };
 }
 #endif // StringUtils_h__
@@ -0,0 +1,98 @@
+#ifndef DIOExecutor_h
+#define DIOExecutor_h
+
+#include <vector>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <type_traits>
+
+#include "CCDB/Globals.h"
+
+namespace ccdb
+{
+
+/** @brief Accounting information of IOExecutor */
+struct IOExecutorStats
+{
+    size_t Threads;             ///< Number of running threads
+    size_t Queued;              ///< Number of tasks waiting for a thread
+    unsigned long Executed;     ///< Number of finished tasks
+};
+
+
+/** @brief Small pool of threads that run database reads in background
+ *
+ * Tasks are run in the order they are submitted. Threads are started when
+ * there are tasks and no idle threads, up to the maximum number of threads.
+ * @see Calibration::GetCalibAsync
+ *
+ * @warning a task must not wait for the result of another task of the same executor:
+ *          if all threads wait, nobody runs the awaited task
+ */
+class IOExecutor
+{
+public:
+
+    /** @brief Ctor
+     *
+     * @param [in] maxThreads - maximum number of threads, at least 1
+     */
+    explicit IOExecutor(size_t maxThreads);
+
+    /** @brief Dtor waits for running tasks. Tasks that are not started are dropped,
+     *  their futures report std::future_error (broken promise)
+     */
+    virtual ~IOExecutor();
+
+    /** @brief Runs the task in background
+     *
+     * @param [in] task - callable without arguments
+     * @return future of the task result. An exception thrown by the task is rethrown by future::get
+     */
+    template<typename Task>
+    std::future<typename std::result_of<Task()>::type> Submit(Task task)
+    {
+        typedef typename std::result_of<Task()>::type Result;
+        std::shared_ptr<std::packaged_task<Result()> > packaged = std::make_shared<std::packaged_task<Result()> >(task);
+        std::future<Result> result = packaged->get_future();
+        Post([packaged]() { (*packaged)(); });
+        return result;
+    }
+
+    /** @brief Maximum number of threads. If reduced, the extra threads stop when they are idle */
+    void SetMaxThreads(size_t maxThreads);
+    size_t GetMaxThreads();
+
+    /** @brief Gets counts of threads, queued and finished tasks */
+    IOExecutorStats GetStats();
+
+private:
+    IOExecutor(const IOExecutor& rhs);
+    IOExecutor& operator=(const IOExecutor& rhs);
+
+    /** Queues the task and starts a thread if all threads are busy */
+    void Post(std::function<void()> task);
+
+    /** Runs tasks until the executor stops or the thread is extra */
+    void Work();
+
+    size_t mMaxThreads;
+    size_t mRunningThreads;                     /// Threads that are not stopped
+    size_t mIdleThreads;                        /// Threads that wait for tasks
+    bool mIsStopping;
+    std::deque<std::function<void()> > mTasks;
+    std::vector<std::thread> mThreads;          /// All started threads, stopped are joined in dtor
+    unsigned long mExecuted;
+
+    std::mutex mMutex;                          /// Guards all members
+    std::condition_variable mTaskAdded;         /// Notified when a task is added or the threads should stop
+};
+
+}
+
+#endif // DIOExecutor_h
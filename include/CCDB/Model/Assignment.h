@@ -7,11 +7,16 @@
 
 #include <vector>
 #include <map>
+#include <mutex>
+#include <atomic>
+#include <memory>
 
 #include "CCDB/Model/StoredObject.h"
 #include "CCDB/Model/ObjectsOwner.h"
 #include "CCDB/Model/ConstantsTypeTable.h"
 #include "CCDB/Model/ConstantsTypeColumn.h"
+#include "CCDB/Model/TypedColumn.h"
+#include "CCDB/Model/AssignmentData.h"
 #include "CCDB/Helpers/StringUtils.h"
 
 using namespace std;
@@ -51,6 +56,49 @@ public:
 	 */
 	static string VectorToBlob(const vector<string>& values);
 
+	/**
+	 * @brief makes a binary typed blob from tokens
+	 *
+	 * Values are converted to the column types and stored as little-endian arrays,
+	 * column by column, encoded with base64 (vault columns are text).
+	 * The header keeps the format version, number of rows and column types.
+	 * If a value can't be converted to its column type or the number of values
+	 * is not a multiple of the number of columns, the text blob is made instead
+	 *
+	 * @param     const vector<string> & values - cells row by row
+	 * @param     types - types of the columns
+	 * @return   std::string
+	 */
+	static string VectorToBlob(const vector<string>& values, const vector<ConstantsTypeColumn::ColumnTypes>& types);
+
+	/** @brief true if the blob is in binary typed format (@see VectorToBlob) */
+	static bool IsBinaryBlob(const string& blob);
+
+	/** @brief Compresses text or binary blob with zlib
+	 *
+	 * The compressed blob keeps the size of the original blob and its zlib stream
+	 * encoded with base64 (vault columns are text). Providers decompress it
+	 * before SetRawData (@see DataProvider::DecompressVault).
+	 * Blobs shorter than CCDB_COMPRESSED_BLOB_MIN_SIZE, already compressed blobs
+	 * and blobs that don't get shorter are returned as they are
+	 *
+	 * @param     blob - text or binary blob
+	 * @param     level - zlib compression level 1-9
+	 * @return   std::string
+	 */
+	static string CompressBlob(const string& blob, int level = 6);
+
+	/** @brief true if the blob is compressed (@see CompressBlob) */
+	static bool IsCompressedBlob(const string& blob);
+
+	/** @brief Restores the blob compressed by CompressBlob
+	 *
+	 * @param [in]  blob   - compressed blob
+	 * @param [out] result - the original blob
+	 * @return false if the blob is not a valid compressed blob
+	 */
+	static bool DecompressBlob(const string& blob, string& result);
+
 	/** @brief Encodes blob separator
 	 *
 	 * if str contains '|' it will be replaced by '&pipe;'
@@ -101,8 +149,34 @@ public:
 	time_t	GetModifiedTime() const { return mModifiedTime;}   ///Time of last modification
     void	SetModifiedTime(time_t val) {mModifiedTime = val;} ///Time of last modification
 
-	string	GetRawData() const { return mRawData; }            ///Raw data blob
-	void	SetRawData(std::string val);					   ///Raw data blob
+	string	GetRawData() const { return mData->GetRawData(); }  ///Raw data blob
+
+	/** @brief Sets raw data blob
+	 *
+	 * The blob is tokenized in one pass: only offsets of the cells are remembered,
+	 * cell strings are made on demand. Cells with escaped separators are decoded here once.
+	 *
+	 * Binary blobs (@see VectorToBlob) are decoded right to typed columns,
+	 * cell strings are formatted from them only if they are requested.
+	 * A binary blob that can't be decoded is read as a text blob
+	 */
+	void	SetRawData(std::string val);
+
+	bool	IsBinaryData() const { return mData->IsBinaryData(); }  ///The data was set from a binary blob
+
+	/** @brief Sets data shared by the assignments with the same blob (@see ConstantSetCache)
+	 *
+	 * The data is not copied and must not be changed after this call.
+	 * The type table of the assignment should be set before, as typed columns
+	 * of the shared data are built by its column types. SetRawData or setting
+	 * another type table gives the assignment its own data again
+	 *
+	 * @param     data - parsed data of the blob
+	 */
+	void	SetSharedData(const std::shared_ptr<AssignmentData>& data);
+
+	/** @brief Parsed data of the assignment. It may be shared with other assignments */
+	std::shared_ptr<AssignmentData> GetAssignmentData() const { return mData; }
 
 	
 	/** @brief GetMappedData returns rows vector of maps of column_name => data_value
@@ -119,11 +193,41 @@ public:
 	 */
 	vector<vector<string> > GetData() const;
 	void GetData(vector<vector<string> > &data) const;
+
+	/** @brief Data converted to a type, row by row (cell [row][column] is at row*columns + column)
+	 *
+	 * Values are taken once on the first call from the typed columns (@see GetTypedColumns),
+	 * so they are the same as GetValue... and Calibration::GetCalib give. The next calls
+	 * return the same converted values. Without a type table the cells are parsed with
+	 * StringUtils::Parse... functions. The vector is a copy of the whole table,
+	 * it is kept with the data as long as the data lives
+	 *
+	 * @remark the functions are thread safe
+	 * @return   vector of all cells converted to the type
+	 */
+	const vector<double>& GetDoubleValues() const;
+	const vector<int>&    GetIntValues() const;
+	const vector<long>&   GetLongValues() const;
+	const vector<bool>&   GetBoolValues() const;
+
+	/** @brief Data as typed columns, one contiguous array per column
+	 *
+	 * Columns are built once on the first call from the blob, each by the type
+	 * of the type table column. If the type table has no columns loaded, all columns
+	 * are string columns. Values of string columns are interned, so equal strings
+	 * of the assignment are kept once. Columns of binary data are decoded by SetRawData
+	 * and have the types stored in the blob.
+	 *
+	 * @remark the function is thread safe
+	 * @return   columns in the order of the type table columns
+	 */
+	const vector<TypedColumn>& GetTypedColumns() const;
 	
 	std::string GetComment() const { return mComment;} ///Comment of assignment
 	void SetComment(std::string val) {mComment = val;} ///Comment of assignment
 	
-	void SetTypeTable(ConstantsTypeTable* typeTable) { this->mTypeTable = typeTable;}
+	void SetTypeTable(ConstantsTypeTable* typeTable);
+	void SetTypeTable(const std::shared_ptr<ConstantsTypeTable>& typeTable); ///Table shared with other assignments (@see TypeTableCache)
 	ConstantsTypeTable* GetTypeTable() const { return mTypeTable; }
 
 	string GetValue(size_t columnIndex);
@@ -131,35 +235,41 @@ public:
 	string GetValue(string columnName);
 	string GetValue(size_t rowIndex, string columnName);
 
-	int GetValueInt(size_t columnIndex) { return StringUtils::ParseInt(GetValue(columnIndex)); }
-	int GetValueInt(size_t rowIndex, size_t columnIndex) { return StringUtils::ParseInt(GetValue(rowIndex, columnIndex)); }
-	int GetValueInt(string columnName) { return StringUtils::ParseInt(GetValue(columnName)); }
-	int GetValueInt(size_t rowIndex, string columnName) { return StringUtils::ParseInt(GetValue(rowIndex, columnName)); }
+	/** @brief Values of cells converted to types
+	 *
+	 * All versions read the typed columns (@see GetTypedColumns, TypedColumn).
+	 * A cell given by columnIndex only is the cell with this index in the row by row order,
+	 * the same as GetValue(columnIndex) gives. A cell of unknown column name is read as an empty string
+	 */
+	int GetValueInt(size_t columnIndex)                  { return GetTypedValue<int>(columnIndex); }
+	int GetValueInt(size_t rowIndex, size_t columnIndex) { return GetTypedValue<int>(rowIndex, columnIndex); }
+	int GetValueInt(string columnName)                   { return GetTypedValue<int>(0, columnName); }
+	int GetValueInt(size_t rowIndex, string columnName)  { return GetTypedValue<int>(rowIndex, columnName); }
 	
-	unsigned int GetValueUInt(size_t columnIndex)                  { return StringUtils::ParseUInt(GetValue(columnIndex)); }
-	unsigned int GetValueUInt(size_t rowIndex, size_t columnIndex) { return StringUtils::ParseUInt(GetValue(rowIndex, columnIndex)); }
-	unsigned int GetValueUInt(string columnName)                   { return StringUtils::ParseUInt(GetValue(columnName)); }
-	unsigned int GetValueUInt(size_t rowIndex, string columnName)  { return StringUtils::ParseUInt(GetValue(rowIndex, columnName)); }
+	unsigned int GetValueUInt(size_t columnIndex)                  { return GetTypedValue<unsigned int>(columnIndex); }
+	unsigned int GetValueUInt(size_t rowIndex, size_t columnIndex) { return GetTypedValue<unsigned int>(rowIndex, columnIndex); }
+	unsigned int GetValueUInt(string columnName)                   { return GetTypedValue<unsigned int>(0, columnName); }
+	unsigned int GetValueUInt(size_t rowIndex, string columnName)  { return GetTypedValue<unsigned int>(rowIndex, columnName); }
 			   
-	double GetValueDouble(size_t columnIndex) { return StringUtils::ParseDouble(GetValue(columnIndex)); }
-	double GetValueDouble(size_t rowIndex, size_t columnIndex) { return StringUtils::ParseDouble(GetValue(rowIndex, columnIndex)); }
-	double GetValueDouble(string columnName) { return StringUtils::ParseDouble(GetValue(columnName)); }
-	double GetValueDouble(size_t rowIndex, string columnName) { return StringUtils::ParseDouble(GetValue(rowIndex, columnName)); }
+	double GetValueDouble(size_t columnIndex)                  { return GetTypedValue<double>(columnIndex); }
+	double GetValueDouble(size_t rowIndex, size_t columnIndex) { return GetTypedValue<double>(rowIndex, columnIndex); }
+	double GetValueDouble(string columnName)                   { return GetTypedValue<double>(0, columnName); }
+	double GetValueDouble(size_t rowIndex, string columnName)  { return GetTypedValue<double>(rowIndex, columnName); }
 			   
-	long GetValueLong(size_t columnIndex)                  { return StringUtils::ParseLong(GetValue(columnIndex)); }
-	long GetValueLong(size_t rowIndex, size_t columnIndex) { return StringUtils::ParseLong(GetValue(rowIndex, columnIndex)); }
-	long GetValueLong(string columnName)                   { return StringUtils::ParseLong(GetValue(columnName)); }
-	long GetValueLong(size_t rowIndex, string columnName)  { return StringUtils::ParseLong(GetValue(rowIndex, columnName)); }
+	long GetValueLong(size_t columnIndex)                  { return GetTypedValue<long>(columnIndex); }
+	long GetValueLong(size_t rowIndex, size_t columnIndex) { return GetTypedValue<long>(rowIndex, columnIndex); }
+	long GetValueLong(string columnName)                   { return GetTypedValue<long>(0, columnName); }
+	long GetValueLong(size_t rowIndex, string columnName)  { return GetTypedValue<long>(rowIndex, columnName); }
 			   
-	unsigned long GetValueULong(size_t columnIndex)                  { return StringUtils::ParseULong(GetValue(columnIndex)); }
-	unsigned long GetValueULong(size_t rowIndex, size_t columnIndex) { return StringUtils::ParseULong(GetValue(rowIndex, columnIndex)); }
-	unsigned long GetValueULong(string columnName)                   { return StringUtils::ParseULong(GetValue(columnName)); }
-	unsigned long GetValueULong(size_t rowIndex, string columnName)  { return StringUtils::ParseULong(GetValue(rowIndex, columnName)); }
+	unsigned long GetValueULong(size_t columnIndex)                  { return GetTypedValue<unsigned long>(columnIndex); }
+	unsigned long GetValueULong(size_t rowIndex, size_t columnIndex) { return GetTypedValue<unsigned long>(rowIndex, columnIndex); }
+	unsigned long GetValueULong(string columnName)                   { return GetTypedValue<unsigned long>(0, columnName); }
+	unsigned long GetValueULong(size_t rowIndex, string columnName)  { return GetTypedValue<unsigned long>(rowIndex, columnName); }
 			   
-	bool GetValueBool(size_t columnIndex)                  { return StringUtils::ParseBool(GetValue(columnIndex)); }
-	bool GetValueBool(size_t rowIndex, size_t columnIndex) { return StringUtils::ParseBool(GetValue(rowIndex, columnIndex)); }
-	bool GetValueBool(string columnName)                   { return StringUtils::ParseBool(GetValue(columnName)); }
-	bool GetValueBool(size_t rowIndex, string columnName)  { return StringUtils::ParseBool(GetValue(rowIndex, columnName)); }
+	bool GetValueBool(size_t columnIndex)                  { return GetTypedValue<bool>(columnIndex); }
+	bool GetValueBool(size_t rowIndex, size_t columnIndex) { return GetTypedValue<bool>(rowIndex, columnIndex); }
+	bool GetValueBool(string columnName)                   { return GetTypedValue<bool>(0, columnName); }
+	bool GetValueBool(size_t rowIndex, string columnName)  { return GetTypedValue<bool>(rowIndex, columnName); }
 
 	ConstantsTypeColumn::ColumnTypes GetValueType(size_t columnIndex) { return mTypeTable->GetColumns()[columnIndex]->GetType(); }
 	ConstantsTypeColumn::ColumnTypes GetValueType(const string& columnName);
@@ -169,10 +279,17 @@ public:
 
 	/** Gets number of columns */
 	size_t GetColumnsCount() const { return mTypeTable->GetColumnsCount(); }
+
+	/** @brief Estimates the amount of memory (in bytes) held by this object
+	 *
+	 * The estimation includes data blob, tokenized data and the owned type table.
+	 * Data shared by several assignments is divided between them.
+	 * It is used by caches to account their memory budget
+	 * @return   size_t approximate size in bytes
+	 */
+	size_t GetMemoryUsage() const;
 private:
 
-	vector<map<string,string> > mRows;	// cache for blob data by rows
-	string mRawData;					// data blob
 	int mId;							// id in database
 	int mDataBlobId;					// blob id in database
 	unsigned int mVariationId;			// database ID of variation
@@ -185,12 +302,39 @@ private:
 	EventRange *mEventRange;			// Event range object, is NULL if not set
 	Variation *mVariation;				// Variation object, is NULL if not set
 	ConstantsTypeTable * mTypeTable;	// Constants table
+	std::shared_ptr<ConstantsTypeTable> mSharedTypeTable; // Keeps mTypeTable alive if it is shared by assignments
 	
 	time_t mCreatedTime;				// time of creation
 	time_t mModifiedTime;				// time of last modification
 	string mComment;					// Comment of assignment
 
-	vector<string> mVectorData;         // Vectorized blob
+	std::shared_ptr<AssignmentData> mData;  // Data blob, its cells and typed values
+	bool mIsDataShared;                     // mData is shared with other assignments and must not be changed
+
+	/** Typed columns of the data are built by the new type table */
+	void OnTypeTableChanged(ConstantsTypeTable* oldTypeTable);
+
+	/** Index of the column by name or -1 if there is no such column */
+	int FindColumn(const string& columnName) const;
+
+	/** Value of the cell from the typed columns. @see GetValueInt */
+	template<typename T> T GetTypedValue(size_t rowIndex, size_t columnIndex)
+	{
+		return GetTypedColumns()[columnIndex].template Get<T>(rowIndex);
+	}
+
+	template<typename T> T GetTypedValue(size_t cellIndex)
+	{
+		size_t columnsCount = GetColumnsCount();
+		return GetTypedValue<T>(cellIndex / columnsCount, cellIndex % columnsCount);
+	}
+
+	template<typename T> T GetTypedValue(size_t rowIndex, const string& columnName)
+	{
+		//an empty cell is parsed to 0 (false) by all StringUtils::Parse... functions
+		int columnIndex = FindColumn(columnName);
+		return columnIndex < 0 ? T() : GetTypedValue<T>(rowIndex, static_cast<size_t>(columnIndex));
+	}
 
 	Assignment(const Assignment& rhs);	
 	Assignment& operator=(const Assignment& rhs);
@@ -0,0 +1,129 @@
+/*
+ * AssignmentData.h
+ */
+
+#ifndef _DAssignmentData_
+#define _DAssignmentData_
+
+#include <vector>
+#include <string>
+#include <mutex>
+#include <atomic>
+
+#include "CCDB/Model/ConstantsTypeTable.h"
+#include "CCDB/Model/ConstantsTypeColumn.h"
+#include "CCDB/Model/TypedColumn.h"
+
+namespace ccdb {
+
+/** @brief Data of a constant set: the blob, its cells and the values converted to types
+ *
+ * The blob is set once by SetRawData and is not changed after the data is shared.
+ * Typed values and columns are built once on the first request, so one object
+ * may be read by any number of threads and shared by all assignments that have
+ * the same blob and column types (@see ConstantSetCache)
+ */
+class AssignmentData
+{
+public:
+	AssignmentData();
+
+	/** @brief Sets raw data blob
+	 *
+	 * The blob is tokenized in one pass: only offsets of the cells are remembered,
+	 * cell strings are made on demand. Cells with escaped separators are decoded here once.
+	 *
+	 * Binary blobs (@see Assignment::VectorToBlob) are decoded right to typed columns,
+	 * cell strings are formatted from them only if they are requested.
+	 * A binary blob that can't be decoded is read as a text blob
+	 */
+	void SetRawData(std::string val);
+
+	const std::string& GetRawData() const { return mRawData; }    ///Raw data blob
+	bool IsBinaryData() const { return mIsBinaryData; }           ///The data was set from a binary blob
+
+	/** Gets number of cells in the blob */
+	size_t GetCellsCount() const;
+
+	/** Copies value of the cell to 'cell'. The buffer of 'cell' is reused if it is big enough */
+	void GetCell(size_t index, std::string& cell) const;
+
+	/** @brief Data converted to a type, row by row. @see Assignment::GetDoubleValues
+	 *
+	 * Values are taken from the typed columns (@see GetTypedColumns). Only if there are
+	 * no typed columns (text data without a type table) the cells are parsed one by one
+	 *
+	 * @remark the functions are thread safe
+	 * @param     table - type table of the data, may be NULL
+	 */
+	const std::vector<double>& GetDoubleValues(const ConstantsTypeTable* table) const;
+	const std::vector<int>&    GetIntValues(const ConstantsTypeTable* table) const;
+	const std::vector<long>&   GetLongValues(const ConstantsTypeTable* table) const;
+	const std::vector<bool>&   GetBoolValues(const ConstantsTypeTable* table) const;
+
+	/** @brief Data as typed columns. @see Assignment::GetTypedColumns
+	 *
+	 * The columns are built on the first call by the types of the table columns,
+	 * the next calls return the same columns whatever table is given
+	 *
+	 * @remark the function is thread safe
+	 * @param     table - type table of the data, may be NULL
+	 */
+	const std::vector<TypedColumn>& GetTypedColumns(const ConstantsTypeTable* table) const;
+
+	/** @brief Typed columns are built again on the next request (the type table is changed)
+	 *
+	 * @warning must not be called for shared data
+	 */
+	void ResetTypedColumns() { mIsTypedColumnsReady = mIsBinaryData; }
+
+	/** @brief Estimates the amount of memory (in bytes) held by this object */
+	size_t GetMemoryUsage() const;
+
+private:
+
+	std::string mRawData;                   // data blob
+
+	/** Cells of mRawData found by SetRawData. Offset of the cell in mRawData (the cell lasts to the next separator)
+	 * or, if kDecodedCell bit is set, index in mDecodedCells for cells with escaped separators */
+	mutable std::vector<unsigned int> mCells;
+	mutable std::vector<std::string> mDecodedCells;   // Decoded values of the cells with escaped separators
+	static const unsigned int kDecodedCell = 0x80000000u;
+
+	bool mIsBinaryData;                     // Data is set from a binary blob, typed columns are decoded by SetRawData
+	mutable std::atomic<bool> mIsCellsReady;// Cells of binary data are formatted on the first request
+
+	/** Decodes binary blob in mRawData to typed columns. false if the blob is not valid */
+	bool DecodeBinaryData();
+
+	/** Formats cells of binary data from typed columns if it is not done yet */
+	void PrepareCells() const;
+
+	/** Gets chars of the cell [begin, end) in mRawData or in mDecodedCells */
+	void GetCellRange(size_t index, const char*& begin, const char*& end) const;
+
+	template<typename T>
+	const std::vector<T>& GetTypedValues(const ConstantsTypeTable* table, std::vector<T>& values, std::atomic<bool>& isReady, bool (*parse)(const char*, const char*, T&)) const;
+
+	mutable std::vector<double> mDoubleValues;  // Data converted to double
+	mutable std::vector<int>    mIntValues;     // Data converted to int
+	mutable std::vector<long>   mLongValues;    // Data converted to long
+	mutable std::vector<bool>   mBoolValues;    // Data converted to bool
+	mutable std::atomic<bool> mIsDoubleValuesReady;
+	mutable std::atomic<bool> mIsIntValuesReady;
+	mutable std::atomic<bool> mIsLongValuesReady;
+	mutable std::atomic<bool> mIsBoolValuesReady;
+	mutable std::vector<TypedColumn> mTypedColumns;  // Data converted by column types
+	mutable std::vector<std::string> mInternedStrings;    // Values of string columns
+	mutable std::atomic<bool> mIsTypedColumnsReady;
+	mutable std::mutex mTypedValuesMutex;       // Guards conversion of typed values and columns
+
+	AssignmentData(const AssignmentData& rhs);
+	AssignmentData& operator=(const AssignmentData& rhs);
+
+	friend class TypedColumn;   // reads text of the cells
+};
+
+}
+
+#endif /* _DAssignmentData_ */
@@ -3,6 +3,7 @@
 
 #include <stdlib.h>
 #include <string>
+#include <atomic>
 
 
 using namespace std;
@@ -114,7 +115,7 @@ private:
 	unsigned long mTempId;	// This is actually UID, The unique Id during a program run. It is called Temp to emphasise that it has no buisness to Id in database
 
 
-	static unsigned long mLastTempId;	//Last given UID
+	static std::atomic<unsigned long> mLastTempId;	//Last given UID. Objects are created by providers of many threads
 
 };
 }
@@ -0,0 +1,109 @@
+/*
+ * TypedColumn.h
+ */
+
+#ifndef _DTypedColumn_
+#define _DTypedColumn_
+
+#include <vector>
+#include <string>
+#include <memory>
+
+#include "CCDB/Model/ConstantsTypeColumn.h"
+
+namespace ccdb {
+
+class AssignmentData;
+
+/** @brief Values of one column of assignment data converted to the column type
+ *
+ * Values are kept in one contiguous array chosen by the column type:
+ * double columns in Doubles, int, uint, long and ulong columns in Integers,
+ * bool columns in Bools and string columns as indexes of interned strings in StringIds.
+ *
+ * Getters of the column type return the stored value. Values of other types are parsed
+ * from the text of the cells with StringUtils::Parse... functions, so a value
+ * is the same whatever column type it has, i.e. GetDouble of "2.2" in an int column is 2.2.
+ * The column is converted to the other type once on the first request and the converted
+ * values are kept with the column (@see GetValues)
+ */
+class TypedColumn
+{
+public:
+	TypedColumn();
+	TypedColumn(const TypedColumn& rhs);              ///Copies values, converted values are made again on request
+	TypedColumn& operator=(const TypedColumn& rhs);
+	~TypedColumn();
+
+	ConstantsTypeColumn::ColumnTypes Type;      ///< Type of the column
+	std::vector<double>       Doubles;          ///< Values of double column
+	std::vector<long>         Integers;         ///< Values of int, uint, long and ulong columns (ulong is kept bit by bit)
+	std::vector<char>         Bools;            ///< Values of bool column
+	std::vector<unsigned int> StringIds;        ///< Values of string column as indexes in Strings
+	const std::vector<std::string>* Strings;    ///< Interned strings of the assignment
+	size_t ParseErrors;                         ///< Number of cells that are not values of the column type
+
+	const AssignmentData* Cells;                ///< Text cells of the column or NULL if the text is formatted from the values (binary data)
+	size_t Column;                              ///< Index of the column in a row of Cells
+	size_t ColumnsCount;                        ///< Number of columns in a row of Cells
+
+	/** Gets number of rows */
+	size_t GetRowsCount() const;
+
+	double        GetDouble(size_t row) const;  ///Value of the row converted to double
+	int           GetInt(size_t row) const;     ///Value of the row converted to int
+	unsigned int  GetUInt(size_t row) const;    ///Value of the row converted to unsigned int
+	long          GetLong(size_t row) const;    ///Value of the row converted to long
+	unsigned long GetULong(size_t row) const;   ///Value of the row converted to unsigned long
+	bool          GetBool(size_t row) const;    ///Value of the row converted to bool
+
+	/** Value of the row converted to T. T is double, int, unsigned int, long, unsigned long or bool */
+	template<typename T> T Get(size_t row) const;
+
+	/** @brief Values of all rows converted to T
+	 *
+	 * Values of a double column are Doubles and values of a long column are Integers.
+	 * Other values are converted once on the first call and kept with the column:
+	 * int, unsigned int and unsigned long values of their own columns are cast from Integers,
+	 * values of other columns are parsed from the cells text. The next calls return the same values
+	 *
+	 * @remark the function is thread safe. T is double, int, unsigned int, long or unsigned long
+	 * @return    GetRowsCount() values or NULL if the column has no rows
+	 */
+	template<typename T> const T* GetValues() const;
+
+	/** Estimates the amount of memory (in bytes) held by converted values */
+	size_t GetConvertedMemoryUsage() const;
+
+	/** @brief Text of the cell in the row
+	 *
+	 * The text is the cell of the blob or, for binary data, the value formatted
+	 * the same way as Assignment::GetVectorData does. Numbers are formatted to the buffer
+	 *
+	 * @param [in]  row - row of the cell
+	 * @param [in]  buffer - buffer of at least 32 chars
+	 * @param [out] begin, end - chars of the text
+	 */
+	void GetText(size_t row, char* buffer, const char*& begin, const char*& end) const;
+
+private:
+	struct Conversions;
+	std::unique_ptr<Conversions> mConversions;   // Values converted to other types
+};
+
+template<> inline double        TypedColumn::Get<double>(size_t row) const        { return GetDouble(row); }
+template<> inline int           TypedColumn::Get<int>(size_t row) const           { return GetInt(row); }
+template<> inline unsigned int  TypedColumn::Get<unsigned int>(size_t row) const  { return GetUInt(row); }
+template<> inline long          TypedColumn::Get<long>(size_t row) const          { return GetLong(row); }
+template<> inline unsigned long TypedColumn::Get<unsigned long>(size_t row) const { return GetULong(row); }
+template<> inline bool          TypedColumn::Get<bool>(size_t row) const          { return GetBool(row); }
+
+template<> const double*        TypedColumn::GetValues<double>() const;
+template<> const int*           TypedColumn::GetValues<int>() const;
+template<> const unsigned int*  TypedColumn::GetValues<unsigned int>() const;
+template<> const long*          TypedColumn::GetValues<long>() const;
+template<> const unsigned long* TypedColumn::GetValues<unsigned long>() const;
+
+}
+
+#endif /* _DTypedColumn_ */
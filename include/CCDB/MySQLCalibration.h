@@ -71,6 +71,10 @@ public:
 	 */
 	virtual bool IsConnected();
 
+protected:
+	/** @brief Creates not connected MySQLDataProvider for the connection pool. @see Calibration::SetPoolSize */
+	virtual DataProvider* CreateProvider();
+
 private:
     MySQLCalibration(const MySQLCalibration& rhs);
     MySQLCalibration& operator=(const MySQLCalibration& rhs);
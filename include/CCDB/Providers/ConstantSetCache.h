@@ -0,0 +1,110 @@
+#ifndef DConstantSetCache_h
+#define DConstantSetCache_h
+
+#include <string>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "CCDB/Globals.h"
+#include "CCDB/Model/AssignmentData.h"
+#include "CCDB/Model/ConstantsTypeTable.h"
+
+namespace ccdb
+{
+
+/** @brief Accounting information of ConstantSetCache */
+struct ConstantSetCacheStats
+{
+    size_t Sets;                ///< Number of parsed constant sets held by assignments
+    unsigned long Hits;         ///< Number of vaults that got already parsed data
+    unsigned long Misses;       ///< Number of vaults that had to be parsed
+};
+
+
+/** @brief Parsed data of constant sets by content
+ *
+ * Many assignments have byte-identical vaults: copies over run ranges and variations
+ * or the same values uploaded again. The cache finds parsed data by a hash of the vault
+ * computed at load time, so such assignments share one immutable AssignmentData
+ * instead of parsing and keeping the same values each.
+ * Typed values depend on column types, so the data is found by the vault and
+ * the column types of the type table. Vaults with equal hashes are compared byte by byte
+ * with the raw data of the cached assignment data. The data keeps decompressed blobs, so
+ * compressed vaults are compared by length and a second hash instead of keeping their copies.
+ *
+ * The cache doesn't keep the data alive: it is released with the last assignment that holds it.
+ * One cache may be shared by several providers (@see DataProvider::SetConstantSetCache),
+ * the functions are thread safe
+ */
+class ConstantSetCache
+{
+public:
+    typedef std::shared_ptr<AssignmentData> DataPtr;
+
+    ConstantSetCache();
+
+    /** @brief Gets parsed data of the vault
+     *
+     * @param [in] vault - vault as it is in the database
+     * @param [in] table - type table of the assignment, may be NULL
+     * @return the data or empty pointer if the vault is not parsed yet or its data is released
+     */
+    DataPtr Get(const std::string& vault, const ConstantsTypeTable* table);
+
+    /** @brief Puts parsed data of the vault to the cache
+     *
+     * The data must not be changed after this call
+     *
+     * @param [in] vault - vault as it is in the database
+     * @param [in] table - type table of the assignment, may be NULL
+     * @param [in] data  - data parsed from the vault
+     * @return the cached data for the vault (another thread could put it meanwhile)
+     */
+    DataPtr Put(const std::string& vault, const ConstantsTypeTable* table, const DataPtr& data);
+
+    /** @brief Removes all entries. Holders of the data keep it */
+    void Clear();
+
+    /** @brief Gets counts of constant sets, hits and misses */
+    ConstantSetCacheStats GetStats();
+
+private:
+    ConstantSetCache(const ConstantSetCache& rhs);
+    ConstantSetCache& operator=(const ConstantSetCache& rhs);
+
+    struct Entry
+    {
+        Entry(): VaultSize(0), VaultCheck(0) {}
+
+        std::weak_ptr<AssignmentData> Data;
+        std::string Types;          ///< Column types the data is parsed for
+        size_t VaultSize;           ///< Length of the vault
+        uint64_t VaultCheck;        ///< Second hash of a compressed vault. Other vaults are compared with the raw data
+    };
+
+    /** Number of columns and their types. Typed columns of equal keys are the same */
+    static std::string GetTypesKey(const ConstantsTypeTable* table);
+
+    /** Hash of the vault and the column types */
+    static size_t GetHash(const std::string& vault, const std::string& types);
+
+    /** Hash of a compressed vault that doesn't depend on GetHash (FNV-1a). 0 for other vaults */
+    static uint64_t GetCheck(const std::string& vault);
+
+    /** true if the entry is the data of the vault */
+    static bool IsEntryOf(const Entry& entry, const DataPtr& data, const std::string& vault, const std::string& types);
+
+    /** Removes entries with released data when there are as many puts as entries since the last sweep */
+    void SweepReleased();
+
+    std::unordered_map<size_t, Entry> mEntries;     /// Hash of the vault and types => data
+    size_t mPutsSinceSweep;
+    ConstantSetCacheStats mStats;
+    std::mutex mMutex;                              /// Guards all members
+};
+
+}
+
+#endif // DConstantSetCache_h
@@ -4,8 +4,11 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <memory>
 
 #include "CCDB/Providers/IAuthentication.h"
+#include "CCDB/Providers/TypeTableCache.h"
+#include "CCDB/Providers/ConstantSetCache.h"
 #include "CCDB/Model/ObjectsOwner.h"
 #include "CCDB/Model/Assignment.h"
 #include "CCDB/Model/ConstantsTypeTable.h"
@@ -53,6 +56,23 @@
 namespace ccdb
 {
 
+/** @brief State of assignments in the database to tell that they are changed. @see DataProvider::GetChangeMark */
+struct ChangeMark
+{
+    ChangeMark(): MaxAssignmentId(0), DataVersion(0) {}
+
+    dbkey_t MaxAssignmentId;        ///< The biggest id of assignments
+    std::string LastModified;       ///< The latest modification time of assignments as the database gives it
+    long long DataVersion;          ///< Version of the whole database (SQLite data_version), 0 if not supported
+
+    bool operator==(const ChangeMark& rhs) const
+    {
+        return MaxAssignmentId == rhs.MaxAssignmentId && LastModified == rhs.LastModified && DataVersion == rhs.DataVersion;
+    }
+    bool operator!=(const ChangeMark& rhs) const { return !(*this == rhs); }
+};
+
+
 class DataProvider: public ObjectsOwner
 {
 public:
@@ -87,6 +107,16 @@ public:
      * @return true if  connection is open
      */
     virtual bool IsConnected()=0;
+
+    /**
+     * @brief checks that the connection is alive
+     *
+     * Unlike IsConnected, which only reports the state, the server is asked
+     * if the provider has one. Is used by @see DataProviderPool before reusing idle connections
+     *
+     * @return true if the connection is alive
+     */
+    virtual bool Ping() { return IsConnected(); }
     
     /** @brief Connection string that was used on last successful connect.
      *
@@ -202,6 +232,35 @@ public:
      */
     virtual ConstantsTypeTable * GetConstantsTypeTable(const string& path, bool loadColumns=false);
 
+    /** @brief Gets type table by full path from the metadata cache or loads it once
+     *
+     * Unlike GetConstantsTypeTable, the table is shared by all assignments of the table
+     * and must not be changed or deleted. @see TypeTableCache
+     *
+     * @param  [in] path absolute path of the type table
+     * @param  [in] loadColumns the table is needed with columns
+     * @return shared table or empty pointer if the table is not found
+     */
+    std::shared_ptr<ConstantsTypeTable> GetSharedTypeTable(const string& path, bool loadColumns=false);
+
+    /** @brief Uses metadata cache of another provider connected to the same database
+     *
+     * Connections of a pool share one cache, so each table is loaded once for all of them
+     */
+    void SetTypeTableCache(std::shared_ptr<TypeTableCache> cache) { mTypeTableCache = cache; }
+
+    /** @brief The metadata cache of type tables. @see GetSharedTypeTable */
+    std::shared_ptr<TypeTableCache> GetTypeTableCache() const { return mTypeTableCache; }
+
+    /** @brief Uses parsed constant sets of another provider
+     *
+     * Assignments of all providers with one cache share the data of equal vaults
+     */
+    void SetConstantSetCache(std::shared_ptr<ConstantSetCache> cache) { mConstantSetCache = cache; }
+
+    /** @brief Parsed constant sets by content. @see ConstantSetCache */
+    std::shared_ptr<ConstantSetCache> GetConstantSetCache() const { return mConstantSetCache; }
+
     /** @brief Gets ConstantsType information from the DB
      *
      * @param  [in] name name of ConstantsTypeTable
@@ -348,6 +407,16 @@ public:
      * @return   DVariation*
      */
     virtual Variation* GetVariation(const string& name)=0;
+
+    /** @brief Gets the variation and all its ancestors
+     *
+     * chain[0] is the variation itself, chain[1] is its parent and so on up to the root variation.
+     * Chains of the loaded variations are built once by LinkVariations
+     *
+     * @param  [in] variation variation returned by GetVariation
+     * @return the chain, it is valid while the provider exists
+     */
+    const vector<Variation *>& GetVariationChain(Variation* variation);
      
     /**
      * @brief Searches all variations associated with this type table
@@ -419,6 +488,91 @@ public:
      * @return DAssignment object or NULL if no assignment is found or error
      */
     virtual Assignment* GetAssignmentShort(int run, const string& path, time_t time, const string& variation="default", bool loadColumns=false)=0;
+
+
+    /** @brief Gets the interval of runs for which the request resolves to the same assignment
+     *
+     * The assignment is one returned by GetAssignmentShort for requested variation and time.
+     * The same request for any run of [runMin, runMax] returns the same assignment, so the result
+     * may be cached for the whole interval. The interval is the run range of the assignment
+     * cut by newer assignments of the same variation and by assignments of variations
+     * that are checked before it (if the data was taken from a parent variation)
+     *
+     * The default implementation gives [run, run] which is always correct
+     *
+     * @param [in]  assignment - assignment returned by GetAssignmentShort
+     * @param [in]  variation  - variation name that was requested
+     * @param [in]  time       - time that was requested, 0 if no time was requested
+     * @param [out] runMin     - first run of the interval
+     * @param [out] runMax     - last run of the interval
+     * @return true if the interval was found, false if error (runMin=runMax=requested run in this case)
+     */
+    virtual bool GetAssignmentRunInterval(Assignment* assignment, const string& variation, time_t time, int& runMin, int& runMax);
+
+
+    /** @brief Gets the interval of runs for which the request has no assignment
+     *
+     * Is called after GetAssignmentShort found nothing. The same request for any run of [runMin, runMax]
+     * finds nothing too, so the miss may be cached for the whole interval. The interval is the gap
+     * between run ranges of the table assignments in the variation chain. If the table or the variation
+     * doesn't exist, the interval is all runs
+     *
+     * The default implementation can't tell a missing assignment from an error and returns false
+     *
+     * @param [in]  path       - absolute path of the type table
+     * @param [in]  run        - run number that was requested
+     * @param [in]  variation  - variation name that was requested
+     * @param [in]  time       - time that was requested, 0 if no time was requested
+     * @param [out] runMin     - first run of the interval
+     * @param [out] runMax     - last run of the interval
+     * @return true if there is no assignment for the run, false if there is one or error happened
+     */
+    virtual bool GetMissingRunInterval(const string& path, int run, const string& variation, time_t time, int& runMin, int& runMax);
+
+
+    /** @brief Gets assignments of many tables for the same run, variation and time at once
+     *
+     * The result is the same as GetAssignmentShort and GetAssignmentRunInterval called for each path,
+     * but providers may load it in bulk. It is used to warm up caches (@see Calibration::Prefetch)
+     *
+     * @param [out] assignments  - assignments[i] is the assignment for paths[i] or NULL if it was not found
+     * @param [out] runIntervals - runIntervals[i] is (runMin, runMax) of assignments[i] (@see GetAssignmentRunInterval)
+     * @param [in]  run          - run number
+     * @param [in]  paths        - absolute paths of type tables
+     * @param [in]  time         - timestamp, 0 for the latest data
+     * @param [in]  variation    - variation name
+     * @param [in]  loadColumns  - do we need to load table columns information or not
+     * @return false if error happened and no assignments could be loaded
+     */
+    virtual bool GetAssignmentsShort(vector<Assignment*>& assignments, vector<pair<int, int> >& runIntervals, int run, const vector<string>& paths,
+                                     time_t time = 0, const string& variation = "default", bool loadColumns = false);
+
+
+    /** @brief Gets the current state of assignments to find out if the database is changed
+     *
+     * The call is cheap, so it may be polled (@see Calibration::SetChangeCheckInterval).
+     * Marks are compared only for the same provider
+     *
+     * The default implementation doesn't support change detection and returns false
+     *
+     * @param [out] mark - the state of assignments
+     * @return false if change detection is not supported or error happened
+     */
+    virtual bool GetChangeMark(ChangeMark& mark);
+
+
+    /** @brief Gets tables whose assignments are added or modified after the mark was taken
+     *
+     * Other changes (removed assignments, changed directories, tables, run ranges and variations)
+     * can't be told by table, then the function returns false and all cached data should be dropped
+     *
+     * The default implementation returns false
+     *
+     * @param [out] paths - absolute paths of the changed tables
+     * @param [in]  since - mark taken by @see GetChangeMark before the changes
+     * @return false if the changed tables can't be told or error happened
+     */
+    virtual bool GetChangedTables(vector<string>& paths, const ChangeMark& since);
        
 
     /** @brief Get last Assignment with all related objects
@@ -688,6 +842,31 @@ protected:
      * @return   void
      */
     void SetObjectLoaded(StoredObject* obj);
+
+    /** @brief Gives the data blob of the vault read from the database
+     *
+     * Compressed vaults (@see Assignment::CompressBlob) are decompressed,
+     * the others are returned as they are. A vault that can't be decompressed
+     * is reported as CCDB_ERROR_VAULT_DECOMPRESS and gives an empty blob
+     *
+     * @param     vault - vault as it is in the database
+     * @param     module - caller method name for the error
+     * @return   text or binary blob for Assignment::SetRawData
+     */
+    std::string DecompressVault(std::string vault, const std::string& module);
+
+    /** @brief Sets the data of the vault read from the database to the assignment
+     *
+     * If an assignment with the same vault and column types is already loaded,
+     * its parsed data is shared (@see ConstantSetCache). Otherwise the vault is
+     * decompressed (@see DecompressVault), parsed and put to the cache.
+     * The type table must be set to the assignment before this call
+     *
+     * @param     assignment - assignment to set the data to
+     * @param     vault - vault as it is in the database
+     * @param     module - caller method name for the error
+     */
+    void SetAssignmentData(Assignment* assignment, std::string vault, const std::string& module);
     
     /******* D I R E C T O R I E S   W O R K *******/ 
     vector<Directory *>  mDirectories;
@@ -715,9 +894,21 @@ protected:
 
     std::string mConnectionString;      ///Connection string that was used on last successfully connect.
 
+    std::shared_ptr<TypeTableCache> mTypeTableCache; ///Type tables by full path. Is replaced when connected to another database
+
+    std::shared_ptr<ConstantSetCache> mConstantSetCache; ///Parsed constant sets by content. Is kept on reconnect as it doesn't depend on the database
+
     IAuthentication * mAuthentication;
 
     map<dbkey_t, Variation *> mVariationsById;
+    map<string, Variation *> mVariationsByName;
+    map<dbkey_t, vector<Variation *> > mVariationChains;   ///Variation id => the variation and its ancestors
+
+    /** @brief Links loaded variations by parent ids and builds mVariationsByName and mVariationChains
+     *
+     * Providers fill mVariationsById with the whole variations table and call this function
+     */
+    void LinkVariations();
 };
 }
 #endif // _DDataProvider_
@@ -0,0 +1,162 @@
+#ifndef DDataProviderPool_h
+#define DDataProviderPool_h
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <time.h>
+
+#include "CCDB/Globals.h"
+#include "CCDB/Providers/DataProvider.h"
+
+namespace ccdb
+{
+
+/** @brief Accounting information of DataProviderPool */
+struct DataProviderPoolStats
+{
+    size_t Connections;                 ///< Number of open connections now
+    size_t Idle;                        ///< Number of open connections that are not checked out now
+    unsigned long Checkouts;            ///< Number of checkouts (re-entrant checkouts are not counted)
+    unsigned long Created;              ///< Number of connections that were opened
+    unsigned long Waits;                ///< Number of checkouts that waited for a free connection
+    unsigned long Reaped;               ///< Number of idle connections closed by @see DataProviderPool::ReapIdle
+    unsigned long HealthCheckFailures;  ///< Number of connections that failed the health check and were reopened
+};
+
+
+/** @brief Pool of connected providers serving concurrent threads
+ *
+ * A provider is not thread safe, so threads that read the database at once
+ * take different providers from the pool. Connections are opened lazily up to
+ * the pool size. If all of them are checked out, the next thread waits for one to be released.
+ *
+ * Checkout is per thread and re-entrant: the thread that already holds a provider
+ * gets the same provider again. A released provider goes back to the thread that used it last
+ * if this thread comes again, so its statement caches and loaded directories stay warm.
+ *
+ * Providers that stayed idle longer than @see SetHealthCheckInterval are checked by
+ * DataProvider::Ping before they are given out and reconnected if the check fails.
+ * Idle providers are closed by @see ReapIdle (@see CalibrationGenerator::UpdateInactivity)
+ */
+class DataProviderPool
+{
+public:
+    typedef std::function<DataProvider*()> Factory;
+
+    /** @brief Ctor
+     *
+     * @param [in] factory - creates not connected provider of the needed type
+     * @param [in] maxSize - maximum number of connections, at least 1
+     */
+    DataProviderPool(Factory factory, size_t maxSize);
+    virtual ~DataProviderPool();
+
+    /** @brief Sets connection string for the pool connections
+     *
+     * Connections are opened lazily by @see Checkout. If the string differs from the
+     * previous one, idle connections are closed and connections in use are closed when released
+     *
+     * @param [in] connectionString - the same as for DataProvider::Connect
+     */
+    void Connect(const std::string& connectionString);
+
+    /** @brief Closes idle connections. Connections in use are closed when released */
+    void Disconnect();
+
+    /** @brief The connection string of the pool connections, empty if not set */
+    std::string GetConnectionString();
+
+    /** @brief Takes a connected provider for the calling thread
+     *
+     * @remark each Checkout must be paired with @see Release from the same thread
+     * @return provider or NULL if connection failed
+     */
+    DataProvider* Checkout();
+
+    /** @brief Gives the provider back to the pool */
+    void Release(DataProvider* provider);
+
+    /** @brief Closes connections that are idle longer than maxIdleTime seconds
+     * @return number of closed connections
+     */
+    size_t ReapIdle(time_t maxIdleTime);
+
+    /** @brief Maximum number of connections. If reduced, the extra connections are closed when idle */
+    void SetMaxSize(size_t maxSize);
+    size_t GetMaxSize();
+
+    /** @brief Providers idle longer than this number of seconds are pinged before use. 0 - always ping */
+    void SetHealthCheckInterval(time_t seconds);
+    time_t GetHealthCheckInterval();
+
+    /** @brief Gets counts of connections, checkouts and reaped connections */
+    DataProviderPoolStats GetStats();
+
+private:
+    DataProviderPool(const DataProviderPool& rhs);
+    DataProviderPool& operator=(const DataProviderPool& rhs);
+
+    /** Pool slot of one provider */
+    struct Connection
+    {
+        DataProvider* Provider;     /// NULL while the connection is being opened
+        std::thread::id Owner;      /// Thread that holds the provider. Default id if idle
+        std::thread::id LastOwner;  /// Thread that used the provider last time
+        int Depth;                  /// Number of nested checkouts by the owner
+        time_t LastUse;             /// Monotonic time when the provider was released
+        unsigned long Generation;   /// mGeneration when the provider was connected
+    };
+
+    /** Connects new provider outside the lock. Returns NULL if failed */
+    DataProvider* OpenProvider(const std::string& connectionString);
+
+    /** Pings the provider and reconnects it if the check fails. Returns false if reconnection failed */
+    bool CheckHealth(DataProvider* provider, const std::string& connectionString, bool& failed);
+
+    /** Removes idle slots which don't fit the size or belong to the old connection string. mMutex must be locked */
+    void RemoveStaleIdle(std::vector<DataProvider*>& removed);
+
+    /** Removes the slot and returns its provider to be deleted outside the lock. mMutex must be locked */
+    DataProvider* RemoveConnection(size_t index);
+
+    /** Index of the slot of the provider or -1. mMutex must be locked */
+    int FindConnection(DataProvider* provider) const;
+
+    Factory mFactory;
+    size_t mMaxSize;
+    time_t mHealthCheckInterval;
+    std::string mConnectionString;
+    unsigned long mGeneration;              /// Changed on Connect to another source and on Disconnect
+    std::vector<Connection> mConnections;
+    DataProviderPoolStats mStats;
+
+    std::mutex mMutex;                      /// Guards all members
+    std::condition_variable mReleased;      /// Notified when a connection is released or removed
+};
+
+
+/** @brief Checks out provider from the pool in ctor and releases in dtor */
+class DataProviderLease
+{
+public:
+    explicit DataProviderLease(DataProviderPool& pool): mPool(pool), mProvider(pool.Checkout()) {}
+    ~DataProviderLease() { if(mProvider) mPool.Release(mProvider); }
+
+    DataProvider* Get() const { return mProvider; }
+    DataProvider* operator->() const { return mProvider; }
+
+private:
+    DataProviderLease(const DataProviderLease& rhs);
+    DataProviderLease& operator=(const DataProviderLease& rhs);
+
+    DataProviderPool& mPool;
+    DataProvider* mProvider;
+};
+
+}
+
+#endif // DDataProviderPool_h
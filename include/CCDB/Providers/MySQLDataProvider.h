@@ -10,6 +10,7 @@
 
 #include "CCDB/Providers/DataProvider.h"
 #include "CCDB/Providers/MySQLConnectionInfo.h"
+#include "CCDB/Providers/MySQLStatement.h"
 #include "CCDB/Model/ConstantsTypeTable.h"
 
 #define CCDB_DEFAULT_MYSQL_USERNAME  "ccdbuser"
@@ -66,6 +67,13 @@ public:
 	 * @return true if  connection is open
 	 */
 	virtual bool IsConnected();
+
+	/**
+	 * @brief checks that the server is reachable by mysql_ping
+	 *
+	 * @return true if the connection is alive
+	 */
+	virtual bool Ping();
 	
 	/**
 	 * @brief closes connection to data
@@ -378,9 +386,9 @@ private:
 	virtual Variation* GetVariationById(int id);
 
     /**
-     * Get variation by database request
+     * Loads the whole variations table and links parents and ancestor chains
      */
-    virtual Variation* SelectVariation(const string& query);
+    bool LoadVariations();
     
 	#pragma endregion Variation
 
@@ -419,6 +427,43 @@ public:
     virtual Assignment* GetAssignmentShort(int run, const string& path, time_t time, const string& variation="default", bool loadColumns=false);
 
 
+    /** @brief Gets the interval of runs for which the request resolves to the same assignment
+     *
+     * @see DataProvider::GetAssignmentRunInterval
+     * @param [in]  assignment - assignment returned by GetAssignmentShort
+     * @param [in]  variation  - variation name that was requested
+     * @param [in]  time       - time that was requested, 0 if no time was requested
+     * @param [out] runMin     - first run of the interval
+     * @param [out] runMax     - last run of the interval
+     * @return true if the interval was found
+     */
+    virtual bool GetAssignmentRunInterval(Assignment* assignment, const string& variation, time_t time, int& runMin, int& runMax);
+
+
+    /** @brief Gets the interval of runs for which the request has no assignment
+     *
+     * @see DataProvider::GetMissingRunInterval
+     * @return true if there is no assignment for the run
+     */
+    virtual bool GetMissingRunInterval(const string& path, int run, const string& variation, time_t time, int& runMin, int& runMax);
+
+
+    /** @brief Gets the current state of assignments to find out if the database is changed
+     *
+     * The mark is the biggest id and the latest modification time of assignments
+     *
+     * @see DataProvider::GetChangeMark
+     */
+    virtual bool GetChangeMark(ChangeMark& mark);
+
+
+    /** @brief Gets tables whose assignments are added or modified after the mark was taken
+     *
+     * @see DataProvider::GetChangedTables
+     */
+    virtual bool GetChangedTables(vector<string>& paths, const ChangeMark& since);
+
+
     
 	/** @brief Get last Assignment with all related objects
 	 *
@@ -648,9 +693,17 @@ protected:
 	 */
 	bool FetchRow();
 
-    /** prepares preparedStatemets for use
+    /** @brief Prepares the statement on the server if it is not prepared yet
+     *
+     * @param [in] statement    - one of the statements of the provider
+     * @param [in] query        - SQL query with '?' placeholders
+     * @param [in] functionName - function name for errors
+     * @return true if the statement is ready to be executed
      */
-    bool InitializePreparedStatements(){ return false;} //TODO implement PreparedStatements for GetAssignmentShort funcitons
+    bool PrepareStatement(MySQLStatement& statement, const char* query, const char* functionName);
+
+    /** @brief Executes the prepared statement and reports the error if any */
+    bool ExecuteStatement(MySQLStatement& statement, const char* functionName);
 
 	//read of row fields
 	bool IsNullOrUnreadable(int fieldNum);		///Check if the field is NULL or is unreadable. If it is Unreadable
@@ -719,11 +772,21 @@ private:
 	static bool mMySqlIsInitialized;	//flag that mysql is initialized
 
 	string mLastFullQuerry;   //full text of last full get assignment query
+
+	//Statements of the hot read queries. They are prepared at the first use
+	MySQLStatement mTypeTableStatement;					//GetConstantsTypeTable
+	MySQLStatement mColumnsStatement;					//LoadColumns
+	MySQLStatement mAssignmentShortStatement;			//GetAssignmentShort
+	MySQLStatement mAssignmentShortByTimeStatement;		//GetAssignmentShort with time
+	MySQLStatement mAssignmentRunIntervalStatement;			//GetAssignmentRunInterval
+	MySQLStatement mAssignmentRunIntervalByTimeStatement;	//GetAssignmentRunInterval with time
+	MySQLStatement mMissingRunIntervalStatement;			//GetMissingRunInterval
+	MySQLStatement mMissingRunIntervalByTimeStatement;		//GetMissingRunInterval with time
 	
 	string mLastShortQuerry;  //full text of last short assignment query
 	
     //VARIATIONs WORK
-    Variation* mLastVariation;                     ///Last requested variation ID. Used for caching
+    bool mVariationsAreLoaded;                     ///The whole variations table is loaded. @see LoadVariations
 	
 
 #pragma endregion Private
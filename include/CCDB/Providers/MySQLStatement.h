@@ -0,0 +1,115 @@
+#ifndef _MySQLStatement_
+#define _MySQLStatement_
+
+#ifdef WIN32
+#include <winsock.h>
+#endif
+#include <mysql.h>
+#include <string>
+#include <vector>
+#include <type_traits>
+
+using namespace std;
+
+namespace ccdb
+{
+
+/** @brief Server side prepared statement with bound parameters and binary results
+ *
+ * The statement is prepared once and then executed many times with different parameters.
+ * Integer parameters and integer result columns travel in the binary form.
+ * Other result columns are fetched into buffers that are kept between executions
+ * and grow when a longer value (like a big blob) comes.
+ *
+ * Parameters are given by their position in the query (0 based, as '?' appear in the query)
+ *
+ * @remark the statement belongs to its MYSQL connection and should be closed before the connection is closed
+ */
+class MySQLStatement
+{
+public:
+	MySQLStatement();
+	~MySQLStatement();
+
+	/** @brief Prepares the query on the server
+	 *
+	 * @param [in] mysql - connection
+	 * @param [in] query - SQL query with '?' placeholders
+	 * @return true if the statement was prepared
+	 */
+	bool Prepare(MYSQL* mysql, const char* query);
+
+	/** @brief true if the statement was prepared and was not closed */
+	bool IsPrepared() const { return mStatement != NULL; }
+
+	/** @brief Closes the statement on the server and frees buffers */
+	void Close();
+
+	/** @brief Sets integer parameter */
+	void SetInt(int index, long long value);
+
+	/** @brief Sets string parameter */
+	void SetString(int index, const string& value);
+
+	/** @brief Executes the statement with the set parameters and stores the result on the client
+	 * @return true if success
+	 */
+	bool Execute();
+
+	/** @brief Number of rows selected by the last Execute */
+	unsigned long long GetRowsCount();
+
+	/** @brief Fetches the next row of the result
+	 * @return true if row was read, false if no more rows or error
+	 */
+	bool Fetch();
+
+	/** @brief Frees the result of the last Execute. The buffers are kept */
+	void FreeResult();
+
+	bool		IsNull(int column) const;			///Is the column of the fetched row NULL
+	long long	GetInt(int column) const;			///Integer value of the column of the fetched row
+	string		GetString(int column) const;		///String value of the column of the fetched row
+
+	/** @brief Text of the last error */
+	string GetError() const { return mError; }
+
+private:
+	MySQLStatement(const MySQLStatement&);				//not copyable
+	MySQLStatement& operator=(const MySQLStatement&);
+
+	/** @brief Remembers error of the statement function */
+	bool SetError(const char* functionName);
+
+	struct Parameter
+	{
+		long long Int;
+		string String;
+		unsigned long Length;
+	};
+
+	//my_bool of the old client libraries is bool in MySQL 8, use whatever MYSQL_BIND has
+	typedef std::remove_pointer<decltype(((MYSQL_BIND*)NULL)->is_null)>::type BindFlag;
+
+	struct Column
+	{
+		bool IsInteger;
+		long long Int;
+		vector<char> Buffer;
+		unsigned long Length;
+		BindFlag IsNull;
+		BindFlag Error;
+	};
+
+	MYSQL_STMT* mStatement;
+	vector<Parameter> mParameters;
+	vector<MYSQL_BIND> mParameterBinds;
+	vector<Column> mColumns;
+	vector<MYSQL_BIND> mColumnBinds;
+	bool mHasResult;				//Execute stored the result that must be freed
+	string mError;
+};
+
+}
+
+#endif // _MySQLStatement_
@@ -74,6 +74,22 @@ public:
 	 */
 	virtual bool CheckConnection(const string& errorSource="");
 
+
+	/** @brief Opens the database for use by one thread at a time
+	 *
+	 * By default the database is opened with SQLITE_OPEN_FULLMUTEX|SQLITE_OPEN_SHAREDCACHE,
+	 * so the provider may be shared by threads, but SQLite serializes all of them.
+	 * Providers of a connection pool (@see DataProviderPool) are used by one thread at a time.
+	 * They open the database with SQLITE_OPEN_NOMUTEX and a private cache, so readers
+	 * with their own connections and prepared statements don't wait for each other.
+	 *
+	 * @remark takes effect on the next Connect
+	 */
+	void SetSingleThreadMode(bool value) { mIsSingleThreadMode = value; }
+
+	/** @brief true if the database is opened with SQLITE_OPEN_NOMUTEX. @see SetSingleThreadMode */
+	bool GetSingleThreadMode() const { return mIsSingleThreadMode; }
+
 	//----------------------------------------------------------------------------------------
 	//	D I R E C T O R Y   M A N G E M E N T
 	//----------------------------------------------------------------------------------------
@@ -357,14 +373,11 @@ public:
 	 */
     Variation* GetVariationById(dbkey_t id);
 
-     /** @brief Executes statement and create Variation object. 
+    /** @brief Loads the whole variations table and links parents and ancestor chains
 	 * 
-     * mStatement should be prepared when calling the function. 
-     * The assumed data order in prepared statement is:
-     * `id`, `parentId`, `name` 
-	 * @return   DVariation*
+	 * @return false if error happened
 	 */
-    Variation *SelectVariation();
+    bool LoadVariations();
 
 	//----------------------------------------------------------------------------------------
 	//	A S S I G N M E N T S
@@ -397,6 +410,56 @@ public:
      * @return new DAssignment object or 
      */
     virtual Assignment* GetAssignmentShort(int run, const string& path, time_t time, const string& variation="default", bool loadColumns =false);
+
+
+    /** @brief Gets the interval of runs for which the request resolves to the same assignment
+     *
+     * @see DataProvider::GetAssignmentRunInterval
+     * @param [in]  assignment - assignment returned by GetAssignmentShort
+     * @param [in]  variation  - variation name that was requested
+     * @param [in]  time       - time that was requested, 0 if no time was requested
+     * @param [out] runMin     - first run of the interval
+     * @param [out] runMax     - last run of the interval
+     * @return true if the interval was found
+     */
+    virtual bool GetAssignmentRunInterval(Assignment* assignment, const string& variation, time_t time, int& runMin, int& runMax);
+
+
+    /** @brief Gets the interval of runs for which the request has no assignment
+     *
+     * @see DataProvider::GetMissingRunInterval
+     * @return true if there is no assignment for the run
+     */
+    virtual bool GetMissingRunInterval(const string& path, int run, const string& variation, time_t time, int& runMin, int& runMax);
+
+
+    /** @brief Gets the current state of assignments to find out if the database is changed
+     *
+     * PRAGMA data_version tells if other connections committed anything.
+     * Only then the biggest id and the latest modification time of assignments are read again
+     *
+     * @see DataProvider::GetChangeMark
+     */
+    virtual bool GetChangeMark(ChangeMark& mark);
+
+
+    /** @brief Gets tables whose assignments are added or modified after the mark was taken
+     *
+     * @see DataProvider::GetChangedTables
+     */
+    virtual bool GetChangedTables(vector<string>& paths, const ChangeMark& since);
+
+
+    /** @brief Gets assignments of many tables for the same run, variation and time at once
+     *
+     * Assignments of all tables and their run intervals are selected by one SQL statement.
+     * All lookups are done in one read transaction, so the database is locked once
+     * and all assignments are taken from the same state of the database
+     *
+     * @see DataProvider::GetAssignmentsShort
+     */
+    virtual bool GetAssignmentsShort(vector<Assignment*>& assignments, vector<pair<int, int> >& runIntervals, int run, const vector<string>& paths,
+                                     time_t time = 0, const string& variation = "default", bool loadColumns = false);
      
     
 	/** @brief Get last Assignment with all related objects
@@ -632,9 +695,33 @@ protected:
 	 */
 	bool FetchRow();
 
-    /** prepares preparedStatemets for use
+    /** Statements that are prepared once per connection and kept in the cache
      */
-    bool InitializePreparedStatements(){ return false;} //TODO implement PreparedStatements for GetAssignmentShort functions
+    enum CachedStatement
+    {
+        StatementTypeTable = 0,           ///GetConstantsTypeTable
+        StatementColumns,                 ///LoadColumns
+        StatementAssignmentShort,         ///GetAssignmentShort
+        StatementAssignmentShortByTime,   ///GetAssignmentShort with time
+        StatementAssignmentRunInterval,         ///GetAssignmentRunInterval
+        StatementAssignmentRunIntervalByTime,   ///GetAssignmentRunInterval with time
+        StatementMissingRunInterval,            ///GetMissingRunInterval
+        StatementMissingRunIntervalByTime,      ///GetMissingRunInterval with time
+        StatementsCount
+    };
+
+    /** @brief Gets prepared statement from the per connection cache
+     *
+     * The statement is prepared at the first call, later it is reused with cleared bindings.
+     * sqlite3_reset should be called instead of sqlite3_finalize when the statement is done
+     *
+     * @return the statement or NULL if it could not be prepared
+     */
+    sqlite3_stmt* GetCachedStatement(CachedStatement id, const char* query, const char* functionName);
+
+    /** @brief Finalizes all cached statements. Must be called before the database is closed
+     */
+    void FinalizeCachedStatements();
 
 	//read of row fields
 	bool IsNullOrUnreadable(int fieldNum);		///Check if the field is NULL or is unreadable. If it is Unreadable
@@ -680,6 +767,15 @@ private:
 	
 	bool mIsStoredObjectOwner;
 	Assignment* FetchAssignment(ConstantsTypeTable *table);
+
+	/** @brief Loads type tables (and their columns) for many paths with one query
+	 *
+	 * Tables that are in the metadata cache are not loaded. @see GetSharedTypeTable
+	 *
+	 * @param [out] tables - tables[i] is a shared type table for paths[i] or empty if it was not found
+	 * @return false if error happened
+	 */
+	bool LoadTypeTables(vector<std::shared_ptr<ConstantsTypeTable> >& tables, const vector<string>& paths, bool loadColumns);
 	virtual void FetchAssignment(Assignment* assignment, ConstantsTypeTable *table);
 
   	
@@ -688,6 +784,7 @@ private:
 	bool mHaveUnfreeResults; 			//indicates that we have some unfree results from mysql, that must be freed
 	sqlite3 *		mDatabase;			//Handler to sqlite object
 	sqlite3_stmt *	mStatement;
+	sqlite3_stmt *	mCachedStatements[StatementsCount];	//Prepared statements cache @see GetCachedStatement
 
 	vector<vector<string> > mRow;
 	
@@ -697,11 +794,17 @@ private:
 	//SQLITE_ULONG mLastInsertedId;		//number of last id
 	
 	bool mIsConnected;					//indicates connection to db
+	bool mIsSingleThreadMode;			//open the database with SQLITE_OPEN_NOMUTEX @see SetSingleThreadMode
 	dbkey_t mLastInsertedId;
 
 	
     //VARIATIONs WORK
-    Variation* mLastVariation;                    ///Last requested variation. Used for caching
+    bool mVariationsAreLoaded;                    ///The whole variations table is loaded. @see LoadVariations
+    ChangeMark mVariationsMark;                   ///The database state the variations are loaded at. Unknown names don't reload them until it is changed
+
+    //CHANGES
+    ChangeMark mLastChangeMark;                   ///The mark of the last GetChangeMark of this connection
+    bool mHasChangeMark;                          ///mLastChangeMark is taken on this connection
 
 };
 }
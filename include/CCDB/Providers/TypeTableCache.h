@@ -0,0 +1,84 @@
+#ifndef DTypeTableCache_h
+#define DTypeTableCache_h
+
+#include <string>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "CCDB/Globals.h"
+#include "CCDB/Model/ConstantsTypeTable.h"
+
+namespace ccdb
+{
+
+/** @brief Accounting information of TypeTableCache */
+struct TypeTableCacheStats
+{
+    size_t Tables;              ///< Number of cached type tables
+    unsigned long Hits;         ///< Number of requests served from the cache
+    unsigned long Misses;       ///< Number of requests that had to be loaded from the database
+};
+
+
+/** @brief Cache of type tables metadata by full path
+ *
+ * Type tables rarely change, while every assignment fetch needs one. The cache keeps
+ * one table per path, shared by all assignments that hold it by a shared pointer.
+ * Cached tables are immutable: when a table is first requested with columns,
+ * the table with columns replaces the one without, holders of the old table keep it.
+ *
+ * One cache may be shared by several providers connected to the same database
+ * (@see DataProvider::SetTypeTableCache), the functions are thread safe
+ */
+class TypeTableCache
+{
+public:
+    typedef std::shared_ptr<ConstantsTypeTable> TablePtr;
+
+    TypeTableCache();
+
+    /** @brief Gets the table by full path
+     *
+     * @param [in] path        - full path of the table like /test/test_vars/test_table
+     * @param [in] withColumns - the table is needed with columns
+     * @return the table or empty pointer if it is not cached (or cached without needed columns)
+     */
+    TablePtr Get(const std::string& path, bool withColumns);
+
+    /** @brief Puts loaded table to the cache
+     *
+     * The table is released from its owner and must not be changed after this call.
+     * A table with columns is not replaced by a table without them
+     *
+     * @param [in] path        - full path of the table
+     * @param [in] table       - loaded table, the cache takes the ownership
+     * @param [in] withColumns - columns of the table are loaded
+     * @return the cached table for the path
+     */
+    TablePtr Put(const std::string& path, ConstantsTypeTable* table, bool withColumns);
+
+    /** @brief Removes all tables. Holders of the tables keep them */
+    void Clear();
+
+    /** @brief Gets counts of tables, hits and misses */
+    TypeTableCacheStats GetStats();
+
+private:
+    TypeTableCache(const TypeTableCache& rhs);
+    TypeTableCache& operator=(const TypeTableCache& rhs);
+
+    struct Entry
+    {
+        TablePtr Table;
+        bool HasColumns;
+    };
+
+    std::unordered_map<std::string, Entry> mTables;   /// Full path => table
+    TypeTableCacheStats mStats;
+    std::mutex mMutex;                                /// Guards all members
+};
+
+}
+
+#endif // DTypeTableCache_h
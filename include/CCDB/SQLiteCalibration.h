@@ -68,6 +68,14 @@ public:
 	 */
 	virtual bool IsConnected();
 
+protected:
+	/** @brief Creates SQLiteDataProvider in single thread mode for the connection pool
+	 *
+	 * Each pooled provider has its own SQLITE_OPEN_NOMUTEX connection and prepared statements,
+	 * so threads that miss the cache read the file in parallel. @see Calibration::SetPoolSize
+	 */
+	virtual DataProvider* CreateProvider();
+
 private:
     SQLiteCalibration(const SQLiteCalibration& rhs);
     SQLiteCalibration& operator=(const SQLiteCalibration& rhs);
@@ -63,6 +63,8 @@ class AddData(ConsoleUtilBase):
         self.is_namevalue_format = False
         self.no_comments = False
         self.c_comments = False  # file has '//'-style comments
+        self.binary = False  # keep data in binary typed form
+        self.compress = False  # compress the vault
         self.raw_entry = "/"  # object path with possible pattern, like /mole/*
         self.path = "/"  # parent path
 
@@ -135,7 +137,9 @@ class AddData(ConsoleUtilBase):
                                                 self.run_min,
                                                 self.run_max,
                                                 self.variation,
-                                                self.comment)
+                                                self.comment,
+                                                self.binary,
+                                                self.compress)
         log.info(assignment.request)
         return 0
 
@@ -195,6 +199,14 @@ class AddData(ConsoleUtilBase):
                 if token == "--c-comments":
                     self.c_comments = True
 
+                # binary typed vault
+                if token == "--binary":
+                    self.binary = True
+
+                # compressed vault
+                if token == "--compress":
+                    self.compress = True
+
             else:
                 if token.startswith("#"):
                     # everething next are comments
@@ -263,5 +275,9 @@ Additional flags:
           --name-value  - indicates that the input file is in name-value format (column of names and column of values)
     -n or --no-comments - do not add all "#..." comments that is found in file to ccdb database
           --c-comments  - for files that contains '//' - C style comments. The add replaces simply // to #. 
+          --binary      - keep the data in binary typed form. It is read faster by C++ library,
+                          but only by versions that know this form (see 'help vault')
+          --compress    - compress the data if it is large. Saves space of large tables,
+                          but only versions that know this form can read it (see 'help vault')
     
     """)
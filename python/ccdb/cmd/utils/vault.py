@@ -0,0 +1,129 @@
+import logging
+import os
+
+from ccdb import AlchemyProvider
+from ccdb.model import ConstantSet, is_binary_blob, is_compressed_blob, decompress_blob
+from ccdb.cmd import ConsoleUtilBase, UtilityArgumentParser
+from ccdb.brace_log_message import BraceMessage as LogFmt
+
+
+log = logging.getLogger("ccdb.cmd.utils.vault")
+
+
+# ccdbcmd module interface
+def create_util_instance():
+    log.debug("      registering Vault")
+    return Vault()
+
+
+#*********************************************************************
+#   Class Vault - Shows and converts the form data is kept in        *
+#                                                                    *
+#*********************************************************************
+class Vault(ConsoleUtilBase):
+    """ Shows and converts the form constant sets are kept in """
+
+    # ccdb utility class descr part
+    # ------------------------------
+    command = "vault"
+    name = "Vault"
+    short_descr = "Shows and converts the form (text or binary, compressed or not) data is kept in"
+    uses_db = True
+
+    # - - - - - - - - - - - - - - - - - - - - -
+    def process(self, args):
+        """Main function that do the job"""
+
+        if log.isEnabledFor(logging.DEBUG):
+            log.debug(LogFmt("{0}Vault is in charge{0}\\".format(os.linesep)))
+            log.debug(LogFmt(" |- arguments : '" + "' '".join(args)+"'"))
+
+        # preparations
+        assert self.context is not None
+        provider = self.context.provider
+        isinstance(provider, AlchemyProvider)
+
+        # process arguments
+        parser = UtilityArgumentParser()
+        group = parser.add_mutually_exclusive_group()
+        group.add_argument("--binary", action="store_true")
+        group.add_argument("--text", action="store_true")
+        compress_group = parser.add_mutually_exclusive_group()
+        compress_group.add_argument("--compress", action="store_true")
+        compress_group.add_argument("--decompress", action="store_true")
+        parser.add_argument("-f", "--force", action="store_true")
+        result = parser.parse_args(args)
+
+        binary = True if result.binary else False if result.text else None
+        compress = True if result.compress else False if result.decompress else None
+
+        # ask confirmation. Converted data can't be read by older versions and other readers
+        if (binary or compress) and not result.force:
+            form = "Binary and compressed forms" if binary and compress else "Binary form" if binary else "Compressed form"
+            print(form + " can be read only by CCDB versions that know it. Older C++ library versions,\n"
+                  "Java/Kotlin readers and other tools that parse the vault text will not read converted data.\n"
+                  "Use 'vault --text --decompress' to convert it back.")
+            if input("To confirm conversion type 'yes': ") != 'yes':
+                return 0
+
+        if binary is not None or compress is not None:
+            (converted, skipped) = provider.convert_constant_sets(binary=binary, compress=compress)
+            print("Converted: {0}, left as they are: {1}".format(converted, skipped))
+
+        self.print_stats(provider)
+        return 0
+
+    # - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+    @staticmethod
+    def print_stats(provider):
+        """Prints number and size of text and binary, compressed and uncompressed constant sets"""
+
+        forms = [(False, False), (True, False), (False, True), (True, True)]
+        counts = dict((form, 0) for form in forms)
+        sizes = dict((form, 0) for form in forms)
+        for (vault,) in provider.session.query(ConstantSet._vault):
+            is_compressed = is_compressed_blob(vault)
+            is_binary = is_binary_blob(decompress_blob(vault) if is_compressed else vault)
+            counts[(is_binary, is_compressed)] += 1
+            sizes[(is_binary, is_compressed)] += len(vault) if vault else 0
+
+        for is_binary, is_compressed in forms:
+            name = ("compressed " if is_compressed else "") + ("binary:" if is_binary else "text:")
+            print("{0:<19}{1} constant sets, {2} bytes".format(name, counts[(is_binary, is_compressed)],
+                                                             sizes[(is_binary, is_compressed)]))
+
+    # - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+    def print_help(self):
+        """Prints help of the command"""
+
+        print("""Shows and converts the form data is kept in the database
+
+    vault               - shows number and size of text and binary, compressed and uncompressed constant sets
+    vault --binary      - converts constant sets to binary typed form (asks confirmation)
+    vault --text        - converts all constant sets back to text form
+    vault --compress    - compresses large constant sets (asks confirmation)
+    vault --decompress  - decompresses all constant sets
+    -f or --force       - converts without confirmation
+
+Text form keeps values as '|' separated strings. Binary form keeps values converted
+to the column types as little-endian arrays (base64 encoded). Binary data is read
+by C++ library without number parsing.
+
+Binary form is NOT readable by older C++ library versions, Java/Kotlin readers and
+tools that parse the vault text. Convert only databases all readers of which know this form.
+Numbers are kept as values, not as the text they were added with: '1.10' is read back
+as '1.1' and '1e-5' as '1e-05'. Data that doesn't match column types or doesn't get
+shorter in binary form stays as text.
+
+Compressed form keeps text or binary data compressed with zlib (base64 encoded).
+Only constant sets of 1024 bytes and longer are compressed, and only if they get
+shorter. Compressed data takes several times less space, but is decompressed on each read.
+
+Compressed form is NOT readable by older C++ library versions, Java/Kotlin readers and
+tools that parse the vault text, the same as binary form. Form and compression may be
+changed together.
+
+Example:
+    >> vault --binary --compress
+    >> vault
+    """)
@@ -1,8 +1,12 @@
 
 
+import base64
+import binascii
 import collections.abc
 import datetime
 import posixpath
+import struct
+import zlib
 
 from sqlalchemy.ext.declarative import declarative_base
 from sqlalchemy.schema import Column, ForeignKey
@@ -19,6 +23,32 @@ blob_delimiter = "|"
 # we have to encode blob_delimiter to blob_delimiter_replace on data write and decode it bach on data read
 blob_delimiter_replacement = "&delimiter;"
 
+# Binary typed blob starts with this prefix (see list_to_blob). The format is
+# #ccdb-bin:<version>:<rows>:<column type codes>:<base64 of little-endian typed arrays, column by column>
+# The same format is read by C++ Assignment::SetRawData
+binary_blob_prefix = "#ccdb-bin:"
+binary_blob_version = 1
+
+# Compressed blob starts with this prefix (see compress_blob). The format is
+# #ccdb-z:<version>:<size of the blob>:<base64 of zlib stream of the text or binary blob>
+# The same format is read by C++ DataProvider::DecompressVault
+compressed_blob_prefix = "#ccdb-z:"
+compressed_blob_version = 1
+
+# Blobs shorter than this are not compressed
+compressed_blob_min_size = 1024
+
+# column type -> (type code in binary blob header, struct format of one value)
+binary_column_formats = {
+    'int': ('i', 'i'),
+    'uint': ('u', 'I'),
+    'long': ('l', 'q'),
+    'ulong': ('L', 'Q'),
+    'double': ('d', 'd'),
+    'bool': ('b', 'B'),
+    'string': ('s', None),
+}
+
 
 #--------------------------------------------
 # class CcdbSchemaVersion
@@ -160,6 +190,48 @@ class ConstantSet(Base):
     def data_list(self, data_list):
         self._vault = list_to_blob(data_list)
 
+    @property
+    def is_binary(self):
+        """
+        True if the vault keeps the data in binary typed form (see list_to_blob)
+        :rtype: bool
+        """
+        vault = self._vault
+        if is_compressed_blob(vault):
+            vault = decompress_blob(vault)
+        return is_binary_blob(vault)
+
+    @property
+    def is_compressed(self):
+        """
+        True if the vault is compressed (see compress_blob)
+        :rtype: bool
+        """
+        return is_compressed_blob(self._vault)
+
+    def set_data_list(self, data_list, binary=False, compress=False):
+        """
+        Sets the data as data_list setter does.
+        If binary is True, the vault keeps the data in binary typed form by column types of the type table.
+        The data that can't be converted to the column types is kept as text
+
+        :param data_list: flat list of values
+        :param binary: store the data in binary typed form
+        :param compress: compress the vault if it is long enough (see compress_blob)
+        """
+        column_types = [column.type for column in self.type_table.columns] if binary else None
+        self._vault = list_to_blob(data_list, column_types, compress)
+
+    def set_data_table(self, data, binary=False, compress=False):
+        """
+        Sets the data as data_table setter does. See set_data_list
+
+        :param data: tabled or flat data
+        :param binary: store the data in binary typed form
+        :param compress: compress the vault if it is long enough
+        """
+        self.set_data_list(list(gen_flatten_data(data)), binary, compress)
+
     @property
     def data_table(self):
         return list_to_table(self.data_list, self.type_table.columns_count)
@@ -471,15 +543,25 @@ def flatten_data(data):
 #--------------------------------------------
 # Get tabled data, convert it to string blob for db insertion
 #--------------------------------------------
-def list_to_blob(data):
+def list_to_blob(data, column_types=None, compress=False):
     """
     Get tabled data, convert it to string blob for db insertion
 
     if you have tabled data use gen_flatten_data to flatten data first
 
+    If column_types are given, the blob is binary typed: values are converted to the column types
+    and stored as little-endian arrays, column by column, encoded with base64.
+    If a value can't be converted to its column type, the text blob is made
+
+    If compress is True, the blob is compressed (see compress_blob)
+
 
     :param data: FLATTENED list of values
     :type data: []
+    :param column_types: types of the columns, like ['int', 'double']
+    :type column_types: []
+    :param compress: compress the blob if it is long enough
+    :type compress: bool
     :return: string with text-blob for database insertion
     :rtype: str
 
@@ -487,6 +569,8 @@ def list_to_blob(data):
     "1|2|str"
     >>>list_to_blob(["strings", "with|surprise"])
     "strings|with&delimiter;surprise"
+    >>>list_to_blob([1, 2.5], ['int', 'double'])
+    "#ccdb-bin:1:1:id:AQAAAAAAAAAAAARA"
     """
     def prepare_item(p_item):
         if not isinstance(p_item, str):
@@ -495,18 +579,20 @@ def list_to_blob(data):
             item_str = p_item
         return item_str.replace(blob_delimiter, blob_delimiter_replacement)
 
+    if column_types:
+        blob = _list_to_binary_blob(data, column_types)
+        if blob is not None:
+            return compress_blob(blob) if compress else blob
+
     if len(data) == 0:
         return ""
     if len(data) == 1:
         return prepare_item(data[0])
 
-    #this for data[:-1] makes result like a1|a2|a3
-    blob = ""
-    for item in data[:-1]:
-        blob += prepare_item(item) + blob_delimiter
-    blob += prepare_item(data[-1])
+    #makes result like a1|a2|a3
+    blob = blob_delimiter.join(prepare_item(item) for item in data)
 
-    return blob
+    return compress_blob(blob) if compress else blob
 
 
 #--------------------------------------------
@@ -526,6 +612,14 @@ def blob_to_list(blob):
     >>>blob_to_list("strings|with&delimiter;surprise")
     ["strings", "with|surprise"]
     """
+    if is_compressed_blob(blob):
+        blob = decompress_blob(blob)
+
+    if is_binary_blob(blob):
+        items = _binary_blob_to_list(blob)
+        if items is not None:
+            return items
+
     splits = blob.split(blob_delimiter)
     items = []
     for item in splits:
@@ -533,6 +627,153 @@ def blob_to_list(blob):
     return items
 
 
+def is_binary_blob(blob):
+    """
+    :return: True if the blob is binary typed blob made by list_to_blob with column types
+    :rtype: bool
+    """
+    return blob is not None and blob.startswith(binary_blob_prefix)
+
+
+def is_compressed_blob(blob):
+    """
+    :return: True if the blob is compressed by compress_blob
+    :rtype: bool
+    """
+    return blob is not None and blob.startswith(compressed_blob_prefix)
+
+
+def compress_blob(blob, level=6):
+    """
+    Compresses text or binary blob with zlib. The result keeps the size of the blob
+    and base64 of its zlib stream. Blobs shorter than compressed_blob_min_size,
+    compressed blobs and blobs that don't get shorter are returned as they are
+
+    :param blob: text or binary blob
+    :param level: zlib compression level 1-9
+    :rtype: str
+    """
+    if blob is None or len(blob) < compressed_blob_min_size or is_compressed_blob(blob):
+        return blob
+
+    blob_bytes = blob.encode('utf-8')
+    encoded = base64.b64encode(zlib.compress(blob_bytes, level)).decode('ascii')
+    result = "{0}{1}:{2}:{3}".format(compressed_blob_prefix, compressed_blob_version, len(blob_bytes), encoded)
+    return result if len(result) < len(blob_bytes) else blob
+
+
+def decompress_blob(blob):
+    """
+    Restores the blob compressed by compress_blob
+
+    :param blob: compressed blob
+    :return: the original text or binary blob
+    :rtype: str
+    :raises ValueError: if the blob is not a valid compressed blob
+    """
+    try:
+        version, size, payload = blob[len(compressed_blob_prefix):].split(":")
+        if int(version) != compressed_blob_version:
+            raise ValueError("Unknown version of compressed blob: " + version)
+        blob_bytes = zlib.decompress(base64.b64decode(payload.encode('ascii'), validate=True))
+        if len(blob_bytes) != int(size):
+            raise ValueError("Size of decompressed blob doesn't match its header")
+        return blob_bytes.decode('utf-8')
+    except (zlib.error, binascii.Error, UnicodeError) as err:
+        raise ValueError("Compressed blob is damaged: " + str(err))
+
+
+def _parse_bool(item):
+    if isinstance(item, bool):
+        return item
+    if item in ("true", "false"):
+        return item == "true"
+    return int(item) != 0
+
+
+def _list_to_binary_blob(data, column_types):
+    """
+    Makes binary typed blob (see list_to_blob)
+
+    :return: the blob or None if the data can't be kept in binary form
+    """
+    cols_count = len(column_types)
+    if not data or len(data) % cols_count:
+        return None
+    rows_count = len(data) // cols_count
+
+    codes = ""
+    payload = bytearray()
+    try:
+        for col_index, column_type in enumerate(column_types):
+            code, value_format = binary_column_formats[column_type]
+            codes += code
+            column = data[col_index::cols_count]
+            if column_type == 'string':
+                for item in column:
+                    item_bytes = (item if isinstance(item, str) else repr(item)).encode('utf-8')
+                    payload += struct.pack('<I', len(item_bytes)) + item_bytes
+            elif column_type == 'double':
+                payload += struct.pack('<{0}d'.format(rows_count), *[float(item) for item in column])
+            elif column_type == 'bool':
+                payload += bytearray(1 if _parse_bool(item) else 0 for item in column)
+            else:
+                values = [int(item) for item in column]
+                payload += struct.pack('<{0}{1}'.format(rows_count, value_format), *values)
+    except (KeyError, ValueError, TypeError, struct.error):
+        return None
+
+    return "{0}{1}:{2}:{3}:{4}".format(binary_blob_prefix, binary_blob_version, rows_count, codes,
+                                       base64.b64encode(bytes(payload)).decode('ascii'))
+
+
+def _binary_blob_to_list(blob):
+    """
+    Reads binary typed blob to the list of strings, the same as blob_to_list gives for text blob
+
+    :return: list of cell strings row by row or None if the blob is not valid
+    """
+    formats_by_code = dict(binary_column_formats.values())
+    try:
+        version, rows_count, codes, payload = blob[len(binary_blob_prefix):].split(":")
+        if int(version) != binary_blob_version:
+            return None
+        rows_count = int(rows_count)
+        payload = base64.b64decode(payload.encode('ascii'), validate=True)
+
+        columns = []
+        pos = 0
+        for code in codes:
+            value_format = formats_by_code[code]
+            if value_format is None:
+                column = []
+                for _ in range(rows_count):
+                    length, = struct.unpack_from('<I', payload, pos)
+                    pos += 4
+                    if pos + length > len(payload):
+                        return None
+                    column.append(payload[pos:pos + length].decode('utf-8'))
+                    pos += length
+            else:
+                row_format = '<{0}{1}'.format(rows_count, value_format)
+                values = struct.unpack_from(row_format, payload, pos)
+                pos += struct.calcsize(row_format)
+                if code == 'd':
+                    column = [repr(value) for value in values]
+                elif code == 'b':
+                    column = ["true" if value else "false" for value in values]
+                else:
+                    column = [str(value) for value in values]
+            columns.append(column)
+
+        if pos != len(payload):
+            return None
+    except (KeyError, ValueError, struct.error, binascii.Error, UnicodeDecodeError):
+        return None
+
+    return [column[row] for row in range(rows_count) for column in columns]
+
+
 #--------------------------------------------
 # Converts flat array to tabled array
 #--------------------------------------------
@@ -1165,7 +1165,8 @@ class AlchemyProvider(object):
     # ------------------------------------------------
     # Creates Assignment
     # ------------------------------------------------
-    def create_assignment(self, data, path, min_run, max_run, variation_name, comment):
+    def create_assignment(self, data, path, min_run, max_run, variation_name, comment, binary_vault=False,
+                          compressed_vault=False):
         """
         Validation:
         If no such run range found, the new will be created (with no name)
@@ -1180,6 +1181,8 @@ class AlchemyProvider(object):
         @param max_run:
         @param variation_name:
         @param comment:
+        @param binary_vault: keep the data in binary typed form (see model.list_to_blob)
+        @param compressed_vault: compress the data if it is large enough (see model.compress_blob)
         @return: created assignment
         @rtype: Assignment
         """
@@ -1238,7 +1241,7 @@ class AlchemyProvider(object):
             assignment.run_range_id = run_range.id
             assignment.variation = variation
             assignment.variation_id = variation.id
-            assignment.constant_set.data_table = rows
+            assignment.constant_set.set_data_table(rows, binary_vault, compressed_vault)
             assignment.comment = comment
             assignment.author_id = user.id
             self.session.add(assignment)
@@ -1269,6 +1272,71 @@ class AlchemyProvider(object):
                                description="Updated assignment '{0}'".format(assignment.request),
                                comment=assignment.comment)
 
+    # ------------------------------------------------
+    # Converts vaults of constant sets to binary or text form
+    # ------------------------------------------------
+    def convert_constant_sets(self, binary=None, compress=None, batch_size=500):
+        """
+        Converts vaults of all constant sets to binary typed form or back to text form,
+        compresses or decompresses them.
+        Binary form keeps numbers as values, not as the text they were added with, so '1.10' is read back as '1.1'.
+        The data that can't be converted to the column types or doesn't get shorter in binary form is left as text,
+        the data that is too short to be compressed is left uncompressed.
+        Binary and compressed forms are read only by the versions that know them (see 'help vault')
+
+        :param binary: True - convert to binary typed form, False - convert to text form, None - keep the form
+        :param compress: True - compress vaults, False - decompress them, None - keep as they are
+        :param batch_size: number of constant sets committed at once
+        :return: (converted, skipped) - numbers of converted constant sets and the ones left as they are
+        :rtype: tuple
+        """
+
+        user = self.get_current_user()
+        if user.name == 'anonymous':
+            raise AnonymousUserForbiddenError
+
+        ids = [row[0] for row in self.session.query(ConstantSet.id).order_by(ConstantSet.id)]
+        converted = 0
+        skipped = 0
+        for start in range(0, len(ids), batch_size):
+            batch_ids = ids[start:start + batch_size]
+            for constant_set in self.session.query(ConstantSet).filter(ConstantSet.id.in_(batch_ids)):
+                is_binary = constant_set.is_binary if binary is None else binary
+                is_compressed = constant_set.is_compressed if compress is None else compress
+                if constant_set.is_binary == is_binary and constant_set.is_compressed == is_compressed:
+                    skipped += 1
+                    continue
+
+                vault = constant_set.vault
+                data_list = constant_set.data_list
+                if is_binary and not constant_set.is_binary:
+                    # binary form is kept only if it saves space, otherwise the data stays readable by all versions
+                    constant_set.set_data_list(data_list, False, is_compressed)
+                    text_size = len(constant_set.vault)
+                    constant_set.set_data_list(data_list, True, is_compressed)
+                    if len(constant_set.vault) >= text_size:
+                        constant_set.set_data_list(data_list, False, is_compressed)
+                else:
+                    constant_set.set_data_list(data_list, is_binary, is_compressed)
+                if constant_set.vault != vault:
+                    converted += 1
+                else:
+                    skipped += 1
+            self.session.commit()
+
+        forms = []
+        if binary is not None:
+            forms.append("binary" if binary else "text")
+        if compress is not None:
+            forms.append("compressed" if compress else "uncompressed")
+        self.create_log_record(user=user,
+                               affected_ids=["constantSets"],
+                               action="update",
+                               description="Converted {0} constant sets to {1} form".format(
+                                   converted, " ".join(forms)),
+                               comment="")
+        return converted, skipped
+
     # ------------------------------------------------
     # Deletes assignment
     # ------------------------------------------------
@@ -2,6 +2,7 @@ import unittest
 import os
 from ccdb import get_ccdb_home_path
 from ccdb.model import gen_flatten_data, list_to_blob, blob_to_list, list_to_table, TypeTableColumn
+from ccdb.model import compress_blob, decompress_blob, is_compressed_blob
 from ccdb.model import LogRecord, User
 from ccdb.errors import DatabaseStructureError, TypeTableNotFound, DirectoryNotFound, \
     UserNotFoundError, VariationNotFound, RunRangeNotFound
@@ -387,6 +388,31 @@ class AlchemyProviderTest(unittest.TestCase):
         self.assertItemsEqual(["1", "2", "str"], blob_to_list("1|2|str"))
         self.assertItemsEqual(["strings", "with|surprise"], blob_to_list("strings|with&delimiter;surprise"))
 
+    def test_binary_blob(self):
+        blob = list_to_blob([1, 2.5, "a|b", 2, -0.1, ""], ['int', 'double', 'string'])
+        self.assertTrue(blob.startswith("#ccdb-bin:1:2:ids:"))
+        self.assertNotIn("|", blob)
+        self.assertEqual(["1", "2.5", "a|b", "2", "-0.1", ""], blob_to_list(blob))
+
+        # values that don't match the column types are kept as text
+        self.assertEqual("x|2", list_to_blob(["x", 2], ['int', 'int']))
+
+    def test_compressed_blob(self):
+        data = ["{0:.4f}".format(1.0 + (i % 17) * 0.25) for i in range(500)]
+        for column_types in (None, ['double', 'double']):
+            blob = list_to_blob(data, column_types, compress=True)
+            self.assertTrue(is_compressed_blob(blob))
+            self.assertLess(len(blob), len(list_to_blob(data, column_types)))
+            self.assertEqual(list_to_blob(data, column_types), decompress_blob(blob))
+            self.assertEqual(data if column_types is None else [repr(float(item)) for item in data],
+                             blob_to_list(blob))
+
+        # short blobs are not compressed, damaged are not decompressed
+        self.assertEqual("1|2|3", list_to_blob([1, 2, 3], compress=True))
+        self.assertEqual("1|2|3", compress_blob("1|2|3"))
+        blob = list_to_blob(data, compress=True)
+        self.assertRaises(ValueError, decompress_blob, blob[:-8])
+
     def test_list_to_table(self):
         self.assertRaises(ValueError, list_to_table, [1, 2, 3], 2)
         self.assertItemsEqual([[1, 2, 3], [4, 5, 6]], list_to_table([1, 2, 3, 4, 5, 6], 3))
@@ -0,0 +1,120 @@
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <vector>
+#include <string>
+#include <atomic>
+#include <cstdlib>
+
+#include <CCDB/SQLiteCalibration.h>
+#include "CCDB/Helpers/StopWatch.h"
+
+// Scaling of GetCalib with the number of threads sharing one Calibration
+//
+// usage: benchmark_CacheScaling [connection string] [table]
+//   by default sqlite://$CCDB_HOME/sql/ccdb.sqlite and /test/test_vars/test_table are used
+//
+// For each number of threads the benchmark measures:
+//   cold - all threads ask the same table at once with an empty cache.
+//          The number of database loads shows how well misses are de-duplicated
+//   hot  - requests/s when all threads read the table from the cache
+//   frozen - requests/s when the table is read from the frozen snapshot (@see Calibration::Freeze)
+//   handle - requests/s when each thread reads the table through its own CalibHandle
+
+const int kRequestsPerThread = 20000;
+const int kThreadCounts[] = {1, 2, 4, 8, 16, 32, 64};
+
+
+void ReadConstants(ccdb::Calibration* calib, const std::string& table, int requests, bool useHandle, std::atomic<bool>* start, double* sum)
+{
+    std::vector<std::vector<double> > values;
+    ccdb::CalibHandle handle = calib->GetHandle(table);
+    while(!start->load()) std::this_thread::yield();
+
+    for(int i = 0; i < requests; i++) {
+        values.clear();
+        if(useHandle) {
+            calib->GetCalib(values, handle);
+        } else {
+            calib->GetCalib(values, table);
+        }
+        *sum += values[0][0];    // Trick the optimization
+    }
+}
+
+
+double RunThreads(ccdb::Calibration* calib, const std::string& table, int threadsCount, int requests, bool useHandle = false)
+{
+    // returns elapsed time in seconds
+
+    std::vector<std::thread> threads;
+    std::vector<double> sums(threadsCount, 0);
+    std::atomic<bool> start(false);
+
+    for(int i = 0; i < threadsCount; i++) {
+        threads.push_back(std::thread(ReadConstants, calib, table, requests, useHandle, &start, &sums[i]));
+    }
+
+    ccdb::StopWatch stopWatch;
+    start = true;
+    for(size_t i = 0; i < threads.size(); i++) threads[i].join();
+    return stopWatch.ElapsedUs() / 1e6;
+}
+
+
+int main(int argc, char* argv[])
+{
+    using namespace std;
+
+    string conStr;
+    if(argc > 1) {
+        conStr = argv[1];
+    } else {
+        const char* home = getenv("CCDB_HOME");
+        conStr = string("sqlite://") + (home ? home : ".") + "/sql/ccdb.sqlite";
+    }
+    string table = argc > 2 ? argv[2] : "/test/test_vars/test_table";
+
+    ccdb::SQLiteCalibration calib(100);
+    if(!calib.Connect(conStr)) {
+        cerr << "Can't connect to " << conStr << endl;
+        return 1;
+    }
+    calib.EnableCache(true);
+
+    cout << "Connection: " << conStr << endl;
+    cout << "Table:      " << table << endl;
+    cout << "Hardware threads: " << thread::hardware_concurrency() << endl << endl;
+    cout << setw(8) << "threads" << setw(12) << "cold loads" << setw(14) << "cold ms"
+         << setw(16) << "hot req/s" << setw(14) << "hot ns/req" << setw(16) << "frozen req/s" << setw(16) << "handle req/s" << endl;
+
+    for(int threadsCount : kThreadCounts) {
+
+        // Cold: one request per thread with the empty cache
+        calib.ClearCache();
+        unsigned long insertions = calib.GetCacheStats().Insertions;
+        double coldTime = RunThreads(&calib, table, threadsCount, 1);
+        unsigned long loads = calib.GetCacheStats().Insertions - insertions;
+
+        // Hot: everything is served from the cache
+        double hotTime = RunThreads(&calib, table, threadsCount, kRequestsPerThread);
+        double requests = (double)threadsCount * kRequestsPerThread;
+
+        // Frozen: the same from the immutable snapshot
+        calib.Freeze();
+        double frozenTime = RunThreads(&calib, table, threadsCount, kRequestsPerThread);
+        calib.Unfreeze();
+
+        // Handles: no parsing and no cache lookups
+        double handleTime = RunThreads(&calib, table, threadsCount, kRequestsPerThread, true);
+
+        cout << setw(8) << threadsCount << setw(12) << loads
+             << setw(14) << fixed << setprecision(3) << coldTime * 1e3
+             << setw(16) << setprecision(0) << requests / hotTime
+             << setw(14) << setprecision(1) << hotTime * 1e9 / requests
+             << setw(16) << setprecision(0) << requests / frozenTime
+             << setw(16) << setprecision(0) << requests / handleTime << endl;
+    }
+
+    return 0;
+}
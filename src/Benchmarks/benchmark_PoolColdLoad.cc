@@ -0,0 +1,103 @@
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <vector>
+#include <string>
+#include <atomic>
+#include <cstdlib>
+
+#include <CCDB/MySQLCalibration.h>
+#include "CCDB/Helpers/StopWatch.h"
+
+// Cold load time of all tables against the size of the connection pool
+//
+// usage: benchmark_PoolColdLoad [connection string] [threads] [run]
+//   by default mysql://ccdb_user@127.0.0.1:3306 ccdb (a local mysqld), 16 threads and run 0 are used
+//
+// For each pool size the benchmark loads every table of the database once from several threads:
+//   first - the cache is empty and pooled connections are opened on the way
+//   cold  - the cache is cleared, connections of the pool are already open
+// Pool size 0 is the calibration without the pool, all loads go one by one through one provider
+
+const int kPoolSizes[] = {0, 1, 2, 4, 8, 16};
+
+
+void LoadTables(ccdb::Calibration* calib, const std::vector<std::string>* namepaths, std::atomic<size_t>* next, std::atomic<bool>* start, std::atomic<size_t>* loaded)
+{
+    std::vector<std::vector<std::string> > values;
+    while(!start->load()) std::this_thread::yield();
+
+    // threads take tables one by one until all of them are loaded
+    for(size_t i = (*next)++; i < namepaths->size(); i = (*next)++) {
+        values.clear();
+        if(calib->GetCalib(values, (*namepaths)[i])) (*loaded)++;
+    }
+}
+
+
+double RunThreads(ccdb::Calibration* calib, const std::vector<std::string>& namepaths, int threadsCount, size_t& loaded)
+{
+    // returns elapsed time in seconds
+
+    std::vector<std::thread> threads;
+    std::atomic<size_t> next(0);
+    std::atomic<size_t> loadedCount(0);
+    std::atomic<bool> start(false);
+
+    for(int i = 0; i < threadsCount; i++) {
+        threads.push_back(std::thread(LoadTables, calib, &namepaths, &next, &start, &loadedCount));
+    }
+
+    ccdb::StopWatch stopWatch;
+    start = true;
+    for(size_t i = 0; i < threads.size(); i++) threads[i].join();
+    loaded = loadedCount;
+    return stopWatch.ElapsedUs() / 1e6;
+}
+
+
+int main(int argc, char* argv[])
+{
+    using namespace std;
+
+    string conStr = argc > 1 ? argv[1] : "mysql://ccdb_user@127.0.0.1:3306 ccdb";
+    int threadsCount = argc > 2 ? atoi(argv[2]) : 16;
+    int run = argc > 3 ? atoi(argv[3]) : 0;
+
+    cout << "Connection: " << conStr << endl;
+    cout << "Threads:    " << threadsCount << endl;
+    cout << "Run:        " << run << endl << endl;
+    cout << setw(10) << "pool size" << setw(10) << "tables" << setw(14) << "first ms"
+         << setw(14) << "cold ms" << setw(14) << "tables/s" << setw(14) << "connections" << setw(10) << "waits" << endl;
+
+    for(int poolSize : kPoolSizes) {
+
+        ccdb::MySQLCalibration calib(run);
+        if(!calib.Connect(conStr)) {
+            cerr << "Can't connect to " << conStr << endl;
+            return 1;
+        }
+        calib.EnableCache(true);
+        calib.SetPoolSize(poolSize);
+
+        vector<string> namepaths;
+        calib.GetListOfNamepaths(namepaths);
+
+        size_t loaded = 0;
+        double firstTime = RunThreads(&calib, namepaths, threadsCount, loaded);
+
+        calib.ClearCache();
+        double coldTime = RunThreads(&calib, namepaths, threadsCount, loaded);
+
+        ccdb::DataProviderPoolStats stats = {};
+        if(calib.GetProviderPool()) stats = calib.GetProviderPool()->GetStats();
+
+        cout << setw(10) << poolSize << setw(10) << loaded
+             << setw(14) << fixed << setprecision(1) << firstTime * 1e3
+             << setw(14) << setprecision(1) << coldTime * 1e3
+             << setw(14) << setprecision(0) << loaded / coldTime
+             << setw(14) << stats.Connections << setw(10) << stats.Waits << endl;
+    }
+
+    return 0;
+}
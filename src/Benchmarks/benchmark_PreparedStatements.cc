@@ -2,14 +2,18 @@
 #define benchmark_PreparedStatements_h__
 
 #include <string.h>
+#include <stdlib.h>
+#include <time.h>
 #include <my_global.h>
 #include <mysql.h>
 #include "CCDB/Console.h"
 #include "CCDB/Helpers/StopWatch.h"
 #include "CCDB/Providers/MySQLDataProvider.h"
+#include "CCDB/Providers/SQLiteDataProvider.h"
 #include "CCDB/Model/Assignment.h"
 #include "Benchmarks/benchmarks.h"
 #include "CCDB/Model/ConstantsTypeTable.h"
+#include "CCDB/Model/RunRange.h"
 
 
 
@@ -225,6 +229,14 @@ bool benchmark_PreparedStatements()
 
     BENCHMARK_FINISH("1000 times prepared statements");
 
+    //The same query through the provider, which uses cached prepared statements
+    BENCHMARK_START("MySQLDataProvider::GetAssignmentShort");
+    for (int i=0; i<10000; i++)
+    {
+        delete prov->GetAssignmentShort(100, "/test/test_vars/test_table", "default", false);
+    }
+    BENCHMARK_FINISH("10000 GetAssignmentShort");
+
     /* Fetch all rows */
     row_count= 0;
     fprintf(stdout, "Fetching results ...\n");
@@ -296,4 +308,94 @@ bool benchmark_PreparedStatements()
     return true;
 }
 
-#endif // benchmark_PreparedStatements_h__
\ No newline at end of file
+#endif // benchmark_PreparedStatements_h__
+
+
+//_______________________________________________________________
+bool benchmark_PreparedStatementsSQLite()
+{
+    //Compares the assignment query prepared for each request with the same
+    //query prepared once and the SQLiteDataProvider that keeps statements in the cache
+
+    const int requests = 10000;
+    const char* home = getenv("CCDB_HOME");
+    string path = string(home ? home : ".") + "/sql/ccdb.sqlite";
+
+    sqlite3* db = NULL;
+    if(sqlite3_open_v2(path.c_str(), &db, SQLITE_OPEN_READONLY, NULL) != SQLITE_OK)
+    {
+        fprintf(stderr, "cant open sqlite database %s\n", path.c_str());
+        sqlite3_close(db);
+        return false;
+    }
+
+    const char* query =
+        "SELECT `assignments`.`id` AS `asId`, "
+        "`constantSets`.`vault` AS `blob` "
+        "FROM  `assignments` "
+        "INNER JOIN `runRanges` ON `assignments`.`runRangeId`= `runRanges`.`id` "
+        "INNER JOIN `constantSets` ON `assignments`.`constantSetId` = `constantSets`.`id` "
+        "WHERE  `runRanges`.`runMin` <= ?1 "
+        "AND `runRanges`.`runMax` >= ?1 "
+        "AND  `assignments`.`variationId` =?2 "
+        "AND `constantSets`.`constantTypeId` = ?3 "
+        "ORDER BY `assignments`.`id` DESC "
+        "LIMIT 1 ";
+
+    BENCHMARK_INIT();
+
+    long rows = 0;
+    BENCHMARK_START("Prepare, execute and finalize for each request");
+    for (int i=0; i<requests; i++)
+    {
+        sqlite3_stmt* statement = NULL;
+        sqlite3_prepare_v2(db, query, -1, &statement, 0);
+        sqlite3_bind_int(statement, 1, 100);
+        sqlite3_bind_int(statement, 2, 1);
+        sqlite3_bind_int(statement, 3, 1);
+        while(sqlite3_step(statement) == SQLITE_ROW) rows++;
+        sqlite3_finalize(statement);
+    }
+    BENCHMARK_FINISH("10000 prepare-execute-finalize");
+
+    sqlite3_stmt* statement = NULL;
+    sqlite3_prepare_v2(db, query, -1, &statement, 0);
+    BENCHMARK_START("Prepare once, reset and rebind for each request");
+    for (int i=0; i<requests; i++)
+    {
+        sqlite3_reset(statement);
+        sqlite3_bind_int(statement, 1, 100);
+        sqlite3_bind_int(statement, 2, 1);
+        sqlite3_bind_int(statement, 3, 1);
+        while(sqlite3_step(statement) == SQLITE_ROW) rows++;
+    }
+    BENCHMARK_FINISH("10000 reset-bind-execute");
+    sqlite3_finalize(statement);
+    sqlite3_close(db);
+
+    //The same through the provider, which uses cached statements
+    SQLiteDataProvider *prov = new SQLiteDataProvider();
+    if(!prov->Connect("sqlite://" + path)) return false;
+
+    BENCHMARK_START("SQLiteDataProvider::GetAssignmentShort");
+    for (int i=0; i<requests; i++)
+    {
+        Assignment* assignment = prov->GetAssignmentShort(100, "/test/test_vars/test_table", "default", false);
+        if(assignment) rows++;
+        delete assignment;
+    }
+    BENCHMARK_FINISH("10000 GetAssignmentShort");
+
+    BENCHMARK_START("SQLiteDataProvider::GetAssignmentShort with time");
+    for (int i=0; i<requests; i++)
+    {
+        Assignment* assignment = prov->GetAssignmentShort(100, "/test/test_vars/test_table", time(NULL), "default", false);
+        if(assignment) rows++;
+        delete assignment;
+    }
+    BENCHMARK_FINISH("10000 GetAssignmentShort with time");
+
+    delete prov;
+    cout<<"rows selected "<<rows<<endl;
+    return true;
+}
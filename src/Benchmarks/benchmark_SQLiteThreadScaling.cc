@@ -0,0 +1,174 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include <string>
+#include <atomic>
+#include <cstdlib>
+#include <cstdio>
+
+#include <sqlite3.h>
+#include <CCDB/SQLiteCalibration.h>
+#include "CCDB/Helpers/StopWatch.h"
+
+// Scaling of SQLite cache misses with the number of threads
+//
+// usage: benchmark_SQLiteThreadScaling [tables] [rows] [columns] [synthetic db path]
+//   by default 200 tables of 10x10 doubles are written to /tmp/ccdb_synthetic.sqlite
+//
+// The synthetic database is a copy of $CCDB_HOME/sql/ccdb.sqlite with /synthetic/table_N tables.
+// Each table has an assignment for every block of 100 runs, each thread loads all tables for its own
+// block, so all requests are cache misses. For each number of threads the benchmark measures:
+//   shared - one provider with SQLITE_OPEN_FULLMUTEX connection, loads go one by one
+//   pool   - per thread SQLITE_OPEN_NOMUTEX connections (@see Calibration::SetPoolSize)
+
+const int kThreadCounts[] = {1, 2, 4, 8, 16};
+const int kMaxThreads = 16;
+
+
+bool Exec(sqlite3* db, const std::string& query)
+{
+    char* error = NULL;
+    if(sqlite3_exec(db, query.c_str(), NULL, NULL, &error) == SQLITE_OK) return true;
+    std::cerr << "SQLite error: " << (error ? error : "") << std::endl << "Query: " << query << std::endl;
+    sqlite3_free(error);
+    return false;
+}
+
+
+bool CreateSyntheticDatabase(const std::string& source, const std::string& path, int tables, int rows, int columns)
+{
+    // Copy of the test database with 'tables' type tables in /synthetic directory
+
+    std::ifstream in(source.c_str(), std::ios::binary);
+    std::ofstream out(path.c_str(), std::ios::binary | std::ios::trunc);
+    if(!in || !out) {
+        std::cerr << "Can't copy " << source << " to " << path << std::endl;
+        return false;
+    }
+    out << in.rdbuf();
+    out.close();
+
+    sqlite3* db = NULL;
+    if(sqlite3_open(path.c_str(), &db) != SQLITE_OK) {
+        std::cerr << "Can't open " << path << std::endl;
+        sqlite3_close(db);
+        return false;
+    }
+
+    // vault of rows x columns doubles
+    std::ostringstream vault;
+    for(int i = 0; i < rows * columns; i++) vault << (i ? "|" : "") << i * 0.5 + 0.25;
+
+    bool ok = Exec(db, "BEGIN") &&
+              Exec(db, "INSERT INTO directories (id, name, parentId) VALUES (1000, 'synthetic', 0)");
+
+    for(int block = 0; ok && block < kMaxThreads; block++) {
+        std::ostringstream query;
+        query << "INSERT INTO runRanges (id, name, runMin, runMax) VALUES (" << 1000 + block << ", '', " << block * 100 << ", " << block * 100 + 99 << ")";
+        ok = Exec(db, query.str());
+    }
+
+    int assignmentId = 1000;
+    for(int table = 0; ok && table < tables; table++) {
+        int typeId = 1000 + table;
+        std::ostringstream query;
+        query << "INSERT INTO typeTables (id, directoryId, name, nRows, nColumns) VALUES (" << typeId << ", 1000, 'table_" << table << "', " << rows << ", " << columns << ");";
+        for(int column = 0; column < columns; column++) {
+            query << "INSERT INTO columns (name, typeId, columnType, \"order\") VALUES ('c" << column << "', " << typeId << ", 'double', " << column << ");";
+        }
+        for(int block = 0; block < kMaxThreads; block++, assignmentId++) {
+            query << "INSERT INTO constantSets (id, vault, constantTypeId) VALUES (" << assignmentId << ", '" << vault.str() << "', " << typeId << ");";
+            query << "INSERT INTO assignments (id, variationId, runRangeId, constantSetId) VALUES (" << assignmentId << ", 1, " << 1000 + block << ", " << assignmentId << ");";
+        }
+        ok = Exec(db, query.str());
+    }
+
+    ok = ok && Exec(db, "COMMIT");
+    sqlite3_close(db);
+    return ok;
+}
+
+
+void LoadTables(ccdb::Calibration* calib, const std::vector<std::string>* namepaths, int run, std::atomic<bool>* start, double* sum)
+{
+    std::vector<std::vector<double> > values;
+    std::string runSuffix = ":" + std::to_string(run);
+    while(!start->load()) std::this_thread::yield();
+
+    for(size_t i = 0; i < namepaths->size(); i++) {
+        values.clear();
+        calib->GetCalib(values, (*namepaths)[i] + runSuffix);
+        *sum += values[0][0];    // Trick the optimization
+    }
+}
+
+
+double RunThreads(const std::string& conStr, const std::vector<std::string>& namepaths, int threadsCount, bool usePool)
+{
+    // returns elapsed time in seconds
+
+    ccdb::SQLiteCalibration calib(0);
+    if(!calib.Connect(conStr)) {
+        std::cerr << "Can't connect to " << conStr << std::endl;
+        exit(1);
+    }
+    calib.EnableCache(true);
+    if(usePool) calib.SetPoolSize(threadsCount);
+
+    std::vector<std::thread> threads;
+    std::vector<double> sums(threadsCount, 0);
+    std::atomic<bool> start(false);
+
+    for(int i = 0; i < threadsCount; i++) {
+        threads.push_back(std::thread(LoadTables, &calib, &namepaths, i * 100 + 50, &start, &sums[i]));
+    }
+
+    ccdb::StopWatch stopWatch;
+    start = true;
+    for(size_t i = 0; i < threads.size(); i++) threads[i].join();
+    return stopWatch.ElapsedUs() / 1e6;
+}
+
+
+int main(int argc, char* argv[])
+{
+    using namespace std;
+
+    int tables = argc > 1 ? atoi(argv[1]) : 200;
+    int rows = argc > 2 ? atoi(argv[2]) : 10;
+    int columns = argc > 3 ? atoi(argv[3]) : 10;
+    string path = argc > 4 ? argv[4] : "/tmp/ccdb_synthetic.sqlite";
+
+    const char* home = getenv("CCDB_HOME");
+    string source = string(home ? home : ".") + "/sql/ccdb.sqlite";
+    if(!CreateSyntheticDatabase(source, path, tables, rows, columns)) return 1;
+    string conStr = "sqlite://" + path;
+
+    vector<string> namepaths;
+    for(int i = 0; i < tables; i++) namepaths.push_back("/synthetic/table_" + to_string(i));
+
+    cout << "Database: " << path << " (" << tables << " tables " << rows << "x" << columns << ")" << endl;
+    cout << "Hardware threads: " << thread::hardware_concurrency() << endl << endl;
+    cout << setw(8) << "threads" << setw(12) << "loads"
+         << setw(14) << "shared ms" << setw(16) << "shared loads/s"
+         << setw(14) << "pool ms" << setw(16) << "pool loads/s" << setw(10) << "speedup" << endl;
+
+    for(int threadsCount : kThreadCounts) {
+        double loads = (double)threadsCount * tables;
+        double sharedTime = RunThreads(conStr, namepaths, threadsCount, false);
+        double poolTime = RunThreads(conStr, namepaths, threadsCount, true);
+
+        cout << setw(8) << threadsCount << setw(12) << setprecision(0) << fixed << loads
+             << setw(14) << setprecision(1) << sharedTime * 1e3
+             << setw(16) << setprecision(0) << loads / sharedTime
+             << setw(14) << setprecision(1) << poolTime * 1e3
+             << setw(16) << setprecision(0) << loads / poolTime
+             << setw(10) << setprecision(2) << sharedTime / poolTime << endl;
+    }
+
+    remove(path.c_str());
+    return 0;
+}
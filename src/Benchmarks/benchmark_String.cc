@@ -4,6 +4,8 @@
 #include "CCDB/Console.h"
 #include "CCDB/Helpers/StringUtils.h"
 #include "CCDB/Helpers/StopWatch.h"
+#include "CCDB/Model/Assignment.h"
+#include "CCDB/Globals.h"
 #include <sstream>
 
 using namespace std;
@@ -62,5 +64,130 @@ bool benchmark_String()
           string query = ss.str();
     }
     BENCHMARK_FINISH("100000 of stringstream formatting do in ");
+
+    //Blob of 10000 cells, every 100th cell has an escaped separator
+    string blob;
+    for (int i=0; i<10000; i++)
+    {
+        if(i) blob.append(CCDB_DATA_BLOB_DELIMETER);
+        blob.append(i%100 ? StringUtils::IntToString(i) + ".25" : string("a&delimiter;b"));
+    }
+
+    //Tokenizing as it was done before: split to substrings, decode every cell and decode again on GetVectorData
+    size_t cellsCount = 0;
+    BENCHMARK_START("100 x 10000 cells blob. StringUtils::Split + DecodeBlobSeparator");
+    for (int i=0; i<100; i++)
+    {
+        vector<string> cells = StringUtils::Split(blob, CCDB_DATA_BLOB_DELIMETER);
+        for (size_t j=0; j<cells.size(); j++) cells[j] = Assignment::DecodeBlobSeparator(cells[j]);
+        vector<string> vectorData;
+        for (size_t j=0; j<cells.size(); j++) vectorData.push_back(Assignment::DecodeBlobSeparator(cells[j]));
+        cellsCount += vectorData.size();
+    }
+    BENCHMARK_FINISH("100 x 10000 cells blob. StringUtils::Split + DecodeBlobSeparator do in ");
+
+    //Single pass tokenizer that keeps cell offsets
+    BENCHMARK_START("100 x 10000 cells blob. Assignment::SetRawData + GetVectorData");
+    for (int i=0; i<100; i++)
+    {
+        Assignment assignment;
+        assignment.SetRawData(blob);
+        vector<string> vectorData;
+        assignment.GetVectorData(vectorData);
+        cellsCount += vectorData.size();
+    }
+    BENCHMARK_FINISH("100 x 10000 cells blob. Assignment::SetRawData + GetVectorData do in ");
+
+    //Tokenizing and conversion to double without making cell strings
+    double sum = 0;
+    BENCHMARK_START("100 x 10000 cells blob. Assignment::SetRawData + GetDoubleValues");
+    for (int i=0; i<100; i++)
+    {
+        Assignment assignment;
+        assignment.SetRawData(blob);
+        sum += assignment.GetDoubleValues()[1];
+    }
+    BENCHMARK_FINISH("100 x 10000 cells blob. Assignment::SetRawData + GetDoubleValues do in ");
+
+    gConsole.WriteLine(" cells: %i, sum: %f", (int)cellsCount, sum);  //Trick the optimization
+
+    //Numeric parsing of detector sized tables: FCAL has 2800 blocks, CDC 3522 straws.
+    //The old path splits the blob to strings and calls atof on each of them
+    const int tableSizes[] = {2800, 3522};
+    const char* tableNames[] = {"FCAL 2800 cells", "CDC 3522 cells"};
+    for (int table=0; table<2; table++)
+    {
+        string numbers;
+        for (int i=0; i<tableSizes[table]; i++)
+        {
+            if(i) numbers.append(CCDB_DATA_BLOB_DELIMETER);
+            numbers.append(StringUtils::Format("%.6f", (i%2 ? -1 : 1) * (i * 0.731 + 0.0123456)));
+        }
+
+        double atofSum = 0;
+        string title = string("1000 x ") + tableNames[table] + ". StringUtils::Split + atof";
+        BENCHMARK_START(title.c_str());
+        for (int i=0; i<1000; i++)
+        {
+            vector<string> cells = StringUtils::Split(numbers, CCDB_DATA_BLOB_DELIMETER);
+            for (size_t j=0; j<cells.size(); j++) atofSum += atof(cells[j].c_str());
+        }
+        BENCHMARK_FINISH((title + " do in ").c_str());
+
+        double bulkSum = 0;
+        size_t errors = 0;
+        title = string("1000 x ") + tableNames[table] + ". StringUtils::ParseDoubles";
+        BENCHMARK_START(title.c_str());
+        for (int i=0; i<1000; i++)
+        {
+            vector<double> values;
+            values.reserve(tableSizes[table]);
+            errors += StringUtils::ParseDoubles(numbers.data(), numbers.data() + numbers.size(), CCDB_DATA_BLOB_DELIMETER[0], values);
+            for (size_t j=0; j<values.size(); j++) bulkSum += values[j];
+        }
+        BENCHMARK_FINISH((title + " do in ").c_str());
+
+        gConsole.WriteLine(" atof sum: %f, bulk sum: %f, errors: %i", atofSum, bulkSum, (int)errors);
+    }
+
+    //Text vs binary typed blob of a channel table: sector, layer, component (int) and gain, pedestal (double)
+    ConstantsTypeTable channelsTable;
+    channelsTable.AddColumn("sector", ConstantsTypeColumn::cIntColumn);
+    channelsTable.AddColumn("layer", ConstantsTypeColumn::cIntColumn);
+    channelsTable.AddColumn("component", ConstantsTypeColumn::cIntColumn);
+    channelsTable.AddColumn("gain", ConstantsTypeColumn::cDoubleColumn);
+    channelsTable.AddColumn("pedestal", ConstantsTypeColumn::cDoubleColumn);
+    vector<ConstantsTypeColumn::ColumnTypes> channelTypes;
+    for (size_t i=0; i<channelsTable.GetColumns().size(); i++) channelTypes.push_back(channelsTable.GetColumns()[i]->GetType());
+
+    vector<string> channelCells;
+    for (int i=0; i<3600; i++)
+    {
+        channelCells.push_back(StringUtils::IntToString(i/600 + 1));
+        channelCells.push_back(StringUtils::IntToString(i/100%6 + 1));
+        channelCells.push_back(StringUtils::IntToString(i%100 + 1));
+        channelCells.push_back(StringUtils::Format("%.17g", 1.0 + (i%37) * 0.0123456789));
+        channelCells.push_back(StringUtils::Format("%.6f", 100.0 + (i%53) * 0.731));
+    }
+    string textBlob = Assignment::VectorToBlob(channelCells);
+    string binaryBlob = Assignment::VectorToBlob(channelCells, channelTypes);
+    gConsole.WriteLine(" 3600 x 5 channels table. text blob: %i bytes, binary blob: %i bytes", (int)textBlob.size(), (int)binaryBlob.size());
+
+    const string* blobs[] = {&textBlob, &binaryBlob};
+    const char* blobNames[] = {"1000 x 3600 x 5 text blob. SetRawData + GetTypedColumns", "1000 x 3600 x 5 binary blob. SetRawData + GetTypedColumns"};
+    for (int kind=0; kind<2; kind++)
+    {
+        double gainSum = 0;
+        BENCHMARK_START(blobNames[kind]);
+        for (int i=0; i<1000; i++)
+        {
+            Assignment assignment;
+            assignment.SetTypeTable(&channelsTable);
+            assignment.SetRawData(*blobs[kind]);
+            gainSum += assignment.GetTypedColumns()[3].Doubles[7];
+        }
+        BENCHMARK_FINISH((string(blobNames[kind]) + " do in ").c_str());
+        gConsole.WriteLine(" gain sum: %f", gainSum);
+    }
     return true;
 }
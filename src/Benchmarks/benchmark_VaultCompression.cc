@@ -0,0 +1,307 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <random>
+#include <cmath>
+#include <cstdlib>
+#include <cstdio>
+
+#include <sqlite3.h>
+#include <CCDB/SQLiteCalibration.h>
+#include "CCDB/Model/Assignment.h"
+#include "CCDB/Model/ConstantsTypeTable.h"
+#include "CCDB/Helpers/StringUtils.h"
+#include "CCDB/Helpers/StopWatch.h"
+
+// Size, transfer time and decode time of text, binary and compressed vaults
+//
+// usage: benchmark_VaultCompression [versions] [synthetic db path prefix]
+//   by default 20 versions of each table are written to /tmp/ccdb_vault_<form>.sqlite
+//
+// The synthetic databases are copies of $CCDB_HOME/sql/ccdb.sqlite with /synthetic tables
+// shaped like the large real ones plus a set of small ones:
+//   gains      - 3600 channels: sector, layer, component (int), gain, pedestal (double)
+//   time_walk  - 1000 x 8 fit parameters
+//   field_map  - 10000 grid points: x, y, z (int), bx, by, bz (double)
+//   status_N   - 40 tables of 1 x 4 ints, too short to be compressed
+// Each table has a new version for every block of 100 runs. The same data is written in each form:
+//   size     - the database file size and the time to transfer it over 100 Mbit/s and 1 Gbit/s links
+//   decode   - DecompressBlob + SetRawData + GetDoubleValues of all vaults kept in memory
+//   load     - GetCalib of every table version through SQLiteCalibration (cache misses)
+
+const int kStatusTables = 40;
+
+struct SyntheticTable
+{
+    std::string Name;
+    ccdb::ConstantsTypeTable Table;
+    std::vector<ccdb::ConstantsTypeColumn::ColumnTypes> Types;
+    std::vector<std::vector<std::string> > Versions;    // cells of each version, row by row
+};
+
+
+bool Exec(sqlite3* db, const std::string& query)
+{
+    char* error = NULL;
+    if(sqlite3_exec(db, query.c_str(), NULL, NULL, &error) == SQLITE_OK) return true;
+    std::cerr << "SQLite error: " << (error ? error : "") << std::endl << "Query: " << query << std::endl;
+    sqlite3_free(error);
+    return false;
+}
+
+
+void AddColumn(SyntheticTable& table, const std::string& name, ccdb::ConstantsTypeColumn::ColumnTypes type)
+{
+    table.Table.AddColumn(name, type);
+    table.Types.push_back(type);
+}
+
+
+std::vector<SyntheticTable> MakeTables(int versions)
+{
+    // Values are printed with the precision they have in calibration files
+
+    using ccdb::StringUtils;
+    using ccdb::ConstantsTypeColumn;
+
+    std::mt19937 random(12345);
+    std::normal_distribution<double> noise(0, 1);
+    std::vector<SyntheticTable> tables(3 + kStatusTables);
+
+    SyntheticTable& gains = tables[0];
+    gains.Name = "gains";
+    AddColumn(gains, "sector", ConstantsTypeColumn::cIntColumn);
+    AddColumn(gains, "layer", ConstantsTypeColumn::cIntColumn);
+    AddColumn(gains, "component", ConstantsTypeColumn::cIntColumn);
+    AddColumn(gains, "gain", ConstantsTypeColumn::cDoubleColumn);
+    AddColumn(gains, "pedestal", ConstantsTypeColumn::cDoubleColumn);
+    for(int version = 0; version < versions; version++) {
+        std::vector<std::string> cells;
+        for(int i = 0; i < 3600; i++) {
+            cells.push_back(StringUtils::IntToString(i / 600 + 1));
+            cells.push_back(StringUtils::IntToString(i / 100 % 6 + 1));
+            cells.push_back(StringUtils::IntToString(i % 100 + 1));
+            cells.push_back(StringUtils::Format("%.4f", 1.0 + 0.05 * noise(random)));
+            cells.push_back(StringUtils::Format("%.2f", 200.0 + 5 * noise(random)));
+        }
+        gains.Versions.push_back(cells);
+    }
+
+    SyntheticTable& timeWalk = tables[1];
+    timeWalk.Name = "time_walk";
+    for(int column = 0; column < 8; column++) AddColumn(timeWalk, "p" + StringUtils::IntToString(column), ConstantsTypeColumn::cDoubleColumn);
+    for(int version = 0; version < versions; version++) {
+        std::vector<std::string> cells;
+        for(int i = 0; i < 1000 * 8; i++) cells.push_back(StringUtils::Format("%.6e", std::pow(10.0, i % 8 - 4) * (1 + 0.1 * noise(random))));
+        timeWalk.Versions.push_back(cells);
+    }
+
+    // the field map is rescaled rarely, so versions repeat
+    SyntheticTable& fieldMap = tables[2];
+    fieldMap.Name = "field_map";
+    AddColumn(fieldMap, "x", ConstantsTypeColumn::cIntColumn);
+    AddColumn(fieldMap, "y", ConstantsTypeColumn::cIntColumn);
+    AddColumn(fieldMap, "z", ConstantsTypeColumn::cIntColumn);
+    AddColumn(fieldMap, "bx", ConstantsTypeColumn::cDoubleColumn);
+    AddColumn(fieldMap, "by", ConstantsTypeColumn::cDoubleColumn);
+    AddColumn(fieldMap, "bz", ConstantsTypeColumn::cDoubleColumn);
+    for(int version = 0; version < versions; version++) {
+        double scale = 1.0 + 0.01 * (version / 5);
+        std::vector<std::string> cells;
+        for(int i = 0; i < 10000; i++) {
+            int x = i % 20 * 5 - 50, y = i / 20 % 20 * 5 - 50, z = i / 400 * 10;
+            cells.push_back(StringUtils::IntToString(x));
+            cells.push_back(StringUtils::IntToString(y));
+            cells.push_back(StringUtils::IntToString(z));
+            cells.push_back(StringUtils::Format("%.5g", scale * 0.01 * x * std::exp(-z / 200.0)));
+            cells.push_back(StringUtils::Format("%.5g", scale * 0.01 * y * std::exp(-z / 200.0)));
+            cells.push_back(StringUtils::Format("%.5g", scale * 5.0 * std::exp(-(x * x + y * y) / 5000.0 - z / 250.0)));
+        }
+        fieldMap.Versions.push_back(cells);
+    }
+
+    for(int table = 0; table < kStatusTables; table++) {
+        SyntheticTable& status = tables[3 + table];
+        status.Name = "status_" + StringUtils::IntToString(table);
+        for(int column = 0; column < 4; column++) AddColumn(status, "s" + StringUtils::IntToString(column), ConstantsTypeColumn::cIntColumn);
+        for(int version = 0; version < versions; version++) {
+            std::vector<std::string> cells;
+            for(int column = 0; column < 4; column++) cells.push_back(StringUtils::IntToString(random() % 3));
+            status.Versions.push_back(cells);
+        }
+    }
+    return tables;
+}
+
+
+std::string MakeVault(const SyntheticTable& table, int version, bool binary, bool compressed)
+{
+    std::string blob = binary ? ccdb::Assignment::VectorToBlob(table.Versions[version], table.Types)
+                              : ccdb::Assignment::VectorToBlob(table.Versions[version]);
+    return compressed ? ccdb::Assignment::CompressBlob(blob) : blob;
+}
+
+
+bool CreateSyntheticDatabase(const std::string& source, const std::string& path, const std::vector<SyntheticTable>& tables,
+                             int versions, bool binary, bool compressed, std::vector<std::string>& vaults)
+{
+    // Copy of the test database with the tables in /synthetic directory. vaults are the written ones
+
+    std::ifstream in(source.c_str(), std::ios::binary);
+    std::ofstream out(path.c_str(), std::ios::binary | std::ios::trunc);
+    if(!in || !out) {
+        std::cerr << "Can't copy " << source << " to " << path << std::endl;
+        return false;
+    }
+    out << in.rdbuf();
+    out.close();
+
+    sqlite3* db = NULL;
+    if(sqlite3_open(path.c_str(), &db) != SQLITE_OK) {
+        std::cerr << "Can't open " << path << std::endl;
+        sqlite3_close(db);
+        return false;
+    }
+
+    bool ok = Exec(db, "BEGIN") &&
+              Exec(db, "INSERT INTO directories (id, name, parentId) VALUES (1000, 'synthetic', 0)");
+
+    for(int version = 0; ok && version < versions; version++) {
+        std::ostringstream query;
+        query << "INSERT INTO runRanges (id, name, runMin, runMax) VALUES (" << 1000 + version << ", '', " << version * 100 << ", " << version * 100 + 99 << ")";
+        ok = Exec(db, query.str());
+    }
+
+    sqlite3_stmt* insertVault = NULL;
+    ok = ok && sqlite3_prepare_v2(db, "INSERT INTO constantSets (id, vault, constantTypeId) VALUES (?, ?, ?)", -1, &insertVault, NULL) == SQLITE_OK;
+
+    int assignmentId = 1000;
+    vaults.clear();
+    for(size_t table = 0; ok && table < tables.size(); table++) {
+        int typeId = 1000 + (int)table;
+        const std::vector<ccdb::ConstantsTypeColumn*>& columns = tables[table].Table.GetColumns();
+        std::ostringstream query;
+        query << "INSERT INTO typeTables (id, directoryId, name, nRows, nColumns) VALUES (" << typeId << ", 1000, '" << tables[table].Name << "', "
+              << tables[table].Versions[0].size() / columns.size() << ", " << columns.size() << ");";
+        for(size_t column = 0; column < columns.size(); column++) {
+            query << "INSERT INTO columns (name, typeId, columnType, \"order\") VALUES ('" << columns[column]->GetName() << "', " << typeId
+                  << ", '" << columns[column]->GetTypeString() << "', " << column << ");";
+        }
+        for(int version = 0; version < versions; version++, assignmentId++) {
+            query << "INSERT INTO assignments (id, variationId, runRangeId, constantSetId) VALUES (" << assignmentId << ", 1, " << 1000 + version << ", " << assignmentId << ");";
+        }
+        ok = Exec(db, query.str());
+
+        for(int version = 0; ok && version < versions; version++) {
+            vaults.push_back(MakeVault(tables[table], version, binary, compressed));
+            sqlite3_bind_int(insertVault, 1, assignmentId - versions + version);
+            sqlite3_bind_text(insertVault, 2, vaults.back().data(), (int)vaults.back().size(), SQLITE_STATIC);
+            sqlite3_bind_int(insertVault, 3, typeId);
+            ok = sqlite3_step(insertVault) == SQLITE_DONE;
+            sqlite3_reset(insertVault);
+        }
+    }
+
+    sqlite3_finalize(insertVault);
+    ok = ok && Exec(db, "COMMIT") && Exec(db, "VACUUM");
+    sqlite3_close(db);
+    return ok;
+}
+
+
+double DecodeVaults(std::vector<SyntheticTable>& tables, const std::vector<std::string>& vaults, int versions)
+{
+    // returns elapsed time in seconds
+
+    double sum = 0;
+    ccdb::StopWatch stopWatch;
+    for(size_t i = 0; i < vaults.size(); i++) {
+        std::string blob;
+        if(ccdb::Assignment::IsCompressedBlob(vaults[i])) ccdb::Assignment::DecompressBlob(vaults[i], blob);
+        else blob = vaults[i];
+
+        ccdb::Assignment assignment;
+        assignment.SetTypeTable(&tables[i / versions].Table);
+        assignment.SetRawData(blob);
+        sum += assignment.GetDoubleValues()[0];    // Trick the optimization
+    }
+    double elapsed = stopWatch.ElapsedUs() / 1e6;
+    if(sum == 0.12345) std::cout << sum;
+    return elapsed;
+}
+
+
+double LoadTables(const std::string& conStr, const std::vector<SyntheticTable>& tables, int versions)
+{
+    // returns elapsed time in seconds
+
+    ccdb::SQLiteCalibration calib(0);
+    if(!calib.Connect(conStr)) {
+        std::cerr << "Can't connect to " << conStr << std::endl;
+        exit(1);
+    }
+    calib.EnableCache(false);
+
+    std::vector<double> values;
+    size_t rows, columns;
+    double sum = 0;
+    ccdb::StopWatch stopWatch;
+    for(int version = 0; version < versions; version++) {
+        for(size_t table = 0; table < tables.size(); table++) {
+            calib.GetCalib(values, rows, columns, "/synthetic/" + tables[table].Name + ":" + std::to_string(version * 100 + 50));
+            sum += values[0];    // Trick the optimization
+        }
+    }
+    double elapsed = stopWatch.ElapsedUs() / 1e6;
+    if(sum == 0.12345) std::cout << sum;
+    return elapsed;
+}
+
+
+int main(int argc, char* argv[])
+{
+    using namespace std;
+
+    int versions = argc > 1 ? atoi(argv[1]) : 20;
+    string prefix = argc > 2 ? argv[2] : "/tmp/ccdb_vault_";
+
+    const char* home = getenv("CCDB_HOME");
+    string source = string(home ? home : ".") + "/sql/ccdb.sqlite";
+    vector<SyntheticTable> tables = MakeTables(versions);
+
+    cout << "Tables: " << tables.size() << " x " << versions << " versions" << endl << endl;
+    cout << setw(18) << "form" << setw(10) << "MB" << setw(8) << "ratio"
+         << setw(14) << "100Mbit/s s" << setw(12) << "1Gbit/s s"
+         << setw(12) << "decode ms" << setw(10) << "load ms" << endl;
+
+    const char* names[] = {"text", "binary", "compressed text", "compressed binary"};
+    double textSize = 0;
+    for(int form = 0; form < 4; form++) {
+        bool binary = form % 2 == 1;
+        bool compressed = form >= 2;
+        string path = prefix + ccdb::StringUtils::Replace(" ", "_", names[form]) + ".sqlite";
+
+        vector<string> vaults;
+        if(!CreateSyntheticDatabase(source, path, tables, versions, binary, compressed, vaults)) return 1;
+
+        ifstream file(path.c_str(), ios::binary | ios::ate);
+        double size = (double)file.tellg();
+        if(form == 0) textSize = size;
+
+        double decodeTime = DecodeVaults(tables, vaults, versions);
+        double loadTime = LoadTables("sqlite://" + path, tables, versions);
+
+        cout << setw(18) << names[form] << setw(10) << setprecision(2) << fixed << size / 1e6
+             << setw(8) << setprecision(2) << textSize / size
+             << setw(14) << setprecision(2) << size * 8 / 1e8
+             << setw(12) << setprecision(3) << size * 8 / 1e9
+             << setw(12) << setprecision(1) << decodeTime * 1e3
+             << setw(10) << setprecision(1) << loadTime * 1e3 << endl;
+
+        remove(path.c_str());
+    }
+    return 0;
+}
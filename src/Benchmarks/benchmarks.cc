@@ -49,6 +49,7 @@ std::string gConnectionString;
 bool benchmark_UserAPI();
 //bool benchmark_Providers();             //providers benchmark
 bool benchmark_PreparedStatements();    //prepared statements benchmark
+bool benchmark_PreparedStatementsSQLite();  //prepared statements benchmark for SQLite
 bool banchmark_UserAPIMultithread();
 bool benchmark_String();
 bool benchmark_AllHallDConstants();
@@ -64,6 +65,7 @@ bool RunBenchmarks()
     //benchmark_String();
   //  result = result && benchmark_Providers();       //providers benchmark
     //result = result && benchmark_PreparedStatements();
+    //result = result && benchmark_PreparedStatementsSQLite();
 
     return result;
 }
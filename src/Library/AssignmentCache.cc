@@ -0,0 +1,492 @@
+#include <algorithm>
+
+#include "CCDB/AssignmentCache.h"
+
+using namespace std;
+
+namespace ccdb
+{
+
+namespace
+{
+    /** RAII holder of the shared (reader) lock */
+    class SharedLock
+    {
+    public:
+        explicit SharedLock(pthread_rwlock_t* lock): mLock(lock) { pthread_rwlock_rdlock(mLock); }
+        ~SharedLock() { pthread_rwlock_unlock(mLock); }
+    private:
+        pthread_rwlock_t* mLock;
+        SharedLock(const SharedLock&);
+        SharedLock& operator=(const SharedLock&);
+    };
+
+    /** RAII holder of the exclusive (writer) lock */
+    class ExclusiveLock
+    {
+    public:
+        explicit ExclusiveLock(pthread_rwlock_t* lock): mLock(lock) { pthread_rwlock_wrlock(mLock); }
+        ~ExclusiveLock() { pthread_rwlock_unlock(mLock); }
+    private:
+        pthread_rwlock_t* mLock;
+        ExclusiveLock(const ExclusiveLock&);
+        ExclusiveLock& operator=(const ExclusiveLock&);
+    };
+}
+
+//______________________________________________________________________________
+AssignmentCache::AssignmentCache(size_t memoryLimit /*=CCDB_DEFAULT_CACHE_MEMORY_LIMIT*/):
+    mBytes(0),
+    mMemoryLimit(memoryLimit),
+    mTick(0),
+    mHits(0),
+    mMisses(0),
+    mMissingCount(0),
+    mEvictions(0),
+    mInsertions(0),
+    mMissingHits(0)
+{
+    pthread_rwlock_init(&mLock, NULL);
+}
+
+
+//______________________________________________________________________________
+AssignmentCache::~AssignmentCache()
+{
+    pthread_rwlock_destroy(&mLock);
+}
+
+
+//______________________________________________________________________________
+shared_ptr<Assignment> AssignmentCache::Get(const string& key)
+{
+    /** @brief Gets assignment by key and marks it as most recently used
+     *
+     * @parameter [in] key - cache key
+     * @return   shared pointer to assignment or empty pointer if key is not in the cache
+     */
+
+    SharedLock lock(&mLock);
+
+    Entries::iterator iter = mEntries.find(key);
+    if(iter == mEntries.end())
+    {
+        mMisses++;
+        return shared_ptr<Assignment>();
+    }
+
+    Touch(iter->second.LastUse);
+    mHits++;
+    return iter->second.Data;
+}
+
+
+//______________________________________________________________________________
+void AssignmentCache::Put(const string& key, const shared_ptr<Assignment>& assignment)
+{
+    /** @brief Adds assignment to the cache. Replaces the assignment if key exists
+     *
+     * Adding may evict the least recently used assignments to fit the memory budget
+     *
+     * @parameter [in] key - cache key
+     * @parameter [in] assignment - assignment to cache. Empty pointers are ignored
+     */
+
+    if(!assignment) return;
+
+    ExclusiveLock lock(&mLock);
+    PutEntry(key, assignment);
+    EvictToFit();
+}
+
+
+//______________________________________________________________________________
+shared_ptr<Assignment> AssignmentCache::Get(const string& requestKey, int run, int* runMin /*=NULL*/, int* runMax /*=NULL*/)
+{
+    /** @brief Gets assignment cached for a run interval that contains the run
+     *
+     * @parameter [in] requestKey - request key without run number, i.e. path:variation:time
+     * @parameter [in] run - run number
+     * @parameter [out] runMin - if not NULL, receives the first run of the interval
+     * @parameter [out] runMax - if not NULL, receives the last run of the interval
+     * @return   shared pointer to assignment or empty pointer if no known interval contains the run
+     */
+
+    SharedLock lock(&mLock);
+
+    Entry* entry = Find(requestKey, run, runMin, runMax);
+    if(!entry)
+    {
+        mMisses++;
+        return shared_ptr<Assignment>();
+    }
+
+    Touch(entry->LastUse);
+    mHits++;
+    return entry->Data;
+}
+
+
+//______________________________________________________________________________
+shared_ptr<Assignment> AssignmentCache::Peek(const string& requestKey, int run, int* runMin /*=NULL*/, int* runMax /*=NULL*/)
+{
+    /** @brief The same as Get(requestKey, run) but hits and misses are not counted */
+
+    SharedLock lock(&mLock);
+
+    Entry* entry = Find(requestKey, run, runMin, runMax);
+    if(!entry) return shared_ptr<Assignment>();
+
+    Touch(entry->LastUse);
+    return entry->Data;
+}
+
+
+//______________________________________________________________________________
+void AssignmentCache::Put(const string& requestKey, int runMin, int runMax, const string& key, const shared_ptr<Assignment>& assignment)
+{
+    /** @brief Adds assignment and the run interval for which the request resolves to it
+     *
+     * @parameter [in] requestKey - request key without run number, i.e. path:variation:time
+     * @parameter [in] runMin - first run of the interval
+     * @parameter [in] runMax - last run of the interval
+     * @parameter [in] key - key of the assignment itself, i.e. path:assignment_id
+     * @parameter [in] assignment - assignment to cache. Empty pointers are ignored
+     */
+
+    if(!assignment) return;
+
+    ExclusiveLock lock(&mLock);
+    Entries::iterator iter = PutEntry(key, assignment);
+
+    RunInterval& interval = mRunIntervals[requestKey][runMin];
+    interval.RunMax = runMax;
+    interval.Key = key;
+    iter->second.Intervals.push_back(make_pair(requestKey, runMin));
+
+    size_t bytes = sizeof(RunInterval) + requestKey.capacity() + key.capacity();
+    iter->second.Bytes += bytes;
+    mBytes += bytes;
+
+    EvictToFit();
+}
+
+
+//______________________________________________________________________________
+void AssignmentCache::PutMissing(const string& requestKey, int runMin, int runMax)
+{
+    /** @brief Remembers that the request has no assignment for runs of the interval
+     *
+     * @parameter [in] requestKey - request key without run number, i.e. path:variation:time
+     * @parameter [in] runMin - first run of the interval
+     * @parameter [in] runMax - last run of the interval
+     */
+
+    ExclusiveLock lock(&mLock);
+    MissingEntries::iterator iter = mMissingIntervals.find(requestKey);
+    if(iter == mMissingIntervals.end())
+    {
+        iter = mMissingIntervals.emplace(piecewise_construct, forward_as_tuple(requestKey), forward_as_tuple()).first;
+        iter->second.Bytes = sizeof(MissingEntry) + requestKey.capacity();
+        mBytes += iter->second.Bytes;
+    }
+    Touch(iter->second.LastUse);
+
+    if(iter->second.Intervals.insert(make_pair(runMin, runMax)).second)
+    {
+        //map node with its links
+        size_t bytes = sizeof(pair<const int, int>) + 4 * sizeof(void*);
+        iter->second.Bytes += bytes;
+        mBytes += bytes;
+        mMissingCount++;
+    }
+
+    EvictToFit();
+}
+
+
+//______________________________________________________________________________
+bool AssignmentCache::IsMissing(const string& requestKey, int run, int* runMin /*=NULL*/, int* runMax /*=NULL*/)
+{
+    /** @brief Checks if the request is known to have no assignment for the run
+     *
+     * @parameter [in] requestKey - request key without run number, i.e. path:variation:time
+     * @parameter [in] run - run number
+     * @parameter [out] runMin - if not NULL, receives the first run of the missing interval
+     * @parameter [out] runMax - if not NULL, receives the last run of the missing interval
+     * @return   true if a missing interval contains the run
+     */
+
+    SharedLock lock(&mLock);
+
+    MissingEntries::iterator intervalsIter = mMissingIntervals.find(requestKey);
+    if(intervalsIter == mMissingIntervals.end()) return false;
+
+    //the last interval that starts at or before the run
+    const map<int, int>& intervals = intervalsIter->second.Intervals;
+    map<int, int>::const_iterator interval = intervals.upper_bound(run);
+    if(interval == intervals.begin()) return false;
+    --interval;
+    if(run > interval->second) return false;
+
+    Touch(intervalsIter->second.LastUse);
+    if(runMin) *runMin = interval->first;
+    if(runMax) *runMax = interval->second;
+    mMissingHits++;
+    return true;
+}
+
+
+//______________________________________________________________________________
+bool AssignmentCache::Remove(const string& key)
+{
+    ExclusiveLock lock(&mLock);
+
+    Entries::iterator iter = mEntries.find(key);
+    if(iter == mEntries.end()) return false;
+
+    EraseEntry(iter);
+    return true;
+}
+
+
+//______________________________________________________________________________
+size_t AssignmentCache::RemoveTable(const string& path)
+{
+    /** @brief Removes assignments and missing intervals of one table
+     *
+     * @parameter [in] path - full path of the table
+     * @return   number of removed assignments and missing intervals
+     */
+
+    string prefix = path + ":";
+    size_t removed = 0;
+
+    ExclusiveLock lock(&mLock);
+    for(Entries::iterator iter = mEntries.begin(); iter != mEntries.end();)
+    {
+        Entries::iterator current = iter++;
+        if(current->first.compare(0, prefix.size(), prefix) != 0) continue;
+        EraseEntry(current);
+        removed++;
+    }
+
+    for(MissingEntries::iterator iter = mMissingIntervals.begin(); iter != mMissingIntervals.end();)
+    {
+        MissingEntries::iterator current = iter++;
+        if(current->first.compare(0, prefix.size(), prefix) != 0) continue;
+        removed += current->second.Intervals.size();
+        EraseMissing(current);
+    }
+    return removed;
+}
+
+
+//______________________________________________________________________________
+void AssignmentCache::Clear()
+{
+    /** @brief Removes all assignments and missing intervals from the cache. Statistics counters are kept */
+
+    ExclusiveLock lock(&mLock);
+    mEntries.clear();
+    mRunIntervals.clear();
+    mMissingIntervals.clear();
+    mMissingCount = 0;
+    mBytes = 0;
+}
+
+
+//______________________________________________________________________________
+void AssignmentCache::SetMemoryLimit(size_t bytes)
+{
+    /** @brief Sets memory budget in bytes. 0 - unlimited
+     *
+     * If the cache is already bigger than the new budget, assignments are evicted immediately
+     */
+
+    ExclusiveLock lock(&mLock);
+    mMemoryLimit = bytes;
+    EvictToFit();
+}
+
+
+//______________________________________________________________________________
+size_t AssignmentCache::GetMemoryLimit() const
+{
+    SharedLock lock(&mLock);
+    return mMemoryLimit;
+}
+
+
+//______________________________________________________________________________
+AssignmentCacheStats AssignmentCache::GetStats() const
+{
+    /** @brief Gets entries, bytes, hits, misses, evictions and insertions accounting */
+
+    SharedLock lock(&mLock);
+
+    AssignmentCacheStats stats;
+    stats.Entries     = mEntries.size();
+    stats.Bytes       = mBytes;
+    stats.MemoryLimit = mMemoryLimit;
+    stats.Hits        = mHits;
+    stats.Misses      = mMisses;
+    stats.Evictions   = mEvictions;
+    stats.Insertions  = mInsertions;
+    stats.MissingIntervals = mMissingCount;
+    stats.MissingHits = mMissingHits;
+    return stats;
+}
+
+
+//______________________________________________________________________________
+void AssignmentCache::ResetStats()
+{
+    mHits = 0;
+    mMisses = 0;
+    mEvictions = 0;
+    mInsertions = 0;
+    mMissingHits = 0;
+}
+
+
+//______________________________________________________________________________
+AssignmentCache::Entries::iterator AssignmentCache::PutEntry(const string& key, const shared_ptr<Assignment>& assignment)
+{
+    // Adds or replaces the entry and marks it as most recently used
+    // exclusive lock must be held by caller
+
+    size_t bytes = assignment->GetMemoryUsage() + key.capacity();
+
+    Entries::iterator iter = mEntries.find(key);
+    if(iter != mEntries.end())
+    {
+        //replace existing, the intervals that refer the entry stay accounted
+        if(iter->second.Data != assignment) mInsertions++;
+        mBytes -= iter->second.DataBytes;
+        iter->second.Bytes -= iter->second.DataBytes;
+        iter->second.Data = assignment;
+    }
+    else
+    {
+        iter = mEntries.emplace(piecewise_construct, forward_as_tuple(key), forward_as_tuple()).first;
+        iter->second.Data = assignment;
+        mInsertions++;
+    }
+    iter->second.DataBytes = bytes;
+    iter->second.Bytes += bytes;
+    Touch(iter->second.LastUse);
+    mBytes += bytes;
+    return iter;
+}
+
+
+//______________________________________________________________________________
+void AssignmentCache::EraseEntry(Entries::iterator iter)
+{
+    // Removes the entry and run intervals that refer it
+    // exclusive lock must be held by caller
+
+    const vector<pair<string, int> >& intervals = iter->second.Intervals;
+    for(size_t i = 0; i < intervals.size(); i++)
+    {
+        unordered_map<string, RunIntervals>::iterator intervalsIter = mRunIntervals.find(intervals[i].first);
+        if(intervalsIter == mRunIntervals.end()) continue;
+
+        //the interval might be already replaced by another entry
+        RunIntervals::iterator interval = intervalsIter->second.find(intervals[i].second);
+        if(interval != intervalsIter->second.end() && interval->second.Key == iter->first)
+        {
+            intervalsIter->second.erase(interval);
+        }
+        if(intervalsIter->second.empty()) mRunIntervals.erase(intervalsIter);
+    }
+
+    mBytes -= iter->second.Bytes;
+    mEntries.erase(iter);
+}
+
+
+//______________________________________________________________________________
+void AssignmentCache::EraseMissing(MissingEntries::iterator iter)
+{
+    // Removes missing intervals of a request
+    // exclusive lock must be held by caller
+
+    mMissingCount -= iter->second.Intervals.size();
+    mBytes -= iter->second.Bytes;
+    mMissingIntervals.erase(iter);
+}
+
+
+//______________________________________________________________________________
+void AssignmentCache::EvictToFit()
+{
+    // Evicts least recently used entries and missing intervals until the cache fits the budget.
+    // The most recently used one is kept so the caller of Put/Get always gets valid data
+    // exclusive lock must be held by caller
+
+    if(mMemoryLimit == 0 || mBytes <= mMemoryLimit) return;   //unlimited or fits
+
+    vector<Entries::iterator> entries;
+    vector<MissingEntries::iterator> missing;
+    entries.reserve(mEntries.size());
+    missing.reserve(mMissingIntervals.size());
+
+    //order by the last use, the oldest first. Indexes after entries are of missing intervals
+    vector<pair<unsigned long, size_t> > byUse;
+    byUse.reserve(mEntries.size() + mMissingIntervals.size());
+    for(Entries::iterator iter = mEntries.begin(); iter != mEntries.end(); ++iter)
+    {
+        byUse.push_back(make_pair(iter->second.LastUse.load(memory_order_relaxed), entries.size()));
+        entries.push_back(iter);
+    }
+    for(MissingEntries::iterator iter = mMissingIntervals.begin(); iter != mMissingIntervals.end(); ++iter)
+    {
+        byUse.push_back(make_pair(iter->second.LastUse.load(memory_order_relaxed), entries.size() + missing.size()));
+        missing.push_back(iter);
+    }
+    sort(byUse.begin(), byUse.end());
+
+    for(size_t i = 0; i + 1 < byUse.size() && mBytes > mMemoryLimit; i++)
+    {
+        size_t index = byUse[i].second;
+        if(index < entries.size()) EraseEntry(entries[index]);
+        else EraseMissing(missing[index - entries.size()]);
+        mEvictions++;
+    }
+}
+
+
+//______________________________________________________________________________
+AssignmentCache::Entry* AssignmentCache::Find(const string& requestKey, int run, int* runMin, int* runMax)
+{
+    // Finds entry by the run interval that contains the run
+    // shared lock must be held by caller
+
+    unordered_map<string, RunIntervals>::iterator intervalsIter = mRunIntervals.find(requestKey);
+    if(intervalsIter == mRunIntervals.end()) return NULL;
+
+    //the last interval that starts at or before the run
+    RunIntervals::iterator interval = intervalsIter->second.upper_bound(run);
+    if(interval == intervalsIter->second.begin()) return NULL;
+    --interval;
+    if(run > interval->second.RunMax) return NULL;
+
+    Entries::iterator iter = mEntries.find(interval->second.Key);
+    if(iter == mEntries.end()) return NULL;
+
+    if(runMin) *runMin = interval->first;
+    if(runMax) *runMax = interval->second.RunMax;
+    return &iter->second;
+}
+
+
+//______________________________________________________________________________
+void AssignmentCache::Touch(atomic<unsigned long>& lastUse)
+{
+    // Marks entry as most recently used. Is safe under the shared lock
+    lastUse.store(mTick.fetch_add(1, memory_order_relaxed) + 1, memory_order_relaxed);
+}
+
+}
@@ -1,4 +1,5 @@
 #include <stdexcept>
+#include <algorithm>
 #include <assert.h>
 #include <iostream>
 #include <memory>
@@ -9,12 +10,355 @@
 #include "CCDB/Helpers/PathUtils.h"
 #include "CCDB/Helpers/TimeProvider.h"
 #include "CCDB/Helpers/PerfLog.h"
+#include "CCDB/Helpers/StopWatch.h"
 
 using namespace std;
 
 namespace ccdb
 {
 
+//______________________________________________________________________________
+template<typename T>
+class TypedCells
+{
+    // Typed columns of the assignment converted to T. Values of each column
+    // are taken once as one array (@see TypedColumn::GetValues)
+
+public:
+    explicit TypedCells(const Assignment &assignment)
+    {
+        const vector<TypedColumn> &columns = assignment.GetTypedColumns();
+        mRowsCount = columns.empty() ? 0 : columns[0].GetRowsCount();
+        mColumns.resize(columns.size());
+        for (size_t columnsIter = 0; columnsIter < columns.size(); columnsIter++)
+        {
+            mColumns[columnsIter] = columns[columnsIter].template GetValues<T>();
+        }
+    }
+
+    size_t size() const { return mColumns.size() * mRowsCount; }
+    size_t GetRowsCount() const { return mRowsCount; }
+    size_t GetColumnsCount() const { return mColumns.size(); }
+
+    /** Values of the column, GetRowsCount() of them */
+    const T* GetColumn(size_t column) const { return mColumns[column]; }
+    T operator()(size_t row, size_t column) const { return mColumns[column][row]; }
+
+    /** Copies cells of rowsNum rows from firstRow row by row (cell [row][column] goes to (row - firstRow)*columns + column) */
+    void CopyRows(T *values, size_t firstRow, size_t rowsNum) const
+    {
+        size_t columnsNum = mColumns.size();
+        const T* const* columns = columnsNum ? &mColumns[0] : NULL;
+        for (size_t rowIter = firstRow; rowIter < firstRow + rowsNum; rowIter++)
+        {
+            for (size_t columnsIter = 0; columnsIter < columnsNum; columnsIter++)
+            {
+                *values++ = columns[columnsIter][rowIter];
+            }
+        }
+    }
+
+private:
+    vector<const T*> mColumns;
+    size_t mRowsCount;
+};
+
+
+//______________________________________________________________________________
+static const string& GetCell(const vector<string> &data, size_t row, size_t column, size_t columnsNum)
+{
+    return data[row*columnsNum + column];
+}
+
+
+//______________________________________________________________________________
+template<typename T>
+static T GetCell(const TypedCells<T> &data, size_t row, size_t column, size_t /*columnsNum*/)
+{
+    return data(row, column);
+}
+
+
+//______________________________________________________________________________
+template<typename T>
+static void FillMappedTable(vector< map<string, T> > &values, const TypedCells<T> &data, const vector<string> &columnNames, const char *func)
+{
+    // Fills vector of rows, each row is a map<header_name, cell_value>
+    // from typed columns
+
+    assert(values.empty());
+
+    size_t columnsNum = columnNames.size();
+    size_t rowsNum = columnsNum == data.GetColumnsCount() ? data.GetRowsCount() : 0;
+    if(rowsNum == 0)
+    {
+        throw std::logic_error(string(func) + ". Data has no rows. Zero rows are not supposed to be.");
+    }
+
+    values.resize(rowsNum);
+    for (size_t columnsIter = 0; columnsIter < columnsNum; columnsIter++)
+    {
+        const T* column = data.GetColumn(columnsIter);
+        const string &name = columnNames[columnsIter];
+        for (size_t rowIter = 0; rowIter < rowsNum; rowIter++) values[rowIter][name] = column[rowIter];
+    }
+}
+
+
+//______________________________________________________________________________
+template<typename T>
+static void FillTable(vector< vector<T> > &values, const TypedCells<T> &data)
+{
+    // Fills vector of rows where each row is a vector of cells
+    // from typed columns
+
+    values.resize(data.GetRowsCount());
+    for (size_t rowIter = 0; rowIter < values.size(); rowIter++)
+    {
+        values[rowIter].resize(data.GetColumnsCount());
+        if(!values[rowIter].empty()) data.CopyRows(&values[rowIter][0], rowIter, 1);
+    }
+}
+
+
+//______________________________________________________________________________
+template<typename T, typename Data>
+static void FillRowMap(map<string, T> &values, const Data &data, const Assignment &assignment, const char *func)
+{
+    // This method is used to return a 1-D array of values (in the form of a
+    // map<string, T>). The data may be stored in either column-wise (1
+    // row with many columns) or row-wise (1 column with many rows). We wish
+    // to support either so we must check which format it is in. If it is
+    // stored row-wise, then we'll need to make up the column names so that
+    // the map being returned is properly ordered.
+    // 5/25/2014  D. Lawrence
+
+    //check data a little...
+    size_t columnsNum = assignment.GetColumnsCount();
+    size_t rowsNum = columnsNum ? data.size() / columnsNum : 0;
+    if(rowsNum == 0)
+    {
+        throw std::logic_error(string(func) + ". Data has no rows. Zero rows are not supposed to be.");
+    }
+
+    //VALUES VALIDATION
+    assert(values.empty());
+
+    // Make sure at least one dimension is exactly 1.
+    if(rowsNum>1 && columnsNum>1){
+        throw std::logic_error(string(func) + ". Appears to be a table (both dimensions are > 1).");
+    }
+
+    if(rowsNum>1){
+        // ---- ROW-WISE ----
+
+        // Loop over rows, generating a column name for each and filling "values"
+        for(unsigned int i=0; i<rowsNum; i++){
+            char colName[16];
+            sprintf(colName, "v%04d", i); // TODO this will be a problem for more than 10k values!
+            values[colName] = GetCell(data, i, 0, columnsNum);
+        }
+
+    }else{
+        // ---- COLUMN-WISE ----
+
+        //get columns names
+        vector<string> columnNames = assignment.GetTypeTable()->GetColumnNames();
+        assert(columnsNum == columnNames.size());
+
+        //compose values
+        for (size_t i=0; i<columnsNum; i++) values[columnNames[i]] = GetCell(data, 0, i, columnsNum);
+    }
+}
+
+
+//______________________________________________________________________________
+static void CheckSingleRow(size_t cellsNum, size_t columnsNum, const char *func)
+{
+    //check data and check that the user will get what he ment...
+    if(cellsNum == 0)
+        throw std::logic_error(string(func) + ". Data has no rows. Zero rows are not supposed to be.");
+
+    if(cellsNum != columnsNum)
+        throw std::logic_error(string(func) + ". logic_error: Calling of single row vector<dataType> version of GetCalib method on dataset that has more than one rows. Use GetCalib vector<vector<dataType> > instead.");
+}
+
+
+//______________________________________________________________________________
+static void FillValues(vector< map<string, string> > &values, Assignment &assignment)
+{
+    assert(values.empty());
+
+    assignment.GetMappedData(values);
+
+    //check data, get columns
+    if(values.size() == 0){
+        throw std::logic_error("Calibration::GetCalib( vector< map<string, string> >&). Data has no rows. Zero rows are not supposed to be.");
+    }
+}
+
+
+//______________________________________________________________________________
+static void FillValues(vector< map<string, double> > &values, Assignment &assignment)
+{
+    //Cells are converted by column types once and kept with the assignment
+    FillMappedTable(values, TypedCells<double>(assignment), assignment.GetTypeTable()->GetColumnNames(),
+                    "Calibration::GetCalib( vector< map<string, double> >&)");
+}
+
+
+//______________________________________________________________________________
+static void FillValues(vector< map<string, int> > &values, Assignment &assignment)
+{
+    FillMappedTable(values, TypedCells<int>(assignment), assignment.GetTypeTable()->GetColumnNames(),
+                    "Calibration::GetCalib( vector< map<string, int> >&)");
+}
+
+
+//______________________________________________________________________________
+static void FillValues(vector< vector<string> > &values, Assignment &assignment)
+{
+    assignment.GetData(values);
+}
+
+
+//______________________________________________________________________________
+static void FillValues(vector< vector<double> > &values, Assignment &assignment)
+{
+    FillTable(values, TypedCells<double>(assignment));
+}
+
+
+//______________________________________________________________________________
+static void FillValues(vector< vector<int> > &values, Assignment &assignment)
+{
+    FillTable(values, TypedCells<int>(assignment));
+}
+
+
+//______________________________________________________________________________
+static void FillValues(map<string, string> &values, Assignment &assignment)
+{
+    FillRowMap(values, assignment.GetVectorData(), assignment, "Calibration::GetCalib( map<string, string>&)");
+}
+
+
+//______________________________________________________________________________
+static void FillValues(map<string, double> &values, Assignment &assignment)
+{
+    FillRowMap(values, TypedCells<double>(assignment), assignment, "Calibration::GetCalib( map<string, double>&)");
+}
+
+
+//______________________________________________________________________________
+static void FillValues(map<string, int> &values, Assignment &assignment)
+{
+    FillRowMap(values, TypedCells<int>(assignment), assignment, "Calibration::GetCalib( map<string, int>&)");
+}
+
+
+//______________________________________________________________________________
+static void FillValues(vector<string> &values, Assignment &assignment)
+{
+    const vector<string> &data = assignment.GetVectorData();
+    CheckSingleRow(data.size(), assignment.GetColumnsCount(), "Calibration::GetCalib(vector<string> &)");
+    values.assign(data.begin(), data.end());
+}
+
+
+//______________________________________________________________________________
+static void FillValues(vector<double> &values, Assignment &assignment)
+{
+    TypedCells<double> data(assignment);
+    CheckSingleRow(data.size(), assignment.GetColumnsCount(), "Calibration::GetCalib(vector<double> &)");
+    values.resize(data.size());
+    data.CopyRows(&values[0], 0, 1);
+}
+
+
+//______________________________________________________________________________
+static void FillValues(vector<int> &values, Assignment &assignment)
+{
+    TypedCells<int> data(assignment);
+    CheckSingleRow(data.size(), assignment.GetColumnsCount(), "Calibration::GetCalib(vector<int> &)");
+    values.resize(data.size());
+    data.CopyRows(&values[0], 0, 1);
+}
+
+
+//______________________________________________________________________________
+static void FillValues(string &value, Assignment &assignment)
+{
+    const vector<string> &data = assignment.GetVectorData();
+    CheckSingleRow(data.size(), assignment.GetColumnsCount(), "Calibration::GetCalib(string &)");
+    value = data[0];
+}
+
+
+//______________________________________________________________________________
+static void FillValues(double &value, Assignment &assignment)
+{
+    TypedCells<double> data(assignment);
+    CheckSingleRow(data.size(), assignment.GetColumnsCount(), "Calibration::GetCalib(double &)");
+    value = data(0, 0);
+}
+
+
+//______________________________________________________________________________
+static void FillValues(int &value, Assignment &assignment)
+{
+    TypedCells<int> data(assignment);
+    CheckSingleRow(data.size(), assignment.GetColumnsCount(), "Calibration::GetCalib(int &)");
+    value = data(0, 0);
+}
+
+
+//______________________________________________________________________________
+template<typename T> static const vector<T>& GetRowMajorValues(const Assignment &assignment);
+template<> const vector<double>& GetRowMajorValues<double>(const Assignment &assignment) { return assignment.GetDoubleValues(); }
+template<> const vector<int>& GetRowMajorValues<int>(const Assignment &assignment) { return assignment.GetIntValues(); }
+
+
+//______________________________________________________________________________
+template<typename T>
+static const T* GetViewValues(const Assignment &assignment, size_t &rows, size_t &columns)
+{
+    //Row by row copy of the typed columns, made once and kept with the assignment data
+    const vector<TypedColumn> &typedColumns = assignment.GetTypedColumns();
+    columns = typedColumns.size();
+    rows = columns ? typedColumns[0].GetRowsCount() : 0;
+    const vector<T>& data = GetRowMajorValues<T>(assignment);
+    return data.empty() ? NULL : &data[0];
+}
+
+
+//______________________________________________________________________________
+template<typename T>
+static void FillFlatValues(vector<T> &values, size_t &rows, size_t &columns, const Assignment &assignment)
+{
+    //Cells are read right from the typed columns, the same way as for vector< vector<T> >
+    TypedCells<T> cells(assignment);
+    rows = cells.GetRowsCount();
+    columns = cells.GetColumnsCount();
+    values.resize(cells.size());
+    if(!values.empty()) cells.CopyRows(&values[0], 0, rows);
+}
+
+
+//______________________________________________________________________________
+template<typename T>
+static void FillFlatValues(T *buffer, size_t bufferSize, size_t &rows, size_t &columns, const Assignment &assignment, const char *func)
+{
+    TypedCells<T> cells(assignment);
+    rows = cells.GetRowsCount();
+    columns = cells.GetColumnsCount();
+    if(cells.size() > bufferSize)
+        throw std::logic_error(string(func) + ". The buffer is too small. The table has " + std::to_string(rows) + " rows and " +
+                               std::to_string(columns) + " columns, buffer size is " + std::to_string(bufferSize));
+    cells.CopyRows(buffer, 0, rows);
+}
+
+
 //______________________________________________________________________________
 Calibration::Calibration()
 {
@@ -27,6 +371,18 @@ Calibration::Calibration()
     mDefaultVariation = "default";
     mIsAutoReconnect = true;
     mLastActivityTime=0;
+    mFrozen = NULL;
+    mFrozenReaders = 0;
+    mFrozenMisses = 0;
+    mCacheGeneration = 0;
+    mIOThreads = CCDB_DEFAULT_IO_THREADS;
+    mHasChangeMark = false;
+    mChangeCheckInterval = 0;
+    mNextChangeCheck = 0;
+    mChangeStats.Checks = 0;
+    mChangeStats.Changes = 0;
+    mChangeStats.InvalidatedTables = 0;
+    mChangeStats.FullClears = 0;
 
 #ifdef CCDB_CACHE_ON
     mIsCacheEnabled = true;
@@ -51,6 +407,18 @@ Calibration::Calibration(int defaultRun, string defaultVariation/*="default"*/,
     x = new PthreadSyncObject();
     mIsAutoReconnect = true;
     mLastActivityTime=0;
+    mFrozen = NULL;
+    mFrozenReaders = 0;
+    mFrozenMisses = 0;
+    mCacheGeneration = 0;
+    mIOThreads = CCDB_DEFAULT_IO_THREADS;
+    mHasChangeMark = false;
+    mChangeCheckInterval = 0;
+    mNextChangeCheck = 0;
+    mChangeStats.Checks = 0;
+    mChangeStats.Changes = 0;
+    mChangeStats.InvalidatedTables = 0;
+    mChangeStats.FullClears = 0;
 
 #ifdef CCDB_CACHE_ON
     mIsCacheEnabled = true;
@@ -64,6 +432,13 @@ Calibration::Calibration(int defaultRun, string defaultVariation/*="default"*/,
 Calibration::~Calibration()
 {
     //Destructor
+    //asynchronous requests use everything below, so they are finished first
+    mIOExecutor.reset();
+    mFrozen = NULL;
+    mSnapshots.clear();
+    mCache.Clear();
+    mHeldAssignments.clear();
+    mPool.reset();
     if(!mProviderIsLocked && mProvider!=NULL) delete mProvider;
 }
 
@@ -104,23 +479,11 @@ bool Calibration::GetCalib( vector< map<string, string> > &values, const string
 	 * @return true if constants were found and filled. false if namepath was not found. raises std::logic_error if any other error acured.
 	 */  
 
-    auto assignment = GetAssignment(namepath, true);
-        
-    if(!assignment)
-    {       
-        return false; //TODO possibly exception throwing?
-    }
+    std::shared_ptr<Assignment> loaded;
+    const std::shared_ptr<Assignment>& assignment = FindOrLoadAssignment(namepath, true, loaded);
+    if(!assignment) return false;
 
-    //Get data
-    
-    assert(values.empty());
-    
-    assignment->GetMappedData(values);
-    
-    //check data, get columns 
-    if(values.size() == 0){
-        throw std::logic_error("Calibration::GetCalib( vector< map<string, string> >&, const string&). Data has no rows. Zero rows are not supposed to be.");
-    }
+    FillValues(values, *assignment);
     return true;
 }
 
@@ -128,39 +491,11 @@ bool Calibration::GetCalib( vector< map<string, string> > &values, const string
 //______________________________________________________________________________
 bool Calibration::GetCalib( vector< map<string, double> > &values, const string & namepath )
 {
-    //read values
-
-    //TODO right now the function works through copy. 
-    //one needs to find out, maybe it needs to be reimplemented
-    
-    vector<map<string, string> > rawValues;
-    try
-    {
-        if(!GetCalib(rawValues, namepath)) return false;
-    }
-    catch (std::exception &)
-    {
-    	throw;
-    }
-
-    assert(values.empty());
-    
-    int rowsNum = rawValues.size();
-    int columnsNum = rawValues[0].size(); //rawTableValues[0] - size was checked in GetCalib
-
-    values.resize(rawValues.size());
-
-    //compose values
-    for (int rowIter = 0; rowIter < rowsNum; rowIter++)
-    {
-        map<string, string>::iterator iter;
-        for ( iter=rawValues[rowIter].begin() ; iter != rawValues[rowIter].end(); iter++ )
-        {
-            double tmpVal = StringUtils::ParseDouble(iter->second);
-            values[rowIter][iter->first] = tmpVal;
-        }
-    }
+    std::shared_ptr<Assignment> loaded;
+    const std::shared_ptr<Assignment>& assignment = FindOrLoadAssignment(namepath, true, loaded);
+    if(!assignment) return false;
 
+    FillValues(values, *assignment);
     return true;
 }
 
@@ -168,37 +503,11 @@ bool Calibration::GetCalib( vector< map<string, double> > &values, const string
 //______________________________________________________________________________
 bool Calibration::GetCalib( vector< map<string, int> > &values, const string & namepath )
 {
-    //TODO right now the function works through copy. 
-    //one needs to find out, maybe it needs to be reimplemented
-
-    vector<map<string, string> > rawValues;
-    try
-    {
-        if(!GetCalib(rawValues, namepath)) return false;
-    }
-    catch (std::exception &)
-    {
-        throw;
-    }
-
-    assert(values.empty());
-
-    int rowsNum = rawValues.size();
-    int columnsNum = rawValues[0].size(); //rawTableValues[0] - size was checked in GetCalib
-
-    values.resize(rawValues.size());
-
-    //compose values
-    for (int rowIter = 0; rowIter < rowsNum; rowIter++)
-    {
-        map<string, string>::iterator iter;
-        for ( iter=rawValues[rowIter].begin() ; iter != rawValues[rowIter].end(); iter++ )
-        {
-            int intlVal = StringUtils::ParseInt(iter->second);
-            values[rowIter][iter->first] = intlVal;
-        }
-    }
+    std::shared_ptr<Assignment> loaded;
+    const std::shared_ptr<Assignment>& assignment = FindOrLoadAssignment(namepath, true, loaded);
+    if(!assignment) return false;
 
+    FillValues(values, *assignment);
     return true;
 }
 
@@ -215,16 +524,12 @@ bool Calibration::GetCalib( vector< vector<string> > &values, const string & nam
      * @parameter [in]  namepath - data path
      * @return true if constants were found and filled. false if namepath was not found. raises std::logic_error if any other error acured.
      */
-    
-    auto assignment = GetAssignment(namepath, false);
-    
-    if(!assignment)
-    {
-        return false;
-    }
-   
-    assignment->GetData(values);
-    
+
+    std::shared_ptr<Assignment> loaded;
+    const std::shared_ptr<Assignment>& assignment = FindOrLoadAssignment(namepath, false, loaded);
+    if(!assignment) return false;
+
+    FillValues(values, *assignment);
     return true;
 }
 
@@ -232,35 +537,11 @@ bool Calibration::GetCalib( vector< vector<string> > &values, const string & nam
 //______________________________________________________________________________
 bool Calibration::GetCalib( vector< vector<double> > &values, const string & namepath )
 {
-    //TODO right now the function works through copy. One has to check, maybe it needs to be reimplemented
-
-    vector< vector<string> > rawValues;
-    try
-    {
-        if(!GetCalib(rawValues, namepath)) return false;
-    }
-    catch (std::exception &)
-    {
-        throw;
-    }
-
-    assert(values.empty());
-
-    int rowsNum = rawValues.size();
-    int columnsNum = rawValues[0].size(); //rawTableValues[0] - size was checked in GetCalib
-
-    values.resize(rawValues.size());
-
-    //compose values
-    for (int rowIter = 0; rowIter < rowsNum; rowIter++)
-    {   
-        for (int columnsIter = 0; columnsIter < columnsNum; columnsIter++)
-        {
-            double tmpVal = StringUtils::ParseDouble(rawValues[rowIter][columnsIter]);
-            values[rowIter].push_back(tmpVal);
-        }
-    }
+    std::shared_ptr<Assignment> loaded;
+    const std::shared_ptr<Assignment>& assignment = FindOrLoadAssignment(namepath, true, loaded);
+    if(!assignment) return false;
 
+    FillValues(values, *assignment);
     return true;
 }
 
@@ -268,33 +549,11 @@ bool Calibration::GetCalib( vector< vector<double> > &values, const string & nam
 //______________________________________________________________________________
 bool Calibration::GetCalib( vector< vector<int> > &values, const string & namepath )
 {
-    vector< vector<string> > rawValues;
-    try
-    {
-        if(!GetCalib(rawValues, namepath)) return false;
-    }
-    catch (std::exception &)
-    {
-        throw;
-    }
-
-    assert(values.empty());
-
-    int rowsNum = rawValues.size();
-    int columnsNum = rawValues[0].size(); //rawTableValues[0] - size was checked in GetCalib
-
-    values.resize(rawValues.size());
-
-    //compose values
-    for (int rowIter = 0; rowIter < rowsNum; rowIter++)
-    {   
-        for (int columnsIter = 0; columnsIter < columnsNum; columnsIter++)
-        {
-            int tmpVal = StringUtils::ParseInt(rawValues[rowIter][columnsIter]);
-            values[rowIter].push_back(tmpVal);
-        }
-    }
+    std::shared_ptr<Assignment> loaded;
+    const std::shared_ptr<Assignment>& assignment = FindOrLoadAssignment(namepath, true, loaded);
+    if(!assignment) return false;
 
+    FillValues(values, *assignment);
     return true;
 }
 
@@ -312,69 +571,11 @@ bool Calibration::GetCalib( map<string, string> &values, const string & namepath
      * @return true if constants were found and filled. false if namepath was not found. raises std::logic_error if any other error acured.
      */
 
+    std::shared_ptr<Assignment> loaded;
+    const std::shared_ptr<Assignment>& assignment = FindOrLoadAssignment(namepath, true, loaded);
+    if(!assignment) return false;
 
-    auto assignment = GetAssignment(namepath, true);
-    
-    if(assignment == NULL)
-    {
-        //TODO possibly exception throwing?
-        return false;
-    }
-
-    //Get data
-    vector< vector<string> > rawTableValues;
-    assignment->GetData(rawTableValues);
-
-    //check data a little...
-    if(rawTableValues.size() == 0)
-    {
-        throw std::logic_error("Calibration::GetCalib( map<string, string>&, const string&). Data has no rows. Zero rows are not supposed to be.");
-    }
-	
-	//VALUES VALIDATION
-	assert(values.empty());
-
-	// This method is used to return a 1-D array of values (in the form of a
-	// map<string, string>). The data may be stored in either column-wise (1 
-	// row with many columns) or row-wise (1 column with many rows). We wish
-	// to support either so we must check which format it is in. If it is
-	// stored row-wise, then we'll need to make up the column names so that
-	// the map being returned is properly ordered.
-	// 5/25/2014  D. Lawrence
-	
-	// Make sure at least one dimension is exactly 1. (Assume all inner vectors
-	// are the same size as the zeroth one.)
-	int rowsNum = rawTableValues.size();
-	int columnsNum = rawTableValues[0].size();
-	if(rowsNum>1 && columnsNum>1){
-		throw std::logic_error("Calibration::GetCalib( map<string, string>&, const string&). Appears to be a table (both dimensions are > 1).");
-	}
-	
-	if(rowsNum>1){
-		// ---- ROW-WISE ----
-		
-		// Loop over rows, generating a column name for each and filling "values"
-		for(unsigned int i=0; i<rowsNum; i++){
-			char colName[16];
-			sprintf(colName, "v%04d", i); // TODO this will be a problem for more than 10k values!
-			values[colName] = rawTableValues[i][0];
-		}
-		
-	}else{
-		// ---- COLUMN-WISE ----
-
-		//now we take only first row of table
-		vector<string> rawValues = rawTableValues[0];
-
-		//get columns names
-		vector<string> columnNames = assignment->GetTypeTable()->GetColumnNames();
-		assert(columnsNum == columnNames.size());
-
-		//compose values
-		for (int i=0; i<columnsNum; i++) values[columnNames[i]] = rawValues[i];
-	}
-
-    //finishing
+    FillValues(values, *assignment);
     return true;
 }
 
@@ -382,268 +583,1268 @@ bool Calibration::GetCalib( map<string, string> &values, const string & namepath
 //______________________________________________________________________________
 bool Calibration::GetCalib( map<string, double> &values, const string & namepath )
 {
-    map<string, string> rawValues;
-    try
-    {
-        if(!GetCalib(rawValues, namepath)) return false;
-    }
-    catch (std::exception &)
-    {
-        throw;
-    }
+    std::shared_ptr<Assignment> loaded;
+    const std::shared_ptr<Assignment>& assignment = FindOrLoadAssignment(namepath, true, loaded);
+    if(!assignment) return false;
 
-    assert(values.empty());
-    
-    //compose values
-    map<string, string>::iterator iter;
-    for ( iter=rawValues.begin() ; iter != rawValues.end(); iter++ )
-    {
-        double tmpVal = StringUtils::ParseDouble(iter->second);
-        values[iter->first] = tmpVal;
+    FillValues(values, *assignment);
+    return true;
+}
+
+
+//______________________________________________________________________________
+bool Calibration::GetCalib( map<string, int> &values, const string & namepath )
+{
+    std::shared_ptr<Assignment> loaded;
+    const std::shared_ptr<Assignment>& assignment = FindOrLoadAssignment(namepath, true, loaded);
+    if(!assignment) return false;
+
+    FillValues(values, *assignment);
+    return true;
+}
+
+
+//______________________________________________________________________________
+bool Calibration::GetCalib( vector<string> &values, const string & namepath )
+{
+    /** @brief Get constants by namepath
+     * 
+     * this version of function fills values as one row as vector<string_values>
+     * 
+     * @parameter [out] values - as vector<string_values>
+     * @parameter [in]  namepath - data path
+     * @return true if constants were found and filled. false if namepath was not found. raises std::logic_error if any other error acured.
+     */
+
+    std::shared_ptr<Assignment> loaded;
+    const std::shared_ptr<Assignment>& assignment = FindOrLoadAssignment(namepath, false, loaded);
+    if(!assignment) return false;
+
+    FillValues(values, *assignment);
+    return true;
+}
+
+
+//______________________________________________________________________________
+bool Calibration::GetCalib( vector<double> &values, const string & namepath )
+{
+    std::shared_ptr<Assignment> loaded;
+    const std::shared_ptr<Assignment>& assignment = FindOrLoadAssignment(namepath, true, loaded);
+    if(!assignment) return false;
+
+    FillValues(values, *assignment);
+    return true;
+}
+
+
+//______________________________________________________________________________
+bool Calibration::GetCalib( vector<int> &values, const string & namepath )
+{
+    std::shared_ptr<Assignment> loaded;
+    const std::shared_ptr<Assignment>& assignment = FindOrLoadAssignment(namepath, true, loaded);
+    if(!assignment) return false;
+
+    FillValues(values, *assignment);
+    return true;
+}
+
+
+//______________________________________________________________________________
+bool Calibration::GetCalib( string &value, const string & namepath )
+{
+	/** @brief Get constant by namepath
+	 *
+	 * This version of function fills just one value
+	 *
+	 * @parameter [out] value
+	 * @parameter [in]  namepath - data path
+	 * @return true if constants were found and filled. false if namepath was not found. raises std::exception if any other error acured.
+	 */
+
+    std::shared_ptr<Assignment> loaded;
+    const std::shared_ptr<Assignment>& assignment = FindOrLoadAssignment(namepath, false, loaded);
+    if(!assignment) return false;
+
+    FillValues(value, *assignment);
+    return true;
+}
+
+
+//______________________________________________________________________________
+bool Calibration::GetCalib( double &value, const string & namepath )
+{
+    std::shared_ptr<Assignment> loaded;
+    const std::shared_ptr<Assignment>& assignment = FindOrLoadAssignment(namepath, true, loaded);
+    if(!assignment) return false;
+
+    FillValues(value, *assignment);
+    return true;
+}
+
+
+//______________________________________________________________________________
+bool Calibration::GetCalib( int &value, const string & namepath )
+{
+    std::shared_ptr<Assignment> loaded;
+    const std::shared_ptr<Assignment>& assignment = FindOrLoadAssignment(namepath, true, loaded);
+    if(!assignment) return false;
+
+    FillValues(value, *assignment);
+    return true;
+}
+
+
+//______________________________________________________________________________
+bool Calibration::GetCalib( vector<double> &values, size_t &rows, size_t &columns, const string & namepath )
+{
+    /** @brief Get constants by namepath
+     *
+     * this version of function fills values as one contiguous row-major array
+     * (cell [row][column] is at row*columns + column)
+     *
+     * @parameter [out] values  - all cells of the table, row by row
+     * @parameter [out] rows    - number of rows
+     * @parameter [out] columns - number of columns
+     * @parameter [in]  namepath - data path
+     * @return true if constants were found and filled. false if namepath was not found. raises std::exception if any other error acured.
+     */
+
+    std::shared_ptr<Assignment> loaded;
+    const std::shared_ptr<Assignment>& assignment = FindOrLoadAssignment(namepath, true, loaded);
+    if(!assignment) return false;
+
+    FillFlatValues(values, rows, columns, *assignment);
+    return true;
+}
+
+
+//______________________________________________________________________________
+bool Calibration::GetCalib( vector<int> &values, size_t &rows, size_t &columns, const string & namepath )
+{
+    std::shared_ptr<Assignment> loaded;
+    const std::shared_ptr<Assignment>& assignment = FindOrLoadAssignment(namepath, true, loaded);
+    if(!assignment) return false;
+
+    FillFlatValues(values, rows, columns, *assignment);
+    return true;
+}
+
+
+//______________________________________________________________________________
+bool Calibration::GetCalib( double *buffer, size_t bufferSize, size_t &rows, size_t &columns, const string & namepath )
+{
+    /** @brief Get constants by namepath
+     *
+     * this version of function copies the table row by row to the buffer of the caller
+     *
+     * @parameter [out] buffer     - buffer for rows*columns values
+     * @parameter [in]  bufferSize - number of values the buffer can hold
+     * @parameter [out] rows       - number of rows
+     * @parameter [out] columns    - number of columns
+     * @parameter [in]  namepath   - data path
+     * @return true if constants were found and filled. false if namepath was not found.
+     *         raises std::logic_error if the buffer is too small (rows and columns are set),
+     *         std::exception if any other error acured.
+     */
+
+    std::shared_ptr<Assignment> loaded;
+    const std::shared_ptr<Assignment>& assignment = FindOrLoadAssignment(namepath, true, loaded);
+    if(!assignment) return false;
+
+    FillFlatValues(buffer, bufferSize, rows, columns, *assignment, "Calibration::GetCalib(double *buffer, ...)");
+    return true;
+}
+
+
+//______________________________________________________________________________
+bool Calibration::GetCalib( int *buffer, size_t bufferSize, size_t &rows, size_t &columns, const string & namepath )
+{
+    std::shared_ptr<Assignment> loaded;
+    const std::shared_ptr<Assignment>& assignment = FindOrLoadAssignment(namepath, true, loaded);
+    if(!assignment) return false;
+
+    FillFlatValues(buffer, bufferSize, rows, columns, *assignment, "Calibration::GetCalib(int *buffer, ...)");
+    return true;
+}
+
+
+//______________________________________________________________________________
+bool Calibration::GetCalib( CalibView<double> &view, const string & namepath )
+{
+    /** @brief Get constants by namepath
+     *
+     * this version of function does not copy values on each call. The view points to the row by row
+     * copy of the typed columns kept with the assignment and keeps the assignment alive. @see CalibView
+     *
+     * @parameter [out] view     - read-only row-major view of the table
+     * @parameter [in]  namepath - data path
+     * @return true if constants were found and filled. false if namepath was not found. raises std::exception if any other error acured.
+     */
+
+    std::shared_ptr<Assignment> loaded;
+    const std::shared_ptr<Assignment>& assignment = FindOrLoadAssignment(namepath, true, loaded);
+    if(!assignment) return false;
+
+    size_t rows, columns;
+    const double* data = GetViewValues<double>(*assignment, rows, columns);
+    view.Set(assignment, data, rows, columns);
+    return true;
+}
+
+
+//______________________________________________________________________________
+bool Calibration::GetCalib( CalibView<int> &view, const string & namepath )
+{
+    std::shared_ptr<Assignment> loaded;
+    const std::shared_ptr<Assignment>& assignment = FindOrLoadAssignment(namepath, true, loaded);
+    if(!assignment) return false;
+
+    size_t rows, columns;
+    const int* data = GetViewValues<int>(*assignment, rows, columns);
+    view.Set(assignment, data, rows, columns);
+    return true;
+}
+
+
+//______________________________________________________________________________
+bool Calibration::GetCalib( vector< map<string, string> > &values, CalibHandle & handle )
+{
+    const std::shared_ptr<Assignment>& assignment = FindOrLoadAssignment(handle, true);
+    if(!assignment) return false;
+
+    FillValues(values, *assignment);
+    return true;
+}
+
+
+//______________________________________________________________________________
+bool Calibration::GetCalib( vector< map<string, double> > &values, CalibHandle & handle )
+{
+    const std::shared_ptr<Assignment>& assignment = FindOrLoadAssignment(handle, true);
+    if(!assignment) return false;
+
+    FillValues(values, *assignment);
+    return true;
+}
+
+
+//______________________________________________________________________________
+bool Calibration::GetCalib( vector< map<string, int> > &values, CalibHandle & handle )
+{
+    const std::shared_ptr<Assignment>& assignment = FindOrLoadAssignment(handle, true);
+    if(!assignment) return false;
+
+    FillValues(values, *assignment);
+    return true;
+}
+
+
+//______________________________________________________________________________
+bool Calibration::GetCalib( vector< vector<string> > &values, CalibHandle & handle )
+{
+    const std::shared_ptr<Assignment>& assignment = FindOrLoadAssignment(handle, false);
+    if(!assignment) return false;
+
+    FillValues(values, *assignment);
+    return true;
+}
+
+
+//______________________________________________________________________________
+bool Calibration::GetCalib( vector< vector<double> > &values, CalibHandle & handle )
+{
+    const std::shared_ptr<Assignment>& assignment = FindOrLoadAssignment(handle, true);
+    if(!assignment) return false;
+
+    FillValues(values, *assignment);
+    return true;
+}
+
+
+//______________________________________________________________________________
+bool Calibration::GetCalib( vector< vector<int> > &values, CalibHandle & handle )
+{
+    const std::shared_ptr<Assignment>& assignment = FindOrLoadAssignment(handle, true);
+    if(!assignment) return false;
+
+    FillValues(values, *assignment);
+    return true;
+}
+
+
+//______________________________________________________________________________
+bool Calibration::GetCalib( map<string, string> &values, CalibHandle & handle )
+{
+    const std::shared_ptr<Assignment>& assignment = FindOrLoadAssignment(handle, true);
+    if(!assignment) return false;
+
+    FillValues(values, *assignment);
+    return true;
+}
+
+
+//______________________________________________________________________________
+bool Calibration::GetCalib( map<string, double> &values, CalibHandle & handle )
+{
+    const std::shared_ptr<Assignment>& assignment = FindOrLoadAssignment(handle, true);
+    if(!assignment) return false;
+
+    FillValues(values, *assignment);
+    return true;
+}
+
+
+//______________________________________________________________________________
+bool Calibration::GetCalib( map<string, int> &values, CalibHandle & handle )
+{
+    const std::shared_ptr<Assignment>& assignment = FindOrLoadAssignment(handle, true);
+    if(!assignment) return false;
+
+    FillValues(values, *assignment);
+    return true;
+}
+
+
+//______________________________________________________________________________
+bool Calibration::GetCalib( vector<string> &values, CalibHandle & handle )
+{
+    const std::shared_ptr<Assignment>& assignment = FindOrLoadAssignment(handle, false);
+    if(!assignment) return false;
+
+    FillValues(values, *assignment);
+    return true;
+}
+
+
+//______________________________________________________________________________
+bool Calibration::GetCalib( vector<double> &values, CalibHandle & handle )
+{
+    const std::shared_ptr<Assignment>& assignment = FindOrLoadAssignment(handle, true);
+    if(!assignment) return false;
+
+    FillValues(values, *assignment);
+    return true;
+}
+
+
+//______________________________________________________________________________
+bool Calibration::GetCalib( vector<int> &values, CalibHandle & handle )
+{
+    const std::shared_ptr<Assignment>& assignment = FindOrLoadAssignment(handle, true);
+    if(!assignment) return false;
+
+    FillValues(values, *assignment);
+    return true;
+}
+
+
+//______________________________________________________________________________
+bool Calibration::GetCalib( string &value, CalibHandle & handle )
+{
+    const std::shared_ptr<Assignment>& assignment = FindOrLoadAssignment(handle, false);
+    if(!assignment) return false;
+
+    FillValues(value, *assignment);
+    return true;
+}
+
+
+//______________________________________________________________________________
+bool Calibration::GetCalib( double &value, CalibHandle & handle )
+{
+    const std::shared_ptr<Assignment>& assignment = FindOrLoadAssignment(handle, true);
+    if(!assignment) return false;
+
+    FillValues(value, *assignment);
+    return true;
+}
+
+
+//______________________________________________________________________________
+bool Calibration::GetCalib( int &value, CalibHandle & handle )
+{
+    const std::shared_ptr<Assignment>& assignment = FindOrLoadAssignment(handle, true);
+    if(!assignment) return false;
+
+    FillValues(value, *assignment);
+    return true;
+}
+
+
+//______________________________________________________________________________
+bool Calibration::GetCalib( vector<double> &values, size_t &rows, size_t &columns, CalibHandle & handle )
+{
+    const std::shared_ptr<Assignment>& assignment = FindOrLoadAssignment(handle, true);
+    if(!assignment) return false;
+
+    FillFlatValues(values, rows, columns, *assignment);
+    return true;
+}
+
+
+//______________________________________________________________________________
+bool Calibration::GetCalib( vector<int> &values, size_t &rows, size_t &columns, CalibHandle & handle )
+{
+    const std::shared_ptr<Assignment>& assignment = FindOrLoadAssignment(handle, true);
+    if(!assignment) return false;
+
+    FillFlatValues(values, rows, columns, *assignment);
+    return true;
+}
+
+
+//______________________________________________________________________________
+bool Calibration::GetCalib( double *buffer, size_t bufferSize, size_t &rows, size_t &columns, CalibHandle & handle )
+{
+    const std::shared_ptr<Assignment>& assignment = FindOrLoadAssignment(handle, true);
+    if(!assignment) return false;
+
+    FillFlatValues(buffer, bufferSize, rows, columns, *assignment, "Calibration::GetCalib(double *buffer, ...)");
+    return true;
+}
+
+
+//______________________________________________________________________________
+bool Calibration::GetCalib( int *buffer, size_t bufferSize, size_t &rows, size_t &columns, CalibHandle & handle )
+{
+    const std::shared_ptr<Assignment>& assignment = FindOrLoadAssignment(handle, true);
+    if(!assignment) return false;
+
+    FillFlatValues(buffer, bufferSize, rows, columns, *assignment, "Calibration::GetCalib(int *buffer, ...)");
+    return true;
+}
+
+
+//______________________________________________________________________________
+bool Calibration::GetCalib( CalibView<double> &view, CalibHandle & handle )
+{
+    const std::shared_ptr<Assignment>& assignment = FindOrLoadAssignment(handle, true);
+    if(!assignment) return false;
+
+    size_t rows, columns;
+    const double* data = GetViewValues<double>(*assignment, rows, columns);
+    view.Set(assignment, data, rows, columns);
+    return true;
+}
+
+
+//______________________________________________________________________________
+bool Calibration::GetCalib( CalibView<int> &view, CalibHandle & handle )
+{
+    const std::shared_ptr<Assignment>& assignment = FindOrLoadAssignment(handle, true);
+    if(!assignment) return false;
+
+    size_t rows, columns;
+    const int* data = GetViewValues<int>(*assignment, rows, columns);
+    view.Set(assignment, data, rows, columns);
+    return true;
+}
+
+
+//______________________________________________________________________________
+string Calibration::GetConnectionString() const
+{
+    //
+    if (mProvider!=NULL) return mProvider->GetConnectionString();
+    
+    return string();
+}
+
+
+//______________________________________________________________________________
+Assignment* Calibration::GetAssignment(const string& namepath, bool loadColumns /*=true*/)
+{
+    /** @brief Gets the assignment from provider using namepath
+     * namepath is the common ccdb request; @see GetCalib
+     *
+     * @remark the function is thread safe
+     *
+     * @warning The caller must not delete the assignment. If cache is enabled, it is held by
+     *          the calibration until ClearCache() or destruction, without cache it is owned by the provider
+     *
+     * @parameter [in] namepath - full namepath is /path/to/data:run:variation:time but usually it is only /path/to/data
+     * @return   DAssignment *
+     */
+
+    if(mIsCacheEnabled)
+    {
+        //the cache may evict its assignment any time, so the calibration holds it.
+        //One assignment is held for all requests (runs) that resolve to it, the first one loaded
+        std::shared_ptr<Assignment> cached = GetSharedAssignment(namepath, loadColumns);
+        if(!cached) return NULL;
+
+        string key = MakeAssignmentKey(ParseRequest(namepath), cached.get(), loadColumns);
+        std::lock_guard<std::mutex> lock(mHeldAssignmentsMutex);
+        return mHeldAssignments.insert(make_pair(key, cached)).first->second.get();
+    }
+
+    auto pl = PerfLog("Calibration::GetAssignment=>" + namepath );
+    UpdateActivityTime();
+    RequestParseResult request = ParseRequest(namepath);
+    CheckConnection();  // Check if is connected and reconnect if needed (and allowed)
+
+    //without cache the assignment is owned by the provider as it always was
+    std::lock_guard<std::mutex> lock(mReadMutex);
+    return LoadAssignment(mProvider, request, loadColumns, false);
+}
+
+
+//______________________________________________________________________________
+void Calibration::ClearCache()
+{
+    /** @brief Removes all assignments from the cache. Handles fetch their assignments again
+     *
+     * Assignments given by GetAssignment are released too
+     */
+
+    mCache.Clear();
+    mCacheGeneration++;
+
+    std::lock_guard<std::mutex> lock(mHeldAssignmentsMutex);
+    mHeldAssignments.clear();
+}
+
+
+//______________________________________________________________________________
+std::shared_ptr<Assignment> Calibration::GetSharedAssignment(const string& namepath, bool loadColumns /*=true*/)
+{
+    /** @brief Gets the assignment from provider using namepath as a shared pointer
+     * namepath is the common ccdb request; @see GetCalib
+     *
+     * The assignment stays valid as long as the pointer is held, even if the cache evicts it
+     *
+     * @remark the function is thread safe
+     *
+     * @parameter [in] namepath - full namepath is /path/to/data:run:variation:time but usually it is only /path/to/data
+     * @return   shared pointer to assignment, empty if no assignment was found
+     */
+
+    std::shared_ptr<Assignment> loaded;
+    return FindOrLoadAssignment(namepath, loadColumns, loaded);
+}
+
+
+//______________________________________________________________________________
+const std::shared_ptr<Assignment>& Calibration::FindOrLoadAssignment(const string& namepath, bool loadColumns, std::shared_ptr<Assignment>& loaded)
+{
+    // Finds the assignment in the frozen snapshot or loads it through the cache.
+    // The snapshot lookup takes no locks and does no allocations.
+    // Returns reference to 'loaded' which holds the result, the snapshot may be deleted after the lookup
+
+    if(mFrozen.load(std::memory_order_relaxed))
+    {
+        // While the lookup is counted, Freeze and Unfreeze don't delete snapshots (@see DeleteReplacedSnapshots)
+        mFrozenReaders.fetch_add(1);
+        const FrozenSnapshot* snapshot = mFrozen.load();
+        if(snapshot)
+        {
+            const FrozenSnapshot::Assignments& assignments = snapshot->ByPath[loadColumns ? 1 : 0];
+            FrozenSnapshot::Assignments::const_iterator iter = assignments.find(namepath);
+            if(iter != assignments.end()) loaded = iter->second;
+        }
+        mFrozenReaders.fetch_sub(1);
+
+        if(loaded) return loaded;
+        if(snapshot) mFrozenMisses++;
     }
 
-    return true;
+    loaded = LoadSharedAssignment(namepath, loadColumns);
+    return loaded;
 }
 
 
 //______________________________________________________________________________
-bool Calibration::GetCalib( map<string, int> &values, const string & namepath )
+CalibHandle Calibration::GetHandle(const string& namepath)
+{
+    /** @brief Creates precompiled handle for the request
+     *
+     * @parameter [in]  namepath - data path. Short /path/to/data .Full format is /path/to/data:run:variation:time
+     * @return handle to use with GetCalib(values, handle)
+     */
+
+    RequestParseResult request = ParseRequest(namepath);
+
+    CalibHandle handle;
+    handle.mOwner = this;
+    handle.mRun = request.RunNumber;
+    handle.mTime = request.Time;
+
+    std::lock_guard<std::mutex> lock(mInternMutex);
+    handle.mPathId = Intern(request.Path, mInternedPaths, mPathIds);
+    handle.mVariationId = Intern(request.Variation, mInternedVariations, mVariationIds);
+    return handle;
+}
+
+
+//______________________________________________________________________________
+std::shared_ptr<Assignment> Calibration::GetSharedAssignment(CalibHandle& handle, bool loadColumns /*=true*/)
 {
-    //TODO right now the function works through copy. 
-    //one needs to find out, maybe it needs to be reimplemented
+    /** @brief Gets the assignment by precompiled handle as a shared pointer */
+
+    return FindOrLoadAssignment(handle, loadColumns);
+}
+
 
+//______________________________________________________________________________
+const std::shared_ptr<Assignment>& Calibration::FindOrLoadAssignment(CalibHandle& handle, bool loadColumns)
+{
+    // Returns the assignment remembered by the handle if it is still valid for the handle run.
+    // Otherwise fetches it through the cache and remembers with its run interval
 
-    map<string, string> rawValues;
-    try
+    if(handle.mOwner != this)
     {
-        if(!GetCalib(rawValues, namepath)) return false;
+        throw std::logic_error("Calibration::GetCalib(..., CalibHandle&). The handle was not created by this Calibration. Use Calibration::GetHandle");
     }
-    catch (std::exception &)
+
+    // Changed tables are dropped from the cache, then handles fetch their assignments again
+    if(mIsCacheEnabled) CheckForChangesIfDue();
+
+    // The handle also remembers the run interval of a request that has no assignment,
+    // then the empty assignment is returned for runs of the interval
+    if(mIsCacheEnabled &&
+       handle.mGeneration == mCacheGeneration.load(std::memory_order_relaxed) &&
+       handle.mRun >= handle.mRunMin && handle.mRun <= handle.mRunMax &&
+       (handle.mHasColumns || !loadColumns))
     {
-        throw;
+        return handle.mAssignment;
     }
 
-    assert(values.empty());
-
-    //compose values
-    map<string, string>::iterator iter;
-    for ( iter=rawValues.begin() ; iter != rawValues.end(); iter++ )
+    // Slow path. Restore the request from interned strings
+    RequestParseResult request;
     {
-        int tmpVal = StringUtils::ParseInt(iter->second);
-        values[iter->first] = tmpVal;
+        std::lock_guard<std::mutex> lock(mInternMutex);
+        request.Path = mInternedPaths[handle.mPathId];
+        request.Variation = mInternedVariations[handle.mVariationId];
     }
+    request.RunNumber = handle.mRun;
+    request.Time = handle.mTime;
+    request.WasParsedPath = request.WasParsedRunNumber = request.WasParsedVariation = request.WasParsedTime = true;
+    request.IsInvalidRunNumber = false;
 
-    return true;
+    UpdateActivityTime();
+
+    unsigned long generation = mCacheGeneration.load(std::memory_order_relaxed);
+    handle.mAssignment = LoadSharedAssignment(request, loadColumns, &handle.mRunMin, &handle.mRunMax);
+    handle.mHasColumns = loadColumns;
+    handle.mGeneration = generation;
+    return handle.mAssignment;
 }
 
 
 //______________________________________________________________________________
-bool Calibration::GetCalib( vector<string> &values, const string & namepath )
+int Calibration::Intern(const string& value, std::deque<string>& strings, std::unordered_map<string, int>& ids)
 {
-    /** @brief Get constants by namepath
-     * 
-     * this version of function fills values as one row as vector<string_values>
-     * 
-     * @parameter [out] values - as vector<string_values>
-     * @parameter [in]  namepath - data path
-     * @return true if constants were found and filled. false if namepath was not found. raises std::logic_error if any other error acured.
-     */
+    // Gets id of the interned string. Adds the string if it is not interned yet
+    // mInternMutex must be locked by caller
 
-	
-    
-	auto assignment = GetAssignment(namepath, true);
-    
-    if(assignment == NULL) return false; //TODO possibly exception throwing?
+    std::unordered_map<string, int>::iterator iter = ids.find(value);
+    if(iter != ids.end()) return iter->second;
 
-    //Get data
-    values.clear();
-    assignment->GetVectorData(values);
-   
-    //check data and check that the user will get what he ment...
-    if(values.size() == 0)
-        throw std::logic_error("Calibration::GetCalib(vector<string> &, const string &). Data has no rows. Zero rows are not supposed to be.");
+    int id = (int)strings.size();
+    strings.push_back(value);
+    ids[value] = id;
+    return id;
+}
 
-    if(values.size() != assignment->GetTypeTable()->GetColumnsCount())
-        throw std::logic_error("Calibration::GetCalib(vector<string> &, const string &). logic_error: Calling of single row vector<dataType> version of GetCalib method on dataset that has more than one rows. Use GetCalib vector<vector<dataType> > instead.");
 
-    return true;
+//______________________________________________________________________________
+std::shared_ptr<Assignment> Calibration::LoadSharedAssignment(const string& namepath, bool loadColumns)
+{
+    // Gets the assignment through the cache or directly from provider if the cache is disabled
+
+    auto pl = PerfLog("Calibration::GetAssignment=>" + namepath );
+
+    UpdateActivityTime();
+
+    return LoadSharedAssignment(ParseRequest(namepath), loadColumns, NULL, NULL);
 }
 
 
 //______________________________________________________________________________
-bool Calibration::GetCalib( vector<double> &values, const string & namepath )
+std::shared_ptr<Assignment> Calibration::LoadSharedAssignment(const RequestParseResult& request, bool loadColumns, int* runMin, int* runMax)
+{
+    // Gets the assignment through the cache or directly from provider if the cache is disabled.
+    // If runMin and runMax are given, they receive the run interval for which the request
+    // resolves to the same assignment ([run, run] if the cache is disabled).
+    // Requests without assignment are cached too: then the empty pointer is returned and the
+    // interval is the one with no assignment, or an empty interval [0, -1] if it is unknown
+
+    if(!mIsCacheEnabled)
+    {
+        CheckConnection();  // Check if is connected and reconnect if needed (and allowed)
+        if(runMin) *runMin = request.RunNumber;
+        if(runMax) *runMax = request.RunNumber;
+        ProviderLease provider(*this);
+        return std::shared_ptr<Assignment>(LoadAssignment(provider.Get(), request, loadColumns, true));
+    }
+
+    CheckForChangesIfDue();
+
+    // Check if we have this value in the cache.
+    // The request resolves to the same assignment for some interval of runs,
+    // so the cache is looked up by request without run and then by the run interval
+    string requestKey = MakeRequestKey(request, loadColumns);
+
+    std::shared_ptr<Assignment> assignment;
+    while(true)
+    {
+        assignment = mCache.Get(requestKey, request.RunNumber, runMin, runMax);
+        if(assignment || mCache.IsMissing(requestKey, request.RunNumber, runMin, runMax)) return assignment;
+
+        // If another thread is loading the same request, wait for it and look at the cache again.
+        // (Its result may be for a run interval that doesn't contain our run, then we load ourselves)
+        std::shared_future<void> otherLoad;
+        std::promise<void> ownLoad;
+        {
+            std::lock_guard<std::mutex> lock(mLoadsMutex);
+            std::map<string, std::shared_future<void> >::iterator iter = mLoads.find(requestKey);
+            if(iter == mLoads.end())
+            {
+                mLoads[requestKey] = ownLoad.get_future().share();
+            }
+            else
+            {
+                otherLoad = iter->second;
+            }
+        }
+
+        if(otherLoad.valid())
+        {
+            otherLoad.wait();
+            assignment = mCache.Peek(requestKey, request.RunNumber, runMin, runMax);
+            if(assignment || mCache.IsMissing(requestKey, request.RunNumber, runMin, runMax)) return assignment;
+            continue;
+        }
+
+        // We are the one who loads. Waiting threads are released whatever happens
+        struct LoadFinisher
+        {
+            Calibration* Owner; const string& Key; std::promise<void>& Load;
+            ~LoadFinisher()
+            {
+                std::lock_guard<std::mutex> lock(Owner->mLoadsMutex);
+                Owner->mLoads.erase(Key);
+                Load.set_value();
+            }
+        } finisher = {this, requestKey, ownLoad};
+
+        // The request could be loaded while we were registering
+        assignment = mCache.Peek(requestKey, request.RunNumber, runMin, runMax);
+        if(assignment || mCache.IsMissing(requestKey, request.RunNumber, runMin, runMax)) return assignment;
+
+        CheckConnection();  // Check if is connected and reconnect if needed (and allowed)
+
+        // Data read before the cache is invalidated is not cached (@see CheckForChanges)
+        unsigned long generation = mCacheGeneration.load();
+
+        ProviderLease provider(*this);
+        assignment.reset(LoadAssignment(provider.Get(), request, loadColumns, true));
+        if(!assignment)
+        {
+            // Remember runs without assignment, so the next requests don't go to the database.
+            // Missing intervals don't depend on columns
+            int missingMin, missingMax;
+            if(provider->GetMissingRunInterval(request.Path, request.RunNumber, request.Variation, request.Time, missingMin, missingMax))
+            {
+                std::lock_guard<std::mutex> lock(mInvalidationMutex);
+                if(mCacheGeneration.load() == generation)
+                {
+                    mCache.PutMissing(MakeRequestKey(request, true), missingMin, missingMax);
+                    mCache.PutMissing(MakeRequestKey(request, false), missingMin, missingMax);
+                }
+            }
+            else
+            {
+                missingMin = 0;
+                missingMax = -1;
+            }
+            if(runMin) *runMin = missingMin;
+            if(runMax) *runMax = missingMax;
+            return assignment;
+        }
+
+        int intervalMin, intervalMax;
+        provider->GetAssignmentRunInterval(assignment.get(), request.Variation, request.Time, intervalMin, intervalMax);
+        if(runMin) *runMin = intervalMin;
+        if(runMax) *runMax = intervalMax;
+
+        std::lock_guard<std::mutex> lock(mInvalidationMutex);
+        if(mCacheGeneration.load() == generation)
+        {
+            mCache.Put(requestKey, intervalMin, intervalMax, MakeAssignmentKey(request, assignment.get(), loadColumns), assignment);
+        }
+        return assignment;
+    }
+}
+
+
+//______________________________________________________________________________
+Assignment* Calibration::LoadAssignment(DataProvider* provider, const RequestParseResult& request, bool loadColumns, bool detach)
 {
-    vector<string> rawValues;
-    try
+    // Loads assignment from the provider. If detach is true the provider doesn't own the result
+    // and the caller is responsible to delete it
+    // The provider must be leased by caller (@see ProviderLease) or mReadMutex locked for mProvider
+
+    Assignment* assignment;
+    if(request.Time > 0)
     {
-        if(!GetCalib(rawValues, namepath)) return false;
+        assignment = provider->GetAssignmentShort(request.RunNumber, request.Path, request.Time, request.Variation, loadColumns);
     }
-    catch (std::exception &)
+    else
     {
-        throw;
+        assignment = provider->GetAssignmentShort(request.RunNumber, request.Path, request.Variation, loadColumns);
     }
-    
-    int columnsNum = rawValues.size(); //rawTableValues[0] - size was checked in GetCalib    
 
-    values.resize(rawValues.size());
+    if(assignment && detach) assignment->ReleaseOwning();
+
+    if(assignment) RememberWarmPath(request, loadColumns);
+
+    return assignment;
+}
+
+
+//______________________________________________________________________________
+void Calibration::RememberWarmPath(const RequestParseResult& request, bool loadColumns)
+{
+    // Remember tables requested for the defaults, they go to the snapshot on Freeze()
+
+    if(request.WasParsedRunNumber || request.WasParsedVariation || request.WasParsedTime) return;
+
+    std::lock_guard<std::mutex> lock(mWarmPathsMutex);
+    bool& withColumns = mWarmPaths[request.Path];
+    withColumns = withColumns || loadColumns;
+}
+
+
+//______________________________________________________________________________
+string Calibration::MakeRequestKey(const RequestParseResult& request, bool loadColumns)
+{
+    // The request resolves to the same assignment for some interval of runs,
+    // so the cache key of the request doesn't include the run
+
+    return request.Path + ":" + request.Variation + ":" + to_string(request.Time) + (loadColumns ? ":cols" : ":no_cols");
+}
+
+
+//______________________________________________________________________________
+string Calibration::MakeAssignmentKey(const RequestParseResult& request, Assignment* assignment, bool loadColumns)
+{
+    return request.Path + ":#" + to_string(assignment->GetId()) + (loadColumns ? ":cols" : ":no_cols");
+}
+
+
+//______________________________________________________________________________
+PrefetchStats Calibration::Prefetch(const vector<string>& namepaths)
+{
+    /** @brief Loads a list of tables to the cache in one go
+     *
+     * @parameter [in] namepaths - requests in GetCalib format /path/to/data:run:variation:time
+     * @return counts of loaded, cached and not found tables and the time spent
+     */
+
+    StopWatch stopWatch;
+    PrefetchStats stats = {namepaths.size(), 0, 0, 0, 0.0};
+    if(!mIsCacheEnabled) return stats;
+
+    UpdateActivityTime();
+    CheckForChangesIfDue();
 
-    //compose values
-    for (int columnsIter = 0; columnsIter < columnsNum; columnsIter++)
+    // Group requests that are not cached yet by run, variation and time
+    map<string, vector<RequestParseResult> > groups;
+    for(size_t i = 0; i < namepaths.size(); i++)
     {
-        double tmpVal = StringUtils::ParseDouble(rawValues[columnsIter]);
-        values[columnsIter] = tmpVal;
+        RequestParseResult request = ParseRequest(namepaths[i]);
+        string requestKey = MakeRequestKey(request, true);
+        if(mCache.Peek(requestKey, request.RunNumber))
+        {
+            stats.AlreadyCached++;
+            continue;
+        }
+        if(mCache.IsMissing(requestKey, request.RunNumber))
+        {
+            stats.NotFound++;
+            continue;
+        }
+        groups[to_string(request.RunNumber) + ":" + request.Variation + ":" + to_string(request.Time)].push_back(request);
     }
-    return true;
+
+    CheckConnection();  // Check if is connected and reconnect if needed (and allowed)
+
+    // Data read before the cache is invalidated is not cached (@see CheckForChanges)
+    unsigned long generation = mCacheGeneration.load();
+
+    ProviderLease provider(*this);
+    for(map<string, vector<RequestParseResult> >::iterator group = groups.begin(); group != groups.end(); ++group)
+    {
+        const vector<RequestParseResult>& requests = group->second;
+        const RequestParseResult& first = requests[0];
+
+        vector<string> paths(requests.size());
+        for(size_t i = 0; i < requests.size(); i++) paths[i] = requests[i].Path;
+
+        vector<Assignment*> assignments;
+        vector<pair<int, int> > runIntervals;
+        if(!provider->GetAssignmentsShort(assignments, runIntervals, first.RunNumber, paths, first.Time, first.Variation, true))
+        {
+            stats.NotFound += requests.size();
+            continue;
+        }
+
+        for(size_t i = 0; i < requests.size(); i++)
+        {
+            if(!assignments[i])
+            {
+                int missingMin, missingMax;
+                if(provider->GetMissingRunInterval(requests[i].Path, first.RunNumber, first.Variation, first.Time, missingMin, missingMax))
+                {
+                    std::lock_guard<std::mutex> lock(mInvalidationMutex);
+                    if(mCacheGeneration.load() == generation)
+                    {
+                        mCache.PutMissing(MakeRequestKey(requests[i], true), missingMin, missingMax);
+                        mCache.PutMissing(MakeRequestKey(requests[i], false), missingMin, missingMax);
+                    }
+                }
+                stats.NotFound++;
+                continue;
+            }
+
+            assignments[i]->ReleaseOwning();
+            std::shared_ptr<Assignment> assignment(assignments[i]);
+            RememberWarmPath(requests[i], true);
+
+            // Assignment with columns serves requests without columns too
+            string assignmentKey = MakeAssignmentKey(requests[i], assignment.get(), true);
+            std::lock_guard<std::mutex> lock(mInvalidationMutex);
+            if(mCacheGeneration.load() == generation)
+            {
+                mCache.Put(MakeRequestKey(requests[i], true), runIntervals[i].first, runIntervals[i].second, assignmentKey, assignment);
+                mCache.Put(MakeRequestKey(requests[i], false), runIntervals[i].first, runIntervals[i].second, assignmentKey, assignment);
+            }
+            stats.Loaded++;
+        }
+    }
+
+    stats.Seconds = stopWatch.ElapsedUs() / 1e6;
+    return stats;
 }
 
 
 //______________________________________________________________________________
-bool Calibration::GetCalib( vector<int> &values, const string & namepath )
+PrefetchStats Calibration::PrefetchAll()
+{
+    /** @brief Loads all tables of the database for default run, variation and time to the cache */
+
+    vector<string> namepaths;
+    GetListOfNamepaths(namepaths);
+    return Prefetch(namepaths);
+}
+
+
+//______________________________________________________________________________
+void Calibration::Freeze()
 {
-    vector<string> rawValues;
-    try
+    /** @brief Publishes immutable snapshot of tables loaded for the default run, variation and time
+     *
+     * After the snapshot is published, GetCalib requests of a plain /path/to/data that is in the snapshot
+     * are served without locks, connection checks and allocations. Other requests go the usual way
+     */
+
+    //tables that were requested with default run, variation and time
+    map<string, bool> warmPaths;
     {
-        if(!GetCalib(rawValues, namepath)) return false;
+        std::lock_guard<std::mutex> lock(mWarmPathsMutex);
+        warmPaths = mWarmPaths;
     }
-    catch (std::exception &)
+
+    std::unique_ptr<FrozenSnapshot> snapshot(new FrozenSnapshot());
+    for(map<string, bool>::iterator iter = warmPaths.begin(); iter != warmPaths.end(); ++iter)
     {
-        throw;
+        std::shared_ptr<Assignment> assignment = LoadSharedAssignment(iter->first, iter->second);
+        if(!assignment) continue;
+
+        //users may ask both /path/to/data and path/to/data
+        string relativePath = iter->first.substr(1);
+        for(int withColumns = 0; withColumns <= (iter->second ? 1 : 0); withColumns++)
+        {
+            snapshot->ByPath[withColumns][iter->first] = assignment;
+            snapshot->ByPath[withColumns][relativePath] = assignment;
+        }
     }
 
-    int columnsNum = rawValues.size(); //rawTableValues[0] - size was checked in GetCalib
+    //the replaced snapshot is kept while readers may still look at it
+    std::lock_guard<std::mutex> lock(mWarmPathsMutex);
+    mFrozen.store(snapshot.get());
+    mSnapshots.push_back(std::move(snapshot));
+    DeleteReplacedSnapshots();
+}
+
+
+//______________________________________________________________________________
+void Calibration::Unfreeze()
+{
+    /** @brief Stops serving requests from the frozen snapshot */
+
+    std::lock_guard<std::mutex> lock(mWarmPathsMutex);
+    mFrozen.store(NULL);
+    DeleteReplacedSnapshots();
+}
+
 
-    values.resize(rawValues.size());
+//______________________________________________________________________________
+void Calibration::DeleteReplacedSnapshots()
+{
+    // Deletes snapshots that are not current if no lookup is in progress.
+    // A lookup that starts after mFrozen is replaced can't see the replaced snapshots,
+    // so once the count of lookups is zero nobody looks at them.
+    // Otherwise they are deleted by one of the next calls
+    // mWarmPathsMutex must be locked by caller
 
-    //compose values
-    for (int columnsIter = 0; columnsIter < columnsNum; columnsIter++)
+    if(mFrozenReaders.load() != 0) return;
+
+    FrozenSnapshot* current = mFrozen.load();
+    for(size_t i = 0; i < mSnapshots.size();)
     {
-        int tmpVal = StringUtils::ParseInt(rawValues[columnsIter]);
-        values[columnsIter] = tmpVal;
+        if(mSnapshots[i].get() == current)
+        {
+            i++;
+            continue;
+        }
+        mSnapshots.erase(mSnapshots.begin() + i);
     }
-    return true;
 }
 
+
 //______________________________________________________________________________
-bool Calibration::GetCalib(string &value, const string & namepath)
+void Calibration::SetPoolSize(size_t poolSize)
 {
-	/** @brief Get constant by namepath
-	 *
-	 * This version of function fills just one value
-	 *
-	 * @remark 	Actually the function calls  GetCalib(vector<string> &values, ...)
-	 * 			and converts its first element to the required type
-	 *
-	 * @parameter [out] value
-	 * @parameter [in]  namepath - data path
-	 * @return true if constants were found and filled. false if namepath was not found. raises std::exception if any other error acured.
-	 */
+    /** @brief Reads the database through a pool of connections
+     *
+     * @param poolSize maximum number of pooled connections. 0 - don't use the pool
+     */
+
+    if(poolSize == 0)
+    {
+        mPool.reset();
+        return;
+    }
+
+    if(mPool)
+    {
+        mPool->SetMaxSize(poolSize);
+        return;
+    }
 
-	vector<string> rawValues;
-	try
-	{
-		if(!GetCalib(rawValues, namepath)) return false;
-	}
-	catch (std::exception &)
-	{
-		throw;
-	}
+    DataProvider* probe = CreateProvider();
+    if(!probe)
+    {
+        throw std::logic_error("Calibration::SetPoolSize. This calibration can't create providers for the connection pool");
+    }
+    delete probe;
 
-	assert(rawValues.size());
-	value = rawValues[0];
-	return true;
+    //pooled connections share the metadata cache and parsed constant sets of the main provider
+    mPool.reset(new DataProviderPool([this]() {
+        DataProvider* provider = CreateProvider();
+        if(provider && mProvider)
+        {
+            provider->SetTypeTableCache(mProvider->GetTypeTableCache());
+            provider->SetConstantSetCache(mProvider->GetConstantSetCache());
+        }
+        return provider;
+    }, poolSize));
 }
 
+
 //______________________________________________________________________________
-bool Calibration::GetCalib(double &value, const string & namepath)
+std::future<std::shared_ptr<Assignment> > Calibration::GetSharedAssignmentAsync(const string & namepath, bool loadColumns)
 {
-	string rawValue;
-	if(!GetCalib(rawValue, namepath)) return false;
-	value = StringUtils::ParseDouble(rawValue);
-	return false;
+    /** @brief Gets the assignment in background. @see GetSharedAssignment */
+
+    return GetIOExecutor().Submit([this, namepath, loadColumns]() { return GetSharedAssignment(namepath, loadColumns); });
 }
 
+
 //______________________________________________________________________________
-bool Calibration::GetCalib(int &value, const string & namepath)
+void Calibration::SetIOThreads(size_t threads)
 {
-	string rawValue;
-	if(!GetCalib(rawValue, namepath)) return false;
-	value = StringUtils::ParseInt(rawValue);
-	return false;
+    /** @brief Sets maximum number of threads that run asynchronous requests
+     *
+     * @param threads maximum number of threads, at least 1
+     */
+
+    std::lock_guard<std::mutex> lock(mIOExecutorMutex);
+    mIOThreads = threads ? threads : 1;
+    if(mIOExecutor) mIOExecutor->SetMaxThreads(mIOThreads);
 }
 
+
 //______________________________________________________________________________
-string Calibration::GetConnectionString() const
+size_t Calibration::GetIOThreads()
 {
-    //
-    if (mProvider!=NULL) return mProvider->GetConnectionString();
-    
-    return string();
+    std::lock_guard<std::mutex> lock(mIOExecutorMutex);
+    return mIOThreads;
 }
 
 
 //______________________________________________________________________________
-    Assignment* Calibration::GetAssignment(const string& namepath, bool loadColumns /*=true*/)
+IOExecutor& Calibration::GetIOExecutor()
 {
-    /** @brief Gets the assignment from provider using namepath
-     * namepath is the common ccdb request; @see GetCalib
+    std::lock_guard<std::mutex> lock(mIOExecutorMutex);
+    if(!mIOExecutor) mIOExecutor.reset(new IOExecutor(mIOThreads));
+    return *mIOExecutor;
+}
+
+
+//______________________________________________________________________________
+void Calibration::SetChangeCheckInterval(time_t seconds)
+{
+    /** @brief Checks the database for changes every 'seconds' seconds. 0 - never
      *
-     * @remark the function is thread safe
-     * 
-     * @parameter [in] namepath - full namepath is /path/to/data:run:variation:time but usually it is only /path/to/data
-     * @return   DAssignment *
+     * The current state of the database is taken right away, so changes made after this call are noticed
      */
 
-    auto pl = PerfLog("Calibration::GetAssignment=>" + namepath );
-    static std::map<std::string, Assignment*> cache;
+    mChangeCheckInterval = seconds > 0 ? seconds : 0;
+    if(seconds <= 0) return;
 
-	UpdateActivityTime();
+    mNextChangeCheck = TimeProvider::GetUnixTimeStamp(ClockSources::Monotonic) + seconds;
+    CheckForChanges();
+}
 
-    RequestParseResult result = PathUtils::ParseRequest(namepath);
-    string variation = (result.WasParsedVariation ? result.Variation : mDefaultVariation);
-    string loadColumnsFlag;
-    int run  = (result.WasParsedRunNumber ? result.RunNumber : mDefaultRun);
 
+//______________________________________________________________________________
+bool Calibration::CheckForChanges()
+{
+    /** @brief Checks the database for changes now and drops changed tables from the cache
+     *
+     * @return true if the database was changed since the last check
+     */
 
+    // One check at a time. The first check only takes the state of the database
+    std::lock_guard<std::mutex> checkLock(mChangeCheckMutex);
 
-    auto time = result.WasParsedTime ? result.Time: mDefaultTime;
+    ChangeMark mark;
+    {
+        // data_version of SQLite is counted per connection, so the main provider is always asked
+        std::lock_guard<std::mutex> lock(mReadMutex);
+        if(!mProvider || !mProvider->IsConnected() || !mProvider->GetChangeMark(mark)) return false;
+    }
+    mChangeStats.Checks++;
 
-    CheckConnection();  // Check if is connected and reconnect if needed (and allowed)
-	
-    //Lock();Unlock();
-    std::lock_guard<std::mutex> lock(mReadMutex);
+    if(!mHasChangeMark || mark == mChangeMark)
+    {
+        mChangeMark = mark;
+        mHasChangeMark = true;
+        return false;
+    }
 
-    // Check if we have this value in the cache
-    if (loadColumns) {
-      loadColumnsFlag = "cols";
-    } else {
-      loadColumnsFlag = "no_cols";
+    vector<string> paths;
+    bool isSelective;
+    {
+        std::lock_guard<std::mutex> lock(mReadMutex);
+        isSelective = mProvider->GetChangedTables(paths, mChangeMark);
     }
-    string cache_key = namepath + ":" + to_string(run) + ":" + variation + ":" + to_string(time) + ":" + loadColumnsFlag;
-    if(mIsCacheEnabled)
+    mChangeMark = mark;
+    mChangeStats.Changes++;
+
+    // Removed assignments, changed directories, variations and such can't be told by table
+    if(!isSelective || paths.empty())
     {
-        if (  cache.find(cache_key) != cache.end() ) {
-            return cache[cache_key];
-        }
+        std::lock_guard<std::mutex> lock(mInvalidationMutex);
+        mCacheGeneration++;
+        mCache.Clear();
+        mChangeStats.FullClears++;
+        return true;
     }
 
-    Assignment* assigment;
+    std::lock_guard<std::mutex> lock(mInvalidationMutex);
+    mCacheGeneration++;
+    for(size_t i = 0; i < paths.size(); i++) mCache.RemoveTable(paths[i]);
+    mChangeStats.InvalidatedTables += paths.size();
+    return true;
+}
+
+
+//______________________________________________________________________________
+ChangeCheckStats Calibration::GetChangeCheckStats()
+{
+    std::lock_guard<std::mutex> lock(mChangeCheckMutex);
+    return mChangeStats;
+}
+
+
+//______________________________________________________________________________
+void Calibration::CheckForChangesIfDue()
+{
+    // Cheap when the check is disabled or not due: one or two atomic loads and reading the clock
+
+    time_t interval = mChangeCheckInterval.load(std::memory_order_relaxed);
+    if(interval <= 0) return;
+
+    time_t now = TimeProvider::GetUnixTimeStamp(ClockSources::Monotonic);
+    time_t next = mNextChangeCheck.load(std::memory_order_relaxed);
+    if(now < next) return;
+
+    // One thread checks, the others go on with the cache
+    if(!mNextChangeCheck.compare_exchange_strong(next, now + interval)) return;
+    CheckForChanges();
+}
+
 
-    if(time > 0)
+//______________________________________________________________________________
+Calibration::ProviderLease::ProviderLease(Calibration& owner):
+    mOwner(owner),
+    mProvider(NULL),
+    mIsPooled(false)
+{
+    DataProviderPool* pool = owner.mPool.get();
+    if(pool)
     {
-		assigment = (mProvider->GetAssignmentShort(run, PathUtils::MakeAbsolute(result.Path), time, variation,loadColumns));
-	}
-    else
-	{
-		assigment = (mProvider->GetAssignmentShort(run, PathUtils::MakeAbsolute(result.Path), variation,loadColumns));
-	}
+        //the pool follows the connection of the main provider
+        string connectionString = owner.GetConnectionString();
+        if(pool->GetConnectionString() != connectionString) pool->Connect(connectionString);
 
-    if(mIsCacheEnabled)
+        mProvider = pool->Checkout();
+        mIsPooled = mProvider != NULL;
+    }
+
+    //without the pool or if a pooled connection can't be opened, the main provider
+    //is used one thread at a time and reports errors as usual
+    if(!mIsPooled)
     {
+        owner.mReadMutex.lock();
+        mProvider = owner.mProvider;
+    }
+}
+
 
-        cache[cache_key] = assigment;
+//______________________________________________________________________________
+Calibration::ProviderLease::~ProviderLease()
+{
+    if(mIsPooled)
+    {
+        mOwner.mPool->Release(mProvider);
+    }
+    else
+    {
+        mOwner.mReadMutex.unlock();
     }
+}
+
+
+//______________________________________________________________________________
+RequestParseResult Calibration::ParseRequest(const string& namepath) const
+{
+    /** @brief Parses namepath and fills not given run, variation and time with default values
+     *
+     * @parameter [in] namepath - full namepath is /path/to/data:run:variation:time
+     * @return   parse result with absolute path
+     */
 
-    return assigment;
+    RequestParseResult result = PathUtils::ParseRequest(namepath);
+    result.Path = PathUtils::MakeAbsolute(result.Path);
+    if(!result.WasParsedRunNumber) result.RunNumber = mDefaultRun;
+    if(!result.WasParsedVariation) result.Variation = mDefaultVariation;
+    if(!result.WasParsedTime)      result.Time      = mDefaultTime;
+    return result;
 }
 
 
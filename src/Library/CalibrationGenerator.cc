@@ -191,6 +191,7 @@ void CalibrationGenerator::UpdateInactivity()
 {
     /** @brief Checks the time of last activity of Calibrations and disconnects
      *         and closes ones that have inactivity longer than @see SetMaxInactiveTime
+     *         Pooled connections of active Calibrations that were idle that long are closed too
      * 
      *  If user would like to use his own timer (or event) to check for inactive connections
      *  He/she should set SetUseInactiveCheckTimer(false) and call UpdateInactivity manually
@@ -211,7 +212,14 @@ void CalibrationGenerator::UpdateInactivity()
     for (size_t i=0; i<mCalibrations.size(); i++)
     {
         if(!mCalibrations[i]->IsConnected()) continue;
-        if(now - mCalibrations[i]->GetLastActivityTime() > mMaxInactiveTime) mCalibrations[i]->Disconnect();
+        if(now - mCalibrations[i]->GetLastActivityTime() > mMaxInactiveTime)
+        {
+            mCalibrations[i]->Disconnect();
+        }
+        else
+        {
+            mCalibrations[i]->ReapIdleConnections(mMaxInactiveTime);
+        }
     }
 }
 
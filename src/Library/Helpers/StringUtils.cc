@@ -1,4 +1,7 @@
 #include <cstdlib>
+#include <cstring>
+#include <climits>
+#include <stdint.h>
 
 #include "CCDB/Helpers/StringUtils.h"
 
@@ -340,44 +343,59 @@ vector<string> & ccdb::StringUtils::Split( const string& str, vector<string>& to
 //______________________________________________________________________________
 int ccdb::StringUtils::ParseInt( const string& source, bool *result/*=NULL*/  )
 {
-    return atoi(source.c_str()); //ugly isn't it?
+    int value;
+    bool isOk = ParseInt(source.data(), source.data() + source.size(), value);
+    if(result) *result = isOk;
+    return value;
 }
 
 
 //______________________________________________________________________________
 unsigned int ccdb::StringUtils::ParseUInt( const string& source, bool *result/*=NULL*/  )
 {
-    return static_cast<unsigned int>(atoi(source.c_str())); //ugly isn't it?
+    unsigned int value;
+    bool isOk = ParseUInt(source.data(), source.data() + source.size(), value);
+    if(result) *result = isOk;
+    return value;
 }
 
 
 //______________________________________________________________________________
 long ccdb::StringUtils::ParseLong( const string& source, bool *result/*=NULL*/  )
 {
-    return atol(source.c_str()); //ugly isn't it?
+    long value;
+    bool isOk = ParseLong(source.data(), source.data() + source.size(), value);
+    if(result) *result = isOk;
+    return value;
 }
 
 
 //______________________________________________________________________________
 unsigned long ccdb::StringUtils::ParseULong( const string& source, bool *result/*=NULL*/  )
 {
-    return static_cast<unsigned long>(atol(source.c_str())); //ugly isn't it?
+    unsigned long value;
+    bool isOk = ParseULong(source.data(), source.data() + source.size(), value);
+    if(result) *result = isOk;
+    return value;
 }
 
 
 //______________________________________________________________________________
 bool ccdb::StringUtils::ParseBool( const string& source, bool *result/*=NULL*/  )
 {
-    if(source=="true") return true;
-    if(source=="false") return false;
-
-    return static_cast<bool>(atoi(source.c_str())!=0); //ugly isn't it?
+    bool value;
+    bool isOk = ParseBool(source.data(), source.data() + source.size(), value);
+    if(result) *result = isOk;
+    return value;
 }
 
 //___________________________________________________________________________________
 double ccdb::StringUtils::ParseDouble( const string& source, bool *result/*=NULL*/  )
 {
-    return atof(source.c_str()); //ugly isn't it?
+    double value;
+    bool isOk = ParseDouble(source.data(), source.data() + source.size(), value);
+    if(result) *result = isOk;
+    return value;
 }
 
 //_______________________________________________________________________________________
@@ -394,6 +412,403 @@ time_t ccdb::StringUtils::ParseUnixTime( const string& source, bool *result/*=NU
 }
 
 
+//______________________________________________________________________________
+static inline const char* SkipBlanks(const char* pos, const char* end)
+{
+    while(pos < end && CCDB_CHECK_CHAR_IS_BLANK(*pos)) pos++;
+    return pos;
+}
+
+
+//______________________________________________________________________________
+static inline bool IsDigit(char c)
+{
+    return static_cast<unsigned char>(c - '0') < 10;
+}
+
+
+//______________________________________________________________________________
+static const char* ParseDigits(const char* pos, const char* end, uint64_t& mantissa, int& significant)
+{
+    // Accumulates decimal digits to mantissa while it has no more than 19 significant digits
+    // (then it fits uint64_t). If there are more, significant gets bigger than 19
+    // and the digits are skipped
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    // 8 digits at once: check and convert the chars as one 64 bit word
+    while(end - pos >= 8 && significant + 8 <= 19)
+    {
+        uint64_t chunk;
+        memcpy(&chunk, pos, 8);
+        if(((chunk & 0xF0F0F0F0F0F0F0F0ULL) | (((chunk + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) != 0x3333333333333333ULL) break;
+
+        chunk -= 0x3030303030303030ULL;
+        chunk = (chunk * 10) + (chunk >> 8);
+        chunk = (((chunk & 0x000000FF000000FFULL) * 0x000F424000000064ULL) +
+                 (((chunk >> 16) & 0x000000FF000000FFULL) * 0x0000271000000001ULL)) >> 32;
+
+        mantissa = mantissa * 100000000ULL + chunk;
+        if(mantissa) significant += 8;     // leading zeros are counted too, it only makes the fast path shorter
+        pos += 8;
+    }
+#endif
+
+    for(; pos < end && IsDigit(*pos); pos++)
+    {
+        if(significant < 19)
+        {
+            mantissa = mantissa * 10 + (*pos - '0');
+            if(mantissa) significant++;
+        }
+        else
+        {
+            significant++;
+        }
+    }
+    return pos;
+}
+
+
+//______________________________________________________________________________
+static bool ParseDoubleSlow(const char* begin, const char* end, double& value)
+{
+    // strtod is correctly rounded and knows inf, nan, hex and long numbers. It needs a null terminated string
+
+    char buffer[64];
+    string longString;
+    const char* str = buffer;
+    size_t length = static_cast<size_t>(end - begin);
+    if(length < sizeof(buffer))
+    {
+        memcpy(buffer, begin, length);
+        buffer[length] = '\0';
+    }
+    else
+    {
+        longString.assign(begin, end);
+        str = longString.c_str();
+    }
+
+    char* parsedEnd;
+    value = strtod(str, &parsedEnd);
+    return parsedEnd != str && SkipBlanks(begin + (parsedEnd - str), end) == end;
+}
+
+
+//______________________________________________________________________________
+bool ccdb::StringUtils::ParseDouble(const char* begin, const char* end, double& value)
+{
+    /** @brief Parses double from chars [begin, end) without making a string
+     *
+     * Decimal numbers up to 19 significant digits with small exponents are converted
+     * exactly (Clinger's fast path): the mantissa and the power of ten are exact doubles,
+     * so the only rounding is in one multiplication or division. Everything else goes to strtod.
+     * Both ways give correctly rounded values
+     */
+
+    static const double kPowersOfTen[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+    const uint64_t kMaxExactMantissa = 1ULL << 53;
+
+    const char* pos = SkipBlanks(begin, end);
+    bool isNegative = false;
+    if(pos < end && (*pos == '-' || *pos == '+'))
+    {
+        isNegative = *pos == '-';
+        pos++;
+    }
+
+    uint64_t mantissa = 0;
+    int significant = 0;
+    const char* digitsBegin = pos;
+    pos = ParseDigits(pos, end, mantissa, significant);
+    int exponent = 0;
+    bool hasDigits = pos > digitsBegin;
+
+    if(pos < end && *pos == '.')
+    {
+        pos++;
+        const char* fractionBegin = pos;
+        pos = ParseDigits(pos, end, mantissa, significant);
+        exponent -= static_cast<int>(pos - fractionBegin);
+        hasDigits = hasDigits || pos > fractionBegin;
+    }
+
+    if(hasDigits && pos < end && (*pos == 'e' || *pos == 'E'))
+    {
+        const char* exponentPos = pos + 1;
+        bool isNegativeExponent = false;
+        if(exponentPos < end && (*exponentPos == '-' || *exponentPos == '+'))
+        {
+            isNegativeExponent = *exponentPos == '-';
+            exponentPos++;
+        }
+
+        if(exponentPos < end && IsDigit(*exponentPos))
+        {
+            int explicitExponent = 0;
+            for(; exponentPos < end && IsDigit(*exponentPos); exponentPos++)
+            {
+                if(explicitExponent < 100000) explicitExponent = explicitExponent * 10 + (*exponentPos - '0');
+            }
+            exponent += isNegativeExponent ? -explicitExponent : explicitExponent;
+            pos = exponentPos;
+        }
+    }
+
+    // Not a plain decimal number (inf, nan, hex, garbage) or too many digits
+    if(!hasDigits || SkipBlanks(pos, end) != end || significant > 19) return ParseDoubleSlow(begin, end, value);
+
+    if(mantissa == 0)
+    {
+        value = isNegative ? -0.0 : 0.0;
+        return true;
+    }
+
+    // A number like 12e25 is 12000e22, it is still exact while the mantissa is below 2^53
+    while(exponent > 22 && mantissa < kMaxExactMantissa / 10)
+    {
+        mantissa *= 10;
+        exponent--;
+    }
+
+    if(mantissa > kMaxExactMantissa || exponent < -22 || exponent > 22) return ParseDoubleSlow(begin, end, value);
+
+    double result = static_cast<double>(mantissa);
+    result = exponent < 0 ? result / kPowersOfTen[-exponent] : result * kPowersOfTen[exponent];
+    value = isNegative ? -result : result;
+    return true;
+}
+
+
+//______________________________________________________________________________
+static bool ParseInteger(const char* begin, const char* end, unsigned long limit, bool isSigned, unsigned long& magnitude, bool& isNegative)
+{
+    // Parses optional sign and decimal digits. The magnitude is clamped by the limit
+    // (the limit of negative signed numbers is one more). Returns true if the whole range is the number
+
+    const char* pos = SkipBlanks(begin, end);
+    isNegative = false;
+    if(pos < end && (*pos == '-' || *pos == '+'))
+    {
+        isNegative = *pos == '-';
+        pos++;
+    }
+
+    unsigned long maxMagnitude = (isSigned && isNegative) ? limit + 1 : limit;
+    magnitude = 0;
+    bool isOverflow = false;
+    const char* digitsBegin = pos;
+    for(; pos < end && IsDigit(*pos); pos++)
+    {
+        unsigned long digit = static_cast<unsigned long>(*pos - '0');
+        if(magnitude > (maxMagnitude - digit) / 10)
+        {
+            isOverflow = true;
+            magnitude = maxMagnitude;
+        }
+        else if(!isOverflow)
+        {
+            magnitude = magnitude * 10 + digit;
+        }
+    }
+
+    return pos > digitsBegin && !isOverflow && SkipBlanks(pos, end) == end;
+}
+
+
+//______________________________________________________________________________
+bool ccdb::StringUtils::ParseLong(const char* begin, const char* end, long& value)
+{
+    unsigned long magnitude;
+    bool isNegative;
+    bool isOk = ParseInteger(begin, end, static_cast<unsigned long>(LONG_MAX), true, magnitude, isNegative);
+    value = isNegative ? static_cast<long>(0UL - magnitude) : static_cast<long>(magnitude);
+    return isOk;
+}
+
+
+//______________________________________________________________________________
+bool ccdb::StringUtils::ParseULong(const char* begin, const char* end, unsigned long& value)
+{
+    // As strtoul does, "-1" is ULONG_MAX. But it is not a valid unsigned number
+
+    unsigned long magnitude;
+    bool isNegative;
+    bool isOk = ParseInteger(begin, end, ULONG_MAX, false, magnitude, isNegative);
+    value = isNegative ? 0UL - magnitude : magnitude;
+    return isOk && (!isNegative || magnitude == 0);
+}
+
+
+//______________________________________________________________________________
+bool ccdb::StringUtils::ParseInt(const char* begin, const char* end, int& value)
+{
+    unsigned long magnitude;
+    bool isNegative;
+    bool isOk = ParseInteger(begin, end, static_cast<unsigned long>(INT_MAX), true, magnitude, isNegative);
+    value = isNegative ? static_cast<int>(-static_cast<long>(magnitude)) : static_cast<int>(magnitude);
+    return isOk;
+}
+
+
+//______________________________________________________________________________
+bool ccdb::StringUtils::ParseUInt(const char* begin, const char* end, unsigned int& value)
+{
+    unsigned long magnitude;
+    bool isNegative;
+    bool isOk = ParseInteger(begin, end, UINT_MAX, false, magnitude, isNegative);
+    value = static_cast<unsigned int>(isNegative ? 0UL - magnitude : magnitude);
+    return isOk && (!isNegative || magnitude == 0);
+}
+
+
+//______________________________________________________________________________
+bool ccdb::StringUtils::ParseBool(const char* begin, const char* end, bool& value)
+{
+    // "true", "false" or a number, which is true if it is not 0
+
+    size_t length = static_cast<size_t>(end - begin);
+    if(length == 4 && memcmp(begin, "true", 4) == 0)
+    {
+        value = true;
+        return true;
+    }
+    if(length == 5 && memcmp(begin, "false", 5) == 0)
+    {
+        value = false;
+        return true;
+    }
+
+    long number;
+    bool isOk = ParseLong(begin, end, number);
+    value = number != 0;
+    return isOk;
+}
+
+
+//______________________________________________________________________________
+size_t ccdb::StringUtils::ParseDoubles(const char* begin, const char* end, char delimiter, vector<double>& values)
+{
+    /** @brief Parses all cells of a blob in one pass
+     *
+     * Cells are separated by the delimiter, empty cells are skipped as Split does
+     * @return number of cells that are not numbers
+     */
+
+    size_t errors = 0;
+    const char* pos = begin;
+    while(pos < end)
+    {
+        if(*pos == delimiter)
+        {
+            pos++;
+            continue;
+        }
+
+        const char* cellEnd = static_cast<const char*>(memchr(pos, delimiter, end - pos));
+        if(!cellEnd) cellEnd = end;
+
+        double value;
+        if(!ParseDouble(pos, cellEnd, value)) errors++;
+        values.push_back(value);
+        pos = cellEnd;
+    }
+    return errors;
+}
+
+
+//______________________________________________________________________________
+string ccdb::StringUtils::Base64Encode(const char* data, size_t size)
+{
+    /** @brief Encodes bytes to base64 text (standard alphabet with '=' padding) */
+
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+    string result;
+    result.reserve((size + 2) / 3 * 4);
+
+    size_t i = 0;
+    for(; i + 2 < size; i += 3)
+    {
+        unsigned int triple = (bytes[i] << 16) | (bytes[i + 1] << 8) | bytes[i + 2];
+        result.push_back(alphabet[(triple >> 18) & 0x3F]);
+        result.push_back(alphabet[(triple >> 12) & 0x3F]);
+        result.push_back(alphabet[(triple >> 6) & 0x3F]);
+        result.push_back(alphabet[triple & 0x3F]);
+    }
+
+    if(i < size)
+    {
+        unsigned int triple = bytes[i] << 16;
+        if(i + 1 < size) triple |= bytes[i + 1] << 8;
+        result.push_back(alphabet[(triple >> 18) & 0x3F]);
+        result.push_back(alphabet[(triple >> 12) & 0x3F]);
+        result.push_back(i + 1 < size ? alphabet[(triple >> 6) & 0x3F] : '=');
+        result.push_back('=');
+    }
+    return result;
+}
+
+
+//______________________________________________________________________________
+bool ccdb::StringUtils::Base64Decode(const char* begin, const char* end, string& result)
+{
+    /** @brief Decodes base64 text made by Base64Encode
+     * @return false if the text is not a valid base64
+     */
+
+    //char -> 6 bits, 64 for chars out of the alphabet. Static local is initialized once and thread safe
+    struct DecodeTable
+    {
+        unsigned char Values[256];
+        DecodeTable()
+        {
+            static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+            memset(Values, 64, sizeof(Values));
+            for(unsigned char i = 0; i < 64; i++) Values[static_cast<unsigned char>(alphabet[i])] = i;
+        }
+    };
+    static const DecodeTable decodeTable;
+    const unsigned char* table = decodeTable.Values;
+
+    result.clear();
+    size_t length = end - begin;
+    if(length % 4 != 0) return false;
+    if(length == 0) return true;
+
+    size_t padding = 0;
+    if(end[-1] == '=') padding++;
+    if(end[-2] == '=') padding++;
+    result.resize(length / 4 * 3);
+    char* out = &result[0];
+
+    const unsigned char* text = reinterpret_cast<const unsigned char*>(begin);
+    for(size_t i = 0; i < length; i += 4, out += 3)
+    {
+        bool isLast = i + 4 == length;
+        unsigned char a = table[text[i]];
+        unsigned char b = table[text[i + 1]];
+        unsigned char c = (isLast && padding >= 2) ? 0 : table[text[i + 2]];
+        unsigned char d = (isLast && padding >= 1) ? 0 : table[text[i + 3]];
+        if((a | b | c | d) & 64)
+        {
+            result.clear();
+            return false;
+        }
+
+        unsigned int triple = (a << 18) | (b << 12) | (c << 6) | d;
+        out[0] = static_cast<char>(triple >> 16);
+        out[1] = static_cast<char>((triple >> 8) & 0xFF);
+        out[2] = static_cast<char>(triple & 0xFF);
+    }
+    result.resize(result.size() - padding);
+    return true;
+}
+
+
 //______________________________________________________________________________
 std::vector<string> ccdb::StringUtils::LexicalSplit( const std::string& source )
 {
@@ -0,0 +1,116 @@
+#include "CCDB/IOExecutor.h"
+
+using namespace std;
+
+namespace ccdb
+{
+
+//______________________________________________________________________________
+IOExecutor::IOExecutor(size_t maxThreads):
+    mMaxThreads(maxThreads ? maxThreads : 1),
+    mRunningThreads(0),
+    mIdleThreads(0),
+    mIsStopping(false),
+    mExecuted(0)
+{
+}
+
+
+//______________________________________________________________________________
+IOExecutor::~IOExecutor()
+{
+    //tasks are destroyed outside the lock, a dropped task breaks its promise
+    deque<function<void()> > dropped;
+    {
+        lock_guard<mutex> lock(mMutex);
+        mIsStopping = true;
+        dropped.swap(mTasks);
+    }
+    mTaskAdded.notify_all();
+    dropped.clear();
+
+    for(size_t i = 0; i < mThreads.size(); i++) mThreads[i].join();
+}
+
+
+//______________________________________________________________________________
+void IOExecutor::Post(function<void()> task)
+{
+    {
+        lock_guard<mutex> lock(mMutex);
+        mTasks.push_back(task);
+
+        //a new thread is started only if nobody can take the task
+        if(mIdleThreads < mTasks.size() && mRunningThreads < mMaxThreads)
+        {
+            mRunningThreads++;
+            mThreads.push_back(thread(&IOExecutor::Work, this));
+        }
+    }
+    mTaskAdded.notify_one();
+}
+
+
+//______________________________________________________________________________
+void IOExecutor::Work()
+{
+    unique_lock<mutex> lock(mMutex);
+    while(true)
+    {
+        mIdleThreads++;
+        while(!mIsStopping && mTasks.empty() && mRunningThreads <= mMaxThreads) mTaskAdded.wait(lock);
+        mIdleThreads--;
+
+        if(mIsStopping || mRunningThreads > mMaxThreads)
+        {
+            mRunningThreads--;
+            return;
+        }
+
+        function<void()> task;
+        task.swap(mTasks.front());
+        mTasks.pop_front();
+
+        lock.unlock();
+        task();         //submitted tasks keep their exceptions in futures
+        task = nullptr;
+        lock.lock();
+
+        mExecuted++;
+    }
+}
+
+
+//______________________________________________________________________________
+void IOExecutor::SetMaxThreads(size_t maxThreads)
+{
+    {
+        lock_guard<mutex> lock(mMutex);
+        mMaxThreads = maxThreads ? maxThreads : 1;
+    }
+
+    //idle extra threads stop
+    mTaskAdded.notify_all();
+}
+
+
+//______________________________________________________________________________
+size_t IOExecutor::GetMaxThreads()
+{
+    lock_guard<mutex> lock(mMutex);
+    return mMaxThreads;
+}
+
+
+//______________________________________________________________________________
+IOExecutorStats IOExecutor::GetStats()
+{
+    lock_guard<mutex> lock(mMutex);
+    IOExecutorStats stats;
+    stats.Threads = mRunningThreads;
+    stats.Queued = mTasks.size();
+    stats.Executed = mExecuted;
+    return stats;
+}
+
+}
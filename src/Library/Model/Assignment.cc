@@ -5,8 +5,14 @@
  *      Author: romanov
  */
 #include <vector>
+#include <utility>
 #include <sstream>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <stdint.h>
 #include <assert.h>
+#include <zlib.h>
 
 #include "CCDB/Model/Assignment.h"
 #include "CCDB/Helpers/StringUtils.h"
@@ -15,12 +21,10 @@
 using namespace ccdb;
 using namespace std;
 
-
 //______________________________________________________________________________
 ccdb::Assignment::Assignment( ObjectsOwner * owner/*=NULL*/, DataProvider *provider/*=NULL*/ )
 :StoredObject(owner, provider)
 {
-	mRawData = string(); 	// data blob
 	mId=0;					// id in database
 	mDataBlobId   = 0;		// blob id in database
 	mVariationId  = 0;		// database ID of variation
@@ -33,6 +37,9 @@ ccdb::Assignment::Assignment( ObjectsOwner * owner/*=NULL*/, DataProvider *provi
 	mEventRange = NULL;		// Event range object, is NULL if not set
 	mVariation  = NULL;		// Variation object, is NULL if not set
 	mTypeTable  = NULL;		// Reference to type table
+
+	mData = std::make_shared<AssignmentData>();	// data blob and its cells
+	mIsDataShared = false;
 }
 
 
@@ -218,6 +225,189 @@ string ccdb::Assignment::VectorToBlob(const vector<string>& values)
 }
 
 
+//______________________________________________________________________________
+static char GetBinaryTypeCode(ConstantsTypeColumn::ColumnTypes type)
+{
+	//one char per column in the header of binary blob
+	switch(type)
+	{
+	case ConstantsTypeColumn::cIntColumn:    return 'i';
+	case ConstantsTypeColumn::cUIntColumn:   return 'u';
+	case ConstantsTypeColumn::cLongColumn:   return 'l';
+	case ConstantsTypeColumn::cULongColumn:  return 'L';
+	case ConstantsTypeColumn::cDoubleColumn: return 'd';
+	case ConstantsTypeColumn::cBoolColumn:   return 'b';
+	default:                                 return 's';
+	}
+}
+
+
+//______________________________________________________________________________
+static void AppendLittleEndian(string& bytes, uint64_t value, size_t size)
+{
+	for (size_t i = 0; i < size; i++) bytes.push_back(static_cast<char>((value >> (8*i)) & 0xFF));
+}
+
+
+//______________________________________________________________________________
+string ccdb::Assignment::VectorToBlob(const vector<string>& values, const vector<ConstantsTypeColumn::ColumnTypes>& types)
+{
+	//#ccdb-bin:<version>:<rows>:<column type codes>:<base64 of little-endian arrays, column by column>
+	size_t columnsNum = types.size();
+	if(values.empty() || columnsNum == 0 || values.size() % columnsNum != 0) return VectorToBlob(values);
+	size_t rowsNum = values.size() / columnsNum;
+
+	string codes;
+	string bytes;
+	for (size_t colIter = 0; colIter < columnsNum; colIter++)
+	{
+		codes.push_back(GetBinaryTypeCode(types[colIter]));
+		for (size_t rowIter = 0; rowIter < rowsNum; rowIter++)
+		{
+			const string& cell = values[rowIter*columnsNum + colIter];
+			const char* begin = cell.data();
+			const char* end = begin + cell.size();
+			bool isParsed = true;
+			switch(types[colIter])
+			{
+			case ConstantsTypeColumn::cIntColumn:
+			{
+				int value;
+				isParsed = StringUtils::ParseInt(begin, end, value);
+				AppendLittleEndian(bytes, static_cast<uint32_t>(value), 4);
+				break;
+			}
+			case ConstantsTypeColumn::cUIntColumn:
+			{
+				unsigned int value;
+				isParsed = StringUtils::ParseUInt(begin, end, value);
+				AppendLittleEndian(bytes, value, 4);
+				break;
+			}
+			case ConstantsTypeColumn::cLongColumn:
+			{
+				long value;
+				isParsed = StringUtils::ParseLong(begin, end, value);
+				AppendLittleEndian(bytes, static_cast<uint64_t>(value), 8);
+				break;
+			}
+			case ConstantsTypeColumn::cULongColumn:
+			{
+				unsigned long value;
+				isParsed = StringUtils::ParseULong(begin, end, value);
+				AppendLittleEndian(bytes, value, 8);
+				break;
+			}
+			case ConstantsTypeColumn::cDoubleColumn:
+			{
+				double value;
+				isParsed = StringUtils::ParseDouble(begin, end, value);
+				uint64_t bits;
+				memcpy(&bits, &value, sizeof(bits));
+				AppendLittleEndian(bytes, bits, 8);
+				break;
+			}
+			case ConstantsTypeColumn::cBoolColumn:
+			{
+				bool value;
+				isParsed = StringUtils::ParseBool(begin, end, value);
+				bytes.push_back(value ? 1 : 0);
+				break;
+			}
+			default:
+				AppendLittleEndian(bytes, cell.size(), 4);
+				bytes.append(cell);
+				break;
+			}
+
+			//the value can't be kept in binary form, text blob keeps it as it is
+			if(!isParsed) return VectorToBlob(values);
+		}
+	}
+
+	string result(CCDB_BINARY_BLOB_PREFIX);
+	result.append(StringUtils::IntToString(CCDB_BINARY_BLOB_VERSION));
+	result.append(":");
+	result.append(StringUtils::IntToString(static_cast<int>(rowsNum)));
+	result.append(":");
+	result.append(codes);
+	result.append(":");
+	result.append(StringUtils::Base64Encode(bytes.data(), bytes.size()));
+	return result;
+}
+
+
+//______________________________________________________________________________
+bool ccdb::Assignment::IsBinaryBlob(const string& blob)
+{
+	return blob.compare(0, strlen(CCDB_BINARY_BLOB_PREFIX), CCDB_BINARY_BLOB_PREFIX) == 0;
+}
+
+
+//______________________________________________________________________________
+string ccdb::Assignment::CompressBlob(const string& blob, int level)
+{
+	//#ccdb-z:<version>:<size of the blob>:<base64 of zlib stream of the blob>
+	if(blob.size() < CCDB_COMPRESSED_BLOB_MIN_SIZE || IsCompressedBlob(blob)) return blob;
+
+	uLongf compressedSize = compressBound(blob.size());
+	string compressed(compressedSize, '\0');
+	int result = compress2(reinterpret_cast<Bytef*>(&compressed[0]), &compressedSize,
+	                       reinterpret_cast<const Bytef*>(blob.data()), blob.size(), level);
+	if(result != Z_OK) return blob;
+
+	string resultBlob(CCDB_COMPRESSED_BLOB_PREFIX);
+	resultBlob.append(StringUtils::IntToString(CCDB_COMPRESSED_BLOB_VERSION));
+	resultBlob.append(":");
+	resultBlob.append(StringUtils::Format("%lu", static_cast<unsigned long>(blob.size())));
+	resultBlob.append(":");
+	resultBlob.append(StringUtils::Base64Encode(compressed.data(), compressedSize));
+	return resultBlob.size() < blob.size() ? resultBlob : blob;
+}
+
+
+//______________________________________________________________________________
+bool ccdb::Assignment::IsCompressedBlob(const string& blob)
+{
+	return blob.compare(0, strlen(CCDB_COMPRESSED_BLOB_PREFIX), CCDB_COMPRESSED_BLOB_PREFIX) == 0;
+}
+
+
+//______________________________________________________________________________
+bool ccdb::Assignment::DecompressBlob(const string& blob, string& result)
+{
+	//#ccdb-z:<version>:<size of the blob>:<base64 of zlib stream of the blob>
+	if(!IsCompressedBlob(blob)) return false;
+	const char* pos = blob.data() + strlen(CCDB_COMPRESSED_BLOB_PREFIX);
+	const char* end = blob.data() + blob.size();
+
+	const char* versionEnd = static_cast<const char*>(memchr(pos, ':', end - pos));
+	if(!versionEnd) return false;
+	const char* sizeEnd = static_cast<const char*>(memchr(versionEnd + 1, ':', end - versionEnd - 1));
+	if(!sizeEnd) return false;
+
+	unsigned int version;
+	unsigned long size;
+	if(!StringUtils::ParseUInt(pos, versionEnd, version) || version != CCDB_COMPRESSED_BLOB_VERSION) return false;
+	if(!StringUtils::ParseULong(versionEnd + 1, sizeEnd, size)) return false;
+
+	string compressed;
+	if(!StringUtils::Base64Decode(sizeEnd + 1, end, compressed)) return false;
+
+	//deflate doesn't compress better than ~1032:1, a bigger size is a damaged header
+	if(size > compressed.size() * 1032ul + 64) return false;
+
+	string data(size, '\0');
+	uLongf dataSize = size;
+	int status = uncompress(reinterpret_cast<Bytef*>(&data[0]), &dataSize,
+	                        reinterpret_cast<const Bytef*>(compressed.data()), compressed.size());
+	if(status != Z_OK || dataSize != size) return false;
+
+	result.swap(data);
+	return true;
+}
+
+
 //______________________________________________________________________________
 vector<map<string,string> > ccdb::Assignment::GetMappedData() const
 {
@@ -263,9 +453,22 @@ void ccdb::Assignment::GetData(std::vector<std::vector<std::string> >& data) con
 
 	//clear before filling
 	data.clear();
-
-	//fill data
-	MapData(data, GetVectorData(), mTypeTable->GetColumnsCount());
+	size_t cellsNum = mData->GetCellsCount();
+	if(cellsNum == 0) return;
+
+	//fill data right from the cells (the same as MapData does with GetVectorData)
+	size_t columnsNum = mTypeTable->GetColumnsCount();
+	assert(columnsNum!=0);
+	size_t rows = cellsNum / columnsNum;
+	data.resize(rows);
+	for (size_t rowIter = 0; rowIter < rows; rowIter++)
+	{
+		data[rowIter].resize(columnsNum);
+		for (size_t colIter = 0; colIter < columnsNum; colIter++)
+		{
+			mData->GetCell(rowIter*columnsNum + colIter, data[rowIter][colIter]);
+		}
+	}
 }
 
 
@@ -297,58 +500,166 @@ vector<string> ccdb::Assignment::GetVectorData() const
 //______________________________________________________________________________
 void ccdb::Assignment::GetVectorData(vector<string>& vectorData) const
 {
-	//split data
+	//cells are already decoded by SetRawData
 	vectorData.clear();
-	vector<string>::const_iterator iter = mVectorData.begin();
-	while (iter<mVectorData.end())
-	{	
-		vectorData.push_back(DecodeBlobSeparator(*iter));
-		iter++;
+	vectorData.resize(mData->GetCellsCount());
+	for (size_t i = 0; i < vectorData.size(); i++)
+	{
+		mData->GetCell(i, vectorData[i]);
 	}
 }
 
+
 //______________________________________________________________________________
 void ccdb::Assignment::SetRawData(std::string val)
 {
-	mVectorData.clear();
-	mRows.clear();
-	mRawData = val;
+	/** @brief Sets raw data blob. @see AssignmentData::SetRawData
+	 *
+	 * Shared data is not changed, the assignment gets its own data
+	 */
 
-	mVectorData = StringUtils::Split(mRawData, CCDB_DATA_BLOB_DELIMETER);
-	for (size_t i = 0; i < mVectorData.size(); i++)
+	if(mIsDataShared)
 	{
-		mVectorData[i] = DecodeBlobSeparator(mVectorData[i]); //Decode blob separators
+		mData = std::make_shared<AssignmentData>();
+		mIsDataShared = false;
 	}
+	mData->SetRawData(std::move(val));
 }
 
-std::string ccdb::Assignment::GetValue(string columnName)
+
+//______________________________________________________________________________
+void ccdb::Assignment::SetSharedData(const std::shared_ptr<AssignmentData>& data)
 {
-	if (mRows.size() == 0)
+	mData = data;
+	mIsDataShared = true;
+}
+
+
+//______________________________________________________________________________
+void ccdb::Assignment::SetTypeTable(ConstantsTypeTable* typeTable)
+{
+	ConstantsTypeTable* oldTypeTable = mTypeTable;
+	mTypeTable = typeTable;
+	OnTypeTableChanged(oldTypeTable);
+}
+
+
+//______________________________________________________________________________
+void ccdb::Assignment::SetTypeTable(const std::shared_ptr<ConstantsTypeTable>& typeTable)
+{
+	ConstantsTypeTable* oldTypeTable = mTypeTable;
+	mSharedTypeTable = typeTable;
+	mTypeTable = typeTable.get();
+	OnTypeTableChanged(oldTypeTable);
+}
+
+
+//______________________________________________________________________________
+void ccdb::Assignment::OnTypeTableChanged(ConstantsTypeTable* oldTypeTable)
+{
+	if(!mIsDataShared)
 	{
-		//fill data
-		MapData(mRows, GetVectorData(), mTypeTable->GetColumnNames());
+		mData->ResetTypedColumns();
+		return;
 	}
-	return mRows[0][columnName];
+
+	//typed columns of shared data are built by the table it was shared for.
+	//With another table the assignment parses its own copy of the blob
+	if(mTypeTable == oldTypeTable) return;
+	std::shared_ptr<AssignmentData> data = std::make_shared<AssignmentData>();
+	data->SetRawData(mData->GetRawData());
+	mData = data;
+	mIsDataShared = false;
 }
 
-std::string ccdb::Assignment::GetValue(size_t rowIndex, string columnName)
+
+//______________________________________________________________________________
+const vector<double>& ccdb::Assignment::GetDoubleValues() const
+{
+	/** @brief Data converted to double, row by row (cell [row][column] is at row*columns + column)
+	 *
+	 * Values are taken from the typed columns once on the first call, the next calls return the same converted values
+	 * @remark the function is thread safe
+	 */
+	return mData->GetDoubleValues(mTypeTable);
+}
+
+
+//______________________________________________________________________________
+const vector<int>& ccdb::Assignment::GetIntValues() const
+{
+	/** @brief Data converted to int, row by row. @see GetDoubleValues */
+	return mData->GetIntValues(mTypeTable);
+}
+
+
+//______________________________________________________________________________
+const vector<long>& ccdb::Assignment::GetLongValues() const
+{
+	/** @brief Data converted to long, row by row. @see GetDoubleValues */
+	return mData->GetLongValues(mTypeTable);
+}
+
+
+//______________________________________________________________________________
+const vector<bool>& ccdb::Assignment::GetBoolValues() const
 {
-	if (mRows.size() == 0)
+	/** @brief Data converted to bool, row by row. @see GetDoubleValues */
+	return mData->GetBoolValues(mTypeTable);
+}
+
+
+//______________________________________________________________________________
+const vector<TypedColumn>& ccdb::Assignment::GetTypedColumns() const
+{
+	/** @brief Data as typed columns, one contiguous array per column
+	 *
+	 * Columns are built once on the first call, the next calls return the same columns
+	 * @remark the function is thread safe
+	 */
+	return mData->GetTypedColumns(mTypeTable);
+}
+
+
+//______________________________________________________________________________
+int ccdb::Assignment::FindColumn(const string& columnName) const
+{
+	if(mTypeTable == NULL) return -1;
+
+	const vector<ConstantsTypeColumn *>& columns = mTypeTable->GetColumns();
+	for (size_t i = 0; i < columns.size(); i++)
 	{
-		//fill data
-		MapData(mRows, GetVectorData(), mTypeTable->GetColumnNames());
+		if(columns[i]->GetName() == columnName) return static_cast<int>(i);
 	}
-	return GetMappedData()[0][columnName];
+	return -1;
+}
+
+
+//______________________________________________________________________________
+std::string ccdb::Assignment::GetValue(string columnName)
+{
+	return GetValue(0, columnName);
+}
+
+std::string ccdb::Assignment::GetValue(size_t rowIndex, string columnName)
+{
+	int columnIndex = FindColumn(columnName);
+	if(columnIndex < 0) return string();
+	return GetValue(rowIndex, static_cast<size_t>(columnIndex));
 }
 
 std::string ccdb::Assignment::GetValue(size_t rowIndex, size_t columnIndex)
 {
-	return GetData()[rowIndex][columnIndex];
+	string cell;
+	mData->GetCell(rowIndex*GetColumnsCount() + columnIndex, cell);
+	return cell;
 }
 
 std::string ccdb::Assignment::GetValue(size_t columnIndex)
 {
-	return GetVectorData()[columnIndex];
+	string cell;
+	mData->GetCell(columnIndex, cell);
+	return cell;
 }
 
 ConstantsTypeColumn::ColumnTypes ccdb::Assignment::GetValueType(const string& columnName)
@@ -357,9 +668,33 @@ ConstantsTypeColumn::ColumnTypes ccdb::Assignment::GetValueType(const string& co
 }
 
 
+//______________________________________________________________________________
+size_t ccdb::Assignment::GetMemoryUsage() const
+{
+	/** @brief Estimates the amount of memory (in bytes) held by this object
+	 *
+	 * The estimation includes data blob, tokenized data and the owned type table.
+	 * Data shared by several assignments is divided between them.
+	 * It is used by caches to account their memory budget
+	 * @return   size_t approximate size in bytes
+	 */
 
+	size_t size = sizeof(Assignment) + mComment.capacity();
 
+	//data blob, its cells and typed values. Shared data is divided between its holders
+	size_t dataSize = mData->GetMemoryUsage();
+	size += mIsDataShared ? dataSize / mData.use_count() : dataSize;
 
+	//type table with columns. Shared tables are counted by nobody
+	if(mTypeTable && !mSharedTypeTable)
+	{
+		size += sizeof(ConstantsTypeTable) + mTypeTable->GetComment().size();
+		const vector<ConstantsTypeColumn *>& columns = mTypeTable->GetColumns();
+		for (size_t i = 0; i < columns.size(); i++)
+		{
+			size += sizeof(ConstantsTypeColumn) + columns[i]->GetName().size();
+		}
+	}
 
-
-
+	return size;
+}
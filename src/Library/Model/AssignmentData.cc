@@ -0,0 +1,558 @@
+/*
+ * AssignmentData.cc
+ */
+
+#include <vector>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <stdint.h>
+#include <unordered_map>
+
+#include "CCDB/Model/AssignmentData.h"
+#include "CCDB/Model/Assignment.h"
+#include "CCDB/Helpers/StringUtils.h"
+#include "CCDB/Globals.h"
+
+using namespace ccdb;
+using namespace std;
+
+const unsigned int ccdb::AssignmentData::kDecodedCell;
+
+
+//______________________________________________________________________________
+static bool GetBinaryColumnType(char code, ConstantsTypeColumn::ColumnTypes& type)
+{
+	switch(code)
+	{
+	case 'i': type = ConstantsTypeColumn::cIntColumn;    return true;
+	case 'u': type = ConstantsTypeColumn::cUIntColumn;   return true;
+	case 'l': type = ConstantsTypeColumn::cLongColumn;   return true;
+	case 'L': type = ConstantsTypeColumn::cULongColumn;  return true;
+	case 'd': type = ConstantsTypeColumn::cDoubleColumn; return true;
+	case 'b': type = ConstantsTypeColumn::cBoolColumn;   return true;
+	case 's': type = ConstantsTypeColumn::cStringColumn; return true;
+	default:  return false;
+	}
+}
+
+
+//______________________________________________________________________________
+static uint64_t ReadLittleEndian(const unsigned char* bytes, size_t size)
+{
+	uint64_t value = 0;
+	for (size_t i = 0; i < size; i++) value |= static_cast<uint64_t>(bytes[i]) << (8*i);
+	return value;
+}
+
+
+//______________________________________________________________________________
+ccdb::AssignmentData::AssignmentData()
+{
+	mIsDoubleValuesReady = false;
+	mIsIntValuesReady    = false;
+	mIsLongValuesReady   = false;
+	mIsBoolValuesReady   = false;
+	mIsTypedColumnsReady = false;
+	mIsBinaryData = false;
+	mIsCellsReady = true;
+}
+
+
+//______________________________________________________________________________
+void ccdb::AssignmentData::SetRawData(std::string val)
+{
+	/** @brief Sets raw data blob
+	 *
+	 * The blob is tokenized in one pass: only offsets of the cells are remembered,
+	 * cell strings are made on demand. Cells with escaped separators are decoded here once
+	 */
+
+	mCells.clear();
+	mDecodedCells.clear();
+	mRawData.swap(val);
+	mIsBinaryData = false;
+	mIsCellsReady = true;
+
+	//typed values are converted from the new data on demand
+	mIsDoubleValuesReady = false;
+	mIsIntValuesReady    = false;
+	mIsLongValuesReady   = false;
+	mIsBoolValuesReady   = false;
+	mIsTypedColumnsReady = false;
+	mDoubleValues.clear();
+	mIntValues.clear();
+	mLongValues.clear();
+	mBoolValues.clear();
+
+	//binary data goes right to typed columns, cells are formatted only if they are requested
+	if(Assignment::IsBinaryBlob(mRawData) && DecodeBinaryData())
+	{
+		mIsBinaryData = true;
+		mIsCellsReady = false;
+		mIsTypedColumnsReady = true;
+		return;
+	}
+
+	//Cells are non empty runs of chars between '|' (the same tokens as StringUtils::Split gives).
+	//memchr finds separators and the nearest '&' which may start an escaped separator,
+	//so only cells with '&' are looked at char by char
+	const char* data = mRawData.data();
+	const char* end = data + mRawData.size();
+	const char* delimiter = CCDB_DATA_BLOB_DELIMETER;
+	const char* amp = static_cast<const char*>(memchr(data, '&', end - data));
+	if(!amp) amp = end;
+
+	const char* pos = data;
+	while(pos < end)
+	{
+		//skip separators
+		if(*pos == delimiter[0])
+		{
+			pos++;
+			continue;
+		}
+
+		const char* cellEnd = static_cast<const char*>(memchr(pos, delimiter[0], end - pos));
+		if(!cellEnd) cellEnd = end;
+
+		unsigned int cell = static_cast<unsigned int>(pos - data);
+		if(amp < cellEnd)
+		{
+			string decoded = Assignment::DecodeBlobSeparator(string(pos, cellEnd));
+			if(decoded.size() != static_cast<size_t>(cellEnd - pos))
+			{
+				cell = static_cast<unsigned int>(mDecodedCells.size()) | kDecodedCell;
+				mDecodedCells.push_back(decoded);
+			}
+			amp = static_cast<const char*>(memchr(cellEnd, '&', end - cellEnd));
+			if(!amp) amp = end;
+		}
+
+		mCells.push_back(cell);
+		pos = cellEnd;
+	}
+
+	//the assignment keeps the cells as long as the data
+	mCells.shrink_to_fit();
+}
+
+
+//______________________________________________________________________________
+bool ccdb::AssignmentData::DecodeBinaryData()
+{
+	//#ccdb-bin:<version>:<rows>:<column type codes>:<base64 of little-endian arrays, column by column>
+	const char* pos = mRawData.data() + strlen(CCDB_BINARY_BLOB_PREFIX);
+	const char* end = mRawData.data() + mRawData.size();
+
+	//header fields
+	const char* fields[3];
+	const char* fieldEnds[3];
+	for (int i = 0; i < 3; i++)
+	{
+		const char* fieldEnd = static_cast<const char*>(memchr(pos, ':', end - pos));
+		if(!fieldEnd) return false;
+		fields[i] = pos;
+		fieldEnds[i] = fieldEnd;
+		pos = fieldEnd + 1;
+	}
+
+	unsigned int version;
+	unsigned int rowsNum;
+	if(!StringUtils::ParseUInt(fields[0], fieldEnds[0], version) || version != CCDB_BINARY_BLOB_VERSION) return false;
+	if(!StringUtils::ParseUInt(fields[1], fieldEnds[1], rowsNum)) return false;
+
+	string bytes;
+	if(!StringUtils::Base64Decode(pos, end, bytes)) return false;
+	const unsigned char* data = reinterpret_cast<const unsigned char*>(bytes.data());
+	size_t left = bytes.size();
+
+	vector<TypedColumn> columns(fieldEnds[2] - fields[2]);
+	vector<string> strings;
+	unordered_map<string, unsigned int> stringIds;
+	for (size_t colIter = 0; colIter < columns.size(); colIter++)
+	{
+		TypedColumn& column = columns[colIter];
+		if(!GetBinaryColumnType(fields[2][colIter], column.Type)) return false;
+		column.Strings = &mInternedStrings;
+
+		switch(column.Type)
+		{
+		case ConstantsTypeColumn::cIntColumn:
+		case ConstantsTypeColumn::cUIntColumn:
+			if(left < rowsNum * 4ul) return false;
+			column.Integers.resize(rowsNum);
+			for (size_t i = 0; i < rowsNum; i++, data += 4)
+			{
+				uint32_t value = static_cast<uint32_t>(ReadLittleEndian(data, 4));
+				column.Integers[i] = column.Type == ConstantsTypeColumn::cIntColumn ? static_cast<long>(static_cast<int32_t>(value)) : static_cast<long>(value);
+			}
+			left -= rowsNum * 4ul;
+			break;
+		case ConstantsTypeColumn::cLongColumn:
+		case ConstantsTypeColumn::cULongColumn:
+			if(left < rowsNum * 8ul) return false;
+			column.Integers.resize(rowsNum);
+			for (size_t i = 0; i < rowsNum; i++, data += 8)
+			{
+				column.Integers[i] = static_cast<long>(ReadLittleEndian(data, 8));
+			}
+			left -= rowsNum * 8ul;
+			break;
+		case ConstantsTypeColumn::cDoubleColumn:
+			if(left < rowsNum * 8ul) return false;
+			column.Doubles.resize(rowsNum);
+			for (size_t i = 0; i < rowsNum; i++, data += 8)
+			{
+				uint64_t bits = ReadLittleEndian(data, 8);
+				memcpy(&column.Doubles[i], &bits, sizeof(bits));
+			}
+			left -= rowsNum * 8ul;
+			break;
+		case ConstantsTypeColumn::cBoolColumn:
+			if(left < rowsNum) return false;
+			column.Bools.assign(data, data + rowsNum);
+			data += rowsNum;
+			left -= rowsNum;
+			break;
+		default:
+			//strings are interned the same way as for text data
+			column.StringIds.resize(rowsNum);
+			for (size_t i = 0; i < rowsNum; i++)
+			{
+				if(left < 4) return false;
+				size_t length = static_cast<size_t>(ReadLittleEndian(data, 4));
+				data += 4;
+				left -= 4;
+				if(left < length) return false;
+
+				string cell(reinterpret_cast<const char*>(data), length);
+				data += length;
+				left -= length;
+				unordered_map<string, unsigned int>::iterator iter = stringIds.find(cell);
+				if(iter == stringIds.end())
+				{
+					iter = stringIds.insert(make_pair(cell, static_cast<unsigned int>(strings.size()))).first;
+					strings.push_back(cell);
+				}
+				column.StringIds[i] = iter->second;
+			}
+			break;
+		}
+	}
+	if(left != 0) return false;
+
+	mTypedColumns.swap(columns);
+	mInternedStrings.swap(strings);
+	return true;
+}
+
+
+//______________________________________________________________________________
+size_t ccdb::AssignmentData::GetCellsCount() const
+{
+	PrepareCells();
+	return mCells.size();
+}
+
+
+//______________________________________________________________________________
+void ccdb::AssignmentData::GetCell(size_t index, string& cell) const
+{
+	PrepareCells();
+	const char* begin;
+	const char* end;
+	GetCellRange(index, begin, end);
+	cell.assign(begin, end);
+}
+
+
+//______________________________________________________________________________
+void ccdb::AssignmentData::GetCellRange(size_t index, const char*& begin, const char*& end) const
+{
+	unsigned int offset = mCells[index];
+	if(offset & kDecodedCell)
+	{
+		const string& cell = mDecodedCells[offset & ~kDecodedCell];
+		begin = cell.data();
+		end = begin + cell.size();
+		return;
+	}
+
+	begin = mRawData.data() + offset;
+	end = mRawData.data() + mRawData.size();
+	const char* cellEnd = static_cast<const char*>(memchr(begin, CCDB_DATA_BLOB_DELIMETER[0], end - begin));
+	if(cellEnd) end = cellEnd;
+}
+
+
+//______________________________________________________________________________
+void ccdb::AssignmentData::PrepareCells() const
+{
+	//Cells of text blobs are found by SetRawData.
+	//Cells of binary data are formatted from typed columns once, on the first request
+	if(mIsCellsReady.load(std::memory_order_acquire)) return;
+
+	std::lock_guard<std::mutex> lock(mTypedValuesMutex);
+	if(mIsCellsReady.load(std::memory_order_relaxed)) return;
+
+	size_t columnsNum = mTypedColumns.size();
+	size_t rowsNum = columnsNum ? mTypedColumns[0].GetRowsCount() : 0;
+	mCells.resize(rowsNum * columnsNum);
+	mDecodedCells.resize(rowsNum * columnsNum);
+	for (size_t rowIter = 0; rowIter < rowsNum; rowIter++)
+	{
+		for (size_t colIter = 0; colIter < columnsNum; colIter++)
+		{
+			size_t index = rowIter*columnsNum + colIter;
+			char buffer[32];
+			const char* begin;
+			const char* end;
+			mTypedColumns[colIter].GetText(rowIter, buffer, begin, end);
+			mDecodedCells[index].assign(begin, end);
+			mCells[index] = static_cast<unsigned int>(index) | kDecodedCell;
+		}
+	}
+	mIsCellsReady.store(true, std::memory_order_release);
+}
+
+//______________________________________________________________________________
+template<typename T>
+const vector<T>& ccdb::AssignmentData::GetTypedValues(const ConstantsTypeTable* table, vector<T>& values, std::atomic<bool>& isReady, bool (*parse)(const char*, const char*, T&)) const
+{
+	//Converts data once. The flag is checked without lock, so
+	//after the conversion the data is read by any number of threads without waiting
+	if(!isReady.load(std::memory_order_acquire))
+	{
+		//Values are taken from the typed columns, so they are the same as
+		//Assignment::GetValue... and GetCalib give. The columns are built before the lock,
+		//GetTypedColumns takes the same mutex
+		const vector<TypedColumn>* columns = NULL;
+		if(mIsBinaryData || (table && table->GetColumnsCount() > 0)) columns = &GetTypedColumns(table);
+
+		std::lock_guard<std::mutex> lock(mTypedValuesMutex);
+		if(columns && !columns->empty() && !isReady.load(std::memory_order_relaxed))
+		{
+			//a trailing incomplete row of text data (if any) is not a part of the columns
+			size_t columnsNum = columns->size();
+			size_t rowsNum = (*columns)[0].GetRowsCount();
+			values.resize(rowsNum * columnsNum);
+			for (size_t rowIter = 0; rowIter < rowsNum; rowIter++)
+			{
+				for (size_t colIter = 0; colIter < columnsNum; colIter++)
+				{
+					values[rowIter*columnsNum + colIter] = (*columns)[colIter].template Get<T>(rowIter);
+				}
+			}
+			isReady.store(true, std::memory_order_release);
+		}
+		if(!isReady.load(std::memory_order_relaxed))
+		{
+			//no typed columns, cells are parsed right in the blob
+			values.resize(mCells.size());
+			const char* begin;
+			const char* end;
+			for (size_t i = 0; i < mCells.size(); i++)
+			{
+				GetCellRange(i, begin, end);
+				T value;
+				parse(begin, end, value);
+				values[i] = value;
+			}
+			isReady.store(true, std::memory_order_release);
+		}
+	}
+	return values;
+}
+
+
+//______________________________________________________________________________
+const vector<double>& ccdb::AssignmentData::GetDoubleValues(const ConstantsTypeTable* table) const
+{
+	/** @brief Data converted to double, row by row (cell [row][column] is at row*columns + column)
+	 *
+	 * Cells are converted once on the first call, the next calls return the same converted values
+	 * @remark the function is thread safe
+	 */
+	return GetTypedValues(table, mDoubleValues, mIsDoubleValuesReady, &StringUtils::ParseDouble);
+}
+
+
+//______________________________________________________________________________
+const vector<int>& ccdb::AssignmentData::GetIntValues(const ConstantsTypeTable* table) const
+{
+	/** @brief Data converted to int, row by row. @see GetDoubleValues */
+	return GetTypedValues(table, mIntValues, mIsIntValuesReady, &StringUtils::ParseInt);
+}
+
+
+//______________________________________________________________________________
+const vector<long>& ccdb::AssignmentData::GetLongValues(const ConstantsTypeTable* table) const
+{
+	/** @brief Data converted to long, row by row. @see GetDoubleValues */
+	return GetTypedValues(table, mLongValues, mIsLongValuesReady, &StringUtils::ParseLong);
+}
+
+
+//______________________________________________________________________________
+const vector<bool>& ccdb::AssignmentData::GetBoolValues(const ConstantsTypeTable* table) const
+{
+	/** @brief Data converted to bool, row by row. @see GetDoubleValues */
+	return GetTypedValues(table, mBoolValues, mIsBoolValuesReady, &StringUtils::ParseBool);
+}
+
+
+//______________________________________________________________________________
+const vector<TypedColumn>& ccdb::AssignmentData::GetTypedColumns(const ConstantsTypeTable* table) const
+{
+	/** @brief Data as typed columns, one contiguous array per column
+	 *
+	 * Columns are built once on the first call, the next calls return the same columns
+	 * @remark the function is thread safe
+	 */
+
+	//The same double checked flag as for typed values
+	if(mIsTypedColumnsReady.load(std::memory_order_acquire)) return mTypedColumns;
+
+	std::lock_guard<std::mutex> lock(mTypedValuesMutex);
+	if(mIsTypedColumnsReady.load(std::memory_order_relaxed)) return mTypedColumns;
+
+	mTypedColumns.clear();
+	mInternedStrings.clear();
+
+	size_t columnsNum = table ? table->GetColumnsCount() : 0;
+	if(columnsNum > 0)
+	{
+		size_t rowsNum = mCells.size() / columnsNum;
+
+		//without loaded columns the types are unknown, the cells are kept as strings
+		const vector<ConstantsTypeColumn *>& typeColumns = table->GetColumns();
+		bool hasTypes = typeColumns.size() == columnsNum;
+
+		mTypedColumns.resize(columnsNum);
+		for (size_t colIter = 0; colIter < columnsNum; colIter++)
+		{
+			TypedColumn& column = mTypedColumns[colIter];
+			column.Type = hasTypes ? typeColumns[colIter]->GetType() : ConstantsTypeColumn::cStringColumn;
+			column.Strings = &mInternedStrings;
+			column.Cells = this;
+			column.Column = colIter;
+			column.ColumnsCount = columnsNum;
+			switch(column.Type)
+			{
+			case ConstantsTypeColumn::cDoubleColumn: column.Doubles.reserve(rowsNum); break;
+			case ConstantsTypeColumn::cBoolColumn:   column.Bools.reserve(rowsNum); break;
+			case ConstantsTypeColumn::cStringColumn: column.StringIds.reserve(rowsNum); break;
+			default:                                 column.Integers.reserve(rowsNum); break;
+			}
+		}
+
+		//numbers are parsed right in the blob, strings are copied once to be interned
+		unordered_map<string, unsigned int> stringIds;
+		string cell;
+		const char* begin;
+		const char* end;
+		for (size_t rowIter = 0; rowIter < rowsNum; rowIter++)
+		{
+			for (size_t colIter = 0; colIter < columnsNum; colIter++)
+			{
+				TypedColumn& column = mTypedColumns[colIter];
+				GetCellRange(rowIter*columnsNum + colIter, begin, end);
+				bool isParsed = true;
+				switch(column.Type)
+				{
+				case ConstantsTypeColumn::cIntColumn:
+				{
+					int value;
+					isParsed = StringUtils::ParseInt(begin, end, value);
+					column.Integers.push_back(value);
+					break;
+				}
+				case ConstantsTypeColumn::cUIntColumn:
+				{
+					unsigned int value;
+					isParsed = StringUtils::ParseUInt(begin, end, value);
+					column.Integers.push_back(value);
+					break;
+				}
+				case ConstantsTypeColumn::cLongColumn:
+				{
+					long value;
+					isParsed = StringUtils::ParseLong(begin, end, value);
+					column.Integers.push_back(value);
+					break;
+				}
+				case ConstantsTypeColumn::cULongColumn:
+				{
+					unsigned long value;
+					isParsed = StringUtils::ParseULong(begin, end, value);
+					column.Integers.push_back(static_cast<long>(value));
+					break;
+				}
+				case ConstantsTypeColumn::cDoubleColumn:
+				{
+					double value;
+					isParsed = StringUtils::ParseDouble(begin, end, value);
+					column.Doubles.push_back(value);
+					break;
+				}
+				case ConstantsTypeColumn::cBoolColumn:
+				{
+					bool value;
+					isParsed = StringUtils::ParseBool(begin, end, value);
+					column.Bools.push_back(value);
+					break;
+				}
+				case ConstantsTypeColumn::cStringColumn:
+				{
+					cell.assign(begin, end);
+					unordered_map<string, unsigned int>::iterator iter = stringIds.find(cell);
+					if(iter == stringIds.end())
+					{
+						iter = stringIds.insert(make_pair(cell, static_cast<unsigned int>(mInternedStrings.size()))).first;
+						mInternedStrings.push_back(cell);
+					}
+					column.StringIds.push_back(iter->second);
+					break;
+				}
+				}
+				if(!isParsed) column.ParseErrors++;
+			}
+		}
+	}
+
+	mIsTypedColumnsReady.store(true, std::memory_order_release);
+	return mTypedColumns;
+}
+
+
+//______________________________________________________________________________
+size_t ccdb::AssignmentData::GetMemoryUsage() const
+{
+	/** @brief Estimates the amount of memory (in bytes) held by this object
+	 *
+	 * The estimation includes data blob, tokenized data, typed values and columns
+	 */
+
+	size_t size = sizeof(AssignmentData) + mRawData.capacity();
+
+	//tokenized blob
+	size += mCells.capacity() * sizeof(unsigned int) + mDecodedCells.capacity() * sizeof(string);
+	for (size_t i = 0; i < mDecodedCells.size(); i++) size += mDecodedCells[i].capacity();
+
+	//converted typed values
+	size += mDoubleValues.capacity() * sizeof(double) + mIntValues.capacity() * sizeof(int) +
+	        mLongValues.capacity() * sizeof(long) + mBoolValues.capacity() / 8;
+
+	//typed columns and interned strings
+	for (size_t i = 0; i < mTypedColumns.size(); i++)
+	{
+		const TypedColumn& column = mTypedColumns[i];
+		size += sizeof(TypedColumn) + column.Doubles.capacity() * sizeof(double) + column.Integers.capacity() * sizeof(long) +
+		        column.Bools.capacity() + column.StringIds.capacity() * sizeof(unsigned int) + column.GetConvertedMemoryUsage();
+	}
+	size += mInternedStrings.capacity() * sizeof(string);
+	for (size_t i = 0; i < mInternedStrings.size(); i++) size += mInternedStrings[i].capacity();
+
+	return size;
+}
@@ -4,7 +4,7 @@
 using namespace ccdb;
 //class DDataProvider;
 
-unsigned long ccdb::StoredObject::mLastTempId=0;
+std::atomic<unsigned long> ccdb::StoredObject::mLastTempId(0);
 
 ccdb::StoredObject::StoredObject( ObjectsOwner * owner/*=NULL*/, DataProvider *provider/*=NULL*/ )
 {
@@ -0,0 +1,313 @@
+/*
+ * TypedColumn.cc
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <atomic>
+
+#include "CCDB/Model/TypedColumn.h"
+#include "CCDB/Model/AssignmentData.h"
+#include "CCDB/Helpers/StringUtils.h"
+
+using namespace ccdb;
+using namespace std;
+
+
+//______________________________________________________________________________
+template<typename T>
+static T ParseText(const TypedColumn& column, size_t row, bool (*parse)(const char*, const char*, T&))
+{
+	//the value is what StringUtils::Parse... gives for the cell, whatever type the column has
+	char buffer[32];
+	const char* begin;
+	const char* end;
+	column.GetText(row, buffer, begin, end);
+	T value;
+	parse(begin, end, value);
+	return value;
+}
+
+
+//______________________________________________________________________________
+static bool ParseBoolChar(const char* begin, const char* end, char& value)
+{
+	bool parsed;
+	bool isParsed = StringUtils::ParseBool(begin, end, parsed);
+	value = parsed ? 1 : 0;
+	return isParsed;
+}
+
+
+//______________________________________________________________________________
+struct ccdb::TypedColumn::Conversions
+{
+	Conversions(): IsDoublesReady(false), IsIntsReady(false), IsUIntsReady(false), IsLongsReady(false), IsULongsReady(false), IsBoolsReady(false) {}
+
+	std::mutex Mutex;                       // Guards conversions
+	std::vector<double>        Doubles;
+	std::vector<int>           Ints;
+	std::vector<unsigned int>  UInts;
+	std::vector<long>          Longs;
+	std::vector<unsigned long> ULongs;
+	std::vector<char>          Bools;
+	std::atomic<bool> IsDoublesReady;
+	std::atomic<bool> IsIntsReady;
+	std::atomic<bool> IsUIntsReady;
+	std::atomic<bool> IsLongsReady;
+	std::atomic<bool> IsULongsReady;
+	std::atomic<bool> IsBoolsReady;
+};
+
+
+//______________________________________________________________________________
+template<typename T, typename Stored>
+static const vector<T>& Convert(const TypedColumn& column, std::mutex& mutex, vector<T>& values, std::atomic<bool>& isReady,
+                                ConstantsTypeColumn::ColumnTypes ownType, const vector<Stored>& stored,
+                                bool (*parse)(const char*, const char*, T&))
+{
+	//Converts the column once. The flag is checked without lock, so
+	//after the conversion the values are read by any number of threads without waiting
+	if(isReady.load(std::memory_order_acquire)) return values;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	if(isReady.load(std::memory_order_relaxed)) return values;
+
+	size_t rowsNum = column.GetRowsCount();
+	values.resize(rowsNum);
+	if(column.Type == ownType)
+	{
+		//values of the column type are kept in a wider array
+		for (size_t rowIter = 0; rowIter < rowsNum; rowIter++) values[rowIter] = static_cast<T>(stored[rowIter]);
+	}
+	else
+	{
+		for (size_t rowIter = 0; rowIter < rowsNum; rowIter++) values[rowIter] = ParseText<T>(column, rowIter, parse);
+	}
+	isReady.store(true, std::memory_order_release);
+	return values;
+}
+
+
+//______________________________________________________________________________
+ccdb::TypedColumn::TypedColumn():
+	Type(ConstantsTypeColumn::cStringColumn),
+	Strings(NULL),
+	ParseErrors(0),
+	Cells(NULL),
+	Column(0),
+	ColumnsCount(0),
+	mConversions(new Conversions())
+{
+}
+
+
+//______________________________________________________________________________
+ccdb::TypedColumn::TypedColumn(const TypedColumn& rhs):
+	Type(rhs.Type),
+	Doubles(rhs.Doubles),
+	Integers(rhs.Integers),
+	Bools(rhs.Bools),
+	StringIds(rhs.StringIds),
+	Strings(rhs.Strings),
+	ParseErrors(rhs.ParseErrors),
+	Cells(rhs.Cells),
+	Column(rhs.Column),
+	ColumnsCount(rhs.ColumnsCount),
+	mConversions(new Conversions())
+{
+}
+
+
+//______________________________________________________________________________
+TypedColumn& ccdb::TypedColumn::operator=(const TypedColumn& rhs)
+{
+	if(this == &rhs) return *this;
+	Type         = rhs.Type;
+	Doubles      = rhs.Doubles;
+	Integers     = rhs.Integers;
+	Bools        = rhs.Bools;
+	StringIds    = rhs.StringIds;
+	Strings      = rhs.Strings;
+	ParseErrors  = rhs.ParseErrors;
+	Cells        = rhs.Cells;
+	Column       = rhs.Column;
+	ColumnsCount = rhs.ColumnsCount;
+	mConversions.reset(new Conversions());
+	return *this;
+}
+
+
+//______________________________________________________________________________
+ccdb::TypedColumn::~TypedColumn()
+{
+}
+
+
+//______________________________________________________________________________
+size_t ccdb::TypedColumn::GetRowsCount() const
+{
+	switch(Type)
+	{
+	case ConstantsTypeColumn::cDoubleColumn: return Doubles.size();
+	case ConstantsTypeColumn::cBoolColumn:   return Bools.size();
+	case ConstantsTypeColumn::cStringColumn: return StringIds.size();
+	default:                                 return Integers.size();
+	}
+}
+
+
+//______________________________________________________________________________
+void ccdb::TypedColumn::GetText(size_t row, char* buffer, const char*& begin, const char*& end) const
+{
+	if(Cells)
+	{
+		Cells->GetCellRange(row*ColumnsCount + Column, begin, end);
+		return;
+	}
+
+	switch(Type)
+	{
+	case ConstantsTypeColumn::cDoubleColumn:
+	{
+		//the shortest form which is read back to the same double
+		double value = Doubles[row];
+		for (int precision = 15; precision <= 17; precision++)
+		{
+			snprintf(buffer, 32, "%.*g", precision, value);
+			if(strtod(buffer, NULL) == value) break;
+		}
+		break;
+	}
+	case ConstantsTypeColumn::cBoolColumn:
+		strcpy(buffer, Bools[row] ? "true" : "false");
+		break;
+	case ConstantsTypeColumn::cStringColumn:
+	{
+		const string& value = (*Strings)[StringIds[row]];
+		begin = value.data();
+		end = begin + value.size();
+		return;
+	}
+	case ConstantsTypeColumn::cULongColumn:
+		snprintf(buffer, 32, "%lu", static_cast<unsigned long>(Integers[row]));
+		break;
+	default:
+		snprintf(buffer, 32, "%ld", Integers[row]);
+		break;
+	}
+	begin = buffer;
+	end = buffer + strlen(buffer);
+}
+
+
+//______________________________________________________________________________
+namespace ccdb
+{
+
+template<> const double* TypedColumn::GetValues<double>() const
+{
+	if(Type == ConstantsTypeColumn::cDoubleColumn) return Doubles.empty() ? NULL : &Doubles[0];
+	const vector<double>& values = Convert(*this, mConversions->Mutex, mConversions->Doubles, mConversions->IsDoublesReady,
+	                                       ConstantsTypeColumn::cDoubleColumn, Doubles, &StringUtils::ParseDouble);
+	return values.empty() ? NULL : &values[0];
+}
+
+
+template<> const int* TypedColumn::GetValues<int>() const
+{
+	const vector<int>& values = Convert(*this, mConversions->Mutex, mConversions->Ints, mConversions->IsIntsReady,
+	                                    ConstantsTypeColumn::cIntColumn, Integers, &StringUtils::ParseInt);
+	return values.empty() ? NULL : &values[0];
+}
+
+
+template<> const unsigned int* TypedColumn::GetValues<unsigned int>() const
+{
+	const vector<unsigned int>& values = Convert(*this, mConversions->Mutex, mConversions->UInts, mConversions->IsUIntsReady,
+	                                             ConstantsTypeColumn::cUIntColumn, Integers, &StringUtils::ParseUInt);
+	return values.empty() ? NULL : &values[0];
+}
+
+
+template<> const long* TypedColumn::GetValues<long>() const
+{
+	if(Type == ConstantsTypeColumn::cLongColumn) return Integers.empty() ? NULL : &Integers[0];
+	const vector<long>& values = Convert(*this, mConversions->Mutex, mConversions->Longs, mConversions->IsLongsReady,
+	                                     ConstantsTypeColumn::cLongColumn, Integers, &StringUtils::ParseLong);
+	return values.empty() ? NULL : &values[0];
+}
+
+
+template<> const unsigned long* TypedColumn::GetValues<unsigned long>() const
+{
+	const vector<unsigned long>& values = Convert(*this, mConversions->Mutex, mConversions->ULongs, mConversions->IsULongsReady,
+	                                              ConstantsTypeColumn::cULongColumn, Integers, &StringUtils::ParseULong);
+	return values.empty() ? NULL : &values[0];
+}
+
+}
+
+
+//______________________________________________________________________________
+double ccdb::TypedColumn::GetDouble(size_t row) const
+{
+	if(Type == ConstantsTypeColumn::cDoubleColumn) return Doubles[row];
+	return GetValues<double>()[row];
+}
+
+
+//______________________________________________________________________________
+int ccdb::TypedColumn::GetInt(size_t row) const
+{
+	if(Type == ConstantsTypeColumn::cIntColumn) return static_cast<int>(Integers[row]);
+	return GetValues<int>()[row];
+}
+
+
+//______________________________________________________________________________
+unsigned int ccdb::TypedColumn::GetUInt(size_t row) const
+{
+	if(Type == ConstantsTypeColumn::cUIntColumn) return static_cast<unsigned int>(Integers[row]);
+	return GetValues<unsigned int>()[row];
+}
+
+
+//______________________________________________________________________________
+long ccdb::TypedColumn::GetLong(size_t row) const
+{
+	if(Type == ConstantsTypeColumn::cLongColumn) return Integers[row];
+	return GetValues<long>()[row];
+}
+
+
+//______________________________________________________________________________
+unsigned long ccdb::TypedColumn::GetULong(size_t row) const
+{
+	if(Type == ConstantsTypeColumn::cULongColumn) return static_cast<unsigned long>(Integers[row]);
+	return GetValues<unsigned long>()[row];
+}
+
+
+//______________________________________________________________________________
+bool ccdb::TypedColumn::GetBool(size_t row) const
+{
+	if(Type == ConstantsTypeColumn::cBoolColumn) return Bools[row] != 0;
+
+	//bools are parsed into chars, as Bools are kept
+	const vector<char>& values = Convert(*this, mConversions->Mutex, mConversions->Bools, mConversions->IsBoolsReady,
+	                                     ConstantsTypeColumn::cBoolColumn, Bools, &ParseBoolChar);
+	return values[row] != 0;
+}
+
+
+//______________________________________________________________________________
+size_t ccdb::TypedColumn::GetConvertedMemoryUsage() const
+{
+	std::lock_guard<std::mutex> lock(mConversions->Mutex);
+	return mConversions->Doubles.capacity() * sizeof(double) + mConversions->Ints.capacity() * sizeof(int) +
+	       mConversions->UInts.capacity() * sizeof(unsigned int) + mConversions->Longs.capacity() * sizeof(long) +
+	       mConversions->ULongs.capacity() * sizeof(unsigned long) + mConversions->Bools.capacity();
+}
@@ -117,6 +117,16 @@ void MySQLCalibration::Disconnect()
     }
 
     mProvider->Disconnect();
+    if(mPool) mPool->Disconnect();
+}
+
+
+//______________________________________________________________________________
+DataProvider* MySQLCalibration::CreateProvider()
+{
+    /** @brief Creates not connected provider for the connection pool. @see Calibration::SetPoolSize */
+
+    return new MySQLDataProvider();
 }
 
 
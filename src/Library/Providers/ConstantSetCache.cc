@@ -0,0 +1,162 @@
+#include "CCDB/Providers/ConstantSetCache.h"
+#include "CCDB/Model/Assignment.h"
+
+using namespace std;
+
+namespace ccdb
+{
+
+//______________________________________________________________________________
+ConstantSetCache::ConstantSetCache():
+    mPutsSinceSweep(0)
+{
+    mStats.Sets = 0;
+    mStats.Hits = 0;
+    mStats.Misses = 0;
+}
+
+
+//______________________________________________________________________________
+string ConstantSetCache::GetTypesKey(const ConstantsTypeTable* table)
+{
+    if(!table) return string();
+
+    //without loaded columns all cells are kept as strings
+    string key = to_string(table->GetColumnsCount());
+    const vector<ConstantsTypeColumn *>& columns = table->GetColumns();
+    if(static_cast<int>(columns.size()) != table->GetColumnsCount()) return key;
+
+    key += ':';
+    for(size_t i = 0; i < columns.size(); i++) key += static_cast<char>('a' + columns[i]->GetType());
+    return key;
+}
+
+
+//______________________________________________________________________________
+size_t ConstantSetCache::GetHash(const string& vault, const string& types)
+{
+    size_t hash = std::hash<string>()(vault);
+    return hash ^ (std::hash<string>()(types) + 0x9e3779b9u + (hash << 6) + (hash >> 2));
+}
+
+
+//______________________________________________________________________________
+uint64_t ConstantSetCache::GetCheck(const string& vault)
+{
+    if(!Assignment::IsCompressedBlob(vault)) return 0;
+
+    uint64_t check = 14695981039346656037ull;
+    for(size_t i = 0; i < vault.size(); i++)
+    {
+        check ^= static_cast<unsigned char>(vault[i]);
+        check *= 1099511628211ull;
+    }
+    return check;
+}
+
+
+//______________________________________________________________________________
+bool ConstantSetCache::IsEntryOf(const Entry& entry, const DataPtr& data, const string& vault, const string& types)
+{
+    if(!data || entry.Types != types || entry.VaultSize != vault.size()) return false;
+
+    //the data keeps the decompressed blob of a compressed vault
+    return Assignment::IsCompressedBlob(vault) ? entry.VaultCheck == GetCheck(vault) : data->GetRawData() == vault;
+}
+
+
+//______________________________________________________________________________
+ConstantSetCache::DataPtr ConstantSetCache::Get(const string& vault, const ConstantsTypeTable* table)
+{
+    /** @brief Gets parsed data of the vault
+     *
+     * @return the data or empty pointer if the vault is not parsed yet or its data is released
+     */
+
+    string types = GetTypesKey(table);
+    size_t hash = GetHash(vault, types);
+
+    lock_guard<mutex> lock(mMutex);
+    unordered_map<size_t, Entry>::iterator iter = mEntries.find(hash);
+    if(iter != mEntries.end())
+    {
+        DataPtr data = iter->second.Data.lock();
+        if(IsEntryOf(iter->second, data, vault, types))
+        {
+            mStats.Hits++;
+            return data;
+        }
+    }
+
+    mStats.Misses++;
+    return DataPtr();
+}
+
+
+//______________________________________________________________________________
+ConstantSetCache::DataPtr ConstantSetCache::Put(const string& vault, const ConstantsTypeTable* table, const DataPtr& data)
+{
+    /** @brief Puts parsed data of the vault to the cache
+     *
+     * @return the cached data for the vault
+     */
+
+    string types = GetTypesKey(table);
+    size_t hash = GetHash(vault, types);
+
+    lock_guard<mutex> lock(mMutex);
+    Entry& entry = mEntries[hash];
+
+    //another thread could parse the same vault meanwhile
+    DataPtr cached = entry.Data.lock();
+    if(IsEntryOf(entry, cached, vault, types)) return cached;
+
+    //an entry with released data or (very rarely) another vault with the same hash is replaced
+    entry.Data = data;
+    entry.Types = types;
+    entry.VaultSize = vault.size();
+    entry.VaultCheck = GetCheck(vault);
+
+    SweepReleased();
+    return data;
+}
+
+
+//______________________________________________________________________________
+void ConstantSetCache::SweepReleased()
+{
+    //amortized: a sweep over all entries is done once per as many puts as there are entries
+    if(++mPutsSinceSweep < mEntries.size()) return;
+    mPutsSinceSweep = 0;
+
+    for(unordered_map<size_t, Entry>::iterator iter = mEntries.begin(); iter != mEntries.end();)
+    {
+        if(iter->second.Data.expired()) iter = mEntries.erase(iter);
+        else ++iter;
+    }
+}
+
+
+//______________________________________________________________________________
+void ConstantSetCache::Clear()
+{
+    lock_guard<mutex> lock(mMutex);
+    mEntries.clear();
+    mPutsSinceSweep = 0;
+}
+
+
+//______________________________________________________________________________
+ConstantSetCacheStats ConstantSetCache::GetStats()
+{
+    lock_guard<mutex> lock(mMutex);
+    ConstantSetCacheStats stats = mStats;
+    stats.Sets = 0;
+    for(unordered_map<size_t, Entry>::const_iterator iter = mEntries.begin(); iter != mEntries.end(); ++iter)
+    {
+        if(!iter->second.Data.expired()) stats.Sets++;
+    }
+    return stats;
+}
+
+}
@@ -24,6 +24,8 @@ DataProvider::DataProvider(void):
     mLogUserName = mAuthentication->GetLogin();
 	ClearErrorsOnFunctionStart();
     mConnectionString="";
+    mTypeTableCache.reset(new TypeTableCache());
+    mConstantSetCache.reset(new ConstantSetCache());
 }
 
 
@@ -70,6 +72,40 @@ void DataProvider::SetObjectLoaded( StoredObject* obj )
 }
 
 
+//______________________________________________________________________________
+string DataProvider::DecompressVault(string vault, const string& module)
+{
+	if(!Assignment::IsCompressedBlob(vault)) return vault;
+
+	string blob;
+	if(!Assignment::DecompressBlob(vault, blob))
+	{
+		Error(CCDB_ERROR_VAULT_DECOMPRESS, module, "Compressed data vault is damaged and can't be decompressed");
+	}
+	return blob;
+}
+
+
+//______________________________________________________________________________
+void DataProvider::SetAssignmentData(Assignment* assignment, string vault, const string& module)
+{
+	ConstantsTypeTable* table = assignment->GetTypeTable();
+	std::shared_ptr<AssignmentData> data = mConstantSetCache->Get(vault, table);
+	if(!data)
+	{
+		string blob = DecompressVault(vault, module);
+		bool isDamaged = blob.empty() && !vault.empty();
+
+		data = std::make_shared<AssignmentData>();
+		data->SetRawData(blob);
+
+		//a damaged vault is reported on each read, so it is not cached
+		if(!isDamaged) data = mConstantSetCache->Put(vault, table, data);
+	}
+	assignment->SetSharedData(data);
+}
+
+
 //----------------------------------------------------------------------------------------
 //	C O N N E C T I O N
 //----------------------------------------------------------------------------------------
@@ -273,6 +309,29 @@ ConstantsTypeTable * DataProvider::GetConstantsTypeTable(const string& path, boo
 	return GetConstantsTypeTable(name, dir, loadColumns);
 }
 
+
+//______________________________________________________________________________
+std::shared_ptr<ConstantsTypeTable> DataProvider::GetSharedTypeTable(const string& path, bool loadColumns/*=false*/)
+{
+	/** @brief Gets type table by full path from the metadata cache or loads it once
+     *
+     * @param  [in] path absolute path of the type table
+     * @param  [in] loadColumns the table is needed with columns
+     * @return shared table or empty pointer if the table is not found
+     */
+
+	string fullPath = path;
+	PathUtils::MakeAbsolute(fullPath);
+
+	std::shared_ptr<ConstantsTypeTable> table = mTypeTableCache->Get(fullPath, loadColumns);
+	if(table) return table;
+
+	ConstantsTypeTable* loaded = GetConstantsTypeTable(fullPath, loadColumns);
+	if(!loaded) return table;
+
+	return mTypeTableCache->Put(fullPath, loaded, loadColumns);
+}
+
 #pragma endregion Type tables
 
 //----------------------------------------------------------------------------------------
@@ -302,6 +361,60 @@ bool DataProvider::GetVariations(vector<Variation*>& resultVariations, const str
 }
 
 
+//______________________________________________________________________________
+const vector<Variation *>& DataProvider::GetVariationChain(Variation* variation)
+{
+    /** @brief Gets the variation and all its ancestors
+     *
+     * @param  [in] variation variation returned by GetVariation
+     * @return chain[0] is the variation itself, chain[1] is its parent and so on
+     */
+
+    map<dbkey_t, vector<Variation *> >::iterator iter = mVariationChains.find(variation->GetId());
+    if(iter != mVariationChains.end() && !iter->second.empty() && iter->second[0] == variation) return iter->second;
+
+    //the variation was not loaded by LinkVariations, walk its parents
+    vector<Variation *>& chain = mVariationChains[variation->GetId()];
+    chain.clear();
+    for(Variation* var = variation; var && chain.size() <= mVariationsById.size(); var = var->GetParent())
+    {
+        chain.push_back(var);
+    }
+    return chain;
+}
+
+
+//______________________________________________________________________________
+void DataProvider::LinkVariations()
+{
+    /** @brief Links loaded variations by parent ids and builds mVariationsByName and mVariationChains
+     */
+
+    mVariationsByName.clear();
+    mVariationChains.clear();
+
+    map<dbkey_t, Variation *>::iterator iter;
+    for(iter = mVariationsById.begin(); iter != mVariationsById.end(); ++iter)
+    {
+        Variation* variation = iter->second;
+        mVariationsByName[variation->GetName()] = variation;
+
+        map<dbkey_t, Variation *>::iterator parent = mVariationsById.find(variation->GetParentDbId());
+        variation->SetParent((variation->GetParentDbId() != 0 && parent != mVariationsById.end()) ? parent->second : NULL);
+    }
+
+    //a broken database could have a loop of parents, a chain can't be longer than all variations
+    for(iter = mVariationsById.begin(); iter != mVariationsById.end(); ++iter)
+    {
+        vector<Variation *>& chain = mVariationChains[iter->first];
+        for(Variation* var = iter->second; var && chain.size() < mVariationsById.size(); var = var->GetParent())
+        {
+            chain.push_back(var);
+        }
+    }
+}
+
+
 
 
 //----------------------------------------------------------------------------------------
@@ -354,6 +467,83 @@ Assignment* DataProvider::GetAssignmentFull( int run, const string& path,int ver
 	return *assigments.begin();
 }
 
+
+//______________________________________________________________________________
+bool DataProvider::GetAssignmentRunInterval(Assignment* assignment, const string& /*variation*/, time_t /*time*/, int& runMin, int& runMax)
+{
+	/** @brief Gets the interval of runs for which the request resolves to the same assignment
+	 *
+	 * The default implementation gives [run, run] which is always correct
+	 */
+
+	runMin = runMax = assignment->GetRequestedRun();
+	return true;
+}
+
+
+//______________________________________________________________________________
+bool DataProvider::GetMissingRunInterval(const string& /*path*/, int run, const string& /*variation*/, time_t /*time*/, int& runMin, int& runMax)
+{
+	/** @brief Gets the interval of runs for which the request has no assignment
+	 *
+	 * The default implementation can't tell a missing assignment from an error and returns false
+	 */
+
+	runMin = runMax = run;
+	return false;
+}
+
+
+//______________________________________________________________________________
+bool DataProvider::GetChangeMark(ChangeMark& mark)
+{
+	/** @brief Gets the current state of assignments to find out if the database is changed
+	 *
+	 * The default implementation doesn't support change detection and returns false
+	 */
+
+	mark = ChangeMark();
+	return false;
+}
+
+
+//______________________________________________________________________________
+bool DataProvider::GetChangedTables(vector<string>& paths, const ChangeMark& /*since*/)
+{
+	/** @brief Gets tables whose assignments are added or modified after the mark was taken
+	 *
+	 * The default implementation can't tell changed tables and returns false
+	 */
+
+	paths.clear();
+	return false;
+}
+
+
+//______________________________________________________________________________
+bool DataProvider::GetAssignmentsShort(vector<Assignment*>& assignments, vector<pair<int, int> >& runIntervals, int run, const vector<string>& paths,
+                                       time_t time /*=0*/, const string& variation /*="default"*/, bool loadColumns /*=false*/)
+{
+	/** @brief Gets assignments of many tables for the same run, variation and time at once
+	 *
+	 * The default implementation calls GetAssignmentShort and GetAssignmentRunInterval for each path
+	 */
+
+	assignments.assign(paths.size(), NULL);
+	runIntervals.assign(paths.size(), make_pair(run, run));
+
+	for(size_t i = 0; i < paths.size(); i++)
+	{
+		Assignment* assignment = (time > 0) ? GetAssignmentShort(run, paths[i], time, variation, loadColumns)
+		                                    : GetAssignmentShort(run, paths[i], variation, loadColumns);
+		if(!assignment) continue;
+
+		GetAssignmentRunInterval(assignment, variation, time, runIntervals[i].first, runIntervals[i].second);
+		assignments[i] = assignment;
+	}
+	return true;
+}
+
 //______________________________________________________________________________
 
 #pragma endregion Assignments
@@ -0,0 +1,397 @@
+#include "CCDB/Providers/DataProviderPool.h"
+#include "CCDB/Helpers/TimeProvider.h"
+
+using namespace std;
+
+namespace ccdb
+{
+
+namespace
+{
+    time_t Now()
+    {
+        return TimeProvider::GetUnixTimeStamp(ClockSources::Monotonic);
+    }
+
+    void DeleteProviders(vector<DataProvider*>& providers)
+    {
+        //providers disconnect in destructors
+        for(size_t i = 0; i < providers.size(); i++) delete providers[i];
+        providers.clear();
+    }
+}
+
+
+//______________________________________________________________________________
+DataProviderPool::DataProviderPool(Factory factory, size_t maxSize):
+    mFactory(factory),
+    mMaxSize(maxSize ? maxSize : 1),
+    mHealthCheckInterval(60),
+    mGeneration(0)
+{
+    mStats.Connections = 0;
+    mStats.Idle = 0;
+    mStats.Checkouts = 0;
+    mStats.Created = 0;
+    mStats.Waits = 0;
+    mStats.Reaped = 0;
+    mStats.HealthCheckFailures = 0;
+}
+
+
+//______________________________________________________________________________
+DataProviderPool::~DataProviderPool()
+{
+    for(size_t i = 0; i < mConnections.size(); i++) delete mConnections[i].Provider;
+}
+
+
+//______________________________________________________________________________
+void DataProviderPool::Connect(const string& connectionString)
+{
+    /** @brief Sets connection string for the pool connections. Connections are opened lazily */
+
+    vector<DataProvider*> removed;
+    {
+        lock_guard<mutex> lock(mMutex);
+        if(connectionString == mConnectionString) return;
+
+        mConnectionString = connectionString;
+        mGeneration++;
+        RemoveStaleIdle(removed);
+    }
+    mReleased.notify_all();
+    DeleteProviders(removed);
+}
+
+
+//______________________________________________________________________________
+void DataProviderPool::Disconnect()
+{
+    /** @brief Closes idle connections. Connections in use are closed when released */
+
+    vector<DataProvider*> removed;
+    {
+        lock_guard<mutex> lock(mMutex);
+        mConnectionString.clear();
+        mGeneration++;
+        RemoveStaleIdle(removed);
+    }
+    mReleased.notify_all();
+    DeleteProviders(removed);
+}
+
+
+//______________________________________________________________________________
+string DataProviderPool::GetConnectionString()
+{
+    lock_guard<mutex> lock(mMutex);
+    return mConnectionString;
+}
+
+
+//______________________________________________________________________________
+DataProvider* DataProviderPool::Checkout()
+{
+    /** @brief Takes a connected provider for the calling thread
+     *
+     * The thread which already holds a provider gets it again. Otherwise an idle provider
+     * is taken, the one this thread used last is preferred. If there are no idle providers
+     * a new connection is opened or, if the pool is full, the thread waits for a release
+     *
+     * @return provider or NULL if connection failed
+     */
+
+    thread::id self = this_thread::get_id();
+    unique_lock<mutex> lock(mMutex);
+
+    //re-entrant checkout
+    for(size_t i = 0; i < mConnections.size(); i++)
+    {
+        if(mConnections[i].Owner == self && mConnections[i].Provider)
+        {
+            mConnections[i].Depth++;
+            return mConnections[i].Provider;
+        }
+    }
+
+    bool waited = false;
+    while(true)
+    {
+        if(mConnectionString.empty()) return NULL;
+
+        //idle connection. The one used by this thread last time, then the most recently used
+        int best = -1;
+        for(size_t i = 0; i < mConnections.size(); i++)
+        {
+            const Connection& connection = mConnections[i];
+            if(!connection.Provider || connection.Depth) continue;
+            if(best >= 0)
+            {
+                const Connection& bestConnection = mConnections[best];
+                bool isOwn = connection.LastOwner == self;
+                bool isBestOwn = bestConnection.LastOwner == self;
+                if(isBestOwn && !isOwn) continue;
+                if(isBestOwn == isOwn && connection.LastUse <= bestConnection.LastUse) continue;
+            }
+            best = (int)i;
+        }
+
+        if(best >= 0)
+        {
+            Connection& connection = mConnections[best];
+            connection.Owner = self;
+            connection.Depth = 1;
+            mStats.Checkouts++;
+
+            DataProvider* provider = connection.Provider;
+            if(Now() - connection.LastUse < mHealthCheckInterval) return provider;
+
+            //check the connection outside the lock, it may take time
+            string connectionString = mConnectionString;
+            lock.unlock();
+            bool failed = false;
+            bool isHealthy = CheckHealth(provider, connectionString, failed);
+            lock.lock();
+
+            if(failed) mStats.HealthCheckFailures++;
+            if(isHealthy) return provider;
+
+            DataProvider* removed = RemoveConnection(FindConnection(provider));
+            lock.unlock();
+            mReleased.notify_one();
+            delete removed;
+            return NULL;
+        }
+
+        //lazy growth. The slot is reserved and the connection is opened outside the lock
+        if(mConnections.size() < mMaxSize)
+        {
+            Connection connection;
+            connection.Provider = NULL;
+            connection.Owner = self;
+            connection.Depth = 1;
+            connection.LastUse = Now();
+            connection.Generation = mGeneration;
+            mConnections.push_back(connection);
+
+            string connectionString = mConnectionString;
+            lock.unlock();
+            DataProvider* provider = OpenProvider(connectionString);
+            lock.lock();
+
+            for(size_t i = 0; i < mConnections.size(); i++)
+            {
+                if(mConnections[i].Provider || mConnections[i].Owner != self) continue;
+
+                if(provider)
+                {
+                    mConnections[i].Provider = provider;
+                    mStats.Created++;
+                    mStats.Checkouts++;
+                }
+                else
+                {
+                    mConnections.erase(mConnections.begin() + i);
+                    lock.unlock();
+                    mReleased.notify_one();
+                }
+                break;
+            }
+            return provider;
+        }
+
+        //the pool is full
+        if(!waited) mStats.Waits++;
+        waited = true;
+        mReleased.wait(lock);
+    }
+}
+
+
+//______________________________________________________________________________
+void DataProviderPool::Release(DataProvider* provider)
+{
+    /** @brief Gives the provider back to the pool
+     *
+     * The provider is closed if the pool was disconnected or connected to another source
+     * while the provider was in use, or if the pool was shrunk
+     */
+
+    DataProvider* removed = NULL;
+    {
+        lock_guard<mutex> lock(mMutex);
+        int index = FindConnection(provider);
+        if(index < 0) return;
+
+        Connection& connection = mConnections[index];
+        if(--connection.Depth > 0) return;
+
+        connection.Owner = thread::id();
+        connection.LastOwner = this_thread::get_id();
+        connection.LastUse = Now();
+
+        if(connection.Generation != mGeneration || mConnections.size() > mMaxSize)
+        {
+            removed = RemoveConnection(index);
+        }
+    }
+    mReleased.notify_one();
+    delete removed;
+}
+
+
+//______________________________________________________________________________
+size_t DataProviderPool::ReapIdle(time_t maxIdleTime)
+{
+    /** @brief Closes connections that are idle longer than maxIdleTime seconds
+     * @return number of closed connections
+     */
+
+    vector<DataProvider*> removed;
+    {
+        lock_guard<mutex> lock(mMutex);
+        time_t now = Now();
+        for(size_t i = mConnections.size(); i-- > 0; )
+        {
+            const Connection& connection = mConnections[i];
+            if(!connection.Provider || connection.Depth) continue;
+            if(now - connection.LastUse > maxIdleTime) removed.push_back(RemoveConnection(i));
+        }
+        mStats.Reaped += removed.size();
+    }
+
+    size_t count = removed.size();
+    if(count) mReleased.notify_all();
+    DeleteProviders(removed);
+    return count;
+}
+
+
+//______________________________________________________________________________
+void DataProviderPool::SetMaxSize(size_t maxSize)
+{
+    vector<DataProvider*> removed;
+    {
+        lock_guard<mutex> lock(mMutex);
+        mMaxSize = maxSize ? maxSize : 1;
+        RemoveStaleIdle(removed);
+    }
+    mReleased.notify_all();
+    DeleteProviders(removed);
+}
+
+
+//______________________________________________________________________________
+size_t DataProviderPool::GetMaxSize()
+{
+    lock_guard<mutex> lock(mMutex);
+    return mMaxSize;
+}
+
+
+//______________________________________________________________________________
+void DataProviderPool::SetHealthCheckInterval(time_t seconds)
+{
+    lock_guard<mutex> lock(mMutex);
+    mHealthCheckInterval = seconds;
+}
+
+
+//______________________________________________________________________________
+time_t DataProviderPool::GetHealthCheckInterval()
+{
+    lock_guard<mutex> lock(mMutex);
+    return mHealthCheckInterval;
+}
+
+
+//______________________________________________________________________________
+DataProviderPoolStats DataProviderPool::GetStats()
+{
+    lock_guard<mutex> lock(mMutex);
+    DataProviderPoolStats stats = mStats;
+    stats.Connections = 0;
+    stats.Idle = 0;
+    for(size_t i = 0; i < mConnections.size(); i++)
+    {
+        if(!mConnections[i].Provider) continue;
+        stats.Connections++;
+        if(!mConnections[i].Depth) stats.Idle++;
+    }
+    return stats;
+}
+
+
+//______________________________________________________________________________
+DataProvider* DataProviderPool::OpenProvider(const string& connectionString)
+{
+    // Creates and connects a provider. Is called without the lock,
+    // so several threads open their connections at once
+
+    DataProvider* provider = mFactory();
+    if(!provider) return NULL;
+
+    if(!provider->Connect(connectionString))
+    {
+        delete provider;
+        return NULL;
+    }
+    return provider;
+}
+
+
+//______________________________________________________________________________
+bool DataProviderPool::CheckHealth(DataProvider* provider, const string& connectionString, bool& failed)
+{
+    // Pings the provider and reconnects it if the check fails. Is called without the lock
+
+    failed = !provider->Ping();
+    if(!failed) return true;
+
+    provider->Disconnect();
+    return provider->Connect(connectionString);
+}
+
+
+//______________________________________________________________________________
+void DataProviderPool::RemoveStaleIdle(vector<DataProvider*>& removed)
+{
+    // Removes idle slots which belong to the old connection string or don't fit the pool size
+    // mMutex must be locked by caller
+
+    for(size_t i = mConnections.size(); i-- > 0; )
+    {
+        const Connection& connection = mConnections[i];
+        if(!connection.Provider || connection.Depth) continue;
+        if(connection.Generation != mGeneration || mConnections.size() > mMaxSize)
+        {
+            removed.push_back(RemoveConnection(i));
+        }
+    }
+}
+
+
+//______________________________________________________________________________
+DataProvider* DataProviderPool::RemoveConnection(size_t index)
+{
+    // Removes the slot. The provider should be deleted by caller outside the lock
+    // mMutex must be locked by caller
+
+    DataProvider* provider = mConnections[index].Provider;
+    mConnections.erase(mConnections.begin() + index);
+    return provider;
+}
+
+
+//______________________________________________________________________________
+int DataProviderPool::FindConnection(DataProvider* provider) const
+{
+    for(size_t i = 0; i < mConnections.size(); i++)
+    {
+        if(mConnections[i].Provider == provider) return (int)i;
+    }
+    return -1;
+}
+
+}
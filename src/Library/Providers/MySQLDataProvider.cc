@@ -5,6 +5,7 @@
 #include <time.h>
 #include <string.h>
 #include <limits.h>
+#include <algorithm>
 
 #include "CCDB/Globals.h"
 #include "CCDB/Log.h"
@@ -22,6 +23,98 @@
 
 using namespace ccdb;
 
+//The latest assignment of the type table for the run among variations of a chain (GetAssignmentShort)
+//parameters: run, run, type table id, CCDB_VARIATION_CHAIN_QUERY_DEPTH variation ids from the requested one to its ancestors,
+//the same ids again for ORDER BY and time. The assignment of the nearest variation wins, of them the latest one
+static string AssignmentShortQuery(bool byTime)
+{
+	ostringstream variationIds;
+	for(int i = 0; i < CCDB_VARIATION_CHAIN_QUERY_DEPTH; i++) variationIds << (i ? ", ?" : "?");
+
+	ostringstream query;
+	query << "SELECT `assignments`.`id` AS `asId`, "
+	         "`constantSets`.`vault` AS `blob`, "
+	         "`runRanges`.`id` AS `rrId`, "
+	         "`runRanges`.`runMin` AS `rrMin`, "
+	         "`runRanges`.`runMax` AS `rrMax`, "
+	         "`assignments`.`variationId` AS `varId` "
+	         "FROM  `assignments` "
+	         "INNER JOIN `runRanges` ON `assignments`.`runRangeId`= `runRanges`.`id` "
+	         "INNER JOIN `constantSets` ON `assignments`.`constantSetId` = `constantSets`.`id` "
+	         "WHERE  `runRanges`.`runMin` <= ? "
+	         "AND `runRanges`.`runMax` >= ? "
+	         "AND `constantSets`.`constantTypeId` = ? "
+	         "AND `assignments`.`variationId` IN (" << variationIds.str() << ") ";
+	if(byTime) query << "AND UNIX_TIMESTAMP(`assignments`.`created`) <= ? ";
+	query << "ORDER BY FIELD(`assignments`.`variationId`, " << variationIds.str() << "), `assignments`.`id` DESC LIMIT 1 ";
+	return query.str();
+}
+
+static const string kAssignmentShortQuery = AssignmentShortQuery(false);
+static const string kAssignmentShortByTimeQuery = AssignmentShortQuery(true);
+
+//Assignments that would win over the found one if they had its run (GetAssignmentRunInterval):
+//newer ones of the same variation and any of the child variations.
+//parameters: run 4 times, type table id, run range of the found assignment, its variation id, its id,
+//CCDB_VARIATION_CHAIN_QUERY_DEPTH child variation ids and time
+static string AssignmentRunIntervalQuery(bool byTime)
+{
+	ostringstream variationIds;
+	for(int i = 0; i < CCDB_VARIATION_CHAIN_QUERY_DEPTH; i++) variationIds << (i ? ", ?" : "?");
+
+	ostringstream query;
+	query << "SELECT MAX(CASE WHEN `runRanges`.`runMax` < ? THEN `runRanges`.`runMax` END), "
+	         "MIN(CASE WHEN `runRanges`.`runMin` > ? THEN `runRanges`.`runMin` END), "
+	         "COUNT(CASE WHEN `runRanges`.`runMin` <= ? AND `runRanges`.`runMax` >= ? THEN 1 END) "
+	         "FROM  `assignments` "
+	         "INNER JOIN `runRanges` ON `assignments`.`runRangeId`= `runRanges`.`id` "
+	         "INNER JOIN `constantSets` ON `assignments`.`constantSetId` = `constantSets`.`id` "
+	         "WHERE `constantSets`.`constantTypeId` = ? "
+	         "AND `runRanges`.`runMax` >= ? "
+	         "AND `runRanges`.`runMin` <= ? "
+	         "AND ((`assignments`.`variationId` = ? AND `assignments`.`id` > ?) "
+	         "OR `assignments`.`variationId` IN (" << variationIds.str() << ")) ";
+	if(byTime) query << "AND UNIX_TIMESTAMP(`assignments`.`created`) <= ? ";
+	return query.str();
+}
+
+static const string kAssignmentRunIntervalQuery = AssignmentRunIntervalQuery(false);
+static const string kAssignmentRunIntervalByTimeQuery = AssignmentRunIntervalQuery(true);
+
+//The table (NULL id if it doesn't exist) and the nearest assignments of a variation chain from the left and right
+//of the run (GetMissingRunInterval). Assignments that cover the run are counted to be sure that there is really nothing.
+//parameters: run 4 times, CCDB_VARIATION_CHAIN_QUERY_DEPTH variation ids, time, table name and directory id
+static string MissingRunIntervalQuery(bool byTime)
+{
+	ostringstream variationIds;
+	for(int i = 0; i < CCDB_VARIATION_CHAIN_QUERY_DEPTH; i++) variationIds << (i ? ", ?" : "?");
+
+	ostringstream query;
+	query << "SELECT MAX(`typeTables`.`id`), "
+	         "MAX(CASE WHEN `runRanges`.`runMax` < ? THEN `runRanges`.`runMax` END), "
+	         "MIN(CASE WHEN `runRanges`.`runMin` > ? THEN `runRanges`.`runMin` END), "
+	         "COUNT(CASE WHEN `runRanges`.`runMin` <= ? AND `runRanges`.`runMax` >= ? THEN 1 END) "
+	         "FROM `typeTables` "
+	         "LEFT JOIN `constantSets` ON `constantSets`.`constantTypeId` = `typeTables`.`id` "
+	         "LEFT JOIN `assignments` ON `assignments`.`constantSetId` = `constantSets`.`id` "
+	         "AND `assignments`.`variationId` IN (" << variationIds.str() << ") ";
+	if(byTime) query << "AND UNIX_TIMESTAMP(`assignments`.`created`) <= ? ";
+	query << "LEFT JOIN `runRanges` ON `runRanges`.`id` = `assignments`.`runRangeId` "
+	         "WHERE `typeTables`.`name` = ? AND `typeTables`.`directoryId` = ?";
+	return query.str();
+}
+
+static const string kMissingRunIntervalQuery = MissingRunIntervalQuery(false);
+static const string kMissingRunIntervalByTimeQuery = MissingRunIntervalQuery(true);
+
+static const char kTypeTableQuery[] =
+        "SELECT `id`, UNIX_TIMESTAMP(`created`) as `created`, UNIX_TIMESTAMP(`modified`) as `modified`, `name`, `directoryId`, `nRows`, `nColumns`, `comment` "
+        "FROM `typeTables` WHERE `name` = ? AND `directoryId` = ?";
+
+static const char kColumnsQuery[] =
+        "SELECT `id`, UNIX_TIMESTAMP(`created`) as `created`, UNIX_TIMESTAMP(`modified`) as `modified`, `name`, `columnType`, `comment` "
+        "FROM `columns` WHERE `typeId` = ? ORDER BY `order`";
+
 
 #pragma region constructors
 
@@ -34,7 +127,7 @@ ccdb::MySQLDataProvider::MySQLDataProvider(void)
 	mDirsAreLoaded = false;
 	mLastFullQuerry="";
 	mLastShortQuerry="";
-    mLastVariation = NULL; 
+    mVariationsAreLoaded = false;
     
 }
 
@@ -69,6 +162,9 @@ bool ccdb::MySQLDataProvider::Connect( std::string connectionString )
 		return false;
 	}
 						
+	//tables of another database are not valid anymore
+	if(!mConnectionString.empty() && mConnectionString != connectionString) mTypeTableCache.reset(new TypeTableCache());
+
 	//try to connect
     bool result = Connect(connection);
     if(result) mConnectionString = connectionString;
@@ -116,6 +212,7 @@ bool ccdb::MySQLDataProvider::Connect(MySQLConnectionInfo connection)
 		mMySQLHnd=NULL;		//some compilers dont set NULL after delete
 		return false;
 	}
+	mVariationsAreLoaded = false;
 	mIsConnected = true;
 	return true;
 }
@@ -205,12 +302,28 @@ bool ccdb::MySQLDataProvider::IsConnected()
 }
 
 
+bool ccdb::MySQLDataProvider::Ping()
+{
+	return IsConnected() && mysql_ping(mMySQLHnd) == 0;
+}
+
+
 void ccdb::MySQLDataProvider::Disconnect()
 {
 	if(IsConnected())
 	{
 		FreeMySQLResult();	//it would free the result or do nothing
-		
+
+		//prepared statements belong to the connection
+		mTypeTableStatement.Close();
+		mColumnsStatement.Close();
+		mAssignmentShortStatement.Close();
+		mAssignmentShortByTimeStatement.Close();
+		mAssignmentRunIntervalStatement.Close();
+		mAssignmentRunIntervalByTimeStatement.Close();
+		mMissingRunIntervalStatement.Close();
+		mMissingRunIntervalByTimeStatement.Close();
+
 		mysql_close(mMySQLHnd);
 		mMySQLHnd = NULL;
 		mIsConnected = false;
@@ -415,34 +528,32 @@ ConstantsTypeTable * ccdb::MySQLDataProvider::GetConstantsTypeTable( const strin
 		return NULL;
 	}
 	
-	string query = StringUtils::Format("SELECT `id`, UNIX_TIMESTAMP(`created`) as `created`, UNIX_TIMESTAMP(`modified`) as `modified`, `name`, `directoryId`, `nRows`, `nColumns`, `comment` FROM `typeTables` WHERE `name` = '%s' AND `directoryId` = '%i';",
-		 /*`name`*/ name.c_str(),
-		 /*`directoryId`*/ parentDir->GetId());
+	MySQLStatement& statement = mTypeTableStatement;
+	if(!PrepareStatement(statement, kTypeTableQuery, "MySQLDataProvider::GetConstantsTypeTable")) return NULL;
 
-	if(!QuerySelect(query))
-	{
-		//TODO: report error
-		return NULL;
-	}
+	statement.SetString(0, name);					/*`name`*/
+	statement.SetInt(1, parentDir->GetId());		/*`directoryId`*/
+	if(!ExecuteStatement(statement, "MySQLDataProvider::GetConstantsTypeTable")) return NULL;
 
-	
 	//Ok! We querryed our directories! lets catch them! 
-	if(!FetchRow())
+	if(!statement.Fetch())
 	{
 		//TODO error not selected
+		statement.FreeResult();
 		return NULL;
 	}
 
 	//ok lets read the data...
 	ConstantsTypeTable *result = new ConstantsTypeTable(this, this);
-	result->SetId(ReadULong(0));
-	result->SetCreatedTime(ReadUnixTime(1));
-	result->SetModifiedTime(ReadUnixTime(2));
-	result->SetName(ReadString(3));
-	result->SetDirectoryId(ReadULong(4));
-	result->SetNRows(ReadInt(5));
-	result->SetNColumnsFromDB(ReadInt(6));
-	result->SetComment(ReadString(7));
+	result->SetId((dbkey_t)statement.GetInt(0));
+	result->SetCreatedTime((time_t)statement.GetInt(1));
+	result->SetModifiedTime((time_t)statement.GetInt(2));
+	result->SetName(statement.GetString(3));
+	result->SetDirectoryId((dbkey_t)statement.GetInt(4));
+	result->SetNRows((int)statement.GetInt(5));
+	result->SetNColumnsFromDB((int)statement.GetInt(6));
+	result->SetComment(statement.GetString(7));
+	statement.FreeResult();
 	
 	SetObjectLoaded(result); //set object flags that it was just loaded from DB
 	
@@ -460,9 +571,6 @@ ConstantsTypeTable * ccdb::MySQLDataProvider::GetConstantsTypeTable( const strin
 	//Ok set a full path for this constant...
 	result->SetFullPath(PathUtils::CombinePath(parentDir->GetFullPath(), result->GetName()));
 
-	
-	FreeMySQLResult();
-	
 	//load columns if needed
 	if(loadColumns) LoadColumns(result);
         
@@ -680,27 +788,25 @@ bool ccdb::MySQLDataProvider::LoadColumns( ConstantsTypeTable* table )
 		return false;
 	}
 		
-	string query = StringUtils::Format("SELECT `id`, UNIX_TIMESTAMP(`created`) as `created`, UNIX_TIMESTAMP(`modified`) as `modified`, `name`, `columnType`, `comment` FROM `columns` WHERE `typeId` = '%i' ORDER BY `order`;",
-		/*`directoryId`*/ table->GetId());
+	MySQLStatement& statement = mColumnsStatement;
+	if(!PrepareStatement(statement, kColumnsQuery, "MySQLDataProvider::LoadColumns")) return false;
 
-	if(!QuerySelect(query))
-	{
-		return false;
-	}
+	statement.SetInt(0, table->GetId());	/*`typeId`*/
+	if(!ExecuteStatement(statement, "MySQLDataProvider::LoadColumns")) return false;
 
 	//clear(); //we clear the consts. Considering that some one else should handle deletion
 
 	//Ok! We querried our directories! lets catch them! 
-	while(FetchRow())
+	while(statement.Fetch())
 	{
 		//ok lets read the data...
 		ConstantsTypeColumn *result = new ConstantsTypeColumn(table, this);
-		result->SetId(ReadULong(0));				
-		result->SetCreatedTime(ReadUnixTime(1));
-		result->SetModifiedTime(ReadUnixTime(2));
-		result->SetName(ReadString(3));
-		result->SetType(ReadString(4));
-		result->SetComment(ReadString(5));
+		result->SetId((dbkey_t)statement.GetInt(0));
+		result->SetCreatedTime((time_t)statement.GetInt(1));
+		result->SetModifiedTime((time_t)statement.GetInt(2));
+		result->SetName(statement.GetString(3));
+		result->SetType(statement.GetString(4));
+		result->SetComment(statement.GetString(5));
 		result->SetDBTypeTableId(table->GetId());
 
 		SetObjectLoaded(result); //set object flags that it was just loaded from DB
@@ -708,7 +814,7 @@ bool ccdb::MySQLDataProvider::LoadColumns( ConstantsTypeTable* table )
 		table->AddColumn(result);
 	}
 
-	FreeMySQLResult();
+	statement.FreeResult();
 
 	return true;
 }
@@ -992,79 +1098,84 @@ vector<Variation *> ccdb::MySQLDataProvider::GetVariations( ConstantsTypeTable *
 
 Variation* ccdb::MySQLDataProvider::GetVariation( const string& name )
 {
+	/** @brief Gets variation by name
+	 *
+	 * The whole variations table is loaded at the first call, later variations are taken from memory.
+	 * If the name is not found, the table is reloaded once as the variation could be added meanwhile
+	 *
+	 * @param    [in] variation name
+	 * @return   variation or NULL if variation with this name is not found
+	 */
 	ClearErrors(); //Clear error in function that can produce new ones
-    if(mLastVariation!=NULL && mLastVariation->GetName()==name) return mLastVariation;
 
-    return SelectVariation("`name`= \"" + name + "\"");
+	bool justLoaded = !mVariationsAreLoaded;
+	if(justLoaded && !LoadVariations()) return NULL;
+
+	map<string, Variation *>::iterator iter = mVariationsByName.find(name);
+	if(iter == mVariationsByName.end() && !justLoaded)
+	{
+		if(!LoadVariations()) return NULL;
+		iter = mVariationsByName.find(name);
+	}
+
+	return iter == mVariationsByName.end() ? NULL : iter->second;
 }
 
-/** @brief Load variation by name
+/** @brief Load variation by id
 * 
-* @param     const char * name
+* @param     int id
 * @return   DVariation*
 */
 Variation* ccdb::MySQLDataProvider::GetVariationById(int id)
 {
-    if(mVariationsById.find(id) != mVariationsById.end()) return mVariationsById[id];
-    
     ClearErrors(); //Clear error in function that can produce new ones
-    return SelectVariation("`id`= " + StringUtils::IntToString(id) + "");
+
+    if(!mVariationsAreLoaded && !LoadVariations()) return NULL;
+
+    map<dbkey_t, Variation *>::iterator iter = mVariationsById.find(id);
+    return iter == mVariationsById.end() ? NULL : iter->second;
 }
 
 /**
-* Get variation by database request
+* Loads the whole variations table by one query. Already loaded variation objects are updated,
+* so pointers that were given out stay valid. Parents and ancestor chains are linked by LinkVariations
 */
-Variation* ccdb::MySQLDataProvider::SelectVariation(const string& whereClause)
+bool ccdb::MySQLDataProvider::LoadVariations()
 {
-    //TODO: Implement method
     string query = "SELECT `id`, UNIX_TIMESTAMP(`created`) as `created`, UNIX_TIMESTAMP(`modified`) as `modified`, `name`, `description`, `comment`, `parentId`"
-        " FROM `variations` WHERE "+whereClause+";";
+        " FROM `variations`;";
 
     //query this
     if(!QuerySelect(query))
     {
         //TODO report error
-        return NULL;
-    }
-
-    //Ok! We queried our run range! lets catch it! 
-    if(!FetchRow())
-    {
-        //nothing was selected
-        return NULL;
+        return false;
     }
 
-    //ok lets read the data...
-    Variation *result = new Variation(this, this);
-    result->SetId(ReadULong(0));
-    result->SetCreatedTime(ReadUnixTime(1));
-    result->SetModifiedTime(ReadUnixTime(2));
-    result->SetName(ReadString(3));
-    result->SetDescription(ReadString(4));
-    result->SetComment(ReadString(5));
-    result->SetParentDbId(ReadULong(6));
-
-    if(mReturnedRowsNum>1)
+    map<dbkey_t, Variation *> loaded;
+    while(FetchRow())
     {
-        //TODO warning not uniq row
+        dbkey_t id = ReadIndex(0);
+        map<dbkey_t, Variation *>::iterator iter = mVariationsById.find(id);
+        Variation *variation = (iter != mVariationsById.end()) ? iter->second : new Variation(this, this);
+        variation->SetId(id);
+        variation->SetCreatedTime(ReadUnixTime(1));
+        variation->SetModifiedTime(ReadUnixTime(2));
+        variation->SetName(ReadString(3));
+        variation->SetDescription(ReadString(4));
+        variation->SetComment(ReadString(5));
+        variation->SetParentDbId(ReadULong(6));
+        loaded[id] = variation;
     }
-
-    result->SetOwner(this, true);
-
-    mVariationsById[result->GetId()] = result;
-    mLastVariation = result;
     FreeMySQLResult();
 
-    //Get parent recursively
-    if(result->GetParentDbId()!=0)
-    {
-        result->SetParent(GetVariationById(result->GetParentDbId()));
-    }
-
-    return result;
+    //variations that were deleted from the database are still owned by the provider
+    mVariationsById.swap(loaded);
+    LinkVariations();
+    mVariationsAreLoaded = true;
+    return true;
 }
 
-
 #pragma endregion Variations
 
 //----------------------------------------------------------------------------------------
@@ -1108,7 +1219,8 @@ Assignment* ccdb::MySQLDataProvider::GetAssignmentShort(int run, const string& p
 	        
     //Get directory. Directories should be cached. So this doesn't make a database request
     
-    ConstantsTypeTable *table = GetConstantsTypeTable(path, loadColumns);
+    //Type table is taken from the metadata cache, it is shared by all assignments of the table
+    std::shared_ptr<ConstantsTypeTable> table = GetSharedTypeTable(path, loadColumns);
     if(!table)
     {
         Error(CCDB_ERROR_NO_TYPETABLE, "MySQLDataProvider::GetAssignmentShort", "Type table was not found: '"+path+"'" );
@@ -1126,50 +1238,47 @@ Assignment* ccdb::MySQLDataProvider::GetAssignmentShort(int run, const string& p
         return NULL;
     }
 
-    //run number to string
-    string runStr = StringUtils::IntToString(run);
+	//the whole variation chain is resolved by one statement. Longer chains than the statement takes are split
+	const vector<Variation *>& chain = GetVariationChain(variation);
+	MySQLStatement& statement = (time>0) ? mAssignmentShortByTimeStatement : mAssignmentShortStatement;
+	size_t first = 0;
+	while(true)
+	{
+		//the prepared query with or without time
+		if(!PrepareStatement(statement, (time>0) ? kAssignmentShortByTimeQuery.c_str() : kAssignmentShortQuery.c_str(), "MySQLDataProvider::GetAssignmentShort"))
+		{
+			return NULL;
+		}
 
-	//ok now we must build our mighty query...
-	string query=
-        "SELECT `assignments`.`id` AS `asId`, "
-        "`constantSets`.`vault` AS `blob` "
-        "FROM  `assignments` "
-        "INNER JOIN `runRanges` ON `assignments`.`runRangeId`= `runRanges`.`id` "
-        "INNER JOIN `constantSets` ON `assignments`.`constantSetId` = `constantSets`.`id` "
-        "INNER JOIN `typeTables` ON `constantSets`.`constantTypeId` = `typeTables`.`id` "
-        "WHERE  `runRanges`.`runMin` <= '"+runStr+"' "
-        "AND `runRanges`.`runMax` >= '"+runStr+"' "
-        "AND `assignments`.`variationId`= '"+StringUtils::IntToString(variation->GetId())+"' "
-        "AND `constantSets`.`constantTypeId` ='"+StringUtils::IntToString(table->GetId())+"' ";
-    
-    //time in querY?
-    if(time>0)
-    {
-        char timeBuf[32];
-        sprintf(timeBuf,"%lu",time);
-        query=query + "AND UNIX_TIMESTAMP(`assignments`.`created`) <= '"+string(timeBuf)+"' ";
-    }
+		statement.SetInt(0, run);						/*`runMin`*/
+		statement.SetInt(1, run);						/*`runMax`*/
+		statement.SetInt(2, table->GetId());			/*`constantTypeId`*/
 
-    //finish query 
-    query = query + "ORDER BY `assignments`.`id` DESC LIMIT 1 ";
-	
-	//query this
-	if(!QuerySelect(query))
-	{
-		//TODO report error
-		return NULL;
-	}
+		//variation ids for IN and for ORDER BY. Unused places of a short chain repeat its last variation
+		for(int i = 0; i < CCDB_VARIATION_CHAIN_QUERY_DEPTH; i++)
+		{
+			dbkey_t variationId = chain[std::min(first + i, chain.size() - 1)]->GetId();
+			statement.SetInt(3 + i, variationId);
+			statement.SetInt(3 + CCDB_VARIATION_CHAIN_QUERY_DEPTH + i, variationId);
+		}
+		if(time>0) statement.SetInt(3 + 2*CCDB_VARIATION_CHAIN_QUERY_DEPTH, time);		/*`created`*/
 
-    //If We have not found data for this variation, getting data for parent variation
-    if(mReturnedRowsNum==0 && variation->GetParentDbId()!=0)
-    {
-        delete table;
-		return GetAssignmentShort(run, path, time, variation->GetParent()->GetName(), loadColumns);
-    }
+		//query this
+		if(!ExecuteStatement(statement, "MySQLDataProvider::GetAssignmentShort"))
+		{
+			return NULL;
+		}
+
+		//the rest of a long chain
+		first += CCDB_VARIATION_CHAIN_QUERY_DEPTH;
+		if(statement.GetRowsCount()!=0 || first >= chain.size()) break;
+		statement.FreeResult();
+	}
 
 	//Ok! We queried our run range! lets catch it! 
-	if(!FetchRow())
+	if(!statement.Fetch())
 	{
+		statement.FreeResult();
 		Error(CCDB_ERROR_NO_ASSIGMENT,"MySQLDataProvider::GetAssignmentShort(int, const string&, time_t, const string&)", 
             StringUtils::Format("No data was selected. Table '%s' for run='%i', timestampt='%lu' and variation='%s' ", path.c_str(), run, time, variationName.c_str()));
 		return NULL;
@@ -1177,28 +1286,278 @@ Assignment* ccdb::MySQLDataProvider::GetAssignmentShort(int run, const string& p
 
 	//ok lets read the data...
 	Assignment *result = new Assignment(this, this);
-	result->SetId( ReadIndex(0) );
-	result->SetRawData( ReadString(1) );
+	result->SetId( (dbkey_t)statement.GetInt(0) );
+	result->SetTypeTable(table);
+	SetAssignmentData(result, statement.GetString(1), "MySQLDataProvider::GetAssignmentShort");
 	
 	//additional fill
 	result->SetRequestedRun(run);
-	result->SetVariationId(variation->GetId());
-	
-    //type table
-    result->SetTypeTable(table);
-    result->BeOwner(table);
-    table->SetOwner(result);
+	result->SetVariationId((dbkey_t)statement.GetInt(5));
+	result->SetRunRangeId((dbkey_t)statement.GetInt(2));
 
-	if(mReturnedRowsNum>1)
+	RunRange * runRange = new RunRange(result, this);
+	runRange->SetId((dbkey_t)statement.GetInt(2));
+	runRange->SetRange((int)statement.GetInt(3), (int)statement.GetInt(4));
+	result->SetRunRange(runRange);
+	statement.FreeResult();
+
+	return result;
+
+}
+
+bool ccdb::MySQLDataProvider::GetAssignmentRunInterval(Assignment* assignment, const string& variationName, time_t time, int& runMin, int& runMax)
+{
+    /** @brief Gets the interval of runs for which the request resolves to the same assignment
+     *
+     * @see DataProvider::GetAssignmentRunInterval
+     * @param [in]  assignment - assignment returned by GetAssignmentShort
+     * @param [in]  variation  - variation name that was requested
+     * @param [in]  time       - time that was requested, 0 if no time was requested
+     * @param [out] runMin     - first run of the interval
+     * @param [out] runMax     - last run of the interval
+     * @return true if the interval was found
+     */
+
+	ClearErrors(); //Clear error in function that can produce new ones
+
+	int run = assignment->GetRequestedRun();
+	runMin = runMax = run;
+
+	if(!CheckConnection("MySQLDataProvider::GetAssignmentRunInterval")) return false;
+
+	RunRange *runRange = assignment->GetRunRange();
+	if(!runRange || !assignment->GetTypeTable()) return false;
+
+	//variations that are checked before the variation the assignment belongs to
+	vector<dbkey_t> childVariationIds;
+	Variation* variation = GetVariation(variationName);
+	while(variation && variation->GetId() != static_cast<unsigned int>(assignment->GetVariationId()))
 	{
-		//TODO warning not uniq row
+		childVariationIds.push_back(variation->GetId());
+		variation = variation->GetParent();
 	}
+	if(!variation) return false;
 
-	FreeMySQLResult();
-	return result;
+	//The nearest of the winning assignments from the left and right are the interval edges.
+	//Child variations are bound by the statement size, more of them are split
+	MySQLStatement& statement = (time>0) ? mAssignmentRunIntervalByTimeStatement : mAssignmentRunIntervalStatement;
+	bool hasLeft = false, hasRight = false;
+	int left = 0, right = 0;
+	for(size_t first = 0; first == 0 || first < childVariationIds.size(); first += CCDB_VARIATION_CHAIN_QUERY_DEPTH)
+	{
+		if(!PrepareStatement(statement, (time>0) ? kAssignmentRunIntervalByTimeQuery.c_str() : kAssignmentRunIntervalQuery.c_str(), "MySQLDataProvider::GetAssignmentRunInterval"))
+		{
+			return false;
+		}
+
+		for(int i = 0; i < 4; i++) statement.SetInt(i, run);
+		statement.SetInt(4, assignment->GetTypeTable()->GetId());		/*`constantTypeId`*/
+		statement.SetInt(5, runRange->GetMin());						/*`runMax`*/
+		statement.SetInt(6, runRange->GetMax());						/*`runMin`*/
+		statement.SetInt(7, assignment->GetVariationId());				/*`variationId`*/
+		statement.SetInt(8, assignment->GetId());						/*`id`*/
+
+		//unused places are 0, no variation has such id
+		for(int i = 0; i < CCDB_VARIATION_CHAIN_QUERY_DEPTH; i++)
+		{
+			statement.SetInt(9 + i, first + i < childVariationIds.size() ? childVariationIds[first + i] : 0);
+		}
+		if(time>0) statement.SetInt(9 + CCDB_VARIATION_CHAIN_QUERY_DEPTH, time);		/*`created`*/
+
+		if(!ExecuteStatement(statement, "MySQLDataProvider::GetAssignmentRunInterval")) return false;
+
+		if(!statement.Fetch())
+		{
+			statement.FreeResult();
+			return false;
+		}
+
+		//something covers the run itself. Shouldn't happen, but be safe and give [run, run]
+		if(statement.GetInt(2) != 0)
+		{
+			statement.FreeResult();
+			return true;
+		}
+
+		if(!statement.IsNull(0) && (!hasLeft || (int)statement.GetInt(0) > left)) { left = (int)statement.GetInt(0); hasLeft = true; }
+		if(!statement.IsNull(1) && (!hasRight || (int)statement.GetInt(1) < right)) { right = (int)statement.GetInt(1); hasRight = true; }
+		statement.FreeResult();
+	}
+
+	runMin = hasLeft ? left + 1 : runRange->GetMin();
+	runMax = hasRight ? right - 1 : runRange->GetMax();
+	return true;
+}
+
+
+bool ccdb::MySQLDataProvider::GetMissingRunInterval(const string& path, int run, const string& variationName, time_t time, int& runMin, int& runMax)
+{
+    /** @brief Gets the interval of runs for which the request has no assignment
+     *
+     * @see DataProvider::GetMissingRunInterval
+     * @param [in]  path       - absolute path of the type table
+     * @param [in]  run        - run number that was requested
+     * @param [in]  variation  - variation name that was requested
+     * @param [in]  time       - time that was requested, 0 if no time was requested
+     * @param [out] runMin     - first run of the interval
+     * @param [out] runMax     - last run of the interval
+     * @return true if there is no assignment for the run
+     */
+
+	ClearErrors(); //Clear error in function that can produce new ones
+
+	runMin = runMax = run;
+	if(!CheckConnection("MySQLDataProvider::GetMissingRunInterval")) return false;
+
+	//no directory or no variation - nothing for all runs. Unless they were not loaded because of an error
+	Directory *dir = GetDirectory(PathUtils::ExtractDirectory(path));
+	Variation* variation = GetVariation(variationName);
+	if(!mDirsAreLoaded || !mVariationsAreLoaded) return false;
+	if(dir == NULL || dir->GetId()<=0 || variation == NULL)
+	{
+		runMin = std::min(run, 0);
+		runMax = INFINITE_RUN;
+		return true;
+	}
+
+	//Variations of the chain are bound by the statement size, longer chains are split
+	const vector<Variation *>& chain = GetVariationChain(variation);
+	MySQLStatement& statement = (time>0) ? mMissingRunIntervalByTimeStatement : mMissingRunIntervalStatement;
+	string name = PathUtils::ExtractObjectname(path);
+	bool hasLeft = false, hasRight = false;
+	int left = 0, right = 0;
+	for(size_t first = 0; first < chain.size(); first += CCDB_VARIATION_CHAIN_QUERY_DEPTH)
+	{
+		if(!PrepareStatement(statement, (time>0) ? kMissingRunIntervalByTimeQuery.c_str() : kMissingRunIntervalQuery.c_str(), "MySQLDataProvider::GetMissingRunInterval"))
+		{
+			return false;
+		}
+
+		for(int i = 0; i < 4; i++) statement.SetInt(i, run);
+
+		//unused places of a short chain repeat its last variation
+		for(int i = 0; i < CCDB_VARIATION_CHAIN_QUERY_DEPTH; i++)
+		{
+			statement.SetInt(4 + i, chain[std::min(first + i, chain.size() - 1)]->GetId());
+		}
+		int index = 4 + CCDB_VARIATION_CHAIN_QUERY_DEPTH;
+		if(time>0) statement.SetInt(index++, time);				/*`created`*/
+		statement.SetString(index++, name);						/*`name`*/
+		statement.SetInt(index, dir->GetId());					/*`directoryId`*/
+
+		if(!ExecuteStatement(statement, "MySQLDataProvider::GetMissingRunInterval")) return false;
+
+		if(!statement.Fetch())
+		{
+			statement.FreeResult();
+			return false;
+		}
+
+		if(statement.IsNull(0))
+		{
+			//no such table
+			statement.FreeResult();
+			runMin = std::min(run, 0);
+			runMax = INFINITE_RUN;
+			return true;
+		}
+
+		if(statement.GetInt(3) != 0)
+		{
+			//something covers the run, it was probably added after the request
+			statement.FreeResult();
+			return false;
+		}
+
+		if(!statement.IsNull(1) && (!hasLeft || (int)statement.GetInt(1) > left)) { left = (int)statement.GetInt(1); hasLeft = true; }
+		if(!statement.IsNull(2) && (!hasRight || (int)statement.GetInt(2) < right)) { right = (int)statement.GetInt(2); hasRight = true; }
+		statement.FreeResult();
+	}
+
+	runMin = hasLeft ? left + 1 : std::min(run, 0);
+	runMax = hasRight ? right - 1 : INFINITE_RUN;
+	return true;
+}
+
+
+bool ccdb::MySQLDataProvider::GetChangeMark(ChangeMark& mark)
+{
+    /** @brief Gets the current state of assignments to find out if the database is changed
+     *
+     * @see DataProvider::GetChangeMark
+     * @param [out] mark - the state of assignments
+     * @return false if error happened
+     */
+
+	ClearErrors(); //Clear error in function that can produce new ones
+
+	mark = ChangeMark();
+	if(!CheckConnection("MySQLDataProvider::GetChangeMark")) return false;
+
+	MySQLStatement statement;
+	if(!PrepareStatement(statement, "SELECT MAX(`id`), MAX(`modified`) FROM `assignments`", "MySQLDataProvider::GetChangeMark")) return false;
+	if(!ExecuteStatement(statement, "MySQLDataProvider::GetChangeMark")) return false;
+
+	if(!statement.Fetch())
+	{
+		statement.FreeResult();
+		return false;
+	}
+
+	if(!statement.IsNull(0)) mark.MaxAssignmentId = (dbkey_t)statement.GetInt(0);
+	if(!statement.IsNull(1)) mark.LastModified = statement.GetString(1);
+	statement.FreeResult();
+	return true;
+}
+
+
+bool ccdb::MySQLDataProvider::GetChangedTables(vector<string>& paths, const ChangeMark& since)
+{
+    /** @brief Gets tables whose assignments are added or modified after the mark was taken
+     *
+     * @see DataProvider::GetChangedTables
+     * @param [out] paths - absolute paths of the changed tables
+     * @param [in]  since - mark taken by GetChangeMark before the changes
+     * @return false if the changed tables can't be told or error happened
+     */
+
+	ClearErrors(); //Clear error in function that can produce new ones
 
+	paths.clear();
+	if(!CheckConnection("MySQLDataProvider::GetChangedTables")) return false;
+	if(!UpdateDirectoriesIfNeeded()) return false;
+
+	//modification time has seconds only, so assignments modified in the same second as the mark are taken too
+	string query =
+		"SELECT DISTINCT `typeTables`.`directoryId`, `typeTables`.`name` FROM `assignments` "
+		"INNER JOIN `constantSets` ON `constantSets`.`id` = `assignments`.`constantSetId` "
+		"INNER JOIN `typeTables` ON `typeTables`.`id` = `constantSets`.`constantTypeId` "
+		"WHERE `assignments`.`id` > ?";
+	if(!since.LastModified.empty()) query += " OR `assignments`.`modified` >= ?";
+
+	MySQLStatement statement;
+	if(!PrepareStatement(statement, query.c_str(), "MySQLDataProvider::GetChangedTables")) return false;
+	statement.SetInt(0, since.MaxAssignmentId);								/*`id`*/
+	if(!since.LastModified.empty()) statement.SetString(1, since.LastModified);	/*`modified`*/
+	if(!ExecuteStatement(statement, "MySQLDataProvider::GetChangedTables")) return false;
+
+	bool isKnown = true;
+	while(statement.Fetch())
+	{
+		//a table of a directory that is not loaded yet can't be named
+		map<dbkey_t, Directory *>::iterator dir = mDirectoriesById.find((dbkey_t)statement.GetInt(0));
+		if(dir == mDirectoriesById.end())
+		{
+			isKnown = false;
+			continue;
+		}
+		paths.push_back(PathUtils::CombinePath(dir->second->GetFullPath(), statement.GetString(1)));
+	}
+	statement.FreeResult();
+	return isKnown;
 }
 
+
 Assignment* ccdb::MySQLDataProvider::GetAssignmentFull( int run, const string& path, const string& variation )
 {
 	if(!CheckConnection("MySQLDataProvider::GetAssignmentFull(int run, cconst string& path, const string& variation")) return NULL;
@@ -1470,7 +1829,8 @@ void ccdb::MySQLDataProvider::FetchAssignment(Assignment* assignment, ConstantsT
 	assignment->SetModifiedTime(ReadUnixTime(2));	/*02  " UNIX_TIMESTAMP(`assignments`.`modified`) as `asModified`,	"*/
 	assignment->SetComment(ReadString(3));			/*03  " `assignments`.`comment) as `asComment`,	"					 */
 	assignment->SetDataVaultId(ReadIndex(4));		/*04  " `constantSets`.`id` AS `constId`, "							 */
-	assignment->SetRawData(ReadString(5));			/*05  " `constantSets`.`vault` AS `blob`, "							 */
+	assignment->SetTypeTable(table);				/*   the data is parsed by column types */
+	SetAssignmentData(assignment, ReadString(5), "MySQLDataProvider::FetchAssignment");	/*05  " `constantSets`.`vault` AS `blob`, "							 */
 	
 	RunRange * runRange = new RunRange(assignment, this);	
 	runRange->SetId(ReadIndex(6));					/*06  " `runRanges`.`id`   AS `rrId`, "	*/
@@ -1491,7 +1851,6 @@ void ccdb::MySQLDataProvider::FetchAssignment(Assignment* assignment, ConstantsT
 	//compose objects
 	assignment->SetRunRange(runRange);
 	assignment->SetVariation(variation);
-	assignment->SetTypeTable(table);
 	if(IsOwner(table)) table->SetOwner(assignment);
 }
 
@@ -1572,42 +1931,52 @@ int ccdb::MySQLDataProvider::ReadInt( int fieldNum )
 {	
 	if(IsNullOrUnreadable(fieldNum)) return 0;
 
-	return atoi(mRow[fieldNum]); //ugly isn't it?
+	int value;
+	StringUtils::ParseInt(mRow[fieldNum], mRow[fieldNum] + strlen(mRow[fieldNum]), value);
+	return value;
 }
 
 unsigned int ccdb::MySQLDataProvider::ReadUInt( int fieldNum )
 {	
 	if(IsNullOrUnreadable(fieldNum)) return 0;
 
-	return static_cast<unsigned int>(atoi(mRow[fieldNum])); //ugly isn't it?
+	unsigned int value;
+	StringUtils::ParseUInt(mRow[fieldNum], mRow[fieldNum] + strlen(mRow[fieldNum]), value);
+	return value;
 }
 
 long ccdb::MySQLDataProvider::ReadLong( int fieldNum )
 {
 	if(IsNullOrUnreadable(fieldNum)) return 0;
 
-	return atol(mRow[fieldNum]); //ugly isn't it?
+	long value;
+	StringUtils::ParseLong(mRow[fieldNum], mRow[fieldNum] + strlen(mRow[fieldNum]), value);
+	return value;
 }
 
 unsigned long ccdb::MySQLDataProvider::ReadULong( int fieldNum )
 {
 	if(IsNullOrUnreadable(fieldNum)) return 0;
 
-	return static_cast<unsigned long>(atol(mRow[fieldNum])); //ugly isn't it?
+	unsigned long value;
+	StringUtils::ParseULong(mRow[fieldNum], mRow[fieldNum] + strlen(mRow[fieldNum]), value);
+	return value;
 }
 
 dbkey_t ccdb::MySQLDataProvider::ReadIndex( int fieldNum )
 {
 	if(IsNullOrUnreadable(fieldNum)) return 0;
 
-	return static_cast<dbkey_t>(atol(mRow[fieldNum])); //ugly isn't it?
+	return static_cast<dbkey_t>(ReadLong(fieldNum));
 }
 
 bool ccdb::MySQLDataProvider::ReadBool( int fieldNum )
 {
 	if(IsNullOrUnreadable(fieldNum)) return false;
 
-	return static_cast<bool>(atoi(mRow[fieldNum])!=0); //ugly isn't it?
+	bool value;
+	StringUtils::ParseBool(mRow[fieldNum], mRow[fieldNum] + strlen(mRow[fieldNum]), value);
+	return value;
 
 }
 
@@ -1615,7 +1984,9 @@ double ccdb::MySQLDataProvider::ReadDouble( int fieldNum )
 {
 	if(IsNullOrUnreadable(fieldNum)) return 0;
 
-	return atof(mRow[fieldNum]); //ugly isn't it?
+	double value;
+	StringUtils::ParseDouble(mRow[fieldNum], mRow[fieldNum] + strlen(mRow[fieldNum]), value);
+	return value;
 }
 
 std::string ccdb::MySQLDataProvider::ReadString( int fieldNum )
@@ -1721,6 +2092,38 @@ void ccdb::MySQLDataProvider::FreeMySQLResult()
 	mResult = NULL;
 }
 
+bool ccdb::MySQLDataProvider::PrepareStatement(MySQLStatement& statement, const char* query, const char* functionName)
+{
+	/** @brief Prepares the statement on the server if it is not prepared yet
+	 *
+	 * @param [in] statement    - one of the statements of the provider
+	 * @param [in] query        - SQL query with '?' placeholders
+	 * @param [in] functionName - function name for errors
+	 * @return true if the statement is ready to be executed
+	 */
+
+	if(statement.IsPrepared()) return true;
+
+	if(!statement.Prepare(mMySQLHnd, query))
+	{
+		Error(CCDB_ERROR_QUERY_SELECT, functionName, statement.GetError());
+		return false;
+	}
+	return true;
+}
+
+bool ccdb::MySQLDataProvider::ExecuteStatement(MySQLStatement& statement, const char* functionName)
+{
+	/** @brief Executes the prepared statement and reports the error if any */
+
+	if(!statement.Execute())
+	{
+		Error(CCDB_ERROR_QUERY_SELECT, functionName, statement.GetError());
+		return false;
+	}
+	return true;
+}
+
 std::string ccdb::MySQLDataProvider::ComposeMySQLError(std::string mySqlFunctionName)
 {
 	string mysqlErr=StringUtils::Format("%s failed:\nError %u (%s)\n",mySqlFunctionName.c_str(), mysql_errno(mMySQLHnd), mysql_error (mMySQLHnd));
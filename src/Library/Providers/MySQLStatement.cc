@@ -0,0 +1,296 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "CCDB/Providers/MySQLStatement.h"
+#include "CCDB/Helpers/StringUtils.h"
+
+using namespace ccdb;
+
+//initial size of a buffer for a string or blob column. It grows if longer values come
+#define CCDB_MYSQL_STATEMENT_BUFFER_SIZE 256
+
+//______________________________________________________________________________
+ccdb::MySQLStatement::MySQLStatement():
+	mStatement(NULL),
+	mHasResult(false)
+{
+}
+
+
+//______________________________________________________________________________
+ccdb::MySQLStatement::~MySQLStatement()
+{
+	Close();
+}
+
+
+//______________________________________________________________________________
+bool ccdb::MySQLStatement::Prepare(MYSQL* mysql, const char* query)
+{
+	/** @brief Prepares the query on the server
+	 *
+	 * Parameters and result columns are bound here once. Integer columns are bound to
+	 * long long values, other columns to buffers that are reused by all executions
+	 *
+	 * @param [in] mysql - connection
+	 * @param [in] query - SQL query with '?' placeholders
+	 * @return true if the statement was prepared
+	 */
+
+	Close();
+	mError.clear();
+
+	mStatement = mysql_stmt_init(mysql);
+	if(!mStatement)
+	{
+		mError = "mysql_stmt_init() failed, out of memory";
+		return false;
+	}
+
+	if(mysql_stmt_prepare(mStatement, query, strlen(query)))
+	{
+		SetError("mysql_stmt_prepare()");
+		mError.append("\n Query: ").append(query);
+		Close();
+		return false;
+	}
+
+	//parameters
+	unsigned long paramsCount = mysql_stmt_param_count(mStatement);
+	mParameters.assign(paramsCount, Parameter());
+	mParameterBinds.assign(paramsCount, MYSQL_BIND());
+	for(unsigned long i = 0; i < paramsCount; i++)
+	{
+		memset(&mParameterBinds[i], 0, sizeof(MYSQL_BIND));
+		mParameters[i].Int = 0;
+		mParameters[i].Length = 0;
+		mParameterBinds[i].buffer_type = MYSQL_TYPE_LONGLONG;
+		mParameterBinds[i].buffer = &mParameters[i].Int;
+	}
+
+	//result columns
+	MYSQL_RES* metadata = mysql_stmt_result_metadata(mStatement);
+	unsigned int columnsCount = metadata ? mysql_num_fields(metadata) : 0;
+	MYSQL_FIELD* fields = metadata ? mysql_fetch_fields(metadata) : NULL;
+
+	mColumns.assign(columnsCount, Column());
+	mColumnBinds.assign(columnsCount, MYSQL_BIND());
+	for(unsigned int i = 0; i < columnsCount; i++)
+	{
+		Column& column = mColumns[i];
+		MYSQL_BIND& bind = mColumnBinds[i];
+		memset(&bind, 0, sizeof(MYSQL_BIND));
+
+		column.IsInteger = fields[i].type == MYSQL_TYPE_TINY ||
+		                   fields[i].type == MYSQL_TYPE_SHORT ||
+		                   fields[i].type == MYSQL_TYPE_INT24 ||
+		                   fields[i].type == MYSQL_TYPE_LONG ||
+		                   fields[i].type == MYSQL_TYPE_LONGLONG;
+		column.Int = 0;
+		column.Length = 0;
+		column.IsNull = 0;
+		column.Error = 0;
+
+		if(column.IsInteger)
+		{
+			bind.buffer_type = MYSQL_TYPE_LONGLONG;
+			bind.buffer = &column.Int;
+		}
+		else
+		{
+			column.Buffer.resize(CCDB_MYSQL_STATEMENT_BUFFER_SIZE);
+			bind.buffer_type = MYSQL_TYPE_STRING;
+			bind.buffer = &column.Buffer[0];
+			bind.buffer_length = column.Buffer.size();
+		}
+		bind.length = &column.Length;
+		bind.is_null = &column.IsNull;
+		bind.error = &column.Error;
+	}
+	if(metadata) mysql_free_result(metadata);
+
+	if(columnsCount && mysql_stmt_bind_result(mStatement, &mColumnBinds[0]))
+	{
+		SetError("mysql_stmt_bind_result()");
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+
+//______________________________________________________________________________
+void ccdb::MySQLStatement::Close()
+{
+	/** @brief Closes the statement on the server and frees buffers */
+
+	if(!mStatement) return;
+
+	FreeResult();
+	mysql_stmt_close(mStatement);
+	mStatement = NULL;
+	mParameters.clear();
+	mParameterBinds.clear();
+	mColumns.clear();
+	mColumnBinds.clear();
+}
+
+
+//______________________________________________________________________________
+void ccdb::MySQLStatement::SetInt(int index, long long value)
+{
+	/** @brief Sets integer parameter */
+
+	mParameters[index].Int = value;
+	MYSQL_BIND& bind = mParameterBinds[index];
+	bind.buffer_type = MYSQL_TYPE_LONGLONG;
+	bind.buffer = &mParameters[index].Int;
+	bind.buffer_length = 0;
+	bind.length = NULL;
+}
+
+
+//______________________________________________________________________________
+void ccdb::MySQLStatement::SetString(int index, const string& value)
+{
+	/** @brief Sets string parameter */
+
+	Parameter& parameter = mParameters[index];
+	parameter.String = value;
+	parameter.Length = parameter.String.size();
+
+	MYSQL_BIND& bind = mParameterBinds[index];
+	bind.buffer_type = MYSQL_TYPE_STRING;
+	bind.buffer = (void*)parameter.String.data();
+	bind.buffer_length = parameter.Length;
+	bind.length = &parameter.Length;
+}
+
+
+//______________________________________________________________________________
+bool ccdb::MySQLStatement::Execute()
+{
+	/** @brief Executes the statement with the set parameters and stores the result on the client
+	 * @return true if success
+	 */
+
+	if(!mStatement)
+	{
+		mError = "The statement is not prepared";
+		return false;
+	}
+
+	FreeResult();
+
+	if(!mParameterBinds.empty() && mysql_stmt_bind_param(mStatement, &mParameterBinds[0])) return SetError("mysql_stmt_bind_param()");
+	if(mysql_stmt_execute(mStatement)) return SetError("mysql_stmt_execute()");
+	if(mysql_stmt_store_result(mStatement)) return SetError("mysql_stmt_store_result()");
+
+	mHasResult = true;
+	return true;
+}
+
+
+//______________________________________________________________________________
+unsigned long long ccdb::MySQLStatement::GetRowsCount()
+{
+	/** @brief Number of rows selected by the last Execute */
+
+	return mHasResult ? mysql_stmt_num_rows(mStatement) : 0;
+}
+
+
+//______________________________________________________________________________
+bool ccdb::MySQLStatement::Fetch()
+{
+	/** @brief Fetches the next row of the result
+	 *
+	 * If a string or blob doesn't fit its buffer, the buffer grows and
+	 * the column is fetched once more. The bigger buffer is kept for the next rows and executions
+	 *
+	 * @return true if row was read, false if no more rows or error
+	 */
+
+	if(!mHasResult) return false;
+
+	int result = mysql_stmt_fetch(mStatement);
+	if(result == MYSQL_NO_DATA) return false;
+	if(result == 1) return SetError("mysql_stmt_fetch()");
+
+	if(result == MYSQL_DATA_TRUNCATED)
+	{
+		bool rebind = false;
+		for(size_t i = 0; i < mColumns.size(); i++)
+		{
+			Column& column = mColumns[i];
+			if(column.IsInteger || column.IsNull || column.Length <= column.Buffer.size()) continue;
+
+			column.Buffer.resize(column.Length);
+			MYSQL_BIND& bind = mColumnBinds[i];
+			bind.buffer = &column.Buffer[0];
+			bind.buffer_length = column.Buffer.size();
+			if(mysql_stmt_fetch_column(mStatement, &bind, i, 0)) return SetError("mysql_stmt_fetch_column()");
+			rebind = true;
+		}
+
+		//the next rows will be fetched to the new buffers
+		if(rebind && mysql_stmt_bind_result(mStatement, &mColumnBinds[0])) return SetError("mysql_stmt_bind_result()");
+	}
+
+	return true;
+}
+
+
+//______________________________________________________________________________
+void ccdb::MySQLStatement::FreeResult()
+{
+	/** @brief Frees the result of the last Execute. The buffers are kept */
+
+	if(!mHasResult) return;
+	mysql_stmt_free_result(mStatement);
+	mHasResult = false;
+}
+
+
+//______________________________________________________________________________
+bool ccdb::MySQLStatement::IsNull(int column) const
+{
+	return column >= (int)mColumns.size() || mColumns[column].IsNull;
+}
+
+
+//______________________________________________________________________________
+long long ccdb::MySQLStatement::GetInt(int column) const
+{
+	if(IsNull(column)) return 0;
+
+	const Column& value = mColumns[column];
+	if(value.IsInteger) return value.Int;
+
+	//decimal or string value, like UNIX_TIMESTAMP of DATETIME
+	return atoll(string(&value.Buffer[0], value.Length).c_str());
+}
+
+
+//______________________________________________________________________________
+string ccdb::MySQLStatement::GetString(int column) const
+{
+	if(IsNull(column)) return string();
+
+	const Column& value = mColumns[column];
+	if(value.IsInteger) return StringUtils::Format("%lld", value.Int);
+	return string(&value.Buffer[0], value.Length);
+}
+
+
+//______________________________________________________________________________
+bool ccdb::MySQLStatement::SetError(const char* functionName)
+{
+	/** @brief Remembers error of the statement function
+	 * @return false, so it can be used as 'return SetError(...)'
+	 */
+
+	mError = StringUtils::Format("%s failed:\nError %u (%s)\n", functionName, mysql_stmt_errno(mStatement), mysql_stmt_error(mStatement));
+	return false;
+}
@@ -6,6 +6,7 @@
 #include <time.h>
 #include <string.h>
 #include <limits.h>
+#include <algorithm>
 
 
 #include "CCDB/Globals.h"
@@ -19,14 +20,107 @@
 
 using namespace ccdb;
 
+//The latest assignment of the type table for the run among variations of a chain (GetAssignmentShort)
+//?1 - run, ?2 - type table id, ?3... - CCDB_VARIATION_CHAIN_QUERY_DEPTH variation ids from the requested one to its ancestors,
+//the next parameter is time. The assignment of the nearest variation wins, of them the latest one
+static string AssignmentShortQuery(bool byTime)
+{
+	ostringstream variationIds;
+	ostringstream depthCases;
+	for(int i = 0; i < CCDB_VARIATION_CHAIN_QUERY_DEPTH; i++)
+	{
+		variationIds << (i ? ", ?" : "?") << i + 3;
+		depthCases << " WHEN ?" << i + 3 << " THEN " << i;
+	}
+
+	ostringstream query;
+	query << "SELECT `assignments`.`id` AS `asId`, "
+	         "`constantSets`.`vault` AS `blob`, "
+	         "`runRanges`.`id` AS `rrId`, "
+	         "`runRanges`.`runMin` AS `rrMin`, "
+	         "`runRanges`.`runMax` AS `rrMax`, "
+	         "`assignments`.`variationId` AS `varId` "
+	         "FROM  `assignments` "
+	         "INNER JOIN `runRanges` ON `assignments`.`runRangeId`= `runRanges`.`id` "
+	         "INNER JOIN `constantSets` ON `assignments`.`constantSetId` = `constantSets`.`id` "
+	         "WHERE  `runRanges`.`runMin` <= ?1 "
+	         "AND `runRanges`.`runMax` >= ?1 "
+	         "AND  `constantSets`.`constantTypeId` = ?2 "
+	         "AND `assignments`.`variationId` IN (" << variationIds.str() << ") ";
+	if(byTime) query << "AND  `assignments`.`created` <= datetime(?" << CCDB_VARIATION_CHAIN_QUERY_DEPTH + 3 << ", 'unixepoch', 'localtime') ";
+	query << "ORDER BY CASE `assignments`.`variationId`" << depthCases.str() << " END, `assignments`.`id` DESC "
+	         "LIMIT 1 ";
+	return query.str();
+}
+
+static const string kAssignmentShortQuery = AssignmentShortQuery(false);
+static const string kAssignmentShortByTimeQuery = AssignmentShortQuery(true);
+
+//Assignments that would win over the found one if they had its run (GetAssignmentRunInterval):
+//newer ones of the same variation and any of the child variations.
+//?1 - run, ?2 - type table id, ?3, ?4 - run range of the found assignment, ?5 - its variation id, ?6 - its id,
+//?7... - CCDB_VARIATION_CHAIN_QUERY_DEPTH child variation ids, the next parameter is time
+static string AssignmentRunIntervalQuery(bool byTime)
+{
+	ostringstream variationIds;
+	for(int i = 0; i < CCDB_VARIATION_CHAIN_QUERY_DEPTH; i++) variationIds << (i ? ", ?" : "?") << i + 7;
+
+	ostringstream query;
+	query << "SELECT MAX(CASE WHEN `runRanges`.`runMax` < ?1 THEN `runRanges`.`runMax` END), "
+	         "MIN(CASE WHEN `runRanges`.`runMin` > ?1 THEN `runRanges`.`runMin` END), "
+	         "COUNT(CASE WHEN `runRanges`.`runMin` <= ?1 AND `runRanges`.`runMax` >= ?1 THEN 1 END) "
+	         "FROM  `assignments` "
+	         "INNER JOIN `runRanges` ON `assignments`.`runRangeId`= `runRanges`.`id` "
+	         "INNER JOIN `constantSets` ON `assignments`.`constantSetId` = `constantSets`.`id` "
+	         "WHERE `constantSets`.`constantTypeId` = ?2 "
+	         "AND `runRanges`.`runMax` >= ?3 "
+	         "AND `runRanges`.`runMin` <= ?4 "
+	         "AND ((`assignments`.`variationId` = ?5 AND `assignments`.`id` > ?6) "
+	         "OR `assignments`.`variationId` IN (" << variationIds.str() << ")) ";
+	if(byTime) query << "AND  `assignments`.`created` <= datetime(?" << CCDB_VARIATION_CHAIN_QUERY_DEPTH + 7 << ", 'unixepoch', 'localtime') ";
+	return query.str();
+}
+
+static const string kAssignmentRunIntervalQuery = AssignmentRunIntervalQuery(false);
+static const string kAssignmentRunIntervalByTimeQuery = AssignmentRunIntervalQuery(true);
+
+//The table (NULL id if it doesn't exist) and the nearest assignments of a variation chain from the left and right
+//of the run (GetMissingRunInterval). Assignments that cover the run are counted to be sure that there is really nothing.
+//?1 - run, ?2 - table name, ?3 - directory id, ?4... - CCDB_VARIATION_CHAIN_QUERY_DEPTH variation ids, the next parameter is time
+static string MissingRunIntervalQuery(bool byTime)
+{
+	ostringstream variationIds;
+	for(int i = 0; i < CCDB_VARIATION_CHAIN_QUERY_DEPTH; i++) variationIds << (i ? ", ?" : "?") << i + 4;
+
+	ostringstream query;
+	query << "SELECT MAX(`typeTables`.`id`), "
+	         "MAX(CASE WHEN `runRanges`.`runMax` < ?1 THEN `runRanges`.`runMax` END), "
+	         "MIN(CASE WHEN `runRanges`.`runMin` > ?1 THEN `runRanges`.`runMin` END), "
+	         "COUNT(CASE WHEN `runRanges`.`runMin` <= ?1 AND `runRanges`.`runMax` >= ?1 THEN 1 END) "
+	         "FROM `typeTables` "
+	         "LEFT JOIN `constantSets` ON `constantSets`.`constantTypeId` = `typeTables`.`id` "
+	         "LEFT JOIN `assignments` ON `assignments`.`constantSetId` = `constantSets`.`id` "
+	         "AND `assignments`.`variationId` IN (" << variationIds.str() << ") ";
+	if(byTime) query << "AND  `assignments`.`created` <= datetime(?" << CCDB_VARIATION_CHAIN_QUERY_DEPTH + 4 << ", 'unixepoch', 'localtime') ";
+	query << "LEFT JOIN `runRanges` ON `runRanges`.`id` = `assignments`.`runRangeId` "
+	         "WHERE `typeTables`.`name` = ?2 AND `typeTables`.`directoryId` = ?3";
+	return query.str();
+}
+
+static const string kMissingRunIntervalQuery = MissingRunIntervalQuery(false);
+static const string kMissingRunIntervalByTimeQuery = MissingRunIntervalQuery(true);
+
 #pragma region constructors
 
 ccdb::SQLiteDataProvider::SQLiteDataProvider(void)
 {
 	mIsConnected = false;
+	mIsSingleThreadMode = false;
 	mDatabase=NULL;
 	mStatement=NULL;
-    mLastVariation = NULL;
+	for(int i = 0; i < StatementsCount; i++) mCachedStatements[i] = NULL;
+    mVariationsAreLoaded = false;
+	mHasChangeMark = false;
 	mRootDir = new Directory(this, this);
 	mDirsAreLoaded = false;
 }
@@ -55,6 +149,8 @@ bool ccdb::SQLiteDataProvider::Connect( std::string connectionString )
 		return false;
 	}
 
+	//tables of another database are not valid anymore
+	if(!mConnectionString.empty() && mConnectionString != connectionString) mTypeTableCache.reset(new TypeTableCache());
 	mConnectionString = connectionString;
 
 	//ok we dont need sqlite:// in the beginning.
@@ -71,7 +167,11 @@ bool ccdb::SQLiteDataProvider::Connect( std::string connectionString )
 	Log::Verbose("ccdb::SQLiteDataProvider::Connect", StringUtils::Format("Connecting to database:\n %s", connectionString.c_str()));
 	
 	//Try to open sqlite database
-	int result = sqlite3_open_v2(connectionString.c_str(), &mDatabase, SQLITE_OPEN_READONLY|SQLITE_OPEN_FULLMUTEX|SQLITE_OPEN_SHAREDCACHE, NULL);
+	//A provider that is used by one thread at a time doesn't need SQLite mutexes and shared cache locks
+	int flags = mIsSingleThreadMode ?
+		SQLITE_OPEN_READONLY|SQLITE_OPEN_NOMUTEX|SQLITE_OPEN_PRIVATECACHE :
+		SQLITE_OPEN_READONLY|SQLITE_OPEN_FULLMUTEX|SQLITE_OPEN_SHAREDCACHE;
+	int result = sqlite3_open_v2(connectionString.c_str(), &mDatabase, flags, NULL);
     //int result = sqlite3_open(connectionString.c_str(), &mDatabase);
 
 	if (result != SQLITE_OK) 
@@ -85,6 +185,8 @@ bool ccdb::SQLiteDataProvider::Connect( std::string connectionString )
 
     sqlite3_exec(mDatabase, "PRAGMA journal_mode = OFF;", NULL, 0, 0);
 	
+	mVariationsAreLoaded = false;
+	mHasChangeMark = false;		//data_version is counted per connection
 	mIsConnected = true;
 	return true;
 }
@@ -99,7 +201,9 @@ void ccdb::SQLiteDataProvider::Disconnect()
 	if(IsConnected())
 	{
 //		FreeSQLiteResult();	//it would free the result or do nothing
-		
+
+		//the database can't be closed while it has prepared statements
+		FinalizeCachedStatements();
 		sqlite3_close(mDatabase);
 		mDatabase = NULL;
 		mIsConnected = false;
@@ -242,29 +346,24 @@ ConstantsTypeTable * ccdb::SQLiteDataProvider::GetConstantsTypeTable( const stri
 		return NULL;
 	}
 	
-	// prepare the SQL statement from the command line
-	//sqlite3_finalize(mStatement);
-	//int result = sqlite3_prepare_v2(mDatabase,"SELECT `id`, strftime('%s', created , 'localtime') as `created`, strftime('%s', modified , 'localtime') as `modified`, `name`, `directoryId`, `nRows`, `nColumns`, `comments` FROM `typeTables` WHERE `name` = '?1' AND `directoryId` = ?2", -1, &mStatement, 0);
-	int result = sqlite3_prepare_v2(mDatabase,"SELECT `id`, strftime('%s', created , 'localtime') as `created`, strftime('%s', modified , 'localtime') as `modified`, `name`, `directoryId`, `nRows`, `nColumns`, `comment` FROM `typeTables`WHERE `name` = ?1 AND `directoryId` = ?2", -1, &mStatement, 0);
-	if( result )
-	{
-		ComposeSQLiteError("SQLiteDataProvider::GetConstantsTypeTable");
-		sqlite3_finalize(mStatement);
-		return NULL;
-	}
+	// take the prepared statement from the cache
+	mStatement = GetCachedStatement(StatementTypeTable,
+		"SELECT `id`, strftime('%s', created , 'localtime') as `created`, strftime('%s', modified , 'localtime') as `modified`, `name`, `directoryId`, `nRows`, `nColumns`, `comment` FROM `typeTables`WHERE `name` = ?1 AND `directoryId` = ?2",
+		"SQLiteDataProvider::GetConstantsTypeTable");
+	if(!mStatement) return NULL;
 
-	result = sqlite3_bind_text(mStatement, 1, name.c_str(), -1, SQLITE_TRANSIENT); /*`name`*/
+	int result = sqlite3_bind_text(mStatement, 1, name.c_str(), -1, SQLITE_TRANSIENT); /*`name`*/
 	if( result )
 	{
 		ComposeSQLiteError("SQLiteDataProvider::GetConstantsTypeTable");
-		sqlite3_finalize(mStatement);
+		sqlite3_reset(mStatement);
 		return NULL;
 	}
-	sqlite3_bind_int(mStatement, 2, parentDir->GetId()); /*`directoryId`*/
+	result = sqlite3_bind_int(mStatement, 2, parentDir->GetId()); /*`directoryId`*/
 	if( result )
 	{
 		ComposeSQLiteError("SQLiteDataProvider::GetConstantsTypeTable");
-		sqlite3_finalize(mStatement);
+		sqlite3_reset(mStatement);
 		return NULL;
 	}
 
@@ -301,7 +400,7 @@ ConstantsTypeTable * ccdb::SQLiteDataProvider::GetConstantsTypeTable( const stri
 				//TODO error, name should be not null and not empty
 				Error(CCDB_ERROR_TYPETABLE_HAS_NO_NAME,"SQLiteDataProvider::GetConstantsTypeTable", "");
 				delete table;
-				sqlite3_finalize(mStatement);
+				sqlite3_reset(mStatement);
 				return NULL;
 			}
 				
@@ -323,8 +422,8 @@ ConstantsTypeTable * ccdb::SQLiteDataProvider::GetConstantsTypeTable( const stri
 	}
 	while(result==SQLITE_ROW );
 
-	// finalize the statement to release resources
-	sqlite3_finalize(mStatement);
+	// reset the statement to release resources, it is kept in the cache
+	sqlite3_reset(mStatement);
 
 	//load columns if needed
 	if(loadColumns && table) LoadColumns(table);
@@ -515,20 +614,17 @@ bool ccdb::SQLiteDataProvider::LoadColumns( ConstantsTypeTable* table )
 		return false;
 	}
 
-	// prepare the SQL statement from the command line
-	int result = sqlite3_prepare_v2(mDatabase, "SELECT `id`, strftime('%s', created , 'localtime') as `created`, strftime('%s', modified , 'localtime') as `modified`, `name`, `columnType`, `comment` FROM `columns` WHERE `typeId` = ?1 ORDER BY `order`;", -1, &mStatement, 0);
-	if( result != 0)
-	{
-		ComposeSQLiteError("ccdb::SQLiteDataProvider::LoadColumns");
-		sqlite3_finalize(mStatement);
-		return false;
-	}
+	// take the prepared statement from the cache
+	mStatement = GetCachedStatement(StatementColumns,
+		"SELECT `id`, strftime('%s', created , 'localtime') as `created`, strftime('%s', modified , 'localtime') as `modified`, `name`, `columnType`, `comment` FROM `columns` WHERE `typeId` = ?1 ORDER BY `order`;",
+		"ccdb::SQLiteDataProvider::LoadColumns");
+	if(!mStatement) return false;
 
-	result = sqlite3_bind_int(mStatement, 1, table->GetId());	/*`directoryId`*/
+	int result = sqlite3_bind_int(mStatement, 1, table->GetId());	/*`directoryId`*/
 	if( result )
 	{
 		ComposeSQLiteError("ccdb::SQLiteDataProvider::LoadColumns");
-		sqlite3_finalize(mStatement);
+		sqlite3_reset(mStatement);
 		return false;
 	}
 
@@ -565,8 +661,8 @@ bool ccdb::SQLiteDataProvider::LoadColumns( ConstantsTypeTable* table )
 	}
 	while(result==SQLITE_ROW );
 
-	// finalize the statement to release resources
-	sqlite3_finalize(mStatement);
+	// reset the statement to release resources, it is kept in the cache
+	sqlite3_reset(mStatement);
 	return true;
 }
 
@@ -857,115 +953,93 @@ vector<Variation *> ccdb::SQLiteDataProvider::GetVariations( ConstantsTypeTable
 
 Variation* ccdb::SQLiteDataProvider::GetVariation( const string& name )
 {
-	/** @brief Gets mysql record Id for specified variation name
-	 *         returns -1 if variation with this name is not found
-	 *	 
+	/** @brief Gets variation by name
+	 *
+	 * The whole variations table is loaded at the first call, later variations are taken from memory.
+	 * If the name is not found, the table is reloaded as the variation could be added meanwhile,
+	 * but only if the database is changed since the last load (@see GetChangeMark)
+	 *
 	 * @param    [in] variation name
-	 * @return   dbkey_t id of variation or -1 if variation with this name is not found
+	 * @return   variation or NULL if variation with this name is not found
 	 */
 
-	char thisFunc[] = "ccdb::SQLiteDataProvider::GetVariation( const string& name )";
-
     ClearErrors(); //Clear error in function that can produce new ones
 
-    //check that maybe we have this variation id by the last request?
-    if(mLastVariation!=NULL && name == mLastVariation->GetName()) return mLastVariation;
-
-    string query = "SELECT `id`, `parentId`, `name` FROM `variations` WHERE `name`= ?1";
+	bool justLoaded = !mVariationsAreLoaded;
+	if(justLoaded && !LoadVariations()) return NULL;
 
-	// prepare the SQL statement from the command line
-	int result = sqlite3_prepare_v2(mDatabase, query.c_str(), -1, &mStatement, 0);
-	if( result ) { ComposeSQLiteError(thisFunc); sqlite3_finalize(mStatement); return NULL; }
+	map<string, Variation *>::iterator iter = mVariationsByName.find(name);
+	if(iter == mVariationsByName.end() && !justLoaded)
+	{
+		//nothing is changed since the load, so the name is unknown still
+		ChangeMark mark;
+		if(GetChangeMark(mark) && mark == mVariationsMark) return NULL;
 
-	result = sqlite3_bind_text(mStatement, 1, name.c_str(), -1, SQLITE_TRANSIENT);
-	if( result ) { ComposeSQLiteError(thisFunc); sqlite3_finalize(mStatement); return NULL; }
+		if(!LoadVariations()) return NULL;
+		iter = mVariationsByName.find(name);
+	}
 
-	mQueryColumns = sqlite3_column_count(mStatement);
-    //select variation
-    mLastVariation = SelectVariation();
-    return mLastVariation;
+	return iter == mVariationsByName.end() ? NULL : iter->second;
 }
 
 
 Variation* ccdb::SQLiteDataProvider::GetVariationById( dbkey_t id )
 {
-	/** @brief Gets mysql record Id for specified variation name
-	 *         returns -1 if variation with this name is not found
-	 *	 
-	 * @param    [in] variation name
-	 * @return   dbkey_t id of variation or -1 if variation with this name is not found
+	/** @brief Gets variation by database id
+	 *
+	 * @param    [in] id of variation
+	 * @return   variation or NULL if variation with this id is not found
 	 */
 
-	char thisFunc[] = "ccdb::SQLiteDataProvider::GetVariationById( dbkey_t id )";
-
     ClearErrors(); //Clear error in function that can produce new ones
 
-    //check that maybe we have this variation id by the last request?
-    if(mVariationsById.find(id) != mVariationsById.end()) return mVariationsById[id];
+	if(!mVariationsAreLoaded && !LoadVariations()) return NULL;
 
-    string query = "SELECT `id`, `parentId`, `name` FROM `variations` WHERE `id`= ?1";
+	map<dbkey_t, Variation *>::iterator iter = mVariationsById.find(id);
+	return iter == mVariationsById.end() ? NULL : iter->second;
+}
 
-	// prepare the SQL statement from the command line
-	int result = sqlite3_prepare_v2(mDatabase, query.c_str(), -1, &mStatement, 0);
-	if( result ) { ComposeSQLiteError(thisFunc); sqlite3_finalize(mStatement); return NULL; }
 
-	result = sqlite3_bind_int(mStatement, 1, id);
-	if( result ) { ComposeSQLiteError(thisFunc); sqlite3_finalize(mStatement); return NULL; }
+bool ccdb::SQLiteDataProvider::LoadVariations()
+{
+	/** @brief Loads the whole variations table by one query
+	 *
+	 * Already loaded variation objects are updated, so pointers that were given out stay valid.
+	 * Parents and ancestor chains are linked by LinkVariations
+	 *
+	 * @return false if error happened
+	 */
 
-    //select variation
-    mLastVariation = SelectVariation();
-    return mLastVariation;
-}
+    char thisFunc[] = "ccdb::SQLiteDataProvider::LoadVariations()";
 
+	if(!CheckConnection(thisFunc)) return false;
 
-Variation* ccdb::SQLiteDataProvider::SelectVariation()
-{
-    ///* Executes statement and create Variation object. mStatement should be prepared when calling the function
+	//the state is taken before the load, so changes made during it are not missed
+	if(!GetChangeMark(mVariationsMark)) return false;
 
-    char thisFunc[] = "ccdb::SQLiteDataProvider::SelectVariation()";
+	int result = sqlite3_prepare_v2(mDatabase, "SELECT `id`, `parentId`, `name` FROM `variations`", -1, &mStatement, 0);
+	if( result ) { ComposeSQLiteError(thisFunc); sqlite3_finalize(mStatement); return false; }
 
-	// execute the statement
-	dbkey_t id = (dbkey_t)-1;
-    dbkey_t parentId = (dbkey_t)-1;
-    string name;
-    int result;
-	do
+	mQueryColumns = sqlite3_column_count(mStatement);
+	map<dbkey_t, Variation *> loaded;
+	while((result = sqlite3_step(mStatement)) == SQLITE_ROW)
 	{
-		result = sqlite3_step(mStatement);
-
-		switch( result )
-		{
-		case SQLITE_DONE:
-			break;
-		case SQLITE_ROW:			
-			id =  ReadULong(0);
-            parentId = ReadULong(1);
-            name = ReadString(2);
-			break;
-		default:
-			ComposeSQLiteError(thisFunc);
-            sqlite3_finalize(mStatement); 
-            return NULL;
-			break;
-		}
+		dbkey_t id = ReadIndex(0);
+		map<dbkey_t, Variation *>::iterator iter = mVariationsById.find(id);
+		Variation *var = (iter != mVariationsById.end()) ? iter->second : new Variation(this, this);
+		var->SetId(id);
+		var->SetParentDbId(ReadIndex(1));
+		var->SetName(ReadString(2));
+		loaded[id] = var;
 	}
-	while(result==SQLITE_ROW );
-
-	// finalize the statement to release resources
 	sqlite3_finalize(mStatement);
-	
-    Variation *var = new Variation(this, this);
-    var->SetName(name);
-    var->SetId(id);
-    var->SetParentDbId(parentId);
-    
-    //recursive call to get variation parent
-    if(parentId>0) var->SetParent(GetVariationById(parentId));
-    
-    //add to cache
-    if(mVariationsById.find(id) == mVariationsById.end())  mVariationsById[id] = var;
-    
-	return var;
+	if(result != SQLITE_DONE) { ComposeSQLiteError(thisFunc); return false; }
+
+	//variations that were deleted from the database are still owned by the provider
+	mVariationsById.swap(loaded);
+	LinkVariations();
+	mVariationsAreLoaded = true;
+	return true;
 }
 
 
@@ -1009,8 +1083,8 @@ Assignment* ccdb::SQLiteDataProvider::GetAssignmentShort(int run, const string&
 
 	if(!CheckConnection(thisFunc)) return NULL;
 	
-    //Get type table
-    ConstantsTypeTable *table = GetConstantsTypeTable(path, loadColumns);
+    //Get type table from the metadata cache, it is shared by all assignments of the table
+    std::shared_ptr<ConstantsTypeTable> table = GetSharedTypeTable(path, loadColumns);
     if(!table)
     {
         Error(CCDB_ERROR_NO_TYPETABLE, "SQLiteDataProvider::GetAssignmentShort", "Type table was not found: '"+path+"'" );
@@ -1025,95 +1099,660 @@ Assignment* ccdb::SQLiteDataProvider::GetAssignmentShort(int run, const string&
         return NULL;
     }
 
-	////ok now we must build our mighty query...
+	//the whole variation chain is resolved by one statement. Longer chains than the statement takes are split
+	const vector<Variation *>& chain = GetVariationChain(variation);
+	Assignment *assignment = NULL;
+	for(size_t first = 0; first < chain.size() && assignment == NULL; first += CCDB_VARIATION_CHAIN_QUERY_DEPTH)
+	{
+		//take the prepared statement with or without time condition from the cache
+		if(time>0)
+		{
+			mStatement = GetCachedStatement(StatementAssignmentShortByTime, kAssignmentShortByTimeQuery.c_str(), thisFunc);
+		}
+		else
+		{
+			mStatement = GetCachedStatement(StatementAssignmentShort, kAssignmentShortQuery.c_str(), thisFunc);
+		}
+		if(!mStatement) return NULL;
+
+		int result = sqlite3_bind_int(mStatement, 1, run);	/*`runMin`, `runMax`*/
+		if( result ) { ComposeSQLiteError(thisFunc); sqlite3_reset(mStatement); return NULL; }
+
+		result = sqlite3_bind_int(mStatement, 2, table->GetId());	/*`constantTypeId`*/
+		if( result ) { ComposeSQLiteError(thisFunc); sqlite3_reset(mStatement); return NULL; }
+
+		//unused places of a short chain repeat its last variation
+		for(int i = 0; i < CCDB_VARIATION_CHAIN_QUERY_DEPTH; i++)
+		{
+			size_t index = std::min(first + i, chain.size() - 1);
+			result = sqlite3_bind_int(mStatement, i + 3, chain[index]->GetId());	/*`variationId`*/
+			if( result ) { ComposeSQLiteError(thisFunc); sqlite3_reset(mStatement); return NULL; }
+		}
+
+		if(time>0)
+		{
+			result = sqlite3_bind_int64(mStatement, CCDB_VARIATION_CHAIN_QUERY_DEPTH + 3, time);	/*`assignments`.`created`*/
+			if( result ) { ComposeSQLiteError(thisFunc); sqlite3_reset(mStatement); return NULL; }
+		}
+
+		mQueryColumns = sqlite3_column_count(mStatement);
+		result = sqlite3_step(mStatement);
+		if(result == SQLITE_ROW)
+		{
+			assignment = new Assignment(this, this);
+			assignment->SetId( ReadIndex(0) );
+			assignment->SetTypeTable(table);
+			SetAssignmentData(assignment, ReadString(1), thisFunc);
+
+			//additional fill
+			assignment->SetRequestedRun(run);
+			assignment->SetVariationId(ReadIndex(5));
+			assignment->SetRunRangeId(ReadIndex(2));
+
+			RunRange * runRange = new RunRange(assignment, this);
+			runRange->SetId(ReadIndex(2));
+			runRange->SetRange(ReadInt(3), ReadInt(4));
+			assignment->SetRunRange(runRange);
+		}
+		else if(result != SQLITE_DONE)
+		{
+			ComposeSQLiteError(thisFunc);
+			sqlite3_reset(mStatement);
+			return NULL;
+		}
+
+		// reset the statement to release resources, it is kept in the cache
+		sqlite3_reset(mStatement);
+	}
+
+	if(assignment == NULL) return NULL;
+
+	return assignment;
+}
+
+
+bool ccdb::SQLiteDataProvider::GetAssignmentRunInterval(Assignment* assignment, const string& variationName, time_t time, int& runMin, int& runMax)
+{
+    /** @brief Gets the interval of runs for which the request resolves to the same assignment
+     *
+     * @see DataProvider::GetAssignmentRunInterval
+     * @param [in]  assignment - assignment returned by GetAssignmentShort
+     * @param [in]  variation  - variation name that was requested
+     * @param [in]  time       - time that was requested, 0 if no time was requested
+     * @param [out] runMin     - first run of the interval
+     * @param [out] runMax     - last run of the interval
+     * @return true if the interval was found
+     */
+	char thisFunc[] = "ccdb::SQLiteDataProvider::GetAssignmentRunInterval(Assignment* assignment, const string& variation, time_t time, int& runMin, int& runMax)";
+	ClearErrors(); //Clear error in function that can produce new ones
+
+	int run = assignment->GetRequestedRun();
+	runMin = runMax = run;
+
+	if(!CheckConnection(thisFunc)) return false;
+
+	RunRange *runRange = assignment->GetRunRange();
+	if(!runRange || !assignment->GetTypeTable()) return false;
+
+	//variations that are checked before the variation the assignment belongs to
+	vector<dbkey_t> childVariationIds;
+	Variation* variation = GetVariation(variationName);
+	while(variation && variation->GetId() != static_cast<unsigned int>(assignment->GetVariationId()))
+	{
+		childVariationIds.push_back(variation->GetId());
+		variation = variation->GetParent();
+	}
+	if(!variation) return false;
+
+	//The nearest of the winning assignments from the left and right are the interval edges.
+	//Child variations are bound by the statement size, more of them are split
+	bool hasLeft = false, hasRight = false;
+	int left = 0, right = 0;
+	for(size_t first = 0; first == 0 || first < childVariationIds.size(); first += CCDB_VARIATION_CHAIN_QUERY_DEPTH)
+	{
+		if(time>0)
+		{
+			mStatement = GetCachedStatement(StatementAssignmentRunIntervalByTime, kAssignmentRunIntervalByTimeQuery.c_str(), thisFunc);
+		}
+		else
+		{
+			mStatement = GetCachedStatement(StatementAssignmentRunInterval, kAssignmentRunIntervalQuery.c_str(), thisFunc);
+		}
+		if(!mStatement) return false;
+
+		int result = sqlite3_bind_int(mStatement, 1, run) ||
+		             sqlite3_bind_int(mStatement, 2, assignment->GetTypeTable()->GetId()) ||
+		             sqlite3_bind_int(mStatement, 3, runRange->GetMin()) ||
+		             sqlite3_bind_int(mStatement, 4, runRange->GetMax()) ||
+		             sqlite3_bind_int(mStatement, 5, assignment->GetVariationId()) ||
+		             sqlite3_bind_int(mStatement, 6, assignment->GetId()) ||
+		             (time>0 && sqlite3_bind_int64(mStatement, CCDB_VARIATION_CHAIN_QUERY_DEPTH + 7, time));
+
+		//unused places are 0, no variation has such id
+		for(int i = 0; i < CCDB_VARIATION_CHAIN_QUERY_DEPTH && !result; i++)
+		{
+			dbkey_t variationId = first + i < childVariationIds.size() ? childVariationIds[first + i] : 0;
+			result = sqlite3_bind_int(mStatement, i + 7, variationId);
+		}
+		if( result ) { ComposeSQLiteError(thisFunc); sqlite3_reset(mStatement); return false; }
+
+		mQueryColumns = sqlite3_column_count(mStatement);
+		if(sqlite3_step(mStatement) != SQLITE_ROW)
+		{
+			ComposeSQLiteError(thisFunc); sqlite3_reset(mStatement); return false;
+		}
+
+		//something covers the run itself. Shouldn't happen, but be safe and give [run, run]
+		if(ReadInt(2) > 0)
+		{
+			sqlite3_reset(mStatement);
+			return true;
+		}
+
+		if(!IsNullOrUnreadable(0) && (!hasLeft || ReadInt(0) > left)) { left = ReadInt(0); hasLeft = true; }
+		if(!IsNullOrUnreadable(1) && (!hasRight || ReadInt(1) < right)) { right = ReadInt(1); hasRight = true; }
+
+		// reset the statement to release resources, it is kept in the cache
+		sqlite3_reset(mStatement);
+	}
+
+	runMin = hasLeft ? left + 1 : runRange->GetMin();
+	runMax = hasRight ? right - 1 : runRange->GetMax();
+	return true;
+}
+
+
+bool ccdb::SQLiteDataProvider::GetMissingRunInterval(const string& path, int run, const string& variationName, time_t time, int& runMin, int& runMax)
+{
+    /** @brief Gets the interval of runs for which the request has no assignment
+     *
+     * @see DataProvider::GetMissingRunInterval
+     * @param [in]  path       - absolute path of the type table
+     * @param [in]  run        - run number that was requested
+     * @param [in]  variation  - variation name that was requested
+     * @param [in]  time       - time that was requested, 0 if no time was requested
+     * @param [out] runMin     - first run of the interval
+     * @param [out] runMax     - last run of the interval
+     * @return true if there is no assignment for the run
+     */
+	char thisFunc[] = "ccdb::SQLiteDataProvider::GetMissingRunInterval(const string& path, int run, const string& variation, time_t time, int& runMin, int& runMax)";
+	ClearErrors(); //Clear error in function that can produce new ones
+
+	runMin = runMax = run;
+	if(!CheckConnection(thisFunc)) return false;
+
+	//no directory or no variation - nothing for all runs. Unless they were not loaded because of an error
+	Directory *dir = GetDirectory(PathUtils::ExtractDirectory(path));
+	Variation* variation = GetVariation(variationName);
+	if(!mDirsAreLoaded || !mVariationsAreLoaded) return false;
+	if(dir == NULL || (dir->GetFullPath()!=string("/") && dir->GetId()<=0) || variation == NULL)
+	{
+		runMin = std::min(run, 0);
+		runMax = INFINITE_RUN;
+		return true;
+	}
+
+	//Variations of the chain are bound by the statement size, longer chains are split
+	const vector<Variation *>& chain = GetVariationChain(variation);
+	string name = PathUtils::ExtractObjectname(path);
+	bool hasLeft = false, hasRight = false;
+	int left = 0, right = 0;
+	for(size_t first = 0; first < chain.size(); first += CCDB_VARIATION_CHAIN_QUERY_DEPTH)
+	{
+		if(time>0)
+		{
+			mStatement = GetCachedStatement(StatementMissingRunIntervalByTime, kMissingRunIntervalByTimeQuery.c_str(), thisFunc);
+		}
+		else
+		{
+			mStatement = GetCachedStatement(StatementMissingRunInterval, kMissingRunIntervalQuery.c_str(), thisFunc);
+		}
+		if(!mStatement) return false;
+
+		int result = sqlite3_bind_int(mStatement, 1, run) ||
+		             sqlite3_bind_text(mStatement, 2, name.c_str(), -1, SQLITE_TRANSIENT) ||
+		             sqlite3_bind_int(mStatement, 3, dir->GetId()) ||
+		             (time>0 && sqlite3_bind_int64(mStatement, CCDB_VARIATION_CHAIN_QUERY_DEPTH + 4, time));
+
+		//unused places of a short chain repeat its last variation
+		for(int i = 0; i < CCDB_VARIATION_CHAIN_QUERY_DEPTH && !result; i++)
+		{
+			size_t index = std::min(first + i, chain.size() - 1);
+			result = sqlite3_bind_int(mStatement, i + 4, chain[index]->GetId());
+		}
+		if( result ) { ComposeSQLiteError(thisFunc); sqlite3_reset(mStatement); return false; }
+
+		mQueryColumns = sqlite3_column_count(mStatement);
+		if(sqlite3_step(mStatement) != SQLITE_ROW)
+		{
+			ComposeSQLiteError(thisFunc); sqlite3_reset(mStatement); return false;
+		}
+
+		if(IsNullOrUnreadable(0))
+		{
+			//no such table
+			sqlite3_reset(mStatement);
+			runMin = std::min(run, 0);
+			runMax = INFINITE_RUN;
+			return true;
+		}
+
+		if(ReadInt(3) != 0)
+		{
+			//something covers the run, it was probably added after the request
+			sqlite3_reset(mStatement);
+			return false;
+		}
+
+		if(!IsNullOrUnreadable(1) && (!hasLeft || ReadInt(1) > left)) { left = ReadInt(1); hasLeft = true; }
+		if(!IsNullOrUnreadable(2) && (!hasRight || ReadInt(2) < right)) { right = ReadInt(2); hasRight = true; }
+
+		// reset the statement to release resources, it is kept in the cache
+		sqlite3_reset(mStatement);
+	}
+
+	runMin = hasLeft ? left + 1 : std::min(run, 0);
+	runMax = hasRight ? right - 1 : INFINITE_RUN;
+	return true;
+}
+
+
+bool ccdb::SQLiteDataProvider::GetChangeMark(ChangeMark& mark)
+{
+	/** @brief Gets the current state of assignments to find out if the database is changed
+	 *
+	 * @see DataProvider::GetChangeMark
+	 * @param [out] mark - the state of assignments
+	 * @return false if error happened
+	 */
+	char thisFunc[] = "ccdb::SQLiteDataProvider::GetChangeMark(ChangeMark& mark)";
+	ClearErrors(); //Clear error in function that can produce new ones
+
+	mark = ChangeMark();
+	if(!CheckConnection(thisFunc)) return false;
+
+	//data_version is changed only by commits of other connections
+	if(!QueryPrepare("PRAGMA data_version", thisFunc)) return false;
+	if(sqlite3_step(mStatement) != SQLITE_ROW)
+	{
+		ComposeSQLiteError(thisFunc); sqlite3_finalize(mStatement); return false;
+	}
+	mark.DataVersion = sqlite3_column_int64(mStatement, 0);
+	sqlite3_finalize(mStatement);
+
+	//nothing is committed since the last check, so the assignments are not scanned again
+	if(mHasChangeMark && mLastChangeMark.DataVersion == mark.DataVersion)
+	{
+		mark = mLastChangeMark;
+		return true;
+	}
+
+	if(!QueryPrepare("SELECT MAX(`id`), MAX(`modified`) FROM `assignments`", thisFunc)) return false;
+	mQueryColumns = sqlite3_column_count(mStatement);
+	if(sqlite3_step(mStatement) != SQLITE_ROW)
+	{
+		ComposeSQLiteError(thisFunc); sqlite3_finalize(mStatement); return false;
+	}
+	if(!IsNullOrUnreadable(0)) mark.MaxAssignmentId = ReadIndex(0);
+	if(!IsNullOrUnreadable(1)) mark.LastModified = ReadString(1);
+	sqlite3_finalize(mStatement);
+
+	mLastChangeMark = mark;
+	mHasChangeMark = true;
+	return true;
+}
+
+
+bool ccdb::SQLiteDataProvider::GetChangedTables(vector<string>& paths, const ChangeMark& since)
+{
+	/** @brief Gets tables whose assignments are added or modified after the mark was taken
+	 *
+	 * @see DataProvider::GetChangedTables
+	 * @param [out] paths - absolute paths of the changed tables
+	 * @param [in]  since - mark taken by GetChangeMark before the changes
+	 * @return false if the changed tables can't be told or error happened
+	 */
+	char thisFunc[] = "ccdb::SQLiteDataProvider::GetChangedTables(vector<string>& paths, const ChangeMark& since)";
+	ClearErrors(); //Clear error in function that can produce new ones
+
+	paths.clear();
+	if(!CheckConnection(thisFunc)) return false;
+	if(!UpdateDirectoriesIfNeeded()) return false;
+
+	//modification time has seconds only, so assignments modified in the same second as the mark are taken too
+	const char* query =
+		"SELECT DISTINCT `typeTables`.`directoryId`, `typeTables`.`name` FROM `assignments` "
+		"INNER JOIN `constantSets` ON `constantSets`.`id` = `assignments`.`constantSetId` "
+		"INNER JOIN `typeTables` ON `typeTables`.`id` = `constantSets`.`constantTypeId` "
+		"WHERE `assignments`.`id` > ?1 OR `assignments`.`modified` >= ?2";
+	if(!QueryPrepare(query, thisFunc)) return false;
+
+	if( sqlite3_bind_int64(mStatement, 1, since.MaxAssignmentId) ||
+	    sqlite3_bind_text(mStatement, 2, since.LastModified.c_str(), -1, SQLITE_TRANSIENT))
+	{
+		ComposeSQLiteError(thisFunc); sqlite3_finalize(mStatement); return false;
+	}
+
+	mQueryColumns = sqlite3_column_count(mStatement);
+	bool isKnown = true;
+	int result;
+	while((result = sqlite3_step(mStatement)) == SQLITE_ROW)
+	{
+		//a table of a directory that is not loaded yet can't be named
+		map<dbkey_t, Directory *>::iterator dir = mDirectoriesById.find(ReadIndex(0));
+		if(dir == mDirectoriesById.end())
+		{
+			isKnown = false;
+			continue;
+		}
+		paths.push_back(PathUtils::CombinePath(dir->second->GetFullPath(), ReadString(1)));
+	}
+
+	if(result != SQLITE_DONE)
+	{
+		ComposeSQLiteError(thisFunc); sqlite3_finalize(mStatement); return false;
+	}
+
+	sqlite3_finalize(mStatement);
+	return isKnown;
+}
+
+
+bool ccdb::SQLiteDataProvider::GetAssignmentsShort(vector<Assignment*>& assignments, vector<pair<int, int> >& runIntervals, int run, const vector<string>& paths,
+                                                    time_t time /*=0*/, const string& variation /*="default"*/, bool loadColumns /*=false*/)
+{
+	/** @brief Gets assignments of many tables for the same run, variation and time at once
+	 *
+	 * All assignments and their run intervals are selected by one statement:
+	 * for each type table the assignments of the variation chain that cover the run are grouped
+	 * and the one of the nearest variation with the biggest id wins (the same as GetAssignmentShort does
+	 * table by table). Then the assignments that would win over it for other runs are joined
+	 * to get the run interval (the same as GetAssignmentRunInterval does).
+	 *
+	 * All lookups are done in one read transaction, so the database is locked once
+	 * and all assignments are taken from the same state of the database
+	 */
+
+	char thisFunc[] = "ccdb::SQLiteDataProvider::GetAssignmentsShort(...)";
+	ClearErrors(); //Clear error in function that can produce new ones
+
+	assignments.assign(paths.size(), NULL);
+	runIntervals.assign(paths.size(), make_pair(run, run));
+
+	if(!CheckConnection(thisFunc)) return false;
+	if(paths.empty()) return true;
+
+	//don't nest transactions if somebody has already opened one
+	bool ownTransaction = sqlite3_get_autocommit(mDatabase) && sqlite3_exec(mDatabase, "BEGIN", NULL, NULL, NULL) == SQLITE_OK;
+
+	//type tables of all paths and the variation chain
+	vector<std::shared_ptr<ConstantsTypeTable> > tables;
+	Variation* requestedVariation = NULL;
+	bool isOk = LoadTypeTables(tables, paths, loadColumns);
+	if(isOk)
+	{
+		requestedVariation = GetVariation(variation);
+		if(!requestedVariation)
+		{
+			Error(CCDB_ERROR_VARIATION_INVALID,"SQLiteDataProvider::GetAssignmentsShort", "No variation '"+variation+"' was found");
+			isOk = false;
+		}
+	}
+
+	//depth of a variation in the chain: 0 - requested variation, 1 - its parent, etc.
+	string typeIds;
+	string variationIds;
+	string depthOfAs("(CASE `assignments`.`variationId`");
+	string depthOfBlocker("(CASE `a`.`variationId`");
+	if(isOk)
+	{
+		map<dbkey_t, bool> uniqueTypeIds;
+		for(size_t i = 0; i < tables.size(); i++)
+		{
+			if(!tables[i] || uniqueTypeIds.count(tables[i]->GetId())) continue;
+			uniqueTypeIds[tables[i]->GetId()] = true;
+			if(!typeIds.empty()) typeIds += ",";
+			typeIds += StringUtils::IntToString(tables[i]->GetId());
+		}
+
+		const vector<Variation *>& chain = GetVariationChain(requestedVariation);
+		for(size_t depth = 0; depth < chain.size(); depth++)
+		{
+			string id = StringUtils::IntToString(chain[depth]->GetId());
+			string when = " WHEN " + id + " THEN " + StringUtils::IntToString(depth);
+			if(!variationIds.empty()) variationIds += ",";
+			variationIds += id;
+			depthOfAs += when;
+			depthOfBlocker += when;
+		}
+		depthOfAs += " END)";
+		depthOfBlocker += " END)";
+	}
+
+	if(!isOk || typeIds.empty())
+	{
+		if(ownTransaction) sqlite3_exec(mDatabase, "COMMIT", NULL, NULL, NULL);
+		return isOk;
+	}
+
+	string timeCondition = (time>0)? string("AND  `assignments`.`created` <= datetime(?2, 'unixepoch', 'localtime') ") : string();
+	string blockerTimeCondition = (time>0)? string("AND  `a`.`created` <= datetime(?2, 'unixepoch', 'localtime') ") : string();
+
+	//`best` - the winning assignment of each type table. SQLite takes bare columns of an
+	//aggregate query from the row that has MIN(), so the row of the nearest variation with the biggest id is taken.
+	//Then the assignments that would win over it if they had our run are joined (@see GetAssignmentRunInterval)
 	string query(
-        "SELECT `assignments`.`id` AS `asId`, "
-        "`constantSets`.`vault` AS `blob` "
+        "WITH `best` AS ("
+        "SELECT `constantSets`.`constantTypeId` AS `typeId`, "
+        "`assignments`.`id` AS `asId`, "
+        "`assignments`.`variationId` AS `varId`, " +
+        depthOfAs + " AS `depth`, "
+        "`constantSets`.`vault` AS `blob`, "
+        "`runRanges`.`id` AS `rrId`, "
+        "`runRanges`.`runMin` AS `rrMin`, "
+        "`runRanges`.`runMax` AS `rrMax`, "
+        "MIN(" + depthOfAs + " * 4294967296 - `assignments`.`id`) "
         "FROM  `assignments` "
         "INNER JOIN `runRanges` ON `assignments`.`runRangeId`= `runRanges`.`id` "
         "INNER JOIN `constantSets` ON `assignments`.`constantSetId` = `constantSets`.`id` "
-        "INNER JOIN `typeTables` ON `constantSets`.`constantTypeId` = `typeTables`.`id` "
         "WHERE  `runRanges`.`runMin` <= ?1 "
         "AND `runRanges`.`runMax` >= ?1 "
-        "AND `assignments`.`variationId`= ?2 "
-        "AND  `constantSets`.`constantTypeId` =?3 " + 
-        ((time>0)? string("AND  `assignments`.`created` <= datetime(?4, 'unixepoch', 'localtime') ") : string()) +
-        "ORDER BY `assignments`.`id` DESC "
-        "LIMIT 1 ");
-	
-//	cout<<query<<endl;
+        "AND `assignments`.`variationId` IN (" + variationIds + ") "
+        "AND `constantSets`.`constantTypeId` IN (" + typeIds + ") " +
+        timeCondition +
+        "GROUP BY `constantSets`.`constantTypeId`) "
+        "SELECT `best`.`typeId`, `best`.`asId`, `best`.`varId`, `best`.`blob`, `best`.`rrId`, `best`.`rrMin`, `best`.`rrMax`, "
+        "MAX(CASE WHEN `r`.`runMax` < ?1 THEN `r`.`runMax` END), "
+        "MIN(CASE WHEN `r`.`runMin` > ?1 THEN `r`.`runMin` END), "
+        "COUNT(CASE WHEN `r`.`runMin` <= ?1 AND `r`.`runMax` >= ?1 THEN 1 END) "
+        "FROM `best` "
+        "LEFT JOIN `constantSets` AS `cs` ON `cs`.`constantTypeId` = `best`.`typeId` "
+        "LEFT JOIN `assignments` AS `a` ON `a`.`constantSetId` = `cs`.`id` "
+        "AND (" + depthOfBlocker + " < `best`.`depth` OR (`a`.`variationId` = `best`.`varId` AND `a`.`id` > `best`.`asId`)) " +
+        blockerTimeCondition +
+        "LEFT JOIN `runRanges` AS `r` ON `r`.`id` = `a`.`runRangeId` "
+        "AND `r`.`runMax` >= `best`.`rrMin` "
+        "AND `r`.`runMin` <= `best`.`rrMax` "
+        "GROUP BY `best`.`typeId`");
 
-	// prepare the SQL statement from the command line
 	int result = sqlite3_prepare_v2(mDatabase, query.c_str(), -1, &mStatement, 0);
-	if( result ) { ComposeSQLiteError(thisFunc); sqlite3_finalize(mStatement); return NULL; }
+	if( result || sqlite3_bind_int(mStatement, 1, run) || (time>0 && sqlite3_bind_int64(mStatement, 2, time)))
+	{
+		ComposeSQLiteError(thisFunc);
+		sqlite3_finalize(mStatement);
+		if(ownTransaction) sqlite3_exec(mDatabase, "COMMIT", NULL, NULL, NULL);
+		return false;
+	}
 
-	result = sqlite3_bind_int(mStatement, 1, run);	/*`directoryId`*/
-	if( result ) { ComposeSQLiteError(thisFunc); sqlite3_finalize(mStatement); return NULL; }
-	
-	result = sqlite3_bind_int(mStatement, 2, variation->GetId());	/*`variationId`*/
-	if( result ) { ComposeSQLiteError(thisFunc); sqlite3_finalize(mStatement); return NULL; }
-			
-	result = sqlite3_bind_int(mStatement, 3, table->GetId());	/*``typeTables`.`directoryId``*/
-	if( result ) { ComposeSQLiteError(thisFunc); sqlite3_finalize(mStatement); return NULL; }
-    
-    if(time>0)
-    {
-        result = sqlite3_bind_int64(mStatement, 4, time);	/*` `assignments`.`created``*/
-        if( result ) { ComposeSQLiteError(thisFunc); sqlite3_finalize(mStatement); return NULL; }
-    }
-	//cout<<endl<<"time "<<time<<endl;
 	mQueryColumns = sqlite3_column_count(mStatement);
-    int selectedRows = 0;
-	// execute the statement
-	Assignment *assignment = NULL;
 	do
 	{
 		result = sqlite3_step(mStatement);
-		
-		switch( result )
+		if(result != SQLITE_ROW) break;
+
+		dbkey_t typeId = ReadIndex(0);
+		for(size_t i = 0; i < tables.size(); i++)
 		{
-		case SQLITE_DONE:
-			break;
-		case SQLITE_ROW:
-			assignment = new Assignment(this, this);
-			assignment->SetId( ReadIndex(0) );			
-			assignment->SetRawData( ReadString(1) );
+			if(!tables[i] || tables[i]->GetId() != typeId) continue;
+
+			Assignment* assignment = new Assignment(this, this);
+			assignment->SetId( ReadIndex(1) );
+			assignment->SetTypeTable(tables[i]);
+			SetAssignmentData(assignment, ReadString(3), thisFunc);
 
 			//additional fill
 			assignment->SetRequestedRun(run);
-            selectedRows++;
-			break;
-		default:
-			ComposeSQLiteError(thisFunc); 
-            sqlite3_finalize(mStatement); 
-            return NULL;
-			break;
+			assignment->SetVariationId(ReadIndex(2));
+			assignment->SetRunRangeId(ReadIndex(4));
+			RunRange * runRange = new RunRange(assignment, this);
+			runRange->SetId(ReadIndex(4));
+			runRange->SetRange(ReadInt(5), ReadInt(6));
+			assignment->SetRunRange(runRange);
+			assignments[i] = assignment;
+
+			//something covers the run itself. Shouldn't happen, but be safe and give [run, run]
+			if(ReadInt(9) == 0)
+			{
+				runIntervals[i].first = IsNullOrUnreadable(7) ? runRange->GetMin() : ReadInt(7) + 1;
+				runIntervals[i].second = IsNullOrUnreadable(8) ? runRange->GetMax() : ReadInt(8) - 1;
+			}
 		}
-	} while(result==SQLITE_ROW );
+	} while(true);
 
-    // finalize the statement to release resources
-    sqlite3_finalize(mStatement);
-        
-    //If We have not found data for this variation, getting data for parent variation
-    if((assignment == NULL && selectedRows==0) && variation->GetParentDbId()!=0)
-    {
-        return GetAssignmentShort(run, path, time, variation->GetParent()->GetName(), loadColumns);
-    }
-    
-	if(assignment == NULL) 
+	if(result != SQLITE_DONE) ComposeSQLiteError(thisFunc);
+	sqlite3_finalize(mStatement);
+
+	if(ownTransaction) sqlite3_exec(mDatabase, "COMMIT", NULL, NULL, NULL);
+	return result == SQLITE_DONE;
+}
+
+
+bool ccdb::SQLiteDataProvider::LoadTypeTables(vector<std::shared_ptr<ConstantsTypeTable> >& tables, const vector<string>& paths, bool loadColumns)
+{
+	/** @brief Loads type tables for many paths at once
+	 *
+	 * Tables that are already in the metadata cache are taken from it. The rest are selected
+	 * by one query, their columns (if needed) by another one, and then are put to the cache.
+	 * The same path requested twice gets the same shared table.
+	 *
+	 * @param [out] tables      - tables[i] is the type table for paths[i] or empty if it was not found
+	 * @param [in]  paths       - absolute paths of type tables
+	 * @param [in]  loadColumns - do we need to load table columns information or not
+	 * @return false if error happened
+	 */
+	char thisFunc[] = "ccdb::SQLiteDataProvider::LoadTypeTables(...)";
+
+	tables.assign(paths.size(), std::shared_ptr<ConstantsTypeTable>());
+
+	//directory id and name of each requested table that is not cached
+	map<pair<dbkey_t, string>, vector<size_t> > requested;
+	string directoryIds;
+	for(size_t i = 0; i < paths.size(); i++)
 	{
-		delete table;
-		return NULL;
+		tables[i] = mTypeTableCache->Get(paths[i], loadColumns);
+		if(tables[i]) continue;
+
+		Directory *dir = GetDirectory(PathUtils::ExtractDirectory(paths[i]));
+		if(dir == NULL || (dir->GetFullPath()!=string("/") && dir->GetId()<=0))
+		{
+			Error(CCDB_ERROR_NO_TYPETABLE, "SQLiteDataProvider::LoadTypeTables", "Type table was not found: '"+paths[i]+"'" );
+			continue;
+		}
+		if(!directoryIds.empty()) directoryIds += ",";
+		directoryIds += StringUtils::IntToString(dir->GetId());
+		requested[make_pair(dir->GetId(), PathUtils::ExtractObjectname(paths[i]))].push_back(i);
 	}
+	if(requested.empty()) return true;
 
+	string query = "SELECT `id`, strftime('%s', created , 'localtime') as `created`, strftime('%s', modified , 'localtime') as `modified`, `name`, `directoryId`, `nRows`, `nColumns`, `comment` FROM `typeTables` "
+	               "WHERE `directoryId` IN (" + directoryIds + ")";
+	int result = sqlite3_prepare_v2(mDatabase, query.c_str(), -1, &mStatement, 0);
+	if( result ) { ComposeSQLiteError(thisFunc); sqlite3_finalize(mStatement); return false; }
 
+	//loaded tables are not shared until their columns are loaded
+	mQueryColumns = sqlite3_column_count(mStatement);
+	map<dbkey_t, ConstantsTypeTable*> loadedById;
+	map<dbkey_t, vector<size_t> > indexesById;
+	string typeIds;
+	while((result = sqlite3_step(mStatement)) == SQLITE_ROW)
+	{
+		map<pair<dbkey_t, string>, vector<size_t> >::iterator it = requested.find(make_pair((dbkey_t)ReadIndex(4), ReadString(3)));
+		if(it == requested.end()) continue;
+
+		if(!typeIds.empty()) typeIds += ",";
+		typeIds += StringUtils::IntToString(ReadIndex(0));
+
+		ConstantsTypeTable* table = new ConstantsTypeTable(this, this);
+		table->SetId(ReadULong(0));
+		table->SetCreatedTime(ReadUnixTime(1));
+		table->SetModifiedTime(ReadUnixTime(2));
+		table->SetName(ReadString(3));
+		table->SetDirectoryId(ReadULong(4));
+		table->SetNRows(ReadInt(5));
+		table->SetNColumnsFromDB(ReadInt(6));
+		table->SetComment(ReadString(7));
+		SetObjectLoaded(table); //set object flags that it was just loaded from DB
+
+		Directory *dir = GetDirectory(PathUtils::ExtractDirectory(paths[it->second[0]]));
+		table->SetDirectory(dir);
+		table->SetFullPath(PathUtils::CombinePath(dir->GetFullPath(), table->GetName()));
+
+		loadedById[table->GetId()] = table;
+		indexesById[table->GetId()] = it->second;
+		requested.erase(it);
+	}
+	sqlite3_finalize(mStatement);
 
-    assignment->SetTypeTable(table);
-    assignment->BeOwner(table);
-    table->SetOwner(assignment);
+	//what is left in requested are not existing tables
+	for(map<pair<dbkey_t, string>, vector<size_t> >::iterator it = requested.begin(); it != requested.end(); ++it)
+	{
+		Error(CCDB_ERROR_NO_TYPETABLE, "SQLiteDataProvider::LoadTypeTables", "Type table was not found: '"+paths[it->second[0]]+"'" );
+	}
 
+	bool isOk = result == SQLITE_DONE;
+	if(!isOk) ComposeSQLiteError(thisFunc);
 
-	return assignment;
+	//columns of all loaded tables
+	if(isOk && loadColumns && !typeIds.empty())
+	{
+		query = "SELECT `id`, strftime('%s', created , 'localtime') as `created`, strftime('%s', modified , 'localtime') as `modified`, `name`, `columnType`, `comment`, `typeId` FROM `columns` "
+		        "WHERE `typeId` IN (" + typeIds + ") ORDER BY `typeId`, `order`;";
+		result = sqlite3_prepare_v2(mDatabase, query.c_str(), -1, &mStatement, 0);
+		if( result ) { ComposeSQLiteError(thisFunc); isOk = false; }
+
+		mQueryColumns = sqlite3_column_count(mStatement);
+		while(isOk && (result = sqlite3_step(mStatement)) == SQLITE_ROW)
+		{
+			ConstantsTypeTable* table = loadedById[ReadIndex(6)];
+			ConstantsTypeColumn *column = new ConstantsTypeColumn(table, this);
+			column->SetId(ReadULong(0));
+			column->SetCreatedTime(ReadUnixTime(1));
+			column->SetModifiedTime(ReadUnixTime(2));
+			column->SetName(ReadString(3));
+			column->SetType(ReadString(4));
+			column->SetComment(ReadString(5));
+			column->SetDBTypeTableId(table->GetId());
+			SetObjectLoaded(column); //set object flags that it was just loaded from DB
+			table->AddColumn(column);
+		}
+		sqlite3_finalize(mStatement);
+		if(isOk && result != SQLITE_DONE) { ComposeSQLiteError(thisFunc); isOk = false; }
+	}
+
+	//complete tables go to the cache, the same path gets the same table
+	for(map<dbkey_t, ConstantsTypeTable*>::iterator it = loadedById.begin(); it != loadedById.end(); ++it)
+	{
+		if(!isOk)
+		{
+			delete it->second;
+			continue;
+		}
+
+		const vector<size_t>& indexes = indexesById[it->first];
+		std::shared_ptr<ConstantsTypeTable> table = mTypeTableCache->Put(it->second->GetFullPath(), it->second, loadColumns);
+		for(size_t j = 0; j < indexes.size(); j++) tables[indexes[j]] = table;
+	}
+	return isOk;
 }
 
 
@@ -1401,7 +2040,8 @@ void ccdb::SQLiteDataProvider::FetchAssignment(Assignment* assignment, Constants
 	assignment->SetModifiedTime(ReadUnixTime(2));	/*02  " UNIX_TIMESTAMP(`assignments`.`modified`) as `asModified`,	"*/
 	assignment->SetComment(ReadString(3));			/*03  " `assignments`.`comment) as `asComment`,	"					 */
 	assignment->SetDataVaultId(ReadIndex(4));		/*04  " `constantSets`.`id` AS `constId`, "							 */
-	assignment->SetRawData(ReadString(5));			/*05  " `constantSets`.`vault` AS `blob`, "							 */
+	assignment->SetTypeTable(table);				/*   the data is parsed by column types */
+	SetAssignmentData(assignment, ReadString(5), "SQLiteDataProvider::FetchAssignment");	/*05  " `constantSets`.`vault` AS `blob`, "							 */
 	
 	RunRange * runRange = new RunRange(assignment, this);	
 	runRange->SetId(ReadIndex(6));					/*06  " `runRanges`.`id`   AS `rrId`, "	*/
@@ -1422,7 +2062,6 @@ void ccdb::SQLiteDataProvider::FetchAssignment(Assignment* assignment, Constants
 	//compose objects
 	assignment->SetRunRange(runRange);
 	assignment->SetVariation(variation);
-	assignment->SetTypeTable(table);
 	if(IsOwner(table)) table->SetOwner(assignment);
 }
 #pragma end region Assignments
@@ -1488,6 +2127,10 @@ bool ccdb::SQLiteDataProvider::IsNullOrUnreadable( int fieldNum )
 		return true;
 	}
 
+	if(sqlite3_column_type(mStatement, fieldNum) == SQLITE_NULL)
+	{
+		return true;
+	}
 	return false;
 }
 
@@ -1495,49 +2138,67 @@ int ccdb::SQLiteDataProvider::ReadInt( int fieldNum )
 {	
 	if(IsNullOrUnreadable(fieldNum)) return 0;
 
-	return atoi((const char*)sqlite3_column_text(mStatement,fieldNum)); //ugly isn't it?
+	const char* text = (const char*)sqlite3_column_text(mStatement,fieldNum);
+	int value;
+	StringUtils::ParseInt(text, text + sqlite3_column_bytes(mStatement,fieldNum), value);
+	return value;
 }
 
 unsigned int ccdb::SQLiteDataProvider::ReadUInt( int fieldNum )
 {	
 	if(IsNullOrUnreadable(fieldNum)) return 0;
 
-	return static_cast<unsigned int>(atoi((const char*)sqlite3_column_text(mStatement,fieldNum))); //ugly isn't it?
+	const char* text = (const char*)sqlite3_column_text(mStatement,fieldNum);
+	unsigned int value;
+	StringUtils::ParseUInt(text, text + sqlite3_column_bytes(mStatement,fieldNum), value);
+	return value;
 }
 
 long ccdb::SQLiteDataProvider::ReadLong( int fieldNum )
 {
 	if(IsNullOrUnreadable(fieldNum)) return 0;
 
-	return atol((const char*)sqlite3_column_text(mStatement,fieldNum)); //ugly isn't it?
+	const char* text = (const char*)sqlite3_column_text(mStatement,fieldNum);
+	long value;
+	StringUtils::ParseLong(text, text + sqlite3_column_bytes(mStatement,fieldNum), value);
+	return value;
 }
 
 unsigned long ccdb::SQLiteDataProvider::ReadULong( int fieldNum )
 {
 	if(IsNullOrUnreadable(fieldNum)) return 0;
 
-	return static_cast<unsigned long>(atol((const char*)sqlite3_column_text(mStatement,fieldNum))); //ugly isn't it?
+	const char* text = (const char*)sqlite3_column_text(mStatement,fieldNum);
+	unsigned long value;
+	StringUtils::ParseULong(text, text + sqlite3_column_bytes(mStatement,fieldNum), value);
+	return value;
 }
 
 dbkey_t ccdb::SQLiteDataProvider::ReadIndex( int fieldNum )
 {
 	if(IsNullOrUnreadable(fieldNum)) return 0;
 
-	return static_cast<dbkey_t>(atol((const char*)sqlite3_column_text(mStatement,fieldNum))); //ugly isn't it?
+	return static_cast<dbkey_t>(ReadLong(fieldNum));
 }
 
 bool ccdb::SQLiteDataProvider::ReadBool( int fieldNum )
 {
 	if(IsNullOrUnreadable(fieldNum)) return false;
 
-	return static_cast<bool>(atoi((const char*)sqlite3_column_text(mStatement,fieldNum))!=0); //ugly isn't it?
+	const char* text = (const char*)sqlite3_column_text(mStatement,fieldNum);
+	bool value;
+	StringUtils::ParseBool(text, text + sqlite3_column_bytes(mStatement,fieldNum), value);
+	return value;
 }
 
 double ccdb::SQLiteDataProvider::ReadDouble( int fieldNum )
 {
 	if(IsNullOrUnreadable(fieldNum)) return 0;
 
-	return atof((const char*)sqlite3_column_text(mStatement,fieldNum)); //ugly isn't it?
+	const char* text = (const char*)sqlite3_column_text(mStatement,fieldNum);
+	double value;
+	StringUtils::ParseDouble(text, text + sqlite3_column_bytes(mStatement,fieldNum), value);
+	return value;
 }
 
 std::string ccdb::SQLiteDataProvider::ReadString( int fieldNum )
@@ -1582,6 +2243,50 @@ void ccdb::SQLiteDataProvider::FreeSQLiteResult()
 	sqlite3_free(mStatement);
 }
 
+sqlite3_stmt* ccdb::SQLiteDataProvider::GetCachedStatement(CachedStatement id, const char* query, const char* functionName)
+{
+	/** @brief Gets prepared statement from the per connection cache
+	 *
+	 * The statement is prepared at the first call. Later calls return the same statement
+	 * with cleared bindings. Call sqlite3_reset (not sqlite3_finalize) when the statement is done.
+	 *
+	 * @param [in] id           - which statement it is
+	 * @param [in] query        - SQL to prepare if the statement is not in the cache yet
+	 * @param [in] functionName - function name for errors
+	 * @return the statement or NULL if it could not be prepared
+	 */
+
+	sqlite3_stmt* statement = mCachedStatements[id];
+	if(statement)
+	{
+		sqlite3_reset(statement);
+		sqlite3_clear_bindings(statement);
+		return statement;
+	}
+
+	if(sqlite3_prepare_v2(mDatabase, query, -1, &statement, 0) != SQLITE_OK)
+	{
+		ComposeSQLiteError(functionName);
+		sqlite3_finalize(statement);
+		return NULL;
+	}
+
+	mCachedStatements[id] = statement;
+	return statement;
+}
+
+
+void ccdb::SQLiteDataProvider::FinalizeCachedStatements()
+{
+	for(int i = 0; i < StatementsCount; i++)
+	{
+		if(mCachedStatements[i] == mStatement) mStatement = NULL;
+		sqlite3_finalize(mCachedStatements[i]);
+		mCachedStatements[i] = NULL;
+	}
+}
+
+
 std::string ccdb::SQLiteDataProvider::ComposeSQLiteError(const std::string& SQLiteFunctionName)
 {
 	string sqliteErr=StringUtils::Format("%s failed:\nError (%s)\n",SQLiteFunctionName.c_str(), sqlite3_errmsg(mDatabase));
@@ -0,0 +1,82 @@
+#include "CCDB/Providers/TypeTableCache.h"
+
+using namespace std;
+
+namespace ccdb
+{
+
+//______________________________________________________________________________
+TypeTableCache::TypeTableCache()
+{
+    mStats.Tables = 0;
+    mStats.Hits = 0;
+    mStats.Misses = 0;
+}
+
+
+//______________________________________________________________________________
+TypeTableCache::TablePtr TypeTableCache::Get(const string& path, bool withColumns)
+{
+    /** @brief Gets the table by full path
+     *
+     * @return the table or empty pointer if it is not cached (or cached without needed columns)
+     */
+
+    lock_guard<mutex> lock(mMutex);
+    unordered_map<string, Entry>::iterator iter = mTables.find(path);
+    if(iter == mTables.end() || (withColumns && !iter->second.HasColumns))
+    {
+        mStats.Misses++;
+        return TablePtr();
+    }
+
+    mStats.Hits++;
+    return iter->second.Table;
+}
+
+
+//______________________________________________________________________________
+TypeTableCache::TablePtr TypeTableCache::Put(const string& path, ConstantsTypeTable* table, bool withColumns)
+{
+    /** @brief Puts loaded table to the cache. The cache takes the ownership
+     *
+     * @return the cached table for the path
+     */
+
+    //the table is not owned by the provider or assignment anymore
+    table->ReleaseOwning();
+
+    //columns by name are built lazily, build them while the table is not shared yet
+    if(withColumns) table->GetColumnsByName();
+    TablePtr loaded(table);
+
+    lock_guard<mutex> lock(mMutex);
+    Entry& entry = mTables[path];
+
+    //another thread could load the table with columns meanwhile
+    if(entry.Table && (entry.HasColumns || !withColumns)) return entry.Table;
+
+    entry.Table = loaded;
+    entry.HasColumns = withColumns;
+    return loaded;
+}
+
+
+//______________________________________________________________________________
+void TypeTableCache::Clear()
+{
+    lock_guard<mutex> lock(mMutex);
+    mTables.clear();
+}
+
+
+//______________________________________________________________________________
+TypeTableCacheStats TypeTableCache::GetStats()
+{
+    lock_guard<mutex> lock(mMutex);
+    TypeTableCacheStats stats = mStats;
+    stats.Tables = mTables.size();
+    return stats;
+}
+
+}
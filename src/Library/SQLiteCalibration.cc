@@ -117,6 +117,18 @@ void SQLiteCalibration::Disconnect()
     }
 
     mProvider->Disconnect();
+    if(mPool) mPool->Disconnect();
+}
+
+
+//______________________________________________________________________________
+DataProvider* SQLiteCalibration::CreateProvider()
+{
+    /** @brief Creates not connected provider for the connection pool. @see Calibration::SetPoolSize */
+
+    SQLiteDataProvider* provider = new SQLiteDataProvider();
+    provider->SetSingleThreadMode(true);
+    return provider;
 }
 
 
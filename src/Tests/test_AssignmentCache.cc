@@ -0,0 +1,625 @@
+#pragma warning(disable:4800)
+#include "Tests/catch.hpp"
+#include "Tests/tests.h"
+#include <memory>
+#include <thread>
+
+#include "CCDB/AssignmentCache.h"
+#include "CCDB/SQLiteCalibration.h"
+
+
+using namespace std;
+using namespace ccdb;
+
+
+/** *********************************************************************
+ * @brief Test of AssignmentCache LRU eviction and accounting
+ */
+TEST_CASE("CCDB/AssignmentCache/LRU","Eviction and accounting of assignments cache")
+{
+	shared_ptr<Assignment> a1(new Assignment());
+	shared_ptr<Assignment> a2(new Assignment());
+	shared_ptr<Assignment> a3(new Assignment());
+	a1->SetRawData("1|2|3");
+	a2->SetRawData("4|5|6");
+	a3->SetRawData("7|8|9");
+
+	//budget that fits two assignments but not three
+	size_t entrySize = a1->GetMemoryUsage() + string("a1").capacity();
+	AssignmentCache cache(entrySize * 2 + entrySize / 2);
+
+	cache.Put("a1", a1);
+	cache.Put("a2", a2);
+	REQUIRE(cache.GetStats().Entries == 2);
+	REQUIRE(cache.GetStats().Bytes > 0);
+
+	//a1 is now the most recently used, so a2 is evicted on the next put
+	REQUIRE(cache.Get("a1") == a1);
+	cache.Put("a3", a3);
+
+	AssignmentCacheStats stats = cache.GetStats();
+	REQUIRE(stats.Entries == 2);
+	REQUIRE(stats.Evictions == 1);
+	REQUIRE(stats.Bytes <= stats.MemoryLimit);
+	REQUIRE_FALSE(cache.Get("a2"));
+	REQUIRE(cache.Get("a3") == a3);
+
+	stats = cache.GetStats();
+	REQUIRE(stats.Hits == 2);
+	REQUIRE(stats.Misses == 1);
+
+	//evicted assignment is still valid for its holder
+	REQUIRE(a2->GetVectorData().size() == 3);
+
+	//shrinking budget evicts immediately but keeps the most recent one
+	cache.SetMemoryLimit(1);
+	REQUIRE(cache.GetStats().Entries == 1);
+	REQUIRE(cache.Get("a3") == a3);
+
+	cache.Clear();
+	REQUIRE(cache.GetStats().Entries == 0);
+	REQUIRE(cache.GetStats().Bytes == 0);
+}
+
+
+TEST_CASE("CCDB/AssignmentCache/Calibration","Calibration serves repeated requests from its own cache")
+{
+	SQLiteCalibration calib(100);
+	if(!calib.Connect(TESTS_SQLITE_STRING)) return;
+	calib.EnableCache(true);
+
+	vector<vector<string> > values;
+	REQUIRE(calib.GetCalib(values, "/test/test_vars/test_table"));
+	values.clear();
+	REQUIRE(calib.GetCalib(values, "test/test_vars/test_table:100"));
+	REQUIRE(values.size() == 2);
+
+	AssignmentCacheStats stats = calib.GetCacheStats();
+	REQUIRE(stats.Entries == 1);
+	REQUIRE(stats.Misses == 1);
+	REQUIRE(stats.Hits == 1);
+
+	//shared assignment outlives the cache
+	shared_ptr<Assignment> assignment = calib.GetSharedAssignment("/test/test_vars/test_table");
+
+	//raw pointers are held by the calibration: the same assignment on every call, valid after eviction
+	Assignment* held = calib.GetAssignment("/test/test_vars/test_table");
+	REQUIRE(held == assignment.get());
+	REQUIRE(calib.GetAssignment("/test/test_vars/test_table:100") == held);
+	weak_ptr<Assignment> heldRef = assignment;
+	assignment.reset();
+	calib.SetCacheMemoryLimit(1);
+	values.clear();
+	REQUIRE(calib.GetCalib(values, "/test/test_vars/test_table2::test"));   //evicts test_table
+	REQUIRE(calib.GetCacheStats().Entries == 1);
+	REQUIRE_FALSE(heldRef.expired());
+	REQUIRE(held->GetVectorData().size() == 6);
+	calib.SetCacheMemoryLimit(0);
+	assignment = calib.GetSharedAssignment("/test/test_vars/test_table");
+
+	calib.ClearCache();
+	REQUIRE(calib.GetCacheStats().Entries == 0);
+	REQUIRE(heldRef.expired());
+	REQUIRE(assignment->GetVectorData().size() == 6);
+}
+
+
+TEST_CASE("CCDB/AssignmentCache/RunIntervals","Runs inside a known interval are served from the cache")
+{
+	AssignmentCache cache(0);
+	shared_ptr<Assignment> a1(new Assignment());
+	shared_ptr<Assignment> a2(new Assignment());
+
+	cache.Put("/table:default:0", 0, 499, "/table:#1", a1);
+	cache.Put("/table:default:0", 500, 3000, "/table:#2", a2);
+
+	REQUIRE(cache.Get("/table:default:0", 0) == a1);
+	REQUIRE(cache.Get("/table:default:0", 499) == a1);
+	REQUIRE(cache.Get("/table:default:0", 500) == a2);
+	REQUIRE(cache.Get("/table:default:0", 3000) == a2);
+	REQUIRE_FALSE(cache.Get("/table:default:0", 3001));
+	REQUIRE_FALSE(cache.Get("/table:mc:0", 100));
+
+	//replacing assignment keeps bytes of its intervals
+	size_t bytes = cache.GetStats().Bytes;
+	cache.Put("/table:#1", a1);
+	REQUIRE(cache.GetStats().Bytes == bytes);
+
+	//removing assignment removes its intervals
+	REQUIRE(cache.Remove("/table:#1"));
+	REQUIRE_FALSE(cache.Get("/table:default:0", 100));
+	REQUIRE(cache.Get("/table:default:0", 1000) == a2);
+	REQUIRE(cache.Remove("/table:#2"));
+	REQUIRE(cache.GetStats().Bytes == 0);
+}
+
+
+TEST_CASE("CCDB/AssignmentCache/MissingIntervals","Runs without assignment are remembered by intervals")
+{
+	AssignmentCache cache(0);
+	cache.PutMissing("/table:default:0", 0, 99);
+	cache.PutMissing("/table:default:0", 3001, INFINITE_RUN);
+
+	int runMin = 0, runMax = 0;
+	REQUIRE(cache.IsMissing("/table:default:0", 50, &runMin, &runMax));
+	REQUIRE(runMin == 0);
+	REQUIRE(runMax == 99);
+	REQUIRE(cache.IsMissing("/table:default:0", 5000));
+	REQUIRE_FALSE(cache.IsMissing("/table:default:0", 100));
+	REQUIRE_FALSE(cache.IsMissing("/table:default:0", -1));
+	REQUIRE_FALSE(cache.IsMissing("/table:mc:0", 50));
+
+	AssignmentCacheStats stats = cache.GetStats();
+	REQUIRE(stats.MissingIntervals == 2);
+	REQUIRE(stats.MissingHits == 2);
+	REQUIRE(stats.Entries == 0);
+	REQUIRE(stats.Bytes > 0);
+
+	cache.Clear();
+	REQUIRE_FALSE(cache.IsMissing("/table:default:0", 50));
+	REQUIRE(cache.GetStats().MissingIntervals == 0);
+	REQUIRE(cache.GetStats().Bytes == 0);
+
+	//missing intervals count in the budget and are evicted with assignments by the last use
+	shared_ptr<Assignment> a1(new Assignment());
+	a1->SetRawData("1|2|3");
+	cache.Put("a1", a1);
+	size_t entrySize = cache.GetStats().Bytes;
+	cache.SetMemoryLimit(entrySize * 3);
+	for(int i = 0; i < 1000; i++) cache.PutMissing("/table" + to_string(i) + ":default:0", 0, 99);
+
+	stats = cache.GetStats();
+	REQUIRE(stats.Bytes <= stats.MemoryLimit);
+	REQUIRE(stats.MissingIntervals < 1000);
+	REQUIRE(stats.Evictions > 0);
+	REQUIRE_FALSE(cache.Get("a1"));
+	REQUIRE_FALSE(cache.IsMissing("/table0:default:0", 50));
+	REQUIRE(cache.IsMissing("/table999:default:0", 50));
+}
+
+
+TEST_CASE("CCDB/AssignmentCache/CalibrationMissing","Repeated requests without data don't go to the database")
+{
+	SQLiteCalibration calib(100);
+	if(!calib.Connect(TESTS_SQLITE_STRING)) return;
+	calib.EnableCache(true);
+
+	//no such table and a table without 'default' assignments
+	vector<vector<string> > values;
+	for(int i = 0; i < 3; i++)
+	{
+		REQUIRE_FALSE(calib.GetCalib(values, "/test/test_vars/no_such_table"));
+		REQUIRE_FALSE(calib.GetCalib(values, "/test/test_vars/test_table2:" + to_string(100 + i)));
+	}
+
+	AssignmentCacheStats stats = calib.GetCacheStats();
+	REQUIRE(stats.MissingIntervals == 4);
+	REQUIRE(stats.MissingHits == 4);
+	REQUIRE(stats.Entries == 0);
+
+	//the request with data is not affected
+	REQUIRE(calib.GetCalib(values, "/test/test_vars/test_table2:100:test"));
+
+	//handles remember missing intervals too
+	CalibHandle handle = calib.GetHandle("/test/test_vars/test_table2:100");
+	REQUIRE_FALSE(calib.GetCalib(values, handle));
+	unsigned long missingHits = calib.GetCacheStats().MissingHits;
+	REQUIRE_FALSE(calib.GetCalib(values, handle));
+	REQUIRE(calib.GetCacheStats().MissingHits == missingHits);
+
+	//the provider reports the whole range of runs
+	int runMin, runMax;
+	DataProvider* provider = calib.GetProvider();
+	REQUIRE(provider->GetMissingRunInterval("/test/test_vars/test_table2", 100, "default", 0, runMin, runMax));
+	REQUIRE(runMin == 0);
+	REQUIRE(runMax == INFINITE_RUN);
+	REQUIRE(provider->GetMissingRunInterval("/test/test_vars/no_such_table", 100, "default", 0, runMin, runMax));
+	REQUIRE_FALSE(provider->GetMissingRunInterval("/test/test_vars/test_table2", 100, "test", 0, runMin, runMax));
+	REQUIRE_FALSE(provider->GetMissingRunInterval("/test/test_vars/test_table", 100, "test", 0, runMin, runMax));
+}
+
+TEST_CASE("CCDB/AssignmentCache/CalibrationRuns","Consecutive runs resolved to one assignment make one database request")
+{
+	SQLiteCalibration calib(100, "test");
+	if(!calib.Connect(TESTS_SQLITE_STRING)) return;
+	calib.EnableCache(true);
+
+	//'test' variation falls back to 'default' for runs 0-499 and has own data for 500-3000
+	vector<vector<double> > values;
+	for(int run = 100; run < 110; run++)
+	{
+		values.clear();
+		REQUIRE(calib.GetCalib(values, "/test/test_vars/test_table:" + to_string(run)));
+		REQUIRE(values[0][0] == Approx(2.2));
+	}
+	values.clear();
+	REQUIRE(calib.GetCalib(values, "/test/test_vars/test_table:600"));
+	REQUIRE(values[0][0] == Approx(1.0));
+
+	AssignmentCacheStats stats = calib.GetCacheStats();
+	REQUIRE(stats.Misses == 2);
+	REQUIRE(stats.Hits == 9);
+	REQUIRE(stats.Entries == 2);
+}
+
+
+TEST_CASE("CCDB/AssignmentCache/TypedValues","Typed values are parsed once and served from the cached assignment")
+{
+	Assignment assignment;
+	assignment.SetRawData("1.5|2|3|4.25|5|6");
+	REQUIRE(assignment.GetDoubleValues().size() == 6);
+	REQUIRE(assignment.GetDoubleValues()[3] == Approx(4.25));
+	REQUIRE(assignment.GetIntValues()[1] == 2);
+
+	//new data resets parsed values
+	assignment.SetRawData("7|8");
+	REQUIRE(assignment.GetIntValues().size() == 2);
+	REQUIRE(assignment.GetIntValues()[0] == 7);
+
+	SQLiteCalibration calib(100);
+	if(!calib.Connect(TESTS_SQLITE_STRING)) return;
+	calib.EnableCache(true);
+
+	vector<vector<double> > table;
+	REQUIRE(calib.GetCalib(table, "/test/test_vars/test_table"));
+	REQUIRE(table.size() == 2);
+	REQUIRE(table[1][2] == Approx(2.7));
+
+	//the same assignment is reused, so are its parsed values
+	shared_ptr<Assignment> cached = calib.GetSharedAssignment("/test/test_vars/test_table");
+	REQUIRE(&cached->GetDoubleValues() == &calib.GetSharedAssignment("/test/test_vars/test_table", false)->GetDoubleValues());
+
+	vector<map<string, double> > rows;
+	REQUIRE(calib.GetCalib(rows, "/test/test_vars/test_table"));
+	REQUIRE(rows.size() == 2);
+	REQUIRE(rows[0].size() == 3);
+
+	double value = 0;
+	REQUIRE_THROWS(calib.GetCalib(value, "/test/test_vars/test_table"));
+
+	int intValue = 0;
+	REQUIRE(calib.GetCalib(intValue, "/test/test_vars/test_table2::test"));
+	REQUIRE(intValue == 10);
+	REQUIRE(calib.GetCalib(value, "/test/test_vars/test_table2::test"));
+	REQUIRE(value == Approx(10));
+
+	map<string, int> rowMap;
+	REQUIRE(calib.GetCalib(rowMap, "/test/test_vars/test_table2::test"));
+	REQUIRE(rowMap.size() == 3);
+}
+
+
+TEST_CASE("CCDB/AssignmentCache/TypedColumns","Data is kept as one typed array per column")
+{
+	ConstantsTypeTable table;
+	table.AddColumn("id", ConstantsTypeColumn::cIntColumn);
+	table.AddColumn("name", ConstantsTypeColumn::cStringColumn);
+	table.AddColumn("value", ConstantsTypeColumn::cDoubleColumn);
+	table.SetNRows(3);
+
+	Assignment assignment;
+	assignment.SetTypeTable(&table);
+	assignment.SetRawData("1|a|1.5|2|b|2.5|3|a|3.5");
+
+	const vector<TypedColumn>& columns = assignment.GetTypedColumns();
+	REQUIRE(columns.size() == 3);
+	REQUIRE(columns[0].Type == ConstantsTypeColumn::cIntColumn);
+	REQUIRE(columns[0].Integers.size() == 3);
+	REQUIRE(columns[2].Doubles.size() == 3);
+	REQUIRE(columns[2].Doubles[1] == Approx(2.5));
+
+	//equal strings are kept once
+	REQUIRE(columns[1].StringIds.size() == 3);
+	REQUIRE(columns[1].Strings->size() == 2);
+	REQUIRE(columns[1].StringIds[0] == columns[1].StringIds[2]);
+
+	REQUIRE(assignment.GetValueInt(2, 0) == 3);
+	REQUIRE(assignment.GetValueDouble(0, 2) == Approx(1.5));
+	REQUIRE(assignment.GetValue(1, "name") == "b");
+	REQUIRE(assignment.GetValue("value") == "1.5");
+	REQUIRE(assignment.GetValue("no_such_column") == "");
+
+	//columns are built once
+	REQUIRE(&assignment.GetTypedColumns()[0] == &columns[0]);
+
+	//values of other types are parsed from the cells, the same as without typed columns
+	Assignment mixed;
+	mixed.SetTypeTable(&table);
+	mixed.SetRawData("2.2|a|2.7|-1|b|nan|3|c|1e3");
+	REQUIRE(mixed.GetValueDouble(0, 0) == Approx(2.2));
+	REQUIRE(mixed.GetValueInt(0, 0) == 2);
+	REQUIRE(mixed.GetValueInt(0, 2) == 2);
+	REQUIRE(mixed.GetValueInt(1, 2) == 0);
+	REQUIRE(mixed.GetValueInt(2, 2) == 1);
+	REQUIRE(mixed.GetValueUInt(1, 0) == StringUtils::ParseUInt("-1"));
+	REQUIRE(mixed.GetValueLong(2, "value") == 1);
+	REQUIRE(mixed.GetValueDouble("id") == Approx(2.2));
+	REQUIRE(mixed.GetValueDouble(3) == Approx(-1));
+	REQUIRE(mixed.GetValueInt("no_such_column") == 0);
+	vector<string> cells = mixed.GetVectorData();
+	for (size_t i = 0; i < cells.size(); i++) REQUIRE(mixed.GetValueInt(i) == StringUtils::ParseInt(cells[i]));
+
+	//other types are converted once per column and kept with it
+	const TypedColumn& idColumn = mixed.GetTypedColumns()[0];
+	const double* idDoubles = idColumn.GetValues<double>();
+	REQUIRE(idDoubles[0] == Approx(2.2));
+	REQUIRE(idColumn.GetValues<double>() == idDoubles);
+	REQUIRE(idColumn.GetValues<int>()[2] == 3);
+	REQUIRE(idColumn.GetValues<long>()[1] == -1);
+	REQUIRE(mixed.GetTypedColumns()[2].GetValues<double>() == &mixed.GetTypedColumns()[2].Doubles[0]);
+	REQUIRE(idColumn.GetConvertedMemoryUsage() >= 3 * sizeof(double));
+
+	//binary data gives the same values as its text cells
+	vector<ConstantsTypeColumn::ColumnTypes> types;
+	types.push_back(ConstantsTypeColumn::cIntColumn);
+	types.push_back(ConstantsTypeColumn::cStringColumn);
+	types.push_back(ConstantsTypeColumn::cDoubleColumn);
+	Assignment binary;
+	binary.SetTypeTable(&table);
+	binary.SetRawData(Assignment::VectorToBlob(StringUtils::Split("7|a|2.5|8|5|nan|9|c|1e300", "|"), types));
+	REQUIRE(binary.IsBinaryData());
+	REQUIRE(binary.GetValueDouble(0, 0) == 7.0);
+	REQUIRE(binary.GetValueInt(0, 2) == 2);
+	REQUIRE(binary.GetValueInt(1, 2) == 0);
+	REQUIRE(binary.GetValueInt(1, 1) == 5);
+	REQUIRE(binary.GetValueInt(2, 2) == 1);
+
+	//typed GetCalib versions are served from the columns of the cached assignment
+	SQLiteCalibration calib(100);
+	if(!calib.Connect(TESTS_SQLITE_STRING)) return;
+	calib.EnableCache(true);
+
+	vector<vector<int> > values;
+	REQUIRE(calib.GetCalib(values, "/test/test_vars/test_table2::test"));
+	REQUIRE(values.size() == 1);
+	REQUIRE(values[0][2] == 30);
+
+	shared_ptr<Assignment> cached = calib.GetSharedAssignment("/test/test_vars/test_table2::test");
+	REQUIRE(cached->GetTypedColumns().size() == 3);
+	REQUIRE(cached->GetTypedColumns()[1].Type == ConstantsTypeColumn::cIntColumn);
+	REQUIRE(cached->GetTypedColumns()[1].Integers[0] == 20);
+}
+
+TEST_CASE("CCDB/AssignmentCache/FlatValues","Tables are read as one row-major array, to a buffer or as a view")
+{
+	SQLiteCalibration calib(100);
+	if(!calib.Connect(TESTS_SQLITE_STRING)) return;
+	calib.EnableCache(true);
+
+	size_t rows = 0, columns = 0;
+	vector<double> values;
+	REQUIRE(calib.GetCalib(values, rows, columns, "/test/test_vars/test_table"));
+	REQUIRE(rows == 2);
+	REQUIRE(columns == 3);
+	REQUIRE(values.size() == 6);
+	REQUIRE(values[0] == Approx(2.2));
+	REQUIRE(values[1*columns + 2] == Approx(2.7));
+
+	vector<int> intValues;
+	REQUIRE(calib.GetCalib(intValues, rows, columns, "/test/test_vars/test_table2::test"));
+	REQUIRE(rows == 1);
+	REQUIRE(intValues.size() == 3);
+	REQUIRE(intValues[2] == 30);
+
+	//buffer of the caller
+	double buffer[6];
+	REQUIRE(calib.GetCalib(buffer, 6, rows, columns, "/test/test_vars/test_table"));
+	REQUIRE(buffer[5] == Approx(2.7));
+	REQUIRE_THROWS_AS(calib.GetCalib(buffer, 5, rows, columns, "/test/test_vars/test_table"), std::logic_error);
+	REQUIRE(rows*columns == 6);
+
+	//the view points to the values of the cached assignment
+	CalibView<double> view;
+	REQUIRE(calib.GetCalib(view, "/test/test_vars/test_table"));
+	REQUIRE(view.GetRowsCount() == 2);
+	REQUIRE(view.GetColumnsCount() == 3);
+	REQUIRE(view(1, 0) == Approx(2.5));
+	shared_ptr<Assignment> cached = calib.GetSharedAssignment("/test/test_vars/test_table");
+	REQUIRE(view.GetData() == &cached->GetDoubleValues()[0]);
+
+	//the view keeps the values after the cache is cleared
+	cached.reset();
+	calib.ClearCache();
+	REQUIRE(view[2] == Approx(2.4));
+
+	CalibHandle handle = calib.GetHandle("/test/test_vars/test_table");
+	CalibView<int> intView;
+	REQUIRE(calib.GetCalib(intView, handle));
+	REQUIRE(intView.GetSize() == 6);
+	REQUIRE(intView[0] == 2);
+
+	REQUIRE_FALSE(calib.GetCalib(view, "/test/test_vars/no_such_table"));
+}
+
+TEST_CASE("CCDB/AssignmentCache/Threads","Concurrent misses of the same request make one database request")
+{
+	SQLiteCalibration calib(100);
+	if(!calib.Connect(TESTS_SQLITE_STRING)) return;
+	calib.EnableCache(true);
+
+	const int threadsCount = 16;
+	vector<thread> threads;
+	vector<double> firstValues(threadsCount, 0);
+	for(int i = 0; i < threadsCount; i++)
+	{
+		threads.push_back(thread([&calib, &firstValues, i]()
+		{
+			vector<vector<double> > values;
+			for(int j = 0; j < 100; j++)
+			{
+				values.clear();
+				calib.GetCalib(values, "/test/test_vars/test_table");
+			}
+			firstValues[i] = values[0][0];
+		}));
+	}
+	for(size_t i = 0; i < threads.size(); i++) threads[i].join();
+
+	for(int i = 0; i < threadsCount; i++) REQUIRE(firstValues[i] == Approx(2.2));
+	REQUIRE(calib.GetCacheStats().Insertions == 1);
+	REQUIRE(calib.GetCacheStats().Entries == 1);
+}
+
+
+TEST_CASE("CCDB/AssignmentCache/Freeze","Frozen calibration serves loaded tables from the snapshot")
+{
+	SQLiteCalibration calib(100);
+	if(!calib.Connect(TESTS_SQLITE_STRING)) return;
+	calib.EnableCache(true);
+
+	//warm-up. Tables of strings are loaded without columns
+	vector<vector<string> > values;
+	REQUIRE(calib.GetCalib(values, "/test/test_vars/test_table"));
+	REQUIRE_FALSE(calib.IsFrozen());
+
+	calib.Freeze();
+	REQUIRE(calib.IsFrozen());
+	AssignmentCacheStats before = calib.GetCacheStats();
+
+	//both absolute and relative paths are in the snapshot
+	values.clear();
+	REQUIRE(calib.GetCalib(values, "/test/test_vars/test_table"));
+	REQUIRE(values[0][0] == "2.2");
+	values.clear();
+	REQUIRE(calib.GetCalib(values, "test/test_vars/test_table"));
+	REQUIRE(values.size() == 2);
+	REQUIRE(calib.GetFrozenMisses() == 0);
+	REQUIRE(calib.GetCacheStats().Hits == before.Hits);
+
+	//assignment was loaded without columns, requests with columns go the slow way
+	vector<map<string, double> > rows;
+	REQUIRE(calib.GetCalib(rows, "/test/test_vars/test_table"));
+	REQUIRE(rows.size() == 2);
+	REQUIRE(calib.GetFrozenMisses() == 1);
+
+	//explicit run is not in the snapshot
+	values.clear();
+	REQUIRE(calib.GetCalib(values, "/test/test_vars/test_table:100"));
+	REQUIRE(calib.GetFrozenMisses() == 2);
+
+	//snapshot is not affected by the cache
+	calib.ClearCache();
+	values.clear();
+	REQUIRE(calib.GetCalib(values, "/test/test_vars/test_table"));
+	REQUIRE(calib.GetFrozenMisses() == 2);
+
+	calib.Unfreeze();
+	REQUIRE_FALSE(calib.IsFrozen());
+
+	//replaced snapshots are deleted, repeated freeze cycles don't hold more and more data
+	shared_ptr<Assignment> assignment = calib.GetSharedAssignment("/test/test_vars/test_table");
+	calib.Freeze();
+	long frozenUseCount = assignment.use_count();
+	for(int i = 0; i < 100; i++)
+	{
+		calib.Unfreeze();
+		calib.Freeze();
+		values.clear();
+		REQUIRE(calib.GetCalib(values, "/test/test_vars/test_table"));
+	}
+	REQUIRE(assignment.use_count() == frozenUseCount);
+	calib.Unfreeze();
+	REQUIRE(assignment.use_count() < frozenUseCount);
+}
+
+
+TEST_CASE("CCDB/AssignmentCache/Handles","Handles keep the assignment while the run is inside its interval")
+{
+	SQLiteCalibration calib(100, "test");
+	if(!calib.Connect(TESTS_SQLITE_STRING)) return;
+	calib.EnableCache(true);
+
+	CalibHandle handle = calib.GetHandle("/test/test_vars/test_table");
+	REQUIRE(handle.IsValid());
+	REQUIRE(handle.GetRun() == 100);
+	REQUIRE(calib.GetHandle("test/test_vars/test_table:500").GetPathId() == handle.GetPathId());
+	REQUIRE(calib.GetHandle("/test/test_vars/test_table2").GetPathId() != handle.GetPathId());
+
+	vector<vector<double> > values;
+	REQUIRE(calib.GetCalib(values, handle));
+	REQUIRE(values[0][0] == Approx(2.2));
+
+	//runs 0-499 resolve to the same assignment and don't look at the cache
+	AssignmentCacheStats before = calib.GetCacheStats();
+	for(int run = 101; run < 110; run++)
+	{
+		handle.SetRun(run);
+		values.clear();
+		REQUIRE(calib.GetCalib(values, handle));
+		REQUIRE(values[0][0] == Approx(2.2));
+	}
+	REQUIRE(calib.GetCacheStats().Hits == before.Hits);
+	REQUIRE(calib.GetCacheStats().Misses == before.Misses);
+
+	//run change outside the interval
+	handle.SetRun(600);
+	double value = 0;
+	REQUIRE_THROWS(calib.GetCalib(value, handle));
+	vector<double> row;
+	REQUIRE_THROWS(calib.GetCalib(row, handle));
+	values.clear();
+	REQUIRE(calib.GetCalib(values, handle));
+	REQUIRE(values[0][0] == Approx(1.0));
+
+	//with columns
+	vector<map<string, double> > rows;
+	REQUIRE(calib.GetCalib(rows, handle));
+	REQUIRE(rows[0].size() == 3);
+
+	CalibHandle intHandle = calib.GetHandle("/test/test_vars/test_table2");
+	int intValue = 0;
+	REQUIRE(calib.GetCalib(intValue, intHandle));
+	REQUIRE(intValue == 10);
+
+	//handle of another calibration
+	SQLiteCalibration other(100);
+	REQUIRE(other.Connect(TESTS_SQLITE_STRING));
+	REQUIRE_THROWS(other.GetCalib(values, handle));
+}
+
+
+TEST_CASE("CCDB/AssignmentCache/Prefetch","Prefetch loads a list of tables in one go")
+{
+	SQLiteCalibration calib(100, "test");
+	if(!calib.Connect(TESTS_SQLITE_STRING)) return;
+	calib.EnableCache(true);
+
+	vector<string> namepaths;
+	namepaths.push_back("/test/test_vars/test_table");
+	namepaths.push_back("test/test_vars/test_table2");
+	namepaths.push_back("/test/test_vars/test_table:600");
+	namepaths.push_back("/test/test_vars/no_such_table");
+
+	PrefetchStats stats = calib.Prefetch(namepaths);
+	REQUIRE(stats.Requested == 4);
+	REQUIRE(stats.Loaded == 3);
+	REQUIRE(stats.NotFound == 1);
+	REQUIRE(stats.AlreadyCached == 0);
+	REQUIRE(stats.Seconds >= 0);
+
+	//all GetCalib versions are served from the cache now
+	AssignmentCacheStats before = calib.GetCacheStats();
+	vector<vector<double> > values;
+	REQUIRE(calib.GetCalib(values, "/test/test_vars/test_table:200"));
+	REQUIRE(values[0][0] == Approx(2.2));
+	vector<map<string, double> > rows;
+	REQUIRE(calib.GetCalib(rows, "/test/test_vars/test_table:600"));
+	REQUIRE(rows[0]["x"] == Approx(1.0));
+	int value = 0;
+	REQUIRE(calib.GetCalib(value, "/test/test_vars/test_table2"));
+	REQUIRE(value == 10);
+	REQUIRE(calib.GetCacheStats().Misses == before.Misses);
+	REQUIRE(calib.GetCacheStats().Insertions == before.Insertions);
+
+	//the second time everything is cached
+	stats = calib.Prefetch(namepaths);
+	REQUIRE(stats.AlreadyCached == 3);
+	REQUIRE(stats.Loaded == 0);
+	REQUIRE(stats.NotFound == 1);
+	REQUIRE(calib.GetCacheStats().MissingHits == 1);
+
+	calib.ClearCache();
+	stats = calib.PrefetchAll();
+	REQUIRE(stats.Loaded > 0);
+	REQUIRE(stats.Loaded + stats.NotFound == stats.Requested);
+}
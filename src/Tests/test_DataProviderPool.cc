@@ -0,0 +1,171 @@
+#pragma warning(disable:4800)
+#include "Tests/catch.hpp"
+#include "Tests/tests.h"
+#include <memory>
+#include <thread>
+#include <vector>
+#include <atomic>
+
+#include "CCDB/Providers/DataProviderPool.h"
+#include "CCDB/Providers/SQLiteDataProvider.h"
+#include "CCDB/Helpers/TimeProvider.h"
+
+
+using namespace std;
+using namespace ccdb;
+
+static DataProvider* CreateSQLiteProvider()
+{
+	return new SQLiteDataProvider();
+}
+
+
+/** *********************************************************************
+ * @brief Test of per thread checkout, lazy growth and waiting for a free connection
+ */
+TEST_CASE("CCDB/DataProviderPool/Checkout","Per thread checkout of pooled providers")
+{
+	DataProviderPool pool(CreateSQLiteProvider, 2);
+
+	//no connection string - no providers
+	REQUIRE(pool.Checkout() == NULL);
+
+	pool.Connect(TESTS_SQLITE_STRING);
+	REQUIRE(pool.GetStats().Connections == 0);
+
+	//re-entrant checkout gives the same provider
+	DataProvider* provider = pool.Checkout();
+	REQUIRE(provider != NULL);
+	REQUIRE(provider->IsConnected());
+	REQUIRE(pool.Checkout() == provider);
+	pool.Release(provider);
+	REQUIRE(pool.GetStats().Idle == 0);
+
+	//another thread opens its own connection
+	DataProvider* otherProvider = NULL;
+	std::thread([&]() { otherProvider = pool.Checkout(); pool.Release(otherProvider); }).join();
+	REQUIRE(otherProvider != NULL);
+	REQUIRE(otherProvider != provider);
+	REQUIRE(pool.GetStats().Created == 2);
+
+	//released provider goes back to the thread that used it
+	pool.Release(provider);
+	REQUIRE(pool.GetStats().Idle == 2);
+	REQUIRE(pool.Checkout() == provider);
+
+	//the pool is full, the third thread waits for a release
+	std::atomic<DataProvider*> second(NULL);
+	std::atomic<bool> releaseSecond(false);
+	std::thread holder([&]()
+	{
+		second = pool.Checkout();
+		while(!releaseSecond) std::this_thread::yield();
+		pool.Release(second);
+	});
+	while(!second) std::this_thread::yield();
+	REQUIRE(second.load() == otherProvider);
+
+	std::atomic<bool> gotProvider(false);
+	std::thread waiter([&]() { DataProvider* p = pool.Checkout(); gotProvider = p == provider; pool.Release(p); });
+	while(pool.GetStats().Waits == 0) std::this_thread::yield();
+	pool.Release(provider);
+	waiter.join();
+	releaseSecond = true;
+	holder.join();
+	REQUIRE(gotProvider.load());
+
+	DataProviderPoolStats stats = pool.GetStats();
+	REQUIRE(stats.Created == 2);
+	REQUIRE(stats.Connections == 2);
+	REQUIRE(stats.Waits == 1);
+}
+
+
+/** *********************************************************************
+ * @brief Test of idle reaping, health checks and reconnection
+ */
+TEST_CASE("CCDB/DataProviderPool/Idle","Idle connections are reaped and checked before use")
+{
+	TimeProvider::SetTimeUnitTest(true);
+	TimeProvider::SetUnitTestTime(1000);
+
+	DataProviderPool pool(CreateSQLiteProvider, 4);
+	pool.Connect(TESTS_SQLITE_STRING);
+
+	DataProvider* provider = pool.Checkout();
+	REQUIRE(provider != NULL);
+
+	//idle connection with broken link is reconnected on the next checkout
+	provider->Disconnect();
+	pool.Release(provider);
+	TimeProvider::SetUnitTestTime(1000 + pool.GetHealthCheckInterval());
+	REQUIRE(pool.Checkout() == provider);
+	REQUIRE(provider->IsConnected());
+	REQUIRE(pool.GetStats().HealthCheckFailures == 1);
+
+	//connections in use are not reaped
+	std::atomic<DataProvider*> busy(NULL);
+	std::atomic<bool> releaseBusy(false);
+	std::thread holder([&]()
+	{
+		busy = pool.Checkout();
+		while(!releaseBusy) std::this_thread::yield();
+		pool.Release(busy);
+	});
+	while(!busy) std::this_thread::yield();
+	REQUIRE(busy.load() != provider);
+	pool.Release(provider);
+
+	TimeProvider::SetUnitTestTime(2000);
+	REQUIRE(pool.ReapIdle(500) == 1);
+	REQUIRE(pool.GetStats().Connections == 1);
+	REQUIRE(pool.GetStats().Reaped == 1);
+
+	//disconnected pool closes the busy connection on release and gives no more providers
+	pool.Disconnect();
+	REQUIRE(pool.Checkout() == NULL);
+	releaseBusy = true;
+	holder.join();
+	REQUIRE(pool.GetStats().Connections == 0);
+
+	TimeProvider::SetTimeUnitTest(false);
+}
+
+
+/** *********************************************************************
+ * @brief Test of parallel loads through the pool
+ */
+TEST_CASE("CCDB/DataProviderPool/ParallelLoads","Threads load assignments through their own connections")
+{
+	DataProviderPool pool(CreateSQLiteProvider, 4);
+	pool.Connect(TESTS_SQLITE_STRING);
+
+	int expectedId;
+	{
+		DataProviderLease provider(pool);
+		Assignment* assignment = provider->GetAssignmentShort(100, "/test/test_vars/test_table", "default", true);
+		REQUIRE(assignment != NULL);
+		expectedId = assignment->GetId();
+	}
+
+	std::atomic<int> loaded(0);
+	vector<std::thread> threads;
+	for(int i = 0; i < 8; i++)
+	{
+		threads.push_back(std::thread([&]()
+		{
+			for(int j = 0; j < 10; j++)
+			{
+				//assignments are owned by the pooled provider
+				DataProviderLease provider(pool);
+				Assignment* assignment = provider.Get() ? provider->GetAssignmentShort(100, "/test/test_vars/test_table", "default", true) : NULL;
+				if(assignment && assignment->GetId() == expectedId) loaded++;
+			}
+		}));
+	}
+	for(size_t i = 0; i < threads.size(); i++) threads[i].join();
+
+	REQUIRE(loaded.load() == 80);
+	REQUIRE(pool.GetStats().Connections <= 4);
+	REQUIRE(pool.GetStats().Idle == pool.GetStats().Connections);
+}
@@ -0,0 +1,68 @@
+#pragma warning(disable:4800)
+#include "Tests/catch.hpp"
+#include "Tests/tests.h"
+#include <memory>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <stdexcept>
+
+#include "CCDB/IOExecutor.h"
+
+
+using namespace std;
+using namespace ccdb;
+
+
+/** *********************************************************************
+ * @brief Test of background tasks, their results and exceptions
+ */
+TEST_CASE("CCDB/IOExecutor/Submit","Tasks run in background and give results by futures")
+{
+	IOExecutor executor(2);
+	REQUIRE(executor.GetStats().Threads == 0);
+
+	vector<future<int> > results;
+	for(int i = 0; i < 10; i++) results.push_back(executor.Submit([i]() { return i * i; }));
+	for(int i = 0; i < 10; i++) REQUIRE(results[i].get() == i * i);
+
+	IOExecutorStats stats = executor.GetStats();
+	REQUIRE(stats.Threads >= 1);
+	REQUIRE(stats.Threads <= 2);
+
+	//exceptions go to the caller
+	future<int> failed = executor.Submit([]() -> int { throw std::logic_error("failed"); });
+	REQUIRE_THROWS_AS(failed.get(), std::logic_error);
+
+	//the executor stays usable and extra threads stop
+	executor.SetMaxThreads(1);
+	REQUIRE(executor.Submit([]() { return 7; }).get() == 7);
+	REQUIRE(executor.GetMaxThreads() == 1);
+}
+
+
+/** *********************************************************************
+ * @brief Test of the executor destruction with queued tasks
+ */
+TEST_CASE("CCDB/IOExecutor/Stop","Running tasks are finished, queued tasks are dropped")
+{
+	std::atomic<bool> release(false);
+	std::atomic<bool> started(false);
+	future<bool> running;
+	future<bool> queued;
+	thread releaser;
+	{
+		IOExecutor executor(1);
+		running = executor.Submit([&]() { started = true; while(!release) this_thread::yield(); return true; });
+		queued = executor.Submit([]() { return true; });
+		while(!started) this_thread::yield();
+		REQUIRE(executor.GetStats().Queued == 1);
+
+		//the executor waits for the running task in dtor
+		releaser = thread([&]() { this_thread::sleep_for(chrono::milliseconds(20)); release = true; });
+	}
+	releaser.join();
+
+	REQUIRE(running.get());
+	REQUIRE_THROWS_AS(queued.get(), std::future_error);
+}
@@ -49,4 +49,164 @@ TEST_CASE("CCDB/ModelObjects","ModelObjects tests")
 
 	//TODO more complicated tests with a - benchmark, b - check for memory management
 };
+
+
+TEST_CASE("CCDB/ModelObjects/AssignmentBlob","Blob is tokenized to cells with decoded separators")
+{
+	Assignment assignment;
+	assignment.SetRawData("|1.5|a&delimiter;b||&amp;|3|");
+
+	//empty cells are skipped as StringUtils::Split does
+	vector<string> cells = assignment.GetVectorData();
+	REQUIRE(cells.size() == 4);
+	REQUIRE(cells[0] == "1.5");
+	REQUIRE(cells[1] == "a|b");
+	REQUIRE(cells[2] == "&amp;");
+	REQUIRE(cells[3] == "3");
+	REQUIRE(assignment.GetValue(1) == "a|b");
+	REQUIRE(assignment.GetDoubleValues()[0] == Approx(1.5));
+	REQUIRE(assignment.GetDoubleValues()[3] == Approx(3));
+
+	//blob made by VectorToBlob is read back
+	assignment.SetRawData(Assignment::VectorToBlob(cells));
+	REQUIRE(assignment.GetVectorData() == cells);
+
+	assignment.SetRawData("");
+	REQUIRE(assignment.GetVectorData().empty());
+}
+
+TEST_CASE("CCDB/ModelObjects/BinaryBlob","Binary typed blob is decoded right to typed columns")
+{
+	string bytes("\x00\xff|binary", 9);
+	string text = StringUtils::Base64Encode(bytes.data(), bytes.size());
+	string decoded;
+	REQUIRE(StringUtils::Base64Decode(text.data(), text.data() + text.size(), decoded));
+	REQUIRE(decoded == bytes);
+	REQUIRE_FALSE(StringUtils::Base64Decode(text.data(), text.data() + text.size() - 1, decoded));
+
+	ConstantsTypeTable table;
+	table.AddColumn("id", ConstantsTypeColumn::cIntColumn);
+	table.AddColumn("value", ConstantsTypeColumn::cDoubleColumn);
+	table.AddColumn("name", ConstantsTypeColumn::cStringColumn);
+	table.AddColumn("flag", ConstantsTypeColumn::cBoolColumn);
+	vector<ConstantsTypeColumn::ColumnTypes> types;
+	for(size_t i = 0; i < table.GetColumns().size(); i++) types.push_back(table.GetColumns()[i]->GetType());
+
+	const char* values[] = {"-7", "0.1", "a|b", "true", "8", "2.5e-300", "", "0"};
+	vector<string> cells(values, values + 8);
+	string blob = Assignment::VectorToBlob(cells, types);
+	REQUIRE(Assignment::IsBinaryBlob(blob));
+	REQUIRE(blob.find('|') == string::npos);
+
+	Assignment assignment;
+	assignment.SetTypeTable(&table);
+	assignment.SetRawData(blob);
+	REQUIRE(assignment.IsBinaryData());
+	REQUIRE(assignment.GetRawData() == blob);
+
+	const vector<TypedColumn>& columns = assignment.GetTypedColumns();
+	REQUIRE(columns.size() == 4);
+	REQUIRE(columns[0].Integers[0] == -7);
+	REQUIRE(columns[1].Doubles[0] == 0.1);
+	REQUIRE(columns[1].Doubles[1] == 2.5e-300);
+	REQUIRE(assignment.GetValueBool(0, 3));
+	REQUIRE(assignment.GetDoubleValues()[4] == 8);
+
+	//cells are formatted from the columns
+	vector<vector<string> > data = assignment.GetData();
+	REQUIRE(data.size() == 2);
+	REQUIRE(data[0][1] == "0.1");
+	REQUIRE(data[0][2] == "a|b");
+	REQUIRE(data[1][2] == "");
+	REQUIRE(data[1][3] == "false");
+	REQUIRE(assignment.GetValue(1, "id") == "8");
+
+	//the type table doesn't drop decoded columns
+	assignment.SetTypeTable(&table);
+	REQUIRE(assignment.GetTypedColumns()[0].Integers[1] == 8);
+
+	//values that are not of the column type are kept in text blob
+	cells[0] = "x";
+	blob = Assignment::VectorToBlob(cells, types);
+	REQUIRE_FALSE(Assignment::IsBinaryBlob(blob));
+
+	//broken binary blob is read as text
+	assignment.SetRawData("#ccdb-bin:1:2:id:AAAA");
+	REQUIRE_FALSE(assignment.IsBinaryData());
+	REQUIRE(assignment.GetVectorData().size() == 1);
+}
+
+
+TEST_CASE("CCDB/ModelObjects/CompressedBlob","Compressed blob gives the original text or binary blob back")
+{
+	vector<string> cells;
+	vector<ConstantsTypeColumn::ColumnTypes> types(2, ConstantsTypeColumn::cDoubleColumn);
+	for(int i = 0; i < 500; i++) cells.push_back(StringUtils::Format("%.4f", 1.0 + (i % 17) * 0.25));
+
+	string textBlob = Assignment::VectorToBlob(cells);
+	string binaryBlob = Assignment::VectorToBlob(cells, types);
+	const string* blobs[] = {&textBlob, &binaryBlob};
+	for(int i = 0; i < 2; i++)
+	{
+		string compressed = Assignment::CompressBlob(*blobs[i]);
+		REQUIRE(Assignment::IsCompressedBlob(compressed));
+		REQUIRE(compressed.size() < blobs[i]->size());
+		REQUIRE(compressed.find('|') == string::npos);
+		REQUIRE(Assignment::CompressBlob(compressed) == compressed);
+
+		string blob;
+		REQUIRE(Assignment::DecompressBlob(compressed, blob));
+		REQUIRE(blob == *blobs[i]);
+	}
+
+	//short blobs are not worth compressing
+	REQUIRE(Assignment::CompressBlob("1|2|3") == "1|2|3");
+	string blob;
+	REQUIRE_FALSE(Assignment::DecompressBlob("1|2|3", blob));
+
+	//damaged blobs are not decompressed
+	string compressed = Assignment::CompressBlob(textBlob);
+	REQUIRE_FALSE(Assignment::DecompressBlob(compressed.substr(0, compressed.size() - 8), blob));
+	REQUIRE_FALSE(Assignment::DecompressBlob("#ccdb-z:1:100000000:AAAA", blob));
+	REQUIRE_FALSE(Assignment::DecompressBlob("#ccdb-z:2:4:AAAA", blob));
+	string wrongSize = "#ccdb-z:1:" + StringUtils::IntToString((int)textBlob.size() + 1) + compressed.substr(compressed.find(':', 10));
+	REQUIRE_FALSE(Assignment::DecompressBlob(wrongSize, blob));
+}
+
+
+TEST_CASE("CCDB/ModelObjects/SharedData","Assignments with the same blob share parsed data")
+{
+	ConstantsTypeTable table;
+	table.AddColumn("x", ConstantsTypeColumn::cIntColumn);
+	table.AddColumn("y", ConstantsTypeColumn::cDoubleColumn);
+
+	std::shared_ptr<AssignmentData> data = std::make_shared<AssignmentData>();
+	data->SetRawData("1|2.5|3|4.5");
+
+	Assignment first, second;
+	first.SetTypeTable(&table);
+	second.SetTypeTable(&table);
+	first.SetSharedData(data);
+	second.SetSharedData(data);
+	REQUIRE(first.GetAssignmentData() == second.GetAssignmentData());
+	REQUIRE(&first.GetTypedColumns() == &second.GetTypedColumns());
+	REQUIRE(second.GetTypedColumns()[0].Integers[1] == 3);
+	REQUIRE(first.GetValueDouble(1, 1) == 4.5);
+
+	//new data of one assignment doesn't change the other
+	first.SetRawData("5|6.5");
+	REQUIRE(first.GetAssignmentData() != data);
+	REQUIRE(first.GetVectorData().size() == 2);
+	REQUIRE(second.GetVectorData().size() == 4);
+
+	//another type table gives the assignment its own data
+	ConstantsTypeTable strings;
+	strings.AddColumn("x", ConstantsTypeColumn::cStringColumn);
+	strings.AddColumn("y", ConstantsTypeColumn::cStringColumn);
+	second.SetTypeTable(&strings);
+	REQUIRE(second.GetAssignmentData() != data);
+	REQUIRE(second.GetRawData() == data->GetRawData());
+	REQUIRE(second.GetValueType(0) == ConstantsTypeColumn::cStringColumn);
+	REQUIRE(data->GetTypedColumns(&table)[1].Doubles[0] == 2.5);
+}
 #endif
@@ -72,5 +72,44 @@ TEST_CASE("CCDB/MySQLDataProvider/Assignments","Assignments tests")
 
 
 
+}
+
+
+TEST_CASE("CCDB/MySQLDataProvider/AssignmentShortPrepared","GetAssignmentShort through prepared statements")
+{
+	DataProvider *prov = new MySQLDataProvider();
+	if(!prov->Connect(TESTS_CONENCTION_STRING)) return;
+
+	//the same statements are executed again and again
+	for(int i = 0; i < 3; i++)
+	{
+		Assignment * assignment = prov->GetAssignmentShort(100, "/test/test_vars/test_table", "default", true);
+		REQUIRE(assignment != NULL);
+		REQUIRE(assignment->GetTypeTable()->GetColumns().size() == 3);
+		REQUIRE(assignment->GetRunRange() != NULL);
+		vector<vector<string> > values = assignment->GetData();
+		REQUIRE(values.size() == 2);
+		REQUIRE(values[0][0] == "2.2");
+		delete assignment;
+	}
+
+	//time variant of the statement
+	Assignment * assignment = prov->GetAssignmentShort(100, "/test/test_vars/test_table", time(NULL), "default", false);
+	REQUIRE(assignment != NULL);
+	REQUIRE(assignment->GetData()[0][0] == "2.2");
+	delete assignment;
+
+	assignment = prov->GetAssignmentShort(100, "/test/test_vars/test_table", 1, "default", false);
+	REQUIRE(assignment == NULL);
+
+	//parent variation fallback re-executes the statement
+	assignment = prov->GetAssignmentShort(100, "/test/test_vars/test_table2", "subtest", false);
+	REQUIRE(assignment != NULL);
+	delete assignment;
+
+	//names are parameters, not parts of the query
+	REQUIRE(prov->GetConstantsTypeTable("/test/test_vars/test_table' OR '1'='1", false) == NULL);
+
+	delete prov;
 }
 #endif //ifdef CCDB_MYSQL
@@ -2,6 +2,8 @@
 #include "Tests/catch.hpp"
 #include "Tests/tests.h"
 #include <memory>
+#include <thread>
+#include <atomic>
 
 #include "CCDB/Console.h"
 #include "CCDB/MySQLCalibration.h"
@@ -238,3 +240,39 @@ TEST_CASE("CCDB/UserAPI/CalibrationGenerator/Timeout","Disconnect database with
     //Turn back normal time
     TimeProvider::SetTimeUnitTest(false);
 }
+
+
+/** *********************************************************************
+ * @brief Test of MySQL calibration reading through the connection pool
+ */
+TEST_CASE("CCDB/UserAPI/MySQL/Pool","Threads load tables through pooled connections")
+{
+    MySQLCalibration calib(100);
+    if(!calib.Connect(TESTS_CONENCTION_STRING)) return;
+    calib.EnableCache(true);
+    calib.SetPoolSize(4);
+    REQUIRE(calib.GetPoolSize() == 4);
+
+    vector<std::thread> threads;
+    std::atomic<int> loaded(0);
+    for(int i = 0; i < 8; i++)
+    {
+        threads.push_back(std::thread([&calib, &loaded, i]()
+        {
+            vector<vector<string> > values;
+            string variation = (i % 2) ? "default" : "test";
+            if(calib.GetCalib(values, "/test/test_vars/test_table::" + variation) && values.size() == 2) loaded++;
+        }));
+    }
+    for(size_t i = 0; i < threads.size(); i++) threads[i].join();
+    REQUIRE(loaded.load() == 8);
+
+    DataProviderPoolStats stats = calib.GetProviderPool()->GetStats();
+    REQUIRE(stats.Connections >= 1);
+    REQUIRE(stats.Connections <= 4);
+
+    //idle connections are closed and the pool follows the calibration connection
+    REQUIRE(calib.ReapIdleConnections(-1) == stats.Connections);
+    calib.Disconnect();
+    REQUIRE(calib.GetProviderPool()->GetStats().Connections == 0);
+}
@@ -2,12 +2,19 @@
 #include "Tests/catch.hpp"
 #include "Tests/tests.h"
 #include <memory>
+#include <thread>
+#include <atomic>
+#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+#include <sqlite3.h>
 
 #include "CCDB/Console.h"
 #include "CCDB/SQLiteCalibration.h"
 #include "CCDB/Providers/SQLiteDataProvider.h"
 #include "CCDB/Helpers/PathUtils.h"
 #include "CCDB/CalibrationGenerator.h"
+#include "CCDB/ConstantsTable.h"
 
 
 using namespace std;
@@ -201,3 +208,387 @@ TEST_CASE("CCDB/UserAPI/SQLite_CalibrationGenerator","Use universal generator to
         }
 	}
 }
+
+
+/** *********************************************************************
+ * @brief Test of SQLite calibration reading through per thread connections
+ */
+TEST_CASE("CCDB/UserAPI/SQLite/Pool","Threads load tables through their own SQLite connections")
+{
+	SQLiteCalibration reference(100);
+	if(!reference.Connect(TESTS_SQLITE_STRING)) return;
+	reference.EnableCache(false);
+
+	SQLiteCalibration calib(100);
+	REQUIRE(calib.Connect(TESTS_SQLITE_STRING));
+	calib.EnableCache(true);
+	calib.SetPoolSize(4);
+
+	//different runs and variations resolve to different assignments
+	vector<string> requests;
+	requests.push_back("/test/test_vars/test_table:100:default");
+	requests.push_back("/test/test_vars/test_table:100:test");
+	requests.push_back("/test/test_vars/test_table:1000:test");
+	requests.push_back("/test/test_vars/test_table:1000:subtest");
+	requests.push_back("/test/test_vars/test_table2:100:test");
+	requests.push_back("/test/test_vars/test_table2:3001:subtest");
+
+	vector<vector<vector<string> > > expected(requests.size());
+	for(size_t i = 0; i < requests.size(); i++) REQUIRE(reference.GetCalib(expected[i], requests[i]));
+
+	std::atomic<int> matched(0);
+	vector<std::thread> threads;
+	for(int t = 0; t < 8; t++)
+	{
+		threads.push_back(std::thread([&, t]()
+		{
+			for(size_t i = 0; i < requests.size(); i++)
+			{
+				size_t index = (i + t) % requests.size();
+				vector<vector<string> > values;
+				if(calib.GetCalib(values, requests[index]) && values == expected[index]) matched++;
+			}
+		}));
+	}
+	for(size_t i = 0; i < threads.size(); i++) threads[i].join();
+	REQUIRE(matched.load() == 8 * (int)requests.size());
+
+	//pooled providers have their own NOMUTEX connections
+	DataProviderPoolStats stats = calib.GetProviderPool()->GetStats();
+	REQUIRE(stats.Connections >= 1);
+	REQUIRE(stats.Connections <= 4);
+	DataProvider* pooled = calib.GetProviderPool()->Checkout();
+	REQUIRE(pooled != calib.GetProvider());
+	REQUIRE(static_cast<SQLiteDataProvider*>(pooled)->GetSingleThreadMode());
+	calib.GetProviderPool()->Release(pooled);
+
+	//prefetch goes through the pool too
+	calib.ClearCache();
+	PrefetchStats prefetch = calib.Prefetch(requests);
+	REQUIRE(prefetch.Loaded == requests.size());
+}
+
+
+/** *********************************************************************
+ * @brief Test of asynchronous requests
+ */
+TEST_CASE("CCDB/UserAPI/SQLite/Async","Requests are read in background and give the same data")
+{
+	SQLiteCalibration reference(100);
+	if(!reference.Connect(TESTS_SQLITE_STRING)) return;
+	reference.EnableCache(false);
+
+	SQLiteCalibration calib(100);
+	REQUIRE(calib.Connect(TESTS_SQLITE_STRING));
+	calib.SetPoolSize(2);
+	REQUIRE(calib.GetIOThreads() == CCDB_DEFAULT_IO_THREADS);
+
+	vector<string> requests;
+	requests.push_back("/test/test_vars/test_table:100:default");
+	requests.push_back("/test/test_vars/test_table:1000:subtest");
+	requests.push_back("/test/test_vars/test_table2:100:test");
+	requests.push_back("/test/test_vars/no_such_table");
+
+	//one request
+	vector<vector<double> > expected;
+	REQUIRE(reference.GetCalib(expected, requests[0]));
+	vector<vector<double> > values;
+	future<bool> result = calib.GetCalibAsync(values, requests[0]);
+	REQUIRE(result.get());
+	REQUIRE(values == expected);
+
+	map<string, string> row;
+	future<bool> rowResult = calib.GetCalibAsync(row, requests[2]);
+	future<std::shared_ptr<Assignment> > assignment = calib.GetSharedAssignmentAsync(requests[1]);
+	REQUIRE(rowResult.get());
+	REQUIRE(assignment.get());
+
+	//many requests at once
+	calib.ClearCache();
+	vector<vector<vector<string> > > tables;
+	future<vector<bool> > many = calib.GetCalibManyAsync(tables, requests);
+	vector<bool> found = many.get();
+	REQUIRE(found.size() == requests.size());
+	REQUIRE(tables.size() == requests.size());
+	for(size_t i = 0; i < requests.size() - 1; i++)
+	{
+		vector<vector<string> > table;
+		REQUIRE(found[i]);
+		REQUIRE(reference.GetCalib(table, requests[i]));
+		REQUIRE(tables[i] == table);
+	}
+	REQUIRE_FALSE(found.back());
+
+	//results of not found requests are the same as of GetCalib
+	string value;
+	future<bool> wrong = calib.GetCalibAsync(value, "/test/test_vars/test_table:100:no_such_variation");
+	REQUIRE(wrong.get() == reference.GetCalib(value, "/test/test_vars/test_table:100:no_such_variation"));
+}
+
+
+/** *********************************************************************
+ * @brief Test of cache invalidation by changes of the database
+ */
+static bool ExecuteSQLite(const string& path, const string& query)
+{
+	sqlite3* db = NULL;
+	bool isOk = sqlite3_open(path.c_str(), &db) == SQLITE_OK &&
+	            sqlite3_exec(db, query.c_str(), NULL, NULL, NULL) == SQLITE_OK;
+	sqlite3_close(db);
+	return isOk;
+}
+
+/** Copies the test database to a temporary file for tests that change it. Empty string if it can't be copied */
+static string CopyTestDatabase(const string& name)
+{
+	string source = string(TESTS_SQLITE_STRING).substr(9);
+	const char* tmpDir = getenv("TMPDIR");
+	string path = string(tmpDir ? tmpDir : "/tmp") + "/" + name;
+
+	ifstream in(source.c_str(), ios::binary);
+	if(!in) return string();
+	ofstream out(path.c_str(), ios::binary);
+	out << in.rdbuf();
+	return path;
+}
+
+TEST_CASE("CCDB/UserAPI/SQLite/ChangeCheck","Changed tables are dropped from the cache")
+{
+	//the database is changed, so the test works with a copy
+	string path = CopyTestDatabase("ccdb_change_check_test.sqlite");
+	if(path.empty()) return;
+
+	SQLiteCalibration calib(100);
+	REQUIRE(calib.Connect("sqlite://" + path));
+	calib.EnableCache(true);
+
+	vector<vector<string> > before, other;
+	REQUIRE(calib.GetCalib(before, "/test/test_vars/test_table"));
+	REQUIRE(calib.GetCalib(other, "/test/test_vars/test_table2::test"));
+	CalibHandle handle = calib.GetHandle("/test/test_vars/test_table");
+	REQUIRE(calib.GetCalib(before, handle));
+	std::shared_ptr<Assignment> changed = calib.GetSharedAssignment("/test/test_vars/test_table");
+	std::shared_ptr<Assignment> kept = calib.GetSharedAssignment("/test/test_vars/test_table2::test");
+
+	//the first check takes the state of the database
+	calib.SetChangeCheckInterval(3600);
+	REQUIRE(calib.GetChangeCheckInterval() == 3600);
+	REQUIRE_FALSE(calib.CheckForChanges());
+
+	//new values of the assignment
+	vector<string> cells = changed->GetVectorData();
+	cells[0] = "42";
+	string id = StringUtils::IntToString(changed->GetId());
+	REQUIRE(ExecuteSQLite(path,
+		"UPDATE constantSets SET vault = '" + Assignment::VectorToBlob(cells) + "' "
+		"WHERE id = (SELECT constantSetId FROM assignments WHERE id = " + id + ");"
+		"UPDATE assignments SET modified = '2030-01-01 00:00:00' WHERE id = " + id + ";"));
+
+	//cached data is used until the check
+	vector<vector<string> > after;
+	REQUIRE(calib.GetCalib(after, "/test/test_vars/test_table"));
+	REQUIRE(after == before);
+
+	REQUIRE(calib.CheckForChanges());
+	ChangeCheckStats stats = calib.GetChangeCheckStats();
+	REQUIRE(stats.Changes == 1);
+	REQUIRE(stats.InvalidatedTables == 1);
+	REQUIRE(stats.FullClears == 0);
+
+	//only the changed table is loaded again
+	REQUIRE(calib.GetCalib(after, "/test/test_vars/test_table"));
+	REQUIRE(after[0][0] == "42");
+	REQUIRE(calib.GetSharedAssignment("/test/test_vars/test_table2::test") == kept);
+	REQUIRE(calib.GetCalib(after, handle));
+	REQUIRE(after[0][0] == "42");
+	REQUIRE_FALSE(calib.CheckForChanges());
+
+	//removed assignments can't be told by table, the whole cache is cleared
+	REQUIRE(ExecuteSQLite(path, "DELETE FROM assignments WHERE id = " + id + ";"));
+	REQUIRE(calib.CheckForChanges());
+	REQUIRE(calib.GetChangeCheckStats().FullClears == 1);
+	REQUIRE(calib.GetSharedAssignment("/test/test_vars/test_table2::test") != kept);
+	std::shared_ptr<Assignment> previous = calib.GetSharedAssignment("/test/test_vars/test_table");
+	REQUIRE((!previous || previous->GetId() != changed->GetId()));
+
+	calib.Disconnect();
+	remove(path.c_str());
+}
+
+TEST_CASE("CCDB/UserAPI/SQLite/NewVariation","Unknown variation is found after it is added")
+{
+	string path = CopyTestDatabase("ccdb_new_variation_test.sqlite");
+	if(path.empty()) return;
+
+	SQLiteDataProvider prov;
+	REQUIRE(prov.Connect("sqlite://" + path));
+	REQUIRE(prov.GetVariation("default") != NULL);
+
+	//the database is not changed, repeated misses don't reload variations
+	REQUIRE(prov.GetVariation("new_variation") == NULL);
+	REQUIRE(prov.GetVariation("new_variation") == NULL);
+
+	REQUIRE(ExecuteSQLite(path, "INSERT INTO variations (id, name, parentId) VALUES (100, 'new_variation', 1);"));
+	Variation* variation = prov.GetVariation("new_variation");
+	REQUIRE(variation != NULL);
+	REQUIRE(variation->GetId() == 100);
+	REQUIRE(variation->GetParent() == prov.GetVariation("default"));
+
+	prov.Disconnect();
+	remove(path.c_str());
+}
+
+
+/** *********************************************************************
+ * @brief Test of typed GetCalib for cells that are not of their column type
+ */
+TEST_CASE("CCDB/UserAPI/SQLite/MixedCells","Typed values are the same as parsed from the cells")
+{
+	string path = CopyTestDatabase("ccdb_mixed_cells_test.sqlite");
+	if(path.empty()) return;
+
+	//test_table2 has int columns
+	REQUIRE(ExecuteSQLite(path, "UPDATE constantSets SET vault = '2.2|-7|1e3' WHERE id = 3;"));
+
+	SQLiteCalibration calib(100);
+	REQUIRE(calib.Connect("sqlite://" + path));
+	calib.EnableCache(true);
+
+	vector<vector<string> > cells;
+	vector<vector<double> > doubles;
+	vector<vector<int> > ints;
+	REQUIRE(calib.GetCalib(cells, "/test/test_vars/test_table2::test"));
+	REQUIRE(calib.GetCalib(doubles, "/test/test_vars/test_table2::test"));
+	REQUIRE(calib.GetCalib(ints, "/test/test_vars/test_table2::test"));
+	for(size_t i = 0; i < cells[0].size(); i++)
+	{
+		REQUIRE(doubles[0][i] == StringUtils::ParseDouble(cells[0][i]));
+		REQUIRE(ints[0][i] == StringUtils::ParseInt(cells[0][i]));
+	}
+	REQUIRE(doubles[0][0] == Approx(2.2));
+	REQUIRE(doubles[0][2] == Approx(1000));
+	REQUIRE(ints[0][0] == 2);
+
+	map<string, double> row;
+	REQUIRE(calib.GetCalib(row, "/test/test_vars/test_table2::test"));
+	REQUIRE(row["c1"] == Approx(2.2));
+
+	calib.Disconnect();
+	remove(path.c_str());
+}
+
+
+/** *********************************************************************
+ * @brief Flat, buffer and view GetCalib give the same values as vector<vector<T>>
+ */
+template<typename T>
+static void CheckFlatValues(SQLiteCalibration& calib, const string& namepath)
+{
+	vector<vector<T> > table;
+	REQUIRE(calib.GetCalib(table, namepath));
+	REQUIRE(!table.empty());
+
+	size_t rows = 0, columns = 0;
+	vector<T> values;
+	REQUIRE(calib.GetCalib(values, rows, columns, namepath));
+	REQUIRE(rows == table.size());
+	REQUIRE(columns == table[0].size());
+
+	vector<T> buffer(rows*columns);
+	REQUIRE(calib.GetCalib(&buffer[0], buffer.size(), rows, columns, namepath));
+
+	CalibView<T> view;
+	REQUIRE(calib.GetCalib(view, namepath));
+	REQUIRE(view.GetRowsCount() == rows);
+	REQUIRE(view.GetColumnsCount() == columns);
+
+	for(size_t row = 0; row < rows; row++)
+	{
+		for(size_t column = 0; column < columns; column++)
+		{
+			REQUIRE(values[row*columns + column] == table[row][column]);
+			REQUIRE(buffer[row*columns + column] == table[row][column]);
+			REQUIRE(view(row, column) == table[row][column]);
+		}
+	}
+}
+
+TEST_CASE("CCDB/UserAPI/SQLite/FlatValues","Flat and nested typed values are the same")
+{
+	string path = CopyTestDatabase("ccdb_flat_values_test.sqlite");
+	if(path.empty()) return;
+
+	//test_table2 has int columns
+	REQUIRE(ExecuteSQLite(path, "UPDATE constantSets SET vault = '2.2|-7|1e3' WHERE id = 3;"));
+
+	SQLiteCalibration calib(100);
+	REQUIRE(calib.Connect("sqlite://" + path));
+	calib.EnableCache(true);
+
+	CheckFlatValues<double>(calib, "/test/test_vars/test_table2::test");
+	CheckFlatValues<int>(calib, "/test/test_vars/test_table2::test");
+	CheckFlatValues<double>(calib, "/test/test_vars/test_table");
+	CheckFlatValues<int>(calib, "/test/test_vars/test_table");
+
+	//the same without the cache
+	calib.EnableCache(false);
+	CheckFlatValues<double>(calib, "/test/test_vars/test_table2::test");
+	CheckFlatValues<int>(calib, "/test/test_vars/test_table");
+
+	calib.Disconnect();
+	remove(path.c_str());
+}
+
+
+/** *********************************************************************
+ * @brief Test of ConstantsTable typed columns and indexes
+ */
+TEST_CASE("CCDB/UserAPI/ConstantsTable","Typed columns, column and row indexes of ConstantsTable")
+{
+	ConstantsTypeTable typeTable;
+	typeTable.AddColumn("sector", ConstantsTypeColumn::cIntColumn);
+	typeTable.AddColumn("layer", ConstantsTypeColumn::cIntColumn);
+	typeTable.AddColumn("ped", ConstantsTypeColumn::cDoubleColumn);
+	typeTable.AddColumn("name", ConstantsTypeColumn::cStringColumn);
+	typeTable.SetNRows(4);
+
+	Assignment assignment;
+	assignment.SetTypeTable(&typeTable);
+	assignment.SetRawData("1|1|0.5|a|1|2|1.5|b|2|1|2.5|c|2|2|3.5|d");
+
+	ConstantsTable table;
+	table.load(assignment);
+	REQUIRE(table.nrows() == 4);
+	REQUIRE(table.ncols() == 4);
+	REQUIRE(table.coltype("ped") == "double");
+	REQUIRE(table.colindex("ped") == 2);
+
+	REQUIRE(table.elem("ped", 2) == Approx(2.5));
+	REQUIRE(table.elem<int>("sector", 3) == 2);
+	REQUIRE(table.elem<string>("name", 1) == "b");
+	REQUIRE(table.elem<string>("ped", 0) == "0.5");
+	REQUIRE(table.elem(table.colindex("ped"), 3) == Approx(3.5));
+	REQUIRE(table.col<int>("layer")[3] == 2);
+	REQUIRE_THROWS_AS(table.elem("no_such_column"), std::out_of_range);
+	REQUIRE_THROWS_AS(table.elem<double>("name", 0), std::logic_error);
+
+	REQUIRE(table.row("sector", 2) == 2);
+	REQUIRE(table.row("sector", 2.0) == 2);
+	REQUIRE_THROWS_AS(table.row("sector", 2.5), std::logic_error);
+	REQUIRE(table.row("name", "d") == 3);
+	REQUIRE(table.row("ped", 1.5) == 1);
+
+	table.index_by({"sector", "layer"});
+	REQUIRE(table.row({2, 1}) == 2);
+	REQUIRE(table.elem("ped", table.row({1, 2})) == Approx(1.5));
+	REQUIRE_THROWS_AS(table.row({3, 1}), std::logic_error);
+	REQUIRE_THROWS_AS(table.index_by({"name"}), std::logic_error);
+
+	//load through any connected calibration
+	SQLiteCalibration calib(100);
+	if(!calib.Connect(TESTS_SQLITE_STRING)) return;
+	table.load_constants("/test/test_vars/test_table", calib);
+	REQUIRE(table.nrows() == 2);
+	REQUIRE(table.elem("x") == Approx(2.2));
+	REQUIRE(table.elem("z", 1) == Approx(2.7));
+}
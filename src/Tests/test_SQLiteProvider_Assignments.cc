@@ -81,3 +81,220 @@ TEST_CASE("CCDB/SQLiteDataProvider/Assignments","Assignments tests")
 	REQUIRE(Assignment::DecodeBlobSeparator("30e-2") == "30e-2");	
 	
 }
+
+
+TEST_CASE("CCDB/SQLiteDataProvider/AssignmentRunInterval","Interval of runs that resolve to the same assignment")
+{
+	DataProvider *prov = new SQLiteDataProvider();
+	if(!prov->Connect(TESTS_SQLITE_STRING)) return;
+
+	int runMin, runMax;
+
+	//default variation, the last assignment covers all runs
+	Assignment * assignment = prov->GetAssignmentShort(100, "/test/test_vars/test_table", "default", true);
+	REQUIRE(assignment != NULL);
+	REQUIRE(prov->GetAssignmentRunInterval(assignment, "default", 0, runMin, runMax));
+	REQUIRE(runMin == 0);
+	REQUIRE(runMax == INFINITE_RUN);
+
+	//'test' falls back to 'default' for run 100, but has its own data for runs 500-3000
+	assignment = prov->GetAssignmentShort(100, "/test/test_vars/test_table", "test", true);
+	REQUIRE(assignment != NULL);
+	REQUIRE(prov->GetAssignmentRunInterval(assignment, "test", 0, runMin, runMax));
+	REQUIRE(runMin == 0);
+	REQUIRE(runMax == 499);
+
+	assignment = prov->GetAssignmentShort(3001, "/test/test_vars/test_table", "test", true);
+	REQUIRE(prov->GetAssignmentRunInterval(assignment, "test", 0, runMin, runMax));
+	REQUIRE(runMin == 3001);
+	REQUIRE(runMax == INFINITE_RUN);
+
+	assignment = prov->GetAssignmentShort(1000, "/test/test_vars/test_table", "test", true);
+	REQUIRE(prov->GetAssignmentRunInterval(assignment, "test", 0, runMin, runMax));
+	REQUIRE(runMin == 500);
+	REQUIRE(runMax == 3000);
+
+	delete prov;
+}
+
+
+TEST_CASE("CCDB/SQLiteDataProvider/AssignmentsShortBulk","Bulk selection gives the same as GetAssignmentShort table by table")
+{
+	DataProvider *prov = new SQLiteDataProvider();
+	if(!prov->Connect(TESTS_SQLITE_STRING)) return;
+
+	vector<string> paths;
+	paths.push_back("/test/test_vars/test_table");
+	paths.push_back("/test/test_vars/test_table2");
+	paths.push_back("/test/test_vars/no_such_table");
+	paths.push_back("/test/test_vars/test_table");
+
+	const char* variations[] = {"default", "test", "subtest"};
+	int runs[] = {100, 1000, 3001};
+
+	for(int v = 0; v < 3; v++)
+	{
+		for(int r = 0; r < 3; r++)
+		{
+			vector<Assignment*> assignments;
+			vector<pair<int, int> > runIntervals;
+			REQUIRE(prov->GetAssignmentsShort(assignments, runIntervals, runs[r], paths, 0, variations[v], true));
+			REQUIRE(assignments.size() == paths.size());
+			REQUIRE(runIntervals.size() == paths.size());
+			REQUIRE(assignments[2] == NULL);
+
+			for(size_t i = 0; i < paths.size(); i++)
+			{
+				Assignment* expected = prov->GetAssignmentShort(runs[r], paths[i], variations[v], true);
+				if(!expected)
+				{
+					REQUIRE(assignments[i] == NULL);
+					continue;
+				}
+
+				int runMin, runMax;
+				REQUIRE(prov->GetAssignmentRunInterval(expected, variations[v], 0, runMin, runMax));
+				REQUIRE(assignments[i] != NULL);
+				REQUIRE(assignments[i]->GetId() == expected->GetId());
+				REQUIRE(assignments[i]->GetVariationId() == expected->GetVariationId());
+				REQUIRE(assignments[i]->GetRawData() == expected->GetRawData());
+				REQUIRE(assignments[i]->GetRunRange()->GetMin() == expected->GetRunRange()->GetMin());
+				REQUIRE(assignments[i]->GetRunRange()->GetMax() == expected->GetRunRange()->GetMax());
+				REQUIRE(assignments[i]->GetTypeTable()->GetFullPath() == paths[i]);
+				REQUIRE(assignments[i]->GetTypeTable()->GetColumns().size() == expected->GetTypeTable()->GetColumns().size());
+				REQUIRE(assignments[i]->GetTypeTable()->GetColumnNames() == expected->GetTypeTable()->GetColumnNames());
+				REQUIRE(runIntervals[i].first == runMin);
+				REQUIRE(runIntervals[i].second == runMax);
+				delete expected;
+				delete assignments[i];
+			}
+		}
+	}
+
+	//nothing was created before the time
+	vector<Assignment*> assignments;
+	vector<pair<int, int> > runIntervals;
+	REQUIRE(prov->GetAssignmentsShort(assignments, runIntervals, 100, paths, 1, "default", false));
+	REQUIRE(assignments[0] == NULL);
+	REQUIRE(assignments[1] == NULL);
+
+	delete prov;
+}
+
+
+TEST_CASE("CCDB/SQLiteDataProvider/TypeTableCache","Assignments of the same table share one cached type table")
+{
+	DataProvider *prov = new SQLiteDataProvider();
+	if(!prov->Connect(TESTS_SQLITE_STRING)) return;
+
+	//the first request without columns loads the table
+	Assignment* first = prov->GetAssignmentShort(100, "/test/test_vars/test_table", "default", false);
+	REQUIRE(first != NULL);
+	REQUIRE(prov->GetTypeTableCache()->GetStats().Misses == 1);
+
+	//the request with columns loads it once more, then it is taken from the cache
+	Assignment* second = prov->GetAssignmentShort(100, "/test/test_vars/test_table", "default", true);
+	Assignment* third = prov->GetAssignmentShort(1000, "/test/test_vars/test_table", "subtest", true);
+	Assignment* noColumns = prov->GetAssignmentShort(100, "/test/test_vars/test_table", "default", false);
+	REQUIRE(second != NULL);
+	REQUIRE(third != NULL);
+	REQUIRE(second->GetTypeTable() == third->GetTypeTable());
+	REQUIRE(noColumns->GetTypeTable() == second->GetTypeTable());
+	REQUIRE(second->GetTypeTable()->GetColumns().size() == 3);
+
+	TypeTableCacheStats stats = prov->GetTypeTableCache()->GetStats();
+	REQUIRE(stats.Tables == 1);
+	REQUIRE(stats.Misses == 2);
+	REQUIRE(stats.Hits >= 2);
+
+	//bulk selection takes the same table
+	vector<string> paths(1, "/test/test_vars/test_table");
+	vector<Assignment*> assignments;
+	vector<pair<int, int> > runIntervals;
+	REQUIRE(prov->GetAssignmentsShort(assignments, runIntervals, 100, paths, 0, "default", true));
+	REQUIRE(assignments[0]->GetTypeTable() == second->GetTypeTable());
+
+	//the table outlives the assignments and the cache
+	ConstantsTypeTable* table = third->GetTypeTable();
+	delete second;
+	delete assignments[0];
+	prov->GetTypeTableCache()->Clear();
+	REQUIRE(table->GetFullPath() == "/test/test_vars/test_table");
+	REQUIRE(third->GetValueType(0) == table->GetColumns()[0]->GetType());
+
+	delete first;
+	delete third;
+	delete noColumns;
+	delete prov;
+}
+
+
+TEST_CASE("CCDB/SQLiteDataProvider/ConstantSetCache","Assignments with the same vault share one parsed constant set")
+{
+	DataProvider *prov = new SQLiteDataProvider();
+	if(!prov->Connect(TESTS_SQLITE_STRING)) return;
+
+	Assignment* first = prov->GetAssignmentShort(100, "/test/test_vars/test_table", "default", true);
+	REQUIRE(first != NULL);
+	ConstantSetCacheStats stats = prov->GetConstantSetCache()->GetStats();
+	REQUIRE(stats.Misses == 1);
+	REQUIRE(stats.Sets == 1);
+
+	//the same vault is parsed once
+	Assignment* second = prov->GetAssignmentShort(100, "/test/test_vars/test_table", "default", true);
+	REQUIRE(second != NULL);
+	REQUIRE(first->GetAssignmentData() == second->GetAssignmentData());
+	REQUIRE(prov->GetConstantSetCache()->GetStats().Hits == 1);
+	REQUIRE(first->GetVectorData() == second->GetVectorData());
+
+	vector<string> paths(1, "/test/test_vars/test_table");
+	vector<Assignment*> assignments;
+	vector<pair<int, int> > runIntervals;
+	REQUIRE(prov->GetAssignmentsShort(assignments, runIntervals, 100, paths, 0, "default", true));
+	REQUIRE(assignments[0]->GetAssignmentData() == first->GetAssignmentData());
+
+	//the data is released with the last assignment
+	vector<vector<string> > values = first->GetData();
+	std::weak_ptr<AssignmentData> data = first->GetAssignmentData();
+	delete first;
+	delete second;
+	REQUIRE_FALSE(data.expired());
+	delete assignments[0];
+	REQUIRE(data.expired());
+	REQUIRE(prov->GetConstantSetCache()->GetStats().Sets == 0);
+
+	//then the vault is parsed again
+	Assignment* third = prov->GetAssignmentShort(100, "/test/test_vars/test_table", "default", true);
+	REQUIRE(third != NULL);
+	REQUIRE(prov->GetConstantSetCache()->GetStats().Misses == 2);
+	REQUIRE(third->GetData() == values);
+
+	delete third;
+	delete prov;
+}
+
+
+TEST_CASE("CCDB/ConstantSetCache/Vaults","Cached data is found only by the same vault")
+{
+	ConstantSetCache cache;
+
+	//text vault is compared with the raw data
+	std::shared_ptr<AssignmentData> text = std::make_shared<AssignmentData>();
+	text->SetRawData("1|2|3");
+	REQUIRE(cache.Put("1|2|3", NULL, text) == text);
+	REQUIRE(cache.Get("1|2|3", NULL) == text);
+	REQUIRE_FALSE(cache.Get("1|2|4", NULL));
+
+	//the data of a compressed vault keeps the decompressed blob
+	std::shared_ptr<AssignmentData> decompressed = std::make_shared<AssignmentData>();
+	decompressed->SetRawData("4|5|6");
+	REQUIRE(cache.Put("#ccdb-z:1:5:eJwzqTGtMQMABMYBmA==", NULL, decompressed) == decompressed);
+	REQUIRE(cache.Get("#ccdb-z:1:5:eJwzqTGtMQMABMYBmA==", NULL) == decompressed);
+	REQUIRE_FALSE(cache.Get("#ccdb-z:1:5:eJwzqTGtMQMABMYBmQ==", NULL));
+	REQUIRE_FALSE(cache.Get("#ccdb-z:1:5:eJwzqTGtMQMABMYBmA=", NULL));
+
+	ConstantSetCacheStats stats = cache.GetStats();
+	REQUIRE(stats.Sets == 2);
+	REQUIRE(stats.Hits == 2);
+	REQUIRE(stats.Misses == 3);
+}
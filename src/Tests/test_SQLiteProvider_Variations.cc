@@ -30,3 +30,43 @@ TEST_CASE("CCDB/SQLiteDataProvider/Vars","Varests")
 	//REQUIRE(variations.size()>0);
 }
 
+
+TEST_CASE("CCDB/SQLiteDataProvider/VariationChain","Variations are loaded at once with their ancestor chains")
+{
+	DataProvider *prov = new SQLiteDataProvider();
+	if(!prov->Connect(TESTS_SQLITE_STRING)) return;
+
+	Variation *variation = prov->GetVariation("subtest");
+	REQUIRE(variation != NULL);
+	REQUIRE(prov->GetVariation("subtest") == variation);
+	REQUIRE(prov->GetVariation("no_such_variation") == NULL);
+
+	//subtest -> test -> default
+	const vector<Variation *>& chain = prov->GetVariationChain(variation);
+	REQUIRE(chain.size() == 3);
+	REQUIRE(chain[0] == variation);
+	REQUIRE(chain[1] == prov->GetVariation("test"));
+	REQUIRE(chain[2] == prov->GetVariation("default"));
+	REQUIRE(chain[2]->GetParent() == NULL);
+
+	//the assignment of the nearest variation in the chain is taken
+	Assignment* assignment = prov->GetAssignmentShort(100, "/test/test_vars/test_table", "test", false);
+	REQUIRE(assignment != NULL);
+	REQUIRE(assignment->GetId() == 4);
+	REQUIRE(assignment->GetVariationId() == 1);
+	delete assignment;
+
+	assignment = prov->GetAssignmentShort(100, "/test/test_vars/test_table2", "subtest", false);
+	REQUIRE(assignment != NULL);
+	REQUIRE(assignment->GetId() == 3);
+	REQUIRE(assignment->GetVariationId() == 3);
+	delete assignment;
+
+	assignment = prov->GetAssignmentShort(100, "/test/test_vars/test_table", "subtest", false);
+	REQUIRE(assignment != NULL);
+	REQUIRE(assignment->GetId() == 5);
+	REQUIRE(assignment->GetVariationId() == 4);
+	delete assignment;
+
+	delete prov;
+}
@@ -4,6 +4,9 @@
 #include "Tests/catch.hpp"
 
 #include "CCDB/Helpers/StringUtils.h"
+#include <climits>
+#include <cstdlib>
+#include <cstring>
 
 
 using namespace std;
@@ -72,4 +75,62 @@ TEST_CASE("CCDB/StringUtils/Split", "Test of lexical splittiong string to tokens
 	REQUIRE(outArray[5] == "30e-2");
 }
 
+
+TEST_CASE("CCDB/StringUtils/ParseNumbers", "Numbers are parsed correctly rounded and errors are reported")
+{
+	//doubles are the same as correctly rounded strtod gives
+	const char* doubles[] = {"0", "-0", "1.991211", "2.2", "0.1", "30e-2", "-1.5E+3", " 12.25 ", "123456789.123456789",
+	                         "9007199254740993", "2.2250738585072014e-308", "4.9e-324", "1e23", "1.7976931348623157e308",
+	                         "12e25", "123456789012345678901234567890", "0.000000000000000000000000000001", "inf", "-nan", "0x1p3"};
+	for(size_t i = 0; i < array_length(doubles); i++)
+	{
+		bool isOk = false;
+		double value = StringUtils::ParseDouble(doubles[i], &isOk);
+		REQUIRE(isOk);
+		double expected = strtod(doubles[i], NULL);
+		if(expected == expected) REQUIRE(memcmp(&value, &expected, sizeof(double)) == 0);
+		else REQUIRE(value != value);
+	}
+
+	//not numbers give what atof gives and are reported
+	bool isOk = true;
+	REQUIRE(StringUtils::ParseDouble("1.5abc", &isOk) == 1.5);
+	REQUIRE_FALSE(isOk);
+	REQUIRE(StringUtils::ParseDouble("", &isOk) == 0);
+	REQUIRE_FALSE(isOk);
+	REQUIRE(StringUtils::ParseDouble("1e", &isOk) == 1);
+	REQUIRE_FALSE(isOk);
+
+	//integers
+	REQUIRE(StringUtils::ParseInt("-42", &isOk) == -42);
+	REQUIRE(isOk);
+	REQUIRE(StringUtils::ParseInt("12.7", &isOk) == 12);
+	REQUIRE_FALSE(isOk);
+	REQUIRE(StringUtils::ParseInt("3000000000", &isOk) == INT_MAX);
+	REQUIRE_FALSE(isOk);
+	REQUIRE(StringUtils::ParseInt("-2147483648", &isOk) == INT_MIN);
+	REQUIRE(isOk);
+	REQUIRE(StringUtils::ParseUInt("4294967295", &isOk) == 4294967295u);
+	REQUIRE(isOk);
+	REQUIRE(StringUtils::ParseLong("-9223372036854775808", &isOk) == LONG_MIN);
+	REQUIRE(isOk);
+	REQUIRE(StringUtils::ParseULong("18446744073709551615", &isOk) == ULONG_MAX);
+	REQUIRE(isOk);
+	REQUIRE(StringUtils::ParseULong("-1", &isOk) == ULONG_MAX);
+	REQUIRE_FALSE(isOk);
+	REQUIRE(StringUtils::ParseBool("true", &isOk));
+	REQUIRE(StringUtils::ParseBool("2", &isOk));
+	REQUIRE_FALSE(StringUtils::ParseBool("0", &isOk));
+	REQUIRE(isOk);
+
+	//the whole blob at once
+	string blob = "|1.5|2|abc||-3e2|";
+	vector<double> values;
+	REQUIRE(StringUtils::ParseDoubles(blob.data(), blob.data() + blob.size(), '|', values) == 1);
+	REQUIRE(values.size() == 4);
+	REQUIRE(values[0] == 1.5);
+	REQUIRE(values[2] == 0);
+	REQUIRE(values[3] == -300);
+}
+
 #endif //test_StringUtils_h